@@ -1 +1,10 @@
-\echo "no changes to apply for rdf_fdw 2.7"
\ No newline at end of file
+/* invalidate the prefixes cached by rdf_fdw once sparql.prefixes is modified */
+CREATE FUNCTION sparql.invalidate_prefixes()
+RETURNS trigger AS 'MODULE_PATHNAME', 'rdf_fdw_invalidate_prefixes'
+LANGUAGE C;
+
+COMMENT ON FUNCTION sparql.invalidate_prefixes() IS 'Invalidates the prefixes cached by rdf_fdw once sparql.prefixes is modified';
+
+CREATE TRIGGER invalidate_prefixes
+AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON sparql.prefixes
+FOR EACH STATEMENT EXECUTE PROCEDURE sparql.invalidate_prefixes();
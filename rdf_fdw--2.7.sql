@@ -3525,6 +3525,16 @@ BEGIN
 END;
 $$ LANGUAGE plpgsql;
 
+CREATE FUNCTION sparql.invalidate_prefixes()
+RETURNS trigger AS 'MODULE_PATHNAME', 'rdf_fdw_invalidate_prefixes'
+LANGUAGE C;
+
+COMMENT ON FUNCTION sparql.invalidate_prefixes() IS 'Invalidates the prefixes cached by rdf_fdw once sparql.prefixes is modified';
+
+CREATE TRIGGER invalidate_prefixes
+AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON sparql.prefixes
+FOR EACH STATEMENT EXECUTE PROCEDURE sparql.invalidate_prefixes();
+
 SELECT sparql.add_context('default', 'Default context for SPARQL prefixes');
 
 SELECT sparql.add_prefix('default', 'rdf', 'http://www.w3.org/1999/02/22-rdf-syntax-ns#');
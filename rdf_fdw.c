@@ -13,15 +13,20 @@
 #include "postgres.h"
 
 #include <curl/curl.h>
+#include <libxml/parser.h>
 #include <libxml/tree.h>
 #include <ctype.h>
 
 #include "sparql.h"
+#include "sparql_json.h"
+#include "sparql_tsv.h"
+#include "sparql_ntriples.h"
 #include "rdf_utils.h"
 #include "rdf_fdw.h"
 #include "rdfnode.h"
 
 #include "fmgr.h"
+#include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/reloptions.h"
 #include "access/sysattr.h"
@@ -29,23 +34,28 @@
 #include "catalog/indexing.h"
 #include "catalog/pg_attribute.h"
 #include "catalog/pg_cast.h"
+#include "catalog/pg_class.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_foreign_data_wrapper.h"
 #include "catalog/pg_foreign_server.h"
 #include "catalog/pg_foreign_table.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_aggregate.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_namespace.h"
 #include "catalog/pg_operator.h"
 #include "catalog/pg_proc.h"
 #include "catalog/pg_user_mapping.h"
 #include "catalog/pg_type.h"
 #include "commands/defrem.h"
+#include "commands/trigger.h"
 #if PG_VERSION_NUM >= 180000
 #include "commands/explain_format.h"
 #include "commands/explain_state.h"
 #endif
 #include "commands/explain.h"
 #include "commands/vacuum.h"
+#include "executor/instrument.h"
 #include "foreign/fdwapi.h"
 #include "foreign/foreign.h"
 #include "libpq/pqsignal.h"
@@ -58,6 +68,7 @@
 #endif
 #include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
 #include "optimizer/planmain.h"
 #include "optimizer/restrictinfo.h"
 #include "optimizer/tlist.h"
@@ -79,14 +90,19 @@
 #include "utils/fmgroids.h"
 #include "utils/formatting.h"
 #include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/sampling.h"
+#include "utils/selfuncs.h"
 #include "utils/resowner.h"
 #include "utils/timestamp.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 #include "utils/timestamp.h"
+#include "executor/executor.h"
 #include "executor/spi.h"
 #if PG_VERSION_NUM < 120000
 #include "nodes/relation.h"
@@ -97,6 +113,9 @@
 #include "optimizer/optimizer.h"
 #include "access/heapam.h"
 #endif
+#if PG_VERSION_NUM >= 140000
+#include "optimizer/appendinfo.h"
+#endif
 #include "funcapi.h"
 #if PG_VERSION_NUM >= 100000
 #include "utils/varlena.h"
@@ -161,11 +180,177 @@ struct MemoryStruct
 	size_t max_size; /* 0 = unlimited */
 };
 
+/*
+ * Backend-local cache of libcurl handles, keyed by foreign server and user.
+ * Keeping an easy handle alive between requests lets libcurl reuse its open
+ * HTTP(S) connections, DNS entries and TLS session ids, so only the first
+ * request of a session pays for the TCP connect and TLS handshake.
+ */
+typedef struct RDFfdwConnCacheKey
+{
+	Oid serverid;	/* FOREIGN SERVER oid */
+	Oid userid;		/* user the request is executed as */
+} RDFfdwConnCacheKey;
+
+typedef struct RDFfdwConnCacheEntry
+{
+	RDFfdwConnCacheKey key;		/* hash key (must be first) */
+	CURL *curl;					/* cached easy handle, or NULL */
+	bool busy;					/* a transfer is running on this handle */
+	bool invalidated;			/* server or user mapping changed; drop handle on next use */
+	uint32 server_hashvalue;	/* hash value of the server's syscache entry */
+	long requests;				/* number of requests executed with this entry */
+	long reused;				/* number of requests that reused an open connection */
+} RDFfdwConnCacheEntry;
+
+static HTAB *ConnectionCache = NULL;
+
+/*
+ * Backend-local cache of remote row count estimates (use_remote_estimate),
+ * keyed by foreign table and by a hash of the COUNT query sent to the
+ * endpoint. The query itself is kept in the entry to tell hash collisions
+ * apart. Entries expire after the server's 'remote_estimate_ttl', and are
+ * removed once the cache holds RDF_ESTIMATE_CACHE_SIZE entries, see
+ * PruneEstimateCache().
+ */
+typedef struct RDFfdwEstimateCacheKey
+{
+	Oid foreigntableid;	/* FOREIGN TABLE oid */
+	uint32 queryhash;	/* hash of the COUNT query */
+} RDFfdwEstimateCacheKey;
+
+typedef struct RDFfdwEstimateCacheEntry
+{
+	RDFfdwEstimateCacheKey key;	/* hash key (must be first) */
+	char *query;				/* COUNT query, or NULL if no count was stored yet */
+	double rows;				/* number of solutions returned by the endpoint */
+	TimestampTz fetched;		/* time at which 'rows' was retrieved */
+	TimestampTz expires;		/* time at which the entry can be removed */
+} RDFfdwEstimateCacheEntry;
+
+static HTAB *EstimateCache = NULL;
+
+/*
+ * Backend-local cache of the FOREIGN TABLE metadata needed to plan a query:
+ * the columns and their OPTIONS, and the parsed 'sparql' option. Entries are
+ * keyed by FOREIGN TABLE oid and marked as invalid by TableCacheInvalCallback
+ * and TableCacheRelcacheCallback once the table or its columns are altered,
+ * so that they are loaded again when the table is used next.
+ */
+typedef struct RDFfdwTableCacheEntry
+{
+	Oid foreigntableid;		/* hash key (must be first) */
+	bool valid;				/* false once the table or its columns changed */
+	uint32 hashvalue;		/* hash value of the table's pg_foreign_table syscache entry */
+	MemoryContext cxt;		/* context holding everything below, or NULL */
+	char *relname;			/* FOREIGN TABLE name */
+	int numcols;			/* number of columns in 'rdfTable' */
+	RDFfdwTable *rdfTable;	/* columns and their OPTIONS */
+	char *deprecated_cols;	/* columns not using the rdfnode type, or NULL */
+	SPARQLQuery *query;		/* clauses of the 'sparql' OPTION, or NULL */
+} RDFfdwTableCacheEntry;
+
+static HTAB *TableCache = NULL;
+
+/*
+ * Backend-local cache of the prefixes stored in sparql.prefixes for each
+ * prefix context (RDFfdwPrefixCacheEntry), allocated in PrefixCacheContext.
+ * Statements modifying sparql.prefixes send a relcache invalidation for it
+ * (rdf_fdw_invalidate_prefixes), upon which PrefixCacheCallback marks the
+ * whole cache as invalid.
+ */
+typedef struct RDFfdwPrefixCacheEntry
+{
+	char *context;	/* prefix context */
+	List *prefixes; /* RDFPrefix entries of the context */
+} RDFfdwPrefixCacheEntry;
+
+static List *PrefixCache = NIL;
+static MemoryContext PrefixCacheContext = NULL;
+static bool PrefixCacheValid = false;
+static Oid PrefixesRelid = InvalidOid;
+
+/*
+ * State of a SPARQL SELECT result that is parsed while it is being
+ * downloaded (enable_streaming). The transfer is driven by a curl multi
+ * handle from rdfIterateForeignScan, and the write callback feeds every
+ * received chunk into a libxml2 push parser. Each <result> element is
+ * handed out as soon as it is complete and freed after being converted
+ * into a tuple, so memory is bounded by roughly one network chunk of
+ * bindings instead of the whole response.
+ */
+typedef struct RDFfdwStream
+{
+	CURLM *multi;						/* multi handle driving the transfer */
+	RDFfdwConnCacheEntry *conn;			/* cached easy handle used for the request */
+	struct curl_slist *headers;			/* HTTP headers of the request */
+	xmlParserCtxtPtr parser;			/* libxml2 push parser (SPARQL XML) */
+	SPARQLJsonParser *json;				/* SPARQL JSON push parser */
+	SPARQLTsvParser *tsv;				/* SPARQL TSV reader */
+	xmlNodePtr results;					/* <results> element, once parsed */
+	xmlNodePtr current;					/* <result> element returned by the last fetch */
+	char **row;							/* TSV row returned by the last fetch */
+	SPARQLJsonTerm *json_row;			/* JSON row returned by the last fetch */
+	CURL *curl;							/* easy handle, checked out of 'conn' */
+	struct MemoryStruct error_body;		/* response body of HTTP errors */
+	struct MemoryStruct header;			/* response headers */
+	RDFfdwScanStats *stats;				/* counters of the scan, or NULL */
+	char errbuf[CURL_ERROR_SIZE];		/* libcurl error buffer */
+	size_t received;					/* number of body bytes parsed so far */
+	long retries;						/* number of retries after network errors */
+	bool attached;						/* 'curl' is attached to 'multi' */
+	bool busy;							/* libcurl is running a callback of this stream */
+	bool done;							/* transfer finished and parser terminated */
+} RDFfdwStream;
+
+/* kinds of RDF terms in SPARQL results, see RDFNodeFromTerm() */
+typedef enum RDFfdwTermType
+{
+	RDF_TERM_IRI,
+	RDF_TERM_BNODE,
+	RDF_TERM_LITERAL
+} RDFfdwTermType;
+
+/*
+ * Entry of RDFfdwState.binding_map: columns bound to a SPARQL variable,
+ * looked up by the name attribute of a <binding> element.
+ */
+typedef struct RDFfdwBindingEntry
+{
+	char *variable; /* variable name without '?' (hash key, must be first) */
+	List *columns;	/* indexes of the columns bound to the variable */
+} RDFfdwBindingEntry;
+
+/*
+ * Argument of IsParameterMember(): the EquivalenceMember of the FOREIGN
+ * TABLE whose join clauses are being collected, and the ones that were
+ * already collected.
+ */
+typedef struct RDFfdwParamMatch
+{
+	Expr *current;		/* member currently being matched, or NULL */
+	List *already_used; /* members whose join clauses were collected */
+} RDFfdwParamMatch;
+
+/*
+ * Rows of a batched parameterized scan that match one join key of the outer
+ * table, an IRI, see LoadParameterBatch().
+ */
+typedef struct RDFfdwParamBatchEntry
+{
+	char *key;	/* IRI of the join key (hash key, must be first) */
+	List *rows; /* HeapTuples of the rows bound to 'key' */
+} RDFfdwParamBatchEntry;
+
+/* Maximum time (ms) to wait for socket activity before checking for interrupts */
+#define RDF_STREAM_POLL_TIMEOUT 1000
+
 static struct RDFfdwOption valid_options[] =
 	{
 		/* Foreign Servers */
 		{RDF_SERVER_OPTION_SELECT_URL, ForeignServerRelationId, true, false},
 		{RDF_SERVER_OPTION_UPDATE_URL, ForeignServerRelationId, false, false},
+		{RDF_SERVER_OPTION_GRAPH_STORE_URL, ForeignServerRelationId, false, false},
 		{RDF_SERVER_OPTION_FORMAT, ForeignServerRelationId, false, false},
 		{RDF_SERVER_OPTION_HTTP_PROXY, ForeignServerRelationId, false, false},
 		{RDF_SERVER_OPTION_HTTPS_PROXY, ForeignServerRelationId, false, false},
@@ -184,6 +369,13 @@ static struct RDFfdwOption valid_options[] =
 		{RDF_SERVER_OPTION_BATCH_SIZE, ForeignServerRelationId, false, false},
 		{RDF_SERVER_OPTION_READONLY, ForeignServerRelationId, false, false},
 		{RDF_SERVER_OPTION_MAX_RESPONSE_SIZE, ForeignServerRelationId, false, false},
+		{RDF_SERVER_OPTION_ENABLE_STREAMING, ForeignServerRelationId, false, false},
+		{RDF_SERVER_OPTION_USE_REMOTE_ESTIMATE, ForeignServerRelationId, false, false},
+		{RDF_SERVER_OPTION_REMOTE_ESTIMATE_TTL, ForeignServerRelationId, false, false},
+		{RDF_SERVER_OPTION_ENABLE_TERM_BINDING, ForeignServerRelationId, false, false},
+		{RDF_SERVER_OPTION_VALUES_THRESHOLD, ForeignServerRelationId, false, false},
+		{RDF_SERVER_OPTION_MAX_VALUES_SIZE, ForeignServerRelationId, false, false},
+		{RDF_SERVER_OPTION_ENABLE_DIRECT_MODIFY, ForeignServerRelationId, false, false},
 		/* Foreign Tables */
 		{RDF_TABLE_OPTION_SPARQL, ForeignTableRelationId, true, false},
 		{RDF_TABLE_OPTION_SPARQL_UPDATE_PATTERN, ForeignTableRelationId, false, false},
@@ -191,6 +383,11 @@ static struct RDFfdwOption valid_options[] =
 		{RDF_TABLE_OPTION_ENABLE_PUSHDOWN, ForeignTableRelationId, false, false},
 		{RDF_TABLE_OPTION_FETCH_SIZE, ForeignTableRelationId, false, false},
 		{RDF_TABLE_OPTION_READONLY, ForeignTableRelationId, false, false},
+		{RDF_TABLE_OPTION_ENABLE_STREAMING, ForeignTableRelationId, false, false},
+		{RDF_TABLE_OPTION_USE_REMOTE_ESTIMATE, ForeignTableRelationId, false, false},
+		{RDF_TABLE_OPTION_ENABLE_TERM_BINDING, ForeignTableRelationId, false, false},
+		{RDF_TABLE_OPTION_VALUES_THRESHOLD, ForeignTableRelationId, false, false},
+		{RDF_TABLE_OPTION_ENABLE_DIRECT_MODIFY, ForeignTableRelationId, false, false},
 		/* Options for Foreign Table's Columns */
 		{RDF_COLUMN_OPTION_VARIABLE, AttributeRelationId, true, false},
 		{RDF_COLUMN_OPTION_EXPRESSION, AttributeRelationId, false, false},
@@ -215,6 +412,7 @@ extern Datum rdf_fdw_version(PG_FUNCTION_ARGS);
 extern Datum rdf_fdw_settings(PG_FUNCTION_ARGS);
 extern Datum rdf_fdw_clone_table(PG_FUNCTION_ARGS);
 extern Datum rdf_fdw_describe(PG_FUNCTION_ARGS);
+extern Datum rdf_fdw_invalidate_prefixes(PG_FUNCTION_ARGS);
 extern Datum rdf_fdw_strstarts(PG_FUNCTION_ARGS);
 extern Datum rdf_fdw_strends(PG_FUNCTION_ARGS);
 extern Datum rdf_fdw_strbefore(PG_FUNCTION_ARGS);
@@ -456,6 +654,7 @@ PG_FUNCTION_INFO_V1(rdf_fdw_version);
 PG_FUNCTION_INFO_V1(rdf_fdw_settings);
 PG_FUNCTION_INFO_V1(rdf_fdw_clone_table);
 PG_FUNCTION_INFO_V1(rdf_fdw_describe);
+PG_FUNCTION_INFO_V1(rdf_fdw_invalidate_prefixes);
 PG_FUNCTION_INFO_V1(rdf_fdw_strstarts);
 PG_FUNCTION_INFO_V1(rdf_fdw_strends);
 PG_FUNCTION_INFO_V1(rdf_fdw_strbefore);
@@ -703,12 +902,18 @@ PG_FUNCTION_INFO_V1(interval_ge_rdfnode);
 
 static void rdfGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid);
 static void rdfGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid);
+#if PG_VERSION_NUM >= 120000
+static void rdfGetForeignJoinPaths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel, RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra);
+static void rdfGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage, RelOptInfo *input_rel, RelOptInfo *output_rel, void *extra);
+#endif
 static ForeignScan *rdfGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid, ForeignPath *best_path, List *tlist, List *scan_clauses, Plan *outer_plan);
 static void rdfBeginForeignScan(ForeignScanState *node, int eflags);
 static void rdfExplainForeignScan(ForeignScanState *node, ExplainState *es);
 static TupleTableSlot *rdfIterateForeignScan(ForeignScanState *node);
 static void rdfReScanForeignScan(ForeignScanState *node);
 static void rdfEndForeignScan(ForeignScanState *node);
+static bool rdfAnalyzeForeignTable(Relation relation, AcquireSampleRowsFunc *func, BlockNumber *totalpages);
+static int rdfAcquireSampleRows(Relation relation, int elevel, HeapTuple *rows, int targrows, double *totalrows, double *totaldeadrows);
 static void rdfAddForeignUpdateTargets(
 #if PG_VERSION_NUM >= 140000
 	PlannerInfo *root,
@@ -719,42 +924,139 @@ static void rdfAddForeignUpdateTargets(
 	RangeTblEntry *target_rte, Relation target_relation);
 static List *rdfPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation, int subplan_index);
 static void rdfBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, int eflags);
+static RDFfdwState *CreateModifyState(Relation rel, CmdType operation, int batch_size);
 static TupleTableSlot *rdfExecForeignInsert(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot);
+#if PG_VERSION_NUM >= 140000
+static TupleTableSlot **rdfExecForeignBatchInsert(EState *estate, ResultRelInfo *rinfo, TupleTableSlot **slots, TupleTableSlot **planSlots, int *numSlots);
+static int rdfGetForeignModifyBatchSize(ResultRelInfo *rinfo);
+#endif
 static TupleTableSlot *rdfExecForeignDelete(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot);
 static TupleTableSlot *rdfExecForeignUpdate(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot);
 static void rdfEndForeignModify(EState *estate, ResultRelInfo *rinfo);
 static int rdfIsForeignRelUpdatable(Relation rel);
+#if PG_VERSION_NUM >= 90600
+static bool rdfPlanDirectModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation, int subplan_index);
+static void rdfBeginDirectModify(ForeignScanState *node, int eflags);
+static TupleTableSlot *rdfIterateDirectModify(ForeignScanState *node);
+static void rdfEndDirectModify(ForeignScanState *node);
+static void rdfExplainDirectModify(ForeignScanState *node, ExplainState *es);
+static bool ContainsSPARQLVariable(const char *fragment, const char *variable);
+#endif
 #if PG_VERSION_NUM >= 110000
 static void rdfBeginForeignInsert(ModifyTableState *mtstate, ResultRelInfo *rinfo);
 static void rdfEndForeignInsert(EState *estate, ResultRelInfo *rinfo);
 static int InsertRetrievedData(RDFfdwState *state, int offset, int fetch_size);
 static Oid GetRelOidFromName(char *relname, char *code);
 #endif /*PG_VERSION_NUM */
-static Datum CreateDatum(int pgtype, int pgtypmod, char *value);
+static void InitColumnInput(RDFfdwState *state);
+static Datum CreateDatum(RDFfdwColumn *col, char *value);
+static RDFfdwDecoder GetColumnDecoder(RDFfdwColumn *col);
+static bool DecodeLexicalForm(RDFfdwDecoder decoder, const char *value, Datum *datum);
+static bool DecodeInteger(const char *value, int64 *result);
+#if PG_VERSION_NUM >= 100000
+static bool DecodeDateTime(const char *value, Datum *datum);
+static bool DecodeDigits(const char **p, int ndigits, int *result);
+#endif /* PG_VERSION_NUM */
+static Datum RDFNodeFromTerm(RDFfdwTermType type, char *value, char *datatype, char *lang);
+static bool IsVerbatimTermValue(const char *value, bool iri);
+static bool IsVerbatimDatatype(const char *datatype);
+static bool IsVerbatimLanguageTag(const char *lang);
 static List *DescribeIRI(RDFfdwState *state);
 static void LoadRDFTableInfo(RDFfdwState *state);
+static RDFfdwTableCacheEntry *GetTableCacheEntry(RDFfdwState *state);
+static void StoreTableCacheEntry(RDFfdwTableCacheEntry *entry, RDFfdwState *state, const char *relname, const char *deprecated_cols);
+static RDFfdwTable *CopyRDFfdwTable(RDFfdwTable *table, int numcols);
+static SPARQLQuery *GetSPARQLQuery(RDFfdwState *state, RDFfdwTableCacheEntry *entry);
+static void TableCacheInvalCallback(Datum arg, int cacheid, uint32 hashvalue);
+static void TableCacheRelcacheCallback(Datum arg, Oid relid);
 static void LoadRDFServerInfo(RDFfdwState *state);
 static void LoadRDFUserMapping(RDFfdwState *state);
 static int ExecuteSPARQL(RDFfdwState *state);
+static RDFfdwConnCacheEntry *GetConnection(RDFfdwState *state);
+static void ConnectionCacheInvalCallback(Datum arg, int cacheid, uint32 hashvalue);
+static struct curl_slist *SetCURLOptions(RDFfdwState *state, char *errbuf, struct MemoryStruct *chunk, struct MemoryStruct *chunk_header);
+static void UpdateConnectionStats(RDFfdwState *state, RDFfdwConnCacheEntry *conn, CURLcode res);
+static void UpdateScanStats(RDFfdwState *state, CURL *curl, long retries, size_t decoded);
+static void AddElapsedTime(double *counter, instr_time start);
+static void ReportRequestError(RDFfdwState *state, CURLcode res, long response_code, struct MemoryStruct *chunk, struct MemoryStruct *chunk_header, char *errbuf);
+static void BeginStreamingSPARQL(RDFfdwState *state, MemoryContext cxt);
+static void EndStreamingSPARQL(RDFfdwStream *stream);
+static void StreamResetCallback(void *arg);
+static void PumpStream(RDFfdwState *state);
+static void FinishStream(RDFfdwState *state, CURLcode res);
+static xmlNodePtr NextStreamedResult(RDFfdwStream *stream);
+static bool FetchNextStreamedBinding(RDFfdwState *state);
 static void CreateTuple(TupleTableSlot *slot, RDFfdwState *state);
 static void LoadRDFData(RDFfdwState *state);
 static xmlNodePtr FetchNextBinding(RDFfdwState *state);
+static char **FetchNextTsvRow(RDFfdwState *state);
+static SPARQLJsonTerm *FetchNextJsonRow(RDFfdwState *state);
+static void CreateBindingMap(RDFfdwState *state);
+static RDFfdwBindingEntry *LookupBinding(RDFfdwState *state, xmlNodePtr binding);
+static uint32 StringKeyHash(const void *key, Size keysize);
+static int StringKeyMatch(const void *key1, const void *key2, Size keysize);
+static bool BindingToDatum(RDFfdwColumn *col, xmlNodePtr binding, Datum *datum);
+static void ResolveTsvFields(RDFfdwState *state, SPARQLTsvParser *tsv);
+static Datum TsvFieldToDatum(RDFfdwColumn *col, SPARQLTsvTerm *term);
+static void CreateTupleFromTsv(TupleTableSlot *slot, RDFfdwState *state);
+static SPARQLJsonParser *CreateJsonParser(RDFfdwState *state, bool keep);
+static Datum JsonTermToDatum(RDFfdwColumn *col, SPARQLJsonTerm *term);
+static void CreateTupleFromJson(TupleTableSlot *slot, RDFfdwState *state);
 static List *SerializePlanData(RDFfdwState *state);
 static struct RDFfdwState *DeserializePlanData(List *list);
 static void InitSession(struct RDFfdwState *state, RelOptInfo *baserel, PlannerInfo *root);
 static struct RDFfdwColumn *GetRDFColumn(struct RDFfdwState *state, char *columnname);
 static void CreateSPARQL(RDFfdwState *state, PlannerInfo *root);
+static double EstimateRemoteRows(RDFfdwState *state, PlannerInfo *root);
+static void PruneEstimateCache(void);
+static double ReadRemoteCount(RDFfdwState *state, const char *variable);
+#if PG_VERSION_NUM >= 120000
+static struct RDFfdwColumn *GetRDFColumnByAttnum(struct RDFfdwState *state, AttrNumber attnum);
+static bool IsRelationPushable(RelOptInfo *rel);
+static void AppendJoinPattern(StringInfo buf, RDFfdwState *state, const char *prefix, List *names, List *targets);
+static RDFfdwState *CreateJoinState(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel, RelOptInfo *innerrel, JoinType jointype, List *restrictlist);
+static char *DeparseAggref(struct RDFfdwState *state, Aggref *aggref);
+static RDFfdwState *CreateGroupingState(PlannerInfo *root, RelOptInfo *input_rel, PathTarget *target, List *having);
+#endif
 static void SetUsedColumns(Expr *expr, struct RDFfdwState *state, int foreignrelid);
 static char *DeparseSQLLimit(struct RDFfdwState *state, PlannerInfo *root, RelOptInfo *baserel);
-static char *DeparseSQLWhereConditions(struct RDFfdwState *state, RelOptInfo *baserel);
+static char *DeparseSQLWhereConditions(struct RDFfdwState *state, RelOptInfo *baserel, PlannerInfo *root);
+static bool IsSPARQLIRIRef(char *term);
+static char *DeparseTermBinding(struct RDFfdwState *state, RelOptInfo *baserel, Expr *expr);
+static char *DeparseBindableTerm(struct RDFfdwState *state, RelOptInfo *baserel, struct RDFfdwColumn *col, Const *constant);
+static int CompareTerms(const void *a, const void *b);
+static List *DeparseValuesList(struct RDFfdwState *state, RelOptInfo *baserel, Expr *expr, bool split);
+static List *DeparseValuesBlocks(struct RDFfdwState *state, const char *sparqlvar, char **terms, int nterms, bool split);
 static char *DeparseSPARQLWhereGraphPattern(struct RDFfdwState *state);
 static char *DatumToString(Datum datum, Oid type);
 static char *DeparseExpr(struct RDFfdwState *state, RelOptInfo *foreignrel, Expr *expr);
-static char *DeparseSQLOrderBy(struct RDFfdwState *state, PlannerInfo *root, RelOptInfo *baserel);
-static char *DeparseSPARQLFrom(char *raw_sparql);
+static char *DeparseSQLOrderBy(struct RDFfdwState *state, RelOptInfo *baserel, List *pathkeys);
+static EquivalenceMember *GetEquivalenceMember(EquivalenceClass *ec, RelOptInfo *baserel);
+#if PG_VERSION_NUM >= 90600
+static bool IsSPARQLOrderSafe(struct RDFfdwState *state, RelOptInfo *baserel, List *pathkeys);
+static void AddSortedPaths(PlannerInfo *root, RelOptInfo *baserel);
+#endif
+static Path *CreateRDFScanPath(PlannerInfo *root, RelOptInfo *baserel, List *pathkeys, Relids required_outer, double rows, Cost startup_cost, Cost total_cost, List *fdw_private);
+#if PG_VERSION_NUM >= 120000
+static bool IsParameterMember(PlannerInfo *root, RelOptInfo *rel, EquivalenceClass *ec, EquivalenceMember *em, void *arg);
+static bool IsParameterClause(struct RDFfdwState *state, RelOptInfo *baserel, RestrictInfo *rinfo, struct RDFfdwColumn **column, Expr **param);
+static bool ContainsParam(Node *node, void *context);
+static void AddParameterizedPaths(PlannerInfo *root, RelOptInfo *baserel);
+static char *DeparseParameterBatch(PlannerInfo *root, Expr *param, double *outer_rows);
+static void BindParameters(ForeignScanState *node, RDFfdwState *state);
+static char *ParameterTerm(struct RDFfdwColumn *col, Datum value);
+static bool LookupParameterBatch(ForeignScanState *node, RDFfdwState *state);
+static void LoadParameterBatch(ForeignScanState *node, RDFfdwState *state);
+#endif
+static void ReleaseRemoteResult(RDFfdwState *state);
+static void SendValuesChunk(RDFfdwState *state);
+static char *DeparseSPARQLFrom(struct RDFfdwState *state);
+static const char *DeparseSPARQLModifier(struct RDFfdwState *state);
 static void ExtractSPARQLPrefixes(struct RDFfdwState *state);
 static Oid GetRDFNodeOID(void);
 static void LoadPrefixes(RDFfdwState *state);
+static List *GetContextPrefixes(const char *context);
+static void PrefixCacheCallback(Datum arg, Oid relid);
 void _PG_init(void);
 
 void _PG_init(void)
@@ -789,15 +1091,38 @@ Datum rdf_fdw_handler(PG_FUNCTION_ARGS)
 	fdwroutine->ReScanForeignScan = rdfReScanForeignScan;
 	fdwroutine->EndForeignScan = rdfEndForeignScan;
 
+#if PG_VERSION_NUM >= 120000
+	/* Join pushdown */
+	fdwroutine->GetForeignJoinPaths = rdfGetForeignJoinPaths;
+
+	/* Aggregate pushdown */
+	fdwroutine->GetForeignUpperPaths = rdfGetForeignUpperPaths;
+#endif
+
+	/* ANALYZE support */
+	fdwroutine->AnalyzeForeignTable = rdfAnalyzeForeignTable;
+
 	/* Modify callbacks (for INSERT/UPDATE/DELETE) */
 	fdwroutine->AddForeignUpdateTargets = rdfAddForeignUpdateTargets;
 	fdwroutine->PlanForeignModify = rdfPlanForeignModify;
 	fdwroutine->BeginForeignModify = rdfBeginForeignModify;
 	fdwroutine->ExecForeignInsert = rdfExecForeignInsert;
+#if PG_VERSION_NUM >= 140000
+	fdwroutine->ExecForeignBatchInsert = rdfExecForeignBatchInsert;
+	fdwroutine->GetForeignModifyBatchSize = rdfGetForeignModifyBatchSize;
+#endif
 	fdwroutine->ExecForeignUpdate = rdfExecForeignUpdate;
 	fdwroutine->ExecForeignDelete = rdfExecForeignDelete;
 	fdwroutine->EndForeignModify = rdfEndForeignModify;
 	fdwroutine->IsForeignRelUpdatable = rdfIsForeignRelUpdatable;
+#if PG_VERSION_NUM >= 90600
+	/* UPDATE and DELETE sent as a single SPARQL UPDATE */
+	fdwroutine->PlanDirectModify = rdfPlanDirectModify;
+	fdwroutine->BeginDirectModify = rdfBeginDirectModify;
+	fdwroutine->IterateDirectModify = rdfIterateDirectModify;
+	fdwroutine->EndDirectModify = rdfEndDirectModify;
+	fdwroutine->ExplainDirectModify = rdfExplainDirectModify;
+#endif
 #if PG_VERSION_NUM >= 110000
 	fdwroutine->BeginForeignInsert = rdfBeginForeignInsert;
 	fdwroutine->EndForeignInsert = rdfEndForeignInsert;
@@ -1484,50 +1809,360 @@ Datum rdf_fdw_coalesce(PG_FUNCTION_ARGS)
 	PG_RETURN_NULL();
 }
 
+/*
+ * InitColumnInput
+ * ---------------
+ *
+ * Resolves the input function of the data type of every column once, so
+ * that CreateDatum() converts values without a catalog lookup per value.
+ * Columns that were already resolved are skipped. The function info is
+ * allocated in the current memory context, which must live as long as the
+ * columns.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ */
+static void InitColumnInput(RDFfdwState *state)
+{
+	elog(DEBUG2, "%s called", __func__);
+
+	for (int i = 0; i < state->numcols; i++)
+	{
+		RDFfdwColumn *col = state->rdfTable->cols[i];
+		Oid typinput;
+
+		if (col->typinput != NULL)
+			continue;
+
+		getTypeInputInfo(col->pgtype, &typinput, &col->typioparam);
+
+		col->typinput = (FmgrInfo *)palloc0(sizeof(FmgrInfo));
+		fmgr_info(typinput, col->typinput);
+
+		/* only these types have ever been given the column's type modifier */
+		if (col->pgtype == NUMERICOID || col->pgtype == TIMESTAMPOID || col->pgtype == TIMESTAMPTZOID || col->pgtype == VARCHAROID)
+			col->typinputmod = col->pgtypmod;
+		else
+			col->typinputmod = -1;
+
+		col->decoder = GetColumnDecoder(col);
+	}
+}
+
+/*
+ * GetColumnDecoder
+ * ----------------
+ *
+ * Chooses the direct conversion of a column from its data type and the
+ * XSD datatype of its values, given by the column OPTION literaltype. A
+ * decoder only understands the lexical forms of its own XSD datatype, so
+ * columns without a literaltype, or with one that doesn't match the data
+ * type (e.g. an integer column holding xsd:string values), always go
+ * through the input function.
+ *
+ * col: column to be converted
+ *
+ * returns the decoder of the column, or RDF_DECODER_INPUT
+ */
+static RDFfdwDecoder GetColumnDecoder(RDFfdwColumn *col)
+{
+	char *xsdtype;
+	bool integer;
+
+	if (col->literaltype == NULL || strlen(col->literaltype) == 0)
+		return RDF_DECODER_INPUT;
+
+	/* xsd:int and <http://www.w3.org/2001/XMLSchema#int> are the same datatype */
+	xsdtype = ExpandDatatypePrefix(col->literaltype);
+
+	if (xsdtype[0] != '<')
+		xsdtype = psprintf("<%s>", xsdtype);
+
+	integer = get_xsd_numeric_type(xsdtype) == XSD_TYPE_INTEGER;
+
+	switch (col->pgtype)
+	{
+	case INT2OID:
+		return integer ? RDF_DECODER_INT2 : RDF_DECODER_INPUT;
+	case INT4OID:
+		return integer ? RDF_DECODER_INT4 : RDF_DECODER_INPUT;
+	case INT8OID:
+		return integer ? RDF_DECODER_INT8 : RDF_DECODER_INPUT;
+	case FLOAT8OID:
+		if (integer || strcmp(xsdtype, RDF_XSD_DECIMAL) == 0 ||
+			strcmp(xsdtype, RDF_XSD_FLOAT) == 0 || strcmp(xsdtype, RDF_XSD_DOUBLE) == 0)
+			return RDF_DECODER_FLOAT8;
+		return RDF_DECODER_INPUT;
+	case BOOLOID:
+		return strcmp(xsdtype, RDF_XSD_BOOLEAN) == 0 ? RDF_DECODER_BOOL : RDF_DECODER_INPUT;
+#if PG_VERSION_NUM >= 100000
+	case TIMESTAMPTZOID:
+		/* a precision would round the value, which is left to timestamptz_in */
+		if (strcmp(xsdtype, RDF_XSD_DATETIME) == 0 && col->pgtypmod < 0)
+			return RDF_DECODER_TIMESTAMPTZ;
+		return RDF_DECODER_INPUT;
+#endif /* PG_VERSION_NUM */
+	default:
+		return RDF_DECODER_INPUT;
+	}
+}
+
 /*
  * CreateDatum
  * -----------
  *
- * Creates a Datum from a given value based on the postgres types and modifiers.
+ * Creates a Datum of the column's data type from a given value. Canonical
+ * lexical forms of numbers and booleans are decoded directly (see
+ * DecodeLexicalForm); everything else goes through the input function
+ * resolved by InitColumnInput().
  *
- * tuple: a Heaptuple
- * pgtype: postgres type
- * pgtypemod: postgres type modifier
+ * col  : column the value belongs to
  * value: value to be converted
  *
  * returns Datum
  */
-static Datum CreateDatum(int pgtype, int pgtypmod, char *value)
+static Datum CreateDatum(RDFfdwColumn *col, char *value)
 {
-	HeapTuple tuple;
-	regproc typinput;
+	Datum datum;
 
-	elog(DEBUG3, "%s called", __func__);
+	if (col->typinput == NULL)
+		elog(ERROR, "%s: input function of column '%s' was not initialized", __func__, col->name);
 
-	tuple = SearchSysCache1(TYPEOID, ObjectIdGetDatum(pgtype));
+	if (col->decoder != RDF_DECODER_INPUT && DecodeLexicalForm(col->decoder, value, &datum))
+		return datum;
 
-	if (!HeapTupleIsValid(tuple))
-		ereport(ERROR,
-				(errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
-				 errmsg("unknown PostgreSQL type OID %u", pgtype)));
+	return InputFunctionCall(col->typinput, value, col->typioparam, col->typinputmod);
+}
 
-	typinput = ((Form_pg_type)GETSTRUCT(tuple))->typinput;
-	ReleaseSysCache(tuple);
+/*
+ * DecodeLexicalForm
+ * -----------------
+ *
+ * Converts the lexical form of an xsd:integer, xsd:double, xsd:boolean or
+ * xsd:dateTime literal straight into a Datum, without going through the
+ * type's input function. Only the strict forms XSD defines are accepted (no whitespace,
+ * no special values such as INF or NaN), for which the result is the same
+ * as the input function's. Anything else, including values out of the
+ * range of the type, is left to the input function, which also takes
+ * care of the error messages.
+ *
+ * decoder: conversion chosen for the column
+ * value  : lexical form of the literal
+ * datum  : converted value
+ *
+ * returns true if the value was converted
+ */
+static bool DecodeLexicalForm(RDFfdwDecoder decoder, const char *value, Datum *datum)
+{
+	int64 integer;
+
+	switch (decoder)
+	{
+	case RDF_DECODER_INT2:
+		if (!DecodeInteger(value, &integer) || integer < PG_INT16_MIN || integer > PG_INT16_MAX)
+			return false;
+		*datum = Int16GetDatum((int16)integer);
+		return true;
+	case RDF_DECODER_INT4:
+		if (!DecodeInteger(value, &integer) || integer < PG_INT32_MIN || integer > PG_INT32_MAX)
+			return false;
+		*datum = Int32GetDatum((int32)integer);
+		return true;
+	case RDF_DECODER_INT8:
+		if (!DecodeInteger(value, &integer))
+			return false;
+		*datum = Int64GetDatum(integer);
+		return true;
+	case RDF_DECODER_FLOAT8:
+	{
+		char *end;
+		double result;
+
+		if (*value == '\0' || strspn(value, "0123456789+-.eE") != strlen(value))
+			return false;
+
+		errno = 0;
+		result = strtod(value, &end);
+
+		/* overflow and underflow are reported by float8in */
+		if (*end != '\0' || errno != 0 || isinf(result))
+			return false;
+
+		*datum = Float8GetDatum(result);
+		return true;
+	}
+	case RDF_DECODER_BOOL:
+		if (strcmp(value, "true") == 0 || strcmp(value, "1") == 0)
+			*datum = BoolGetDatum(true);
+		else if (strcmp(value, "false") == 0 || strcmp(value, "0") == 0)
+			*datum = BoolGetDatum(false);
+		else
+			return false;
+		return true;
+#if PG_VERSION_NUM >= 100000
+	case RDF_DECODER_TIMESTAMPTZ:
+		return DecodeDateTime(value, datum);
+#endif /* PG_VERSION_NUM */
+	default:
+		return false;
+	}
+}
+
+/*
+ * DecodeInteger
+ * -------------
+ *
+ * Parses the lexical form of an xsd:integer: an optional sign followed
+ * by decimal digits.
+ *
+ * value : lexical form
+ * result: parsed value
+ *
+ * returns false if the value has any other form or doesn't fit in an int64
+ */
+static bool DecodeInteger(const char *value, int64 *result)
+{
+	const char *p = value;
+	bool negative = false;
+	uint64 magnitude = 0;
+
+	if (*p == '-' || *p == '+')
+		negative = (*p++ == '-');
+
+	if (*p == '\0')
+		return false;
+
+	for (; *p; p++)
+	{
+		if (*p < '0' || *p > '9')
+			return false;
+
+		/* stop before the magnitude exceeds the one of PG_INT64_MIN */
+		if (magnitude > ((uint64)PG_INT64_MAX + 1 - (*p - '0')) / 10)
+			return false;
+
+		magnitude = magnitude * 10 + (*p - '0');
+	}
+
+	if (!negative && magnitude > (uint64)PG_INT64_MAX)
+		return false;
+
+	*result = negative ? (int64)(0 - magnitude) : (int64)magnitude;
+
+	return true;
+}
+
+#if PG_VERSION_NUM >= 100000
+/*
+ * DecodeDateTime
+ * --------------
+ *
+ * Parses the lexical form of an xsd:dateTime with a time zone, e.g.
+ * 2024-05-01T12:30:00.5+02:00 or 2024-05-01T10:30:00Z, into a timestamptz.
+ * A value with an explicit offset doesn't depend on the session's TimeZone
+ * or DateStyle, so the result is the one of timestamptz_in. Values without
+ * a time zone, years outside 0001-9999, more than six fractional digits,
+ * 24:00:00 and leap seconds are left to the input function.
+ *
+ * value : lexical form
+ * datum : converted value
+ *
+ * returns false if the value has any other form or is out of range
+ */
+static bool DecodeDateTime(const char *value, Datum *datum)
+{
+	const char *p = value;
+	struct pg_tm tm;
+	fsec_t fsec = 0;
+	int tz = 0;
+	Timestamp result;
+
+	memset(&tm, 0, sizeof(tm));
+
+	if (!DecodeDigits(&p, 4, &tm.tm_year) || *p++ != '-' ||
+		!DecodeDigits(&p, 2, &tm.tm_mon) || *p++ != '-' ||
+		!DecodeDigits(&p, 2, &tm.tm_mday) || *p++ != 'T' ||
+		!DecodeDigits(&p, 2, &tm.tm_hour) || *p++ != ':' ||
+		!DecodeDigits(&p, 2, &tm.tm_min) || *p++ != ':' ||
+		!DecodeDigits(&p, 2, &tm.tm_sec))
+		return false;
+
+	if (tm.tm_year < 1 || tm.tm_mon < 1 || tm.tm_mon > MONTHS_PER_YEAR ||
+		tm.tm_mday < 1 || tm.tm_mday > day_tab[isleap(tm.tm_year)][tm.tm_mon - 1] ||
+		tm.tm_hour > 23 || tm.tm_min > 59 || tm.tm_sec > 59)
+		return false;
+
+	if (*p == '.')
+	{
+		int scale = USECS_PER_SEC;
+
+		if (!isdigit((unsigned char)*++p))
+			return false;
+
+		for (; isdigit((unsigned char)*p); p++)
+		{
+			if (scale == 1)
+				return false;
+
+			scale /= 10;
+			fsec += (*p - '0') * scale;
+		}
+	}
+
+	/* PostgreSQL counts time zone offsets in seconds west of UTC */
+	if (*p == 'Z')
+		p++;
+	else if (*p == '+' || *p == '-')
+	{
+		bool west = (*p++ == '-');
+		int hours;
+		int minutes;
 
-	if (pgtype == FLOAT4OID ||
-		pgtype == FLOAT8OID ||
-		pgtype == NUMERICOID ||
-		pgtype == TIMESTAMPOID ||
-		pgtype == TIMESTAMPTZOID ||
-		pgtype == VARCHAROID)
-		return OidFunctionCall3(
-			typinput,
-			CStringGetDatum(value),
-			ObjectIdGetDatum(InvalidOid),
-			Int32GetDatum(pgtypmod));
+		if (!DecodeDigits(&p, 2, &hours) || *p++ != ':' || !DecodeDigits(&p, 2, &minutes) ||
+			hours > 14 || minutes > 59 || (hours == 14 && minutes > 0))
+			return false;
+
+		tz = (hours * SECS_PER_HOUR + minutes * SECS_PER_MINUTE) * (west ? 1 : -1);
+	}
 	else
-		return OidFunctionCall1(typinput, CStringGetDatum(value));
+		return false;
+
+	if (*p != ' ' || tm2timestamp(&tm, fsec, &tz, &result) != 0 || !IS_VALID_TIMESTAMP(result))
+		return false;
+
+	*datum = TimestampTzGetDatum(result);
+
+	return true;
+}
+
+/*
+ * DecodeDigits
+ * ------------
+ *
+ * Reads exactly ndigits decimal digits and advances the position past them.
+ *
+ * p      : current position in the lexical form
+ * ndigits: number of digits to read
+ * result : parsed value
+ *
+ * returns false if there are fewer digits
+ */
+static bool DecodeDigits(const char **p, int ndigits, int *result)
+{
+	*result = 0;
+
+	for (int i = 0; i < ndigits; i++)
+	{
+		if (!isdigit((unsigned char)(*p)[i]))
+			return false;
+
+		*result = *result * 10 + ((*p)[i] - '0');
+	}
+
+	*p += ndigits;
+
+	return true;
 }
+#endif /* PG_VERSION_NUM */
 
 /*
  * DescribeIRI
@@ -1825,11 +2460,11 @@ Datum rdf_fdw_describe(PG_FUNCTION_ARGS)
 			Form_pg_attribute att = TupleDescAttr(funcctx->attinmeta->tupdesc, i);
 
 			if (strcmp(NameStr(att->attname), "subject") == 0)
-				values[i] = CreateDatum(att->atttypid, att->atttypmod, triple->subject);
+				values[i] = InputFunctionCall(&attinmeta->attinfuncs[i], triple->subject, attinmeta->attioparams[i], attinmeta->atttypmods[i]);
 			else if (strcmp(NameStr(att->attname), "predicate") == 0)
-				values[i] = CreateDatum(att->atttypid, att->atttypmod, triple->predicate);
+				values[i] = InputFunctionCall(&attinmeta->attinfuncs[i], triple->predicate, attinmeta->attioparams[i], attinmeta->atttypmods[i]);
 			else if (strcmp(NameStr(att->attname), "object") == 0)
-				values[i] = CreateDatum(att->atttypid, att->atttypmod, triple->object);
+				values[i] = InputFunctionCall(&attinmeta->attinfuncs[i], triple->object, attinmeta->attioparams[i], attinmeta->atttypmods[i]);
 			else
 				nulls[i] = true;
 		}
@@ -2172,7 +2807,7 @@ Datum rdf_fdw_clone_table(PG_FUNCTION_ARGS)
 
 	LoadPrefixes(state);
 
-	state->sparql_from = DeparseSPARQLFrom(state->raw_sparql);
+	state->sparql_from = DeparseSPARQLFrom(state);
 	elog(DEBUG2, "sparql_from = \n\n'%s'", state->sparql_from);
 
 	state->sparql_select = NameStr(select);
@@ -2184,6 +2819,13 @@ Datum rdf_fdw_clone_table(PG_FUNCTION_ARGS)
 	state->inserted_records = 0;
 	state->offset = begin_offset;
 
+	InitColumnInput(state);
+
+	/* values of the record being inserted, see InsertRetrievedData */
+	state->temp_cxt = AllocSetContextCreate(CurrentMemoryContext,
+											"rdf_fdw clone record context",
+											ALLOCSET_DEFAULT_SIZES);
+
 	if (verbose)
 		elog(INFO, "\n\n== Parameters ==\n\nforeign_table: '%s'\ntarget_table: '%s'\ncreate_table: '%s'\nfetch_size: %d\nbegin_offset: %d\nmax_records: %d\nordering_column: '%s'\nordering sparql variable: '%s'\nsort_order: '%s'\n",
 			 get_rel_name(state->foreigntableid),
@@ -2294,15 +2936,14 @@ Datum rdf_fdw_clone_table(PG_FUNCTION_ARGS)
 static int InsertRetrievedData(RDFfdwState *state, int offset, int fetch_size)
 {
 	xmlNodePtr result;
-	xmlNodePtr value;
 	xmlNodePtr record;
-	regproc typinput;
-	HeapTuple tuple;
-	Datum datum;
 	RangeVar *rv;
 	int ret = -1;
 	int processed_records = 0;
 	char *quoted_target;
+	Datum *values = (Datum *)palloc(state->numcols * sizeof(Datum));
+	bool *bound = (bool *)palloc(state->numcols * sizeof(bool));
+	MemoryContext oldcontext;
 
 	elog(DEBUG1, "%s called", __func__);
 
@@ -2315,7 +2956,7 @@ static int InsertRetrievedData(RDFfdwState *state, int offset, int fetch_size)
 	for (size_t rec = 0; rec < state->pagesize; rec++)
 	{
 		SPIPlanPtr pplan;
-		Oid *ctypes = (Oid *)palloc(state->numcols * sizeof(Oid));
+		Oid *ctypes;
 		StringInfoData insert_stmt;
 		StringInfoData insert_cols;
 		StringInfoData insert_pidx;
@@ -2324,117 +2965,103 @@ static int InsertRetrievedData(RDFfdwState *state, int offset, int fetch_size)
 		char *cnulls; /* column nulls */
 		int colindex = 0;
 
+		/* the values and statement of a record are only needed until it is inserted */
+		MemoryContextReset(state->temp_cxt);
+		oldcontext = MemoryContextSwitchTo(state->temp_cxt);
+
+		ctypes = (Oid *)palloc(state->numcols * sizeof(Oid));
 		cvals = (Datum *)palloc(state->numcols * sizeof(Datum));
 		cnulls = (char *)palloc(state->numcols * sizeof(char));
 		initStringInfo(&insert_cols);
 		initStringInfo(&insert_pidx);
 
-		record = FetchNextBinding(state);
-
 		for (int i = 0; i < state->numcols; i++)
+			bound[i] = false;
+
+		if (state->tsv)
 		{
-			char *sparqlvar = state->rdfTable->cols[i]->sparqlvar;
-			char *colname = state->rdfTable->cols[i]->name;
-			Oid pgtype = state->rdfTable->cols[i]->pgtype;
-			int pgtypmod = state->rdfTable->cols[i]->pgtypmod;
+			char **row = FetchNextTsvRow(state);
 
-			for (result = record->children; result != NULL; result = result->next)
+			if (row == NULL)
+				elog(ERROR, "%s: SPARQL TSV result has fewer rows than expected", __func__);
+
+			for (int i = 0; i < state->numcols; i++)
 			{
-				StringInfoData name;
-				xmlChar *n = xmlGetProp(result, (xmlChar *)RDF_XML_NAME_TAG);
-				initStringInfo(&name);
-				appendStringInfo(&name, "?%s", (char *)n);
-				xmlFree(n);
+				SPARQLTsvTerm term;
 
-				if (strcmp(sparqlvar, NameStr(name)) == 0 && state->rdfTable->cols[i]->used)
-				{
+				if (!state->rdfTable->cols[i]->used || state->tsv_fields[i] < 0)
+					continue;
 
-					for (value = result->children; value != NULL; value = value->next)
-					{
-						StringInfoData literal_value;
-						xmlChar *datatype = xmlGetProp(value, (xmlChar *)RDF_SPARQL_RESULT_LITERAL_DATATYPE);
-						xmlChar *lang = xmlGetProp(value, (xmlChar *)RDF_SPARQL_RESULT_LITERAL_LANG);
-						xmlChar *content = xmlNodeGetContent(value);
+				SPARQLTsvDecodeTerm(row[state->tsv_fields[i]], &term);
 
-						initStringInfo(&literal_value);
+				/* unbound variables are left out, just like in SPARQL XML results */
+				if (term.type == SPARQL_TSV_UNBOUND)
+					continue;
 
-						if (content == NULL)
-						{
-							pfree(name.data);
-							ereport(ERROR,
-									(errcode(ERRCODE_INTERNAL_ERROR),
-									 errmsg("unable to get content of XML node '%s' for column '%s'", sparqlvar, colname)));
-						}
+				values[i] = TsvFieldToDatum(state->rdfTable->cols[i], &term);
+				bound[i] = true;
+			}
+		}
+		else if (state->json)
+		{
+			SPARQLJsonTerm *row = FetchNextJsonRow(state);
 
-						if (pgtype == RDFNODEOID)
-						{
-							if (strcmp((char *)value->name, RDF_SPARQL_RESULT_URI) == 0)
-								appendStringInfo(&literal_value, "%s", iri((char *)content));
-							else if (strcmp((char *)value->name, RDF_SPARQL_RESULT_BNODE) == 0)
-								appendStringInfo(&literal_value, "_:%s", (char *)content);
-							else
-							{
-								/* Build literal with proper quote escaping */
-								char *escaped = cstring_to_rdfliteral((char *)content);
-
-								if (datatype)
-									appendStringInfo(&literal_value, "%s", strdt(escaped, (char *)datatype));
-								else if (lang)
-									appendStringInfo(&literal_value, "%s", strlang(escaped, (char *)lang));
-								else
-									appendStringInfo(&literal_value, "%s", escaped);
-							}
-						}
-						else
-							appendStringInfoString(&literal_value, (char *)content);
+			if (row == NULL)
+				elog(ERROR, "%s: SPARQL JSON result has fewer rows than expected", __func__);
 
-						datum = CStringGetDatum(literal_value.data);
-						ctypes[colindex] = pgtype;
-						cnulls[colindex] = false;
+			for (int i = 0; i < state->numcols; i++)
+			{
+				/* unbound variables are left out, just like in SPARQL XML results */
+				if (!state->rdfTable->cols[i]->used || state->json_fields[i] < 0 ||
+					row[state->json_fields[i]].type == SPARQL_JSON_UNBOUND)
+					continue;
 
-						xmlFree(content);
-						xmlFree(lang);
-						xmlFree(datatype);
+				values[i] = JsonTermToDatum(state->rdfTable->cols[i], &row[state->json_fields[i]]);
+				bound[i] = true;
+			}
+		}
+		else
+		{
+			record = FetchNextBinding(state);
 
-						if (pgtype == RDFNODEOID)
-							cvals[colindex] = DirectFunctionCall1(rdfnode_in, datum);
-						else
-						{
-							tuple = SearchSysCache1(TYPEOID, ObjectIdGetDatum(pgtype));
-
-							if (!HeapTupleIsValid(tuple))
-								ereport(ERROR,
-										(errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
-										 errmsg("cache lookup failed for type %u > column '%s'", pgtype, colname)));
-
-							typinput = ((Form_pg_type)GETSTRUCT(tuple))->typinput;
-							ReleaseSysCache(tuple);
-
-							if (pgtype == NUMERICOID || pgtype == TIMESTAMPOID || pgtype == TIMESTAMPTZOID || pgtype == VARCHAROID)
-								cvals[colindex] = OidFunctionCall3(
-									typinput,
-									datum,
-									ObjectIdGetDatum(InvalidOid),
-									Int32GetDatum(pgtypmod));
-							else
-								cvals[colindex] = OidFunctionCall1(typinput, datum);
-						}
-					}
-					colindex++;
+			/* assign each binding of the record to its columns in a single pass */
+			for (result = record->children; result != NULL; result = result->next)
+			{
+				RDFfdwBindingEntry *entry = LookupBinding(state, result);
+				ListCell *cell;
 
-					appendStringInfo(&insert_cols, "%s %s",
-									 colindex > 1 ? "," : "",
-									 quote_identifier(state->rdfTable->cols[i]->name));
+				if (entry == NULL)
+					continue;
 
-					appendStringInfo(&insert_pidx, "%s$%d",
-									 colindex > 1 ? "," : "",
-									 colindex);
-				}
+				foreach (cell, entry->columns)
+				{
+					int i = lfirst_int(cell);
 
-				pfree(name.data);
+					if (state->rdfTable->cols[i]->used)
+						bound[i] = BindingToDatum(state->rdfTable->cols[i], result, &values[i]);
+				}
 			}
 		}
 
+		for (int i = 0; i < state->numcols; i++)
+		{
+			if (!bound[i])
+				continue;
+
+			ctypes[colindex] = state->rdfTable->cols[i]->pgtype;
+			cvals[colindex] = values[i];
+			cnulls[colindex] = false;
+			colindex++;
+
+			appendStringInfo(&insert_cols, "%s %s",
+							 colindex > 1 ? "," : "",
+							 quote_identifier(state->rdfTable->cols[i]->name));
+
+			appendStringInfo(&insert_pidx, "%s$%d",
+							 colindex > 1 ? "," : "",
+							 colindex);
+		}
+
 		state->rowcount++;
 
 		initStringInfo(&insert_stmt);
@@ -2443,6 +3070,8 @@ static int InsertRetrievedData(RDFfdwState *state, int offset, int fetch_size)
 						 NameStr(insert_cols),
 						 NameStr(insert_pidx));
 
+		MemoryContextSwitchTo(oldcontext);
+
 		pplan = SPI_prepare(NameStr(insert_stmt), colindex, ctypes);
 
 		ret = SPI_execp(pplan, cvals, cnulls, 0);
@@ -2452,6 +3081,9 @@ static int InsertRetrievedData(RDFfdwState *state, int offset, int fetch_size)
 					(errcode(ERRCODE_FDW_UNABLE_TO_CREATE_EXECUTION),
 					 errmsg("SPI_execp returned %d. Unable to insert data into '%s'", ret, state->target_table_name)));
 
+		/* the plan is prepared for every record, don't keep it until SPI_finish */
+		SPI_freeplan(pplan);
+
 		if (state->commit_page)
 			SPI_commit();
 
@@ -2546,6 +3178,7 @@ Datum rdf_fdw_validator(PG_FUNCTION_ARGS)
 				}
 
 				if (strcmp(opt->optname, RDF_SERVER_OPTION_SELECT_URL) == 0 ||
+					strcmp(opt->optname, RDF_SERVER_OPTION_GRAPH_STORE_URL) == 0 ||
 					strcmp(opt->optname, RDF_SERVER_OPTION_HTTP_PROXY) == 0 ||
 					strcmp(opt->optname, RDF_SERVER_OPTION_HTTPS_PROXY) == 0)
 				{
@@ -2650,17 +3283,47 @@ Datum rdf_fdw_validator(PG_FUNCTION_ARGS)
 					}
 				}
 
-				if (strcmp(opt->optname, RDF_SERVER_OPTION_ENABLE_PUSHDOWN) == 0)
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_VALUES_THRESHOLD) == 0)
 				{
-					char *enable_pushdown = defGetString(def);
-					if (strcasecmp(enable_pushdown, "true") != 0 && strcasecmp(enable_pushdown, "false") != 0)
+					char *endptr;
+					char *threshold_str = defGetString(def);
+					long threshold_val = strtol(threshold_str, &endptr, 0);
+
+					if (threshold_str[0] == '\0' || *endptr != '\0' || threshold_val < 0 || threshold_val > INT_MAX)
+					{
 						ereport(ERROR,
 								(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
-								 errmsg("invalid %s: '%s'", def->defname, enable_pushdown),
-								 errhint("This parameter expects boolean values ('true' or 'false').")));
+								 errmsg("invalid %s: '%s'", def->defname, threshold_str),
+								 errhint("Expected a non-negative integer (number of elements, 0 = disabled).")));
+					}
 				}
 
-				if (strcmp(opt->optname, RDF_SERVER_OPTION_ENABLE_XML_HUGE) == 0)
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_MAX_VALUES_SIZE) == 0)
+				{
+					char *endptr;
+					char *max_size_str = defGetString(def);
+					long max_size_val = strtol(max_size_str, &endptr, 0);
+
+					if (max_size_str[0] == '\0' || *endptr != '\0' || max_size_val < 0)
+					{
+						ereport(ERROR,
+								(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								 errmsg("invalid %s: '%s'", def->defname, max_size_str),
+								 errhint("Expected a non-negative integer (maximum size of a VALUES block in bytes, 0 = unlimited).")));
+					}
+				}
+
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_ENABLE_PUSHDOWN) == 0)
+				{
+					char *enable_pushdown = defGetString(def);
+					if (strcasecmp(enable_pushdown, "true") != 0 && strcasecmp(enable_pushdown, "false") != 0)
+						ereport(ERROR,
+								(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								 errmsg("invalid %s: '%s'", def->defname, enable_pushdown),
+								 errhint("This parameter expects boolean values ('true' or 'false').")));
+				}
+
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_ENABLE_XML_HUGE) == 0)
 				{
 					char *enable_pushdown = defGetString(def);
 					if (strcasecmp(enable_pushdown, "true") != 0 && strcasecmp(enable_pushdown, "false") != 0)
@@ -2670,6 +3333,61 @@ Datum rdf_fdw_validator(PG_FUNCTION_ARGS)
 								 errhint("This parameter expects boolean values ('true' or 'false').")));
 				}
 
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_ENABLE_STREAMING) == 0)
+				{
+					char *enable_streaming = defGetString(def);
+					if (strcasecmp(enable_streaming, "true") != 0 && strcasecmp(enable_streaming, "false") != 0)
+						ereport(ERROR,
+								(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								 errmsg("invalid %s: '%s'", def->defname, enable_streaming),
+								 errhint("This parameter expects boolean values ('true' or 'false').")));
+				}
+
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_ENABLE_TERM_BINDING) == 0)
+				{
+					char *enable_term_binding = defGetString(def);
+					if (strcasecmp(enable_term_binding, "true") != 0 && strcasecmp(enable_term_binding, "false") != 0)
+						ereport(ERROR,
+								(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								 errmsg("invalid %s: '%s'", def->defname, enable_term_binding),
+								 errhint("This parameter expects boolean values ('true' or 'false').")));
+				}
+
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_ENABLE_DIRECT_MODIFY) == 0)
+				{
+					char *enable_direct_modify = defGetString(def);
+					if (strcasecmp(enable_direct_modify, "true") != 0 && strcasecmp(enable_direct_modify, "false") != 0)
+						ereport(ERROR,
+								(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								 errmsg("invalid %s: '%s'", def->defname, enable_direct_modify),
+								 errhint("This parameter expects boolean values ('true' or 'false').")));
+				}
+
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_USE_REMOTE_ESTIMATE) == 0)
+				{
+					char *use_remote_estimate = defGetString(def);
+					if (strcasecmp(use_remote_estimate, "true") != 0 && strcasecmp(use_remote_estimate, "false") != 0)
+						ereport(ERROR,
+								(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								 errmsg("invalid %s: '%s'", def->defname, use_remote_estimate),
+								 errhint("This parameter expects boolean values ('true' or 'false').")));
+				}
+
+				if (strcmp(opt->optname, RDF_SERVER_OPTION_REMOTE_ESTIMATE_TTL) == 0)
+				{
+					char *endptr;
+					char *ttl_str = defGetString(def);
+					long ttl_val = strtol(ttl_str, &endptr, 0);
+
+					if (ttl_str[0] == '\0' || *endptr != '\0' || ttl_val < 0)
+					{
+						ereport(ERROR,
+								(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								 errmsg("invalid %s: '%s'", def->defname, ttl_str),
+								 errhint("Expected a non-negative integer (time in seconds, 0 = estimates are not cached).")));
+					}
+				}
+
 				if (strcmp(opt->optname, RDF_TABLE_OPTION_SPARQL) == 0)
 				{
 					char *sparql = defGetString(def);
@@ -2825,6 +3543,53 @@ static void rdfGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel, Oid for
 	elog(DEBUG1, "%s called", __func__);
 
 	state->foreigntableid = foreigntableid;
+
+	InitSession(state, baserel, root);
+
+	/*
+	 * The planner assumes 1000 rows for every foreign table. Once the table
+	 * was analyzed, baserel->tuples holds the number of rows reported by the
+	 * endpoint (see rdfAcquireSampleRows), to which the selectivity of the
+	 * conditions is applied using the statistics of the columns.
+	 */
+	if (baserel->tuples > 0)
+		baserel->rows = clamp_row_est(baserel->tuples *
+									  clauselist_selectivity(root, baserel->baserestrictinfo,
+															 baserel->relid, JOIN_INNER, NULL));
+
+	/*
+	 * With use_remote_estimate the endpoint is asked how many solutions the
+	 * pushed down graph pattern and FILTER expressions have. Conditions that
+	 * could not be pushed down are applied to that number with their
+	 * selectivity, as they are evaluated locally.
+	 */
+	if (state->use_remote_estimate && state->enable_pushdown && state->is_sparql_parsable)
+	{
+		double rows = EstimateRemoteRows(state, root);
+
+		if (rows >= 0)
+		{
+			List *local_conds = NIL;
+			ListCell *cell;
+
+			foreach (cell, baserel->baserestrictinfo)
+			{
+				RestrictInfo *ri = lfirst_node(RestrictInfo, cell);
+
+				if (!list_member_ptr(state->remote_conds, ri))
+					local_conds = lappend(local_conds, ri);
+			}
+
+			rows *= clauselist_selectivity(root, local_conds, baserel->relid, JOIN_INNER, NULL);
+			baserel->rows = clamp_row_est(rows);
+
+			elog(DEBUG1, "%s: remote estimate of %.0f rows (%d local conditions)", __func__,
+				 baserel->rows, list_length(local_conds));
+		}
+	}
+	else if (state->use_remote_estimate)
+		elog(DEBUG1, "%s: use_remote_estimate ignored, as the SPARQL query cannot be pushed down", __func__);
+
 	state->startup_cost = 10000.0;
 	/* estimate total cost as startup cost + 10 * (returned rows) */
 	state->total_cost = state->startup_cost + baserel->rows * 10.0;
@@ -2835,48 +3600,153 @@ static void rdfGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid forei
 {
 	struct RDFfdwState *state = (struct RDFfdwState *)baserel->fdw_private;
 
+	add_path(baserel, CreateRDFScanPath(root, baserel, NIL, baserel->lateral_relids,
+										baserel->rows, state->startup_cost, state->total_cost, NIL));
+
+#if PG_VERSION_NUM >= 90600
+	AddSortedPaths(root, baserel);
+#endif
+
+#if PG_VERSION_NUM >= 120000
+	AddParameterizedPaths(root, baserel);
+#endif
+}
+
+#if PG_VERSION_NUM >= 120000
+static void rdfGetForeignJoinPaths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel, RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
+{
+	struct RDFfdwState *state;
+	ForeignPath *path;
+	double rows;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	/* the join was already pushed down, e.g. with outer and inner swapped */
+	if (joinrel->fdw_private)
+		return;
+
+	/*
+	 * Rows locked by SELECT FOR UPDATE/SHARE or rechecked by UPDATE/DELETE
+	 * would require a local join plan to recheck them, so only plain SELECT
+	 * statements are considered.
+	 */
+	if (root->parse->commandType != CMD_SELECT || root->rowMarks != NIL)
+		return;
+
+	if (jointype != JOIN_INNER && jointype != JOIN_LEFT)
+		return;
+
+	state = CreateJoinState(root, joinrel, outerrel, innerrel, jointype, extra->restrictlist);
+
+	if (state == NULL)
+		return;
+
+	/*
+	 * A local join sends one request for each input and fetches all their
+	 * rows, while the endpoint joins them with a single request. The joined
+	 * rows are not estimated to cost more than the rows of both inputs, as
+	 * the planner's estimate of them can be far off, e.g. with the default
+	 * selectivity of equality conditions on rdfnode columns.
+	 */
+	rows = Min(joinrel->rows, outerrel->rows + innerrel->rows);
+
+	state->startup_cost = 10000.0;
+	/* estimate total cost as startup cost + 10 * (transferred rows) */
+	state->total_cost = state->startup_cost + rows * 10.0;
+	joinrel->fdw_private = state;
+
+	path = create_foreign_join_path(root, joinrel,
+									NULL, /* default pathtarget */
+									joinrel->rows,
+#if PG_VERSION_NUM >= 180000
+									0, /* no disabled plan nodes */
+#endif
+									state->startup_cost,
+									state->total_cost,
+									NIL, /* pathkeys */
+									joinrel->lateral_relids,
+									NULL, /* fdw_outerpath */
 #if PG_VERSION_NUM >= 170000
-	Path *path = (Path *)create_foreignscan_path(root, baserel,
-												 NULL, /* pathtarget */
-												 baserel->rows,
+									NIL, /* fdw_restrictinfo */
+#endif
+									NIL); /* fdw_private */
+
+	add_path(joinrel, (Path *)path);
+}
+
+static void rdfGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage, RelOptInfo *input_rel, RelOptInfo *output_rel, void *extra)
+{
+	struct RDFfdwState *state;
+	Query *parse = root->parse;
+	GroupPathExtraData *group_extra = (GroupPathExtraData *)extra;
+	PathTarget *target;
+	ForeignPath *path;
+	double rows = 1;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	/* only aggregations of a single FOREIGN TABLE are pushed down */
+	if (stage != UPPERREL_GROUP_AGG || input_rel->reloptkind != RELOPT_BASEREL)
+		return;
+
+	if (output_rel->fdw_private)
+		return;
+
+	/* GROUPING SETS, ROLLUP and CUBE have no SPARQL equivalent */
+	if (parse->groupingSets != NIL || group_extra->patype != PARTITIONWISE_AGGREGATE_NONE)
+		return;
+
+	target = root->upper_targets[UPPERREL_GROUP_AGG];
+	state = CreateGroupingState(root, input_rel, target, (List *)group_extra->havingQual);
+
+	if (state == NULL)
+		return;
+
+	/* without GROUP BY an aggregation returns a single row */
+	if (parse->groupClause != NIL)
+		rows = estimate_num_groups(root,
+								   get_sortgrouplist_exprs(parse->groupClause, root->processed_tlist),
+								   input_rel->rows,
+								   NULL
+#if PG_VERSION_NUM >= 140000
+								   ,
+								   NULL
+#endif
+		);
+
+	/*
+	 * The endpoint sends only the groups over the wire, so the aggregation is
+	 * estimated to be cheaper than fetching all rows of the table.
+	 */
+	state->startup_cost = 10000.0;
+	state->total_cost = state->startup_cost + rows * 10.0;
+	output_rel->fdw_private = state;
+	output_rel->rows = rows;
+
+	path = create_foreign_upper_path(root, output_rel,
+									 target,
+									 rows,
 #if PG_VERSION_NUM >= 180000
-												 0, /* no parallel pathflags */
+									 0, /* no disabled plan nodes */
 #endif
-												 state->startup_cost,
-												 state->total_cost,
-												 NIL, /* pathkeys */
-												 baserel->lateral_relids,
-												 NULL,	/* fdw_outerpath */
-												 NIL,	/* fdw_restrictinfo */
-												 NULL); /* fdw_private */
-#elif PG_VERSION_NUM >= 90600
-	Path *path = (Path *)create_foreignscan_path(root, baserel,
-												 NULL, /* pathtarget */
-												 baserel->rows,
-												 state->startup_cost,
-												 state->total_cost,
-												 NIL,
-												 baserel->lateral_relids,
-												 NULL,
-												 NULL);
-#else /* PG_VERSION_NUM < 90600 (PostgreSQL 9.5) */
-	Path *path = (Path *)create_foreignscan_path(root, baserel,
-												 baserel->rows,
-												 state->startup_cost,
-												 state->total_cost,
-												 NIL,
-												 baserel->lateral_relids,
-												 NULL,
-												 NIL);
+									 state->startup_cost,
+									 state->total_cost,
+									 NIL,  /* pathkeys */
+									 NULL, /* fdw_outerpath */
+#if PG_VERSION_NUM >= 170000
+									 NIL, /* fdw_restrictinfo */
 #endif
+									 NIL); /* fdw_private */
 
-	add_path(baserel, path);
+	add_path(output_rel, (Path *)path);
 }
+#endif /* PG_VERSION_NUM >= 120000 */
 
 static ForeignScan *rdfGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid, ForeignPath *best_path, List *tlist, List *scan_clauses, Plan *outer_plan)
 {
 	struct RDFfdwState *state = (struct RDFfdwState *)baserel->fdw_private;
 	List *fdw_private = NIL;
+	List *fdw_exprs = NIL;
 	ListCell *cell;
 
 	elog(DEBUG1, "%s called", __func__);
@@ -2886,7 +3756,33 @@ static ForeignScan *rdfGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel, Oi
 		elog(DEBUG2, "%s: original scan_clauses nodeTag=%u", __func__, nodeTag(node));
 	}
 
-	InitSession(state, baserel, root);
+#if PG_VERSION_NUM >= 120000
+	/*
+	 * The SPARQL query of a join or aggregation was created by
+	 * CreateJoinState() or CreateGroupingState(), including all join clauses,
+	 * GROUP BY and HAVING. Its columns are returned in the order of
+	 * scan_tlist, which becomes the scan tuple of the plan.
+	 */
+	if (IS_JOIN_REL(baserel) || IS_UPPER_REL(baserel))
+	{
+		List *fdw_scan_tlist = add_to_flat_tlist(NIL, state->scan_tlist);
+
+		fdw_private = SerializePlanData(state);
+
+		return make_foreignscan(tlist,
+								NIL,			/* all join clauses are pushed down */
+								0,				/* no scan relation for joins and aggregations */
+								NIL,			/* no param expressions */
+								fdw_private,	/* pass along our state */
+								fdw_scan_tlist, /* columns of the join or aggregation */
+								NIL,			/* no recheck quals */
+								outer_plan);
+	}
+#endif
+
+	/* the rows are sorted for a merge join, see AddSortedPaths() */
+	if (best_path->fdw_private != NIL)
+		state->sparql_orderby = strVal(linitial(best_path->fdw_private));
 
 	if (!state->enable_pushdown)
 	{
@@ -2900,8 +3796,52 @@ static ForeignScan *rdfGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel, Oi
 	}
 	else
 	{
+		char *sparql_where = state->sparql_where;
+
+#if PG_VERSION_NUM >= 120000
+		/*
+		 * Values that are only known at execution time are bound to the graph
+		 * pattern by BindParameters(): the join keys of the outer row of a
+		 * parameterized path, and Params, e.g. of prepared statements with a
+		 * generic plan or of InitPlans. The executor computes them from
+		 * fdw_exprs, and BindParameters() replaces the marker with them. The
+		 * conditions are evaluated locally as well. Scans whose IN list is
+		 * split into several requests are not parameterized.
+		 */
+		state->param_columns = NIL;
+
+		foreach (cell, scan_clauses)
+		{
+			RestrictInfo *rinfo = lfirst_node(RestrictInfo, cell);
+			struct RDFfdwColumn *col;
+			Expr *param;
+
+			if (state->values_chunks != NIL || list_member_ptr(state->remote_conds, rinfo) ||
+				!IsParameterClause(state, baserel, rinfo, &col, &param))
+				continue;
+
+			if (bms_is_subset(rinfo->clause_relids, baserel->relids) && !ContainsParam((Node *)param, NULL))
+				continue;
+
+			elog(DEBUG2, "  %s: binding '%s' at execution time", __func__, col->sparqlvar);
+			fdw_exprs = lappend(fdw_exprs, param);
+			state->param_columns = lappend(state->param_columns, makeString(col->name));
+		}
+
+		if (state->param_columns != NIL)
+			state->sparql_where = psprintf("\n %s\n%s", RDF_SPARQL_PARAMETERS_MARKER, sparql_where);
+
+		/* the join keys of all outer rows may be sent at once, see LoadParameterBatch() */
+		if (list_length(fdw_exprs) == 1)
+		{
+			double outer_rows;
+
+			state->param_batch_sql = DeparseParameterBatch(root, (Expr *)linitial(fdw_exprs), &outer_rows);
+		}
+#endif
 		elog(DEBUG2, "  %s: SPARQL is parsable, calling CreateSPARQL()", __func__);
 		CreateSPARQL(state, root);
+		state->sparql_where = sparql_where;
 	}
 
 	/*
@@ -2938,7 +3878,7 @@ static ForeignScan *rdfGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel, Oi
 		return make_foreignscan(tlist,
 								local_exprs, /* quals PostgreSQL evaluates locally */
 								baserel->relid,
-								NIL,		 /* no param expressions */
+								fdw_exprs,	 /* values bound to a parameterized scan */
 								fdw_private, /* pass along our state */
 								NIL,		 /* no custom tlist */
 								NIL,		 /* no recheck quals */
@@ -2962,9 +3902,72 @@ static void rdfBeginForeignScan(ForeignScanState *node, int eflags)
 		return;
 	}
 
+	InitColumnInput(state);
+
+	/* counters shown by EXPLAIN (ANALYZE), see rdfExplainForeignScan */
+	if (node->ss.ps.instrument)
+	{
+		state->stats = (RDFfdwScanStats *)palloc0(sizeof(RDFfdwScanStats));
+		state->stats->timing = node->ss.ps.instrument->need_timer;
+	}
+
+	/* values of the current row, see rdfIterateForeignScan */
+	state->temp_cxt = AllocSetContextCreate(CurrentMemoryContext,
+											"rdf_fdw tuple context",
+											ALLOCSET_DEFAULT_SIZES);
+
 	elog(DEBUG2, "%s: initializing XML parser", __func__);
 
-	LoadRDFData(state);
+#if PG_VERSION_NUM >= 120000
+	if (fs->fdw_exprs != NIL)
+	{
+		/*
+		 * The request of a parameterized scan is sent once the values of the
+		 * outer row are known, see BindParameters(). Its result is kept in a
+		 * context of its own, which is reset for every new set of values.
+		 */
+		state->param_exprs = ExecInitExprList(fs->fdw_exprs, (PlanState *)node);
+		state->sparql_params = state->sparql;
+		state->param_cxt = AllocSetContextCreate(CurrentMemoryContext,
+												 "rdf_fdw parameter context",
+												 ALLOCSET_DEFAULT_SIZES);
+		state->params_bound = false;
+		CreateBindingMap(state);
+
+		if (state->param_batch_sql != NULL)
+			state->param_batch_cxt = AllocSetContextCreate(CurrentMemoryContext,
+														   "rdf_fdw parameter batch context",
+														   ALLOCSET_DEFAULT_SIZES);
+	}
+	else
+#endif
+	if (state->values_chunks != NIL)
+	{
+		/*
+		 * An IN list too large for a single request is sent in several
+		 * requests, one for every VALUES block, see SendValuesChunk().
+		 */
+		state->sparql_params = state->sparql;
+		state->param_cxt = AllocSetContextCreate(CurrentMemoryContext,
+												 "rdf_fdw values context",
+												 ALLOCSET_DEFAULT_SIZES);
+		state->values_chunk = 0;
+		CreateBindingMap(state);
+	}
+	else if (state->enable_streaming)
+	{
+		/*
+		 * The streamed request is kept in a context of its own, which is
+		 * reset when the request is sent again on a rescan.
+		 */
+		state->param_cxt = AllocSetContextCreate(CurrentMemoryContext,
+												 "rdf_fdw stream context",
+												 ALLOCSET_DEFAULT_SIZES);
+		BeginStreamingSPARQL(state, state->param_cxt);
+	}
+	else
+		LoadRDFData(state);
+
 	state->rowcount = 0;
 	node->fdw_state = (void *)state;
 }
@@ -2982,6 +3985,14 @@ static void rdfExplainForeignScan(ForeignScanState *node, ExplainState *es)
 		{
 			ExplainPropertyText("Pushdown", "enabled", es);
 
+			/* graph pattern of the join, in a single line */
+			if (state->is_join)
+				ExplainPropertyText("Remote Join", str_replace(state->sparql_where, "\n", " "), es);
+
+			/* graph pattern with the bound terms, see DeparseTermBinding() */
+			else if (state->sparql_values)
+				ExplainPropertyText("Remote Pattern", str_replace(state->sparql_where, "\n", " "), es);
+
 			if (state->sparql_select && strlen(state->sparql_select) > 0)
 				ExplainPropertyText("Remote Select", state->sparql_select, es);
 
@@ -2991,6 +4002,38 @@ static void rdfExplainForeignScan(ForeignScanState *node, ExplainState *es)
 			else if (state->has_unparsable_conds)
 				ExplainPropertyText("Remote Filter", "not pushable", es);
 
+			/* variables bound to the values of the outer row, see BindParameters() */
+			if (state->param_columns != NIL)
+			{
+				StringInfoData params;
+				ListCell *cell;
+
+				initStringInfo(&params);
+
+				foreach (cell, state->param_columns)
+				{
+					struct RDFfdwColumn *col = GetRDFColumn(state, strVal(lfirst(cell)));
+
+					appendStringInfo(&params, "%s%s", params.len > 0 ? ", " : "", col->sparqlvar);
+				}
+
+				/* the join keys of all outer rows are sent at once, see LoadParameterBatch() */
+				if (state->param_batch_sql != NULL)
+					appendStringInfoString(&params, " (batched)");
+
+				ExplainPropertyText("Remote Parameters", params.data, es);
+			}
+
+			/* IN list sent in several requests, see SendValuesChunk() */
+			if (state->values_chunks != NIL)
+				ExplainPropertyText("Remote Requests", psprintf("%d", list_length(state->values_chunks)), es);
+
+			if (state->sparql_groupby && strlen(state->sparql_groupby) > 0)
+				ExplainPropertyText("Remote Group By", state->sparql_groupby, es);
+
+			if (state->sparql_having && strlen(state->sparql_having) > 0)
+				ExplainPropertyText("Remote Having", state->sparql_having, es);
+
 			if (state->sparql_orderby && strlen(state->sparql_orderby) > 0)
 				ExplainPropertyText("Remote Sort Key", state->sparql_orderby, es);
 
@@ -2999,6 +4042,27 @@ static void rdfExplainForeignScan(ForeignScanState *node, ExplainState *es)
 		}
 		else
 			ExplainPropertyText("Pushdown", "disabled", es);
+
+		/* counters of the executed scan, see RDFfdwScanStats */
+		if (es->analyze && state->stats)
+		{
+			RDFfdwScanStats *stats = state->stats;
+
+			ExplainPropertyText("HTTP Requests", psprintf("%ld", stats->requests), es);
+			ExplainPropertyText("HTTP Retries", psprintf("%ld", stats->retries), es);
+			ExplainPropertyText("Remote Rows", psprintf("%ld", stats->rows), es);
+			ExplainPropertyText("Response Bytes", psprintf("%.0f", stats->bytes), es);
+			ExplainPropertyText("Response Bytes Decoded", psprintf("%.0f", stats->bytes_decoded), es);
+
+			if (es->timing && stats->timing)
+			{
+				ExplainPropertyText("Connect Time", psprintf("%.3f ms", stats->connect_time), es);
+				ExplainPropertyText("Time to First Byte", psprintf("%.3f ms", stats->first_byte_time), es);
+				ExplainPropertyText("Transfer Time", psprintf("%.3f ms", stats->transfer_time), es);
+				ExplainPropertyText("Parse Time", psprintf("%.3f ms", stats->parse_time), es);
+				ExplainPropertyText("Conversion Time", psprintf("%.3f ms", stats->conversion_time), es);
+			}
+		}
 	}
 }
 
@@ -3006,6 +4070,7 @@ static TupleTableSlot *rdfIterateForeignScan(ForeignScanState *node)
 {
 	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
 	struct RDFfdwState *state = (struct RDFfdwState *)node->fdw_state;
+	MemoryContext oldcontext;
 
 	elog(DEBUG3, "%s called", __func__);
 
@@ -3015,12 +4080,72 @@ static TupleTableSlot *rdfIterateForeignScan(ForeignScanState *node)
 		return NULL;
 	}
 
+#if PG_VERSION_NUM >= 120000
+	/* send the request with the current values of the parameters */
+	if (state->param_exprs != NIL && !state->params_bound)
+		BindParameters(node, state);
+
+	/* rows of the current join key of a batched scan, see LoadParameterBatch() */
+	if (state->param_batch_entry != NULL)
+	{
+		if (state->param_batch_pos >= list_length(state->param_batch_entry->rows))
+			return NULL;
+
+		ExecForceStoreHeapTuple((HeapTuple)list_nth(state->param_batch_entry->rows, state->param_batch_pos++),
+								slot, false);
+		return slot;
+	}
+#endif
+
+	/* send the request of the first VALUES block of a split IN list */
+	if (state->values_chunks != NIL && state->values_chunk == 0)
+		SendValuesChunk(state);
+
 	elog(DEBUG3, "  %s: rowcount = %d | pagesize = %d", __func__, state->rowcount, state->pagesize);
 
-	if (state->rowcount >= state->pagesize)
-		return NULL;
+	for (;;)
+	{
+		if (state->stream)
+		{
+			/* wait for the next record to arrive from the endpoint */
+			if (FetchNextStreamedBinding(state))
+			{
+				if (state->stats)
+					state->stats->rows++;
+				break;
+			}
+		}
+		else if (state->rowcount < state->pagesize)
+			break;
+
+		/* the results of a split IN list continue with the next VALUES block */
+		if (state->values_chunk >= list_length(state->values_chunks))
+			return NULL;
+
+		SendValuesChunk(state);
+	}
+
+	/*
+	 * Everything allocated while converting a row, including its Datums, goes
+	 * into a context that is reset when the next row is requested, by which
+	 * time the executor is done with the previous contents of the slot. This
+	 * keeps the memory usage of a scan independent of its number of rows.
+	 */
+	MemoryContextReset(state->temp_cxt);
+	oldcontext = MemoryContextSwitchTo(state->temp_cxt);
+
+	if (state->stats && state->stats->timing)
+	{
+		instr_time start;
+
+		INSTR_TIME_SET_CURRENT(start);
+		CreateTuple(slot, state);
+		AddElapsedTime(&state->stats->conversion_time, start);
+	}
+	else
+		CreateTuple(slot, state);
 
-	CreateTuple(slot, state);
+	MemoryContextSwitchTo(oldcontext);
 
 	elog(DEBUG3, "%s: virtual tuple stored (%d/%d)", __func__, state->rowcount, state->pagesize);
 	elog(DEBUG3, "%s: valid slots = %d", __func__, slot->tts_nvalid);
@@ -3041,9 +4166,34 @@ static void rdfReScanForeignScan(ForeignScanState *node)
      * the already-fetched result page.  The fetched records list is NOT
      * cleared because rdf_fdw batches the entire SPARQL result set into
      * memory during BeginForeignScan; there is nothing to re-fetch.
+     * Streamed results are discarded as they are consumed, so in that case
+     * the request is sent again. So is the request of a parameterized scan
+     * whose values have changed, i.e. for every new outer row, and so are
+     * the requests of a split IN list.
      */
-    if (state)
+#if PG_VERSION_NUM >= 120000
+    if (state && state->param_exprs != NIL && (node->ss.ps.chgParam != NULL || state->stream))
+        state->params_bound = false;
+    else
+#endif
+    if (state && state->values_chunks != NIL)
+        state->values_chunk = 0;
+    else if (state && state->stream)
+    {
+        /* the reset callback of the context closes the request */
+        MemoryContextReset(state->param_cxt);
+        BeginStreamingSPARQL(state, state->param_cxt);
+    }
+    else if (state)
+    {
         state->rowcount = 0;
+        state->param_batch_pos = 0;
+
+        if (state->tsv)
+            SPARQLTsvRewind(state->tsv);
+        else if (state->json)
+            SPARQLJsonRewind(state->json);
+    }
 }
 
 static void rdfEndForeignScan(ForeignScanState *node)
@@ -3063,6 +4213,24 @@ static void rdfEndForeignScan(ForeignScanState *node)
 			xmlFreeDoc(state->xmldoc);
 		}
 
+		if (state->stream)
+		{
+			elog(DEBUG2, "%s: closing streamed request", __func__);
+			EndStreamingSPARQL(state->stream);
+		}
+
+		if (state->tsv)
+		{
+			elog(DEBUG2, "%s: freeing TSV result", __func__);
+			SPARQLTsvFreeParser(state->tsv);
+		}
+
+		if (state->json)
+		{
+			elog(DEBUG2, "%s: freeing JSON result", __func__);
+			SPARQLJsonFreeParser(state->json);
+		}
+
 		elog(DEBUG2, "%s: freeing rdf_fdw state", __func__);
 		pfree(state);
 	}
@@ -3070,6 +4238,208 @@ static void rdfEndForeignScan(ForeignScanState *node)
 	elog(DEBUG1, "%s exit rdf_fdw: so long .. \n", __func__);
 }
 
+/*
+ * rdfAnalyzeForeignTable
+ * ----------------------
+ * ANALYZE support: the sample rows are fetched from the SPARQL endpoint by
+ * rdfAcquireSampleRows(). Foreign tables have no pages of their own, so
+ * only a nominal page count is reported.
+ */
+static bool rdfAnalyzeForeignTable(Relation relation, AcquireSampleRowsFunc *func, BlockNumber *totalpages)
+{
+	elog(DEBUG1, "%s called", __func__);
+
+	*func = rdfAcquireSampleRows;
+	*totalpages = 1;
+
+	return true;
+}
+
+/*
+ * rdfAcquireSampleRows
+ * --------------------
+ * Collects a random sample of up to 'targrows' rows of a foreign table for
+ * ANALYZE. The number of solutions of the graph pattern is first retrieved
+ * with a COUNT query (see EstimateRemoteRows), and the sample is then read
+ * in RDF_ANALYZE_SAMPLE_WINDOWS windows of LIMIT/OFFSET spread evenly over
+ * the result set, each starting at a random offset within its stride. The
+ * records are converted into rows by CreateTuple(), as in a scan, and kept
+ * with reservoir sampling.
+ *
+ * SPARQL queries that cannot be rewritten (see IsSPARQLParsable) are sent
+ * as they are, and the sample is taken from the complete result set.
+ *
+ * The remote count is returned in 'totalrows', so that it is stored in
+ * pg_class.reltuples and used by the planner for the row estimates of the
+ * table.
+ */
+static int rdfAcquireSampleRows(Relation relation, int elevel, HeapTuple *rows, int targrows, double *totalrows, double *totaldeadrows)
+{
+	RDFfdwState *state = (RDFfdwState *)palloc0(sizeof(RDFfdwState));
+	TupleDesc tupdesc = RelationGetDescr(relation);
+	TupleTableSlot *slot;
+	MemoryContext oldcontext;
+	StringInfoData select;
+	double remote_rows = -1;
+	double samplerows = 0;
+	int numrows = 0;
+	int windows = 1;
+	int window_size = targrows;
+	long stride = 0;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	state->foreigntableid = RelationGetRelid(relation);
+	state->foreign_table = GetForeignTable(state->foreigntableid);
+	state->server = GetForeignServer(state->foreign_table->serverid);
+	state->enable_pushdown = true;
+	state->query_param = RDF_DEFAULT_QUERY_PARAM;
+	state->format = RDF_DEFAULT_FORMAT;
+	state->connect_timeout = RDF_DEFAULT_CONNECTTIMEOUT;
+	state->request_timeout = RDF_DEFAULT_REQUEST_TIMEOUT;
+	state->max_retries = RDF_DEFAULT_MAXRETRY;
+	state->sparql_query_type = SPARQL_SELECT;
+
+	LoadRDFServerInfo(state);
+	LoadRDFTableInfo(state);
+	LoadRDFUserMapping(state);
+
+	/* all columns are analyzed */
+	initStringInfo(&select);
+	for (int i = 0; i < state->numcols; i++)
+	{
+		if (!state->rdfTable->cols[i]->sparqlvar)
+			continue;
+
+		state->rdfTable->cols[i]->used = true;
+
+		if (!state->rdfTable->cols[i]->expression)
+			appendStringInfo(&select, "%s ", state->rdfTable->cols[i]->sparqlvar);
+		else
+			appendStringInfo(&select, "(%s AS %s) ",
+							 state->rdfTable->cols[i]->expression,
+							 state->rdfTable->cols[i]->sparqlvar);
+	}
+
+	LoadPrefixes(state);
+
+	state->sparql_select = select.data;
+	state->sparql_from = DeparseSPARQLFrom(state);
+	state->sparql_where = DeparseSPARQLWhereGraphPattern(state);
+	state->sparql_filter = "";
+
+	if (state->is_sparql_parsable)
+	{
+		/* ANALYZE always asks for a fresh count */
+		state->remote_estimate_ttl = 0;
+		remote_rows = EstimateRemoteRows(state, NULL);
+
+		if (remote_rows > targrows)
+		{
+			windows = RDF_ANALYZE_SAMPLE_WINDOWS;
+			window_size = (targrows + windows - 1) / windows;
+			stride = (long)(remote_rows / windows);
+		}
+	}
+
+	InitColumnInput(state);
+
+	state->temp_cxt = AllocSetContextCreate(CurrentMemoryContext,
+											"rdf_fdw analyze record context",
+											ALLOCSET_DEFAULT_SIZES);
+
+#if PG_VERSION_NUM >= 120000
+	slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+#else
+	slot = MakeSingleTupleTableSlot(tupdesc);
+#endif
+
+	for (int w = 0; w < windows; w++)
+	{
+		StringInfoData limit_clause;
+		long offset = 0;
+
+		CHECK_FOR_INTERRUPTS();
+
+		state->pagesize = 0;
+		state->rowcount = 0;
+
+		if (!state->is_sparql_parsable)
+			state->sparql = state->raw_sparql;
+		else
+		{
+			/*
+			 * Without an ORDER BY the solutions of each window depend on the
+			 * order in which the endpoint returns them, which is good enough
+			 * for a sample and much cheaper than sorting the result set.
+			 */
+			if (stride > window_size)
+				offset = w * stride + (long)(anl_random_fract() * (stride - window_size));
+
+			initStringInfo(&limit_clause);
+			appendStringInfo(&limit_clause, "OFFSET %ld LIMIT %d", offset, window_size);
+			state->sparql_limit = limit_clause.data;
+
+			CreateSPARQL(state, NULL);
+		}
+
+		LoadRDFData(state);
+
+		while (state->rowcount < state->pagesize)
+		{
+			int pos = -1;
+
+			MemoryContextReset(state->temp_cxt);
+			oldcontext = MemoryContextSwitchTo(state->temp_cxt);
+			CreateTuple(slot, state);
+			MemoryContextSwitchTo(oldcontext);
+
+			state->rowcount++;
+
+			/* reservoir sampling (Vitter's algorithm R) */
+			if (numrows < targrows)
+				pos = numrows++;
+			else
+			{
+				pos = (int)((samplerows + 1) * anl_random_fract());
+
+				if (pos >= targrows)
+					pos = -1;
+				else
+					heap_freetuple(rows[pos]);
+			}
+
+			if (pos >= 0)
+				rows[pos] = heap_form_tuple(tupdesc, slot->tts_values, slot->tts_isnull);
+
+			samplerows++;
+		}
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+
+	if (state->xmldoc)
+		xmlFreeDoc(state->xmldoc);
+
+	if (state->tsv)
+		SPARQLTsvFreeParser(state->tsv);
+
+	if (state->json)
+		SPARQLJsonFreeParser(state->json);
+
+	MemoryContextDelete(state->temp_cxt);
+
+	*totalrows = remote_rows >= 0 ? remote_rows : samplerows;
+	*totaldeadrows = 0;
+
+	ereport(elevel,
+			(errmsg("\"%s\": table contains %.0f rows, %d rows in sample",
+					RelationGetRelationName(relation), *totalrows, numrows)));
+
+	elog(DEBUG1, "%s exit: returning %d rows", __func__, numrows);
+	return numrows;
+}
+
 /*
  * rdfAddForeignUpdateTargets
  * ------------------------------
@@ -3210,8 +4580,6 @@ static List *rdfPlanForeignModify(PlannerInfo *root, ModifyTable *plan,
 static void rdfBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinfo,
 								  List *fdw_private, int subplan_index, int eflags)
 {
-	RDFfdwState *state;
-	Relation rel = rinfo->ri_RelationDesc;
 	CmdType operation = mtstate->operation;
 
 	elog(DEBUG1, "%s called", __func__);
@@ -3222,6 +4590,28 @@ static void rdfBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinf
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("unsupported operation type: %d", operation)));
 
+	/* Store state in ResultRelInfo */
+	rinfo->ri_FdwState = CreateModifyState(rinfo->ri_RelationDesc, operation, RDF_DEFAULT_BATCH_SIZE);
+
+	elog(DEBUG1, "%s exit", __func__);
+}
+
+/*
+ * CreateModifyState
+ * -----------------
+ * Loads the SERVER, FOREIGN TABLE and USER MAPPING info needed to modify
+ * the triples of 'rel', checks its 'sparql_update_pattern' and sets up the
+ * batch buffer. Shared by INSERT, UPDATE and DELETE statements and by COPY
+ * FROM.
+ *
+ * rel       : foreign table to be modified
+ * operation : CMD_INSERT, CMD_DELETE or CMD_UPDATE
+ * batch_size: number of rows per request, unless the SERVER sets batch_size
+ */
+static RDFfdwState *CreateModifyState(Relation rel, CmdType operation, int batch_size)
+{
+	RDFfdwState *state;
+
 	/* Create and initialize the FDW state */
 	state = (RDFfdwState *)palloc0(sizeof(RDFfdwState));
 	state->foreigntableid = RelationGetRelid(rel);
@@ -3235,7 +4625,7 @@ static void rdfBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinf
 	state->request_timeout = RDF_DEFAULT_REQUEST_TIMEOUT;
 	state->max_retries = RDF_DEFAULT_MAXRETRY;
 	state->fetch_size = RDF_DEFAULT_FETCH_SIZE;
-	state->batch_size = RDF_DEFAULT_BATCH_SIZE;
+	state->batch_size = batch_size;
 	state->foreign_table = GetForeignTable(state->foreigntableid);
 	state->server = GetForeignServer(state->foreign_table->serverid);
 
@@ -3281,6 +4671,36 @@ static void rdfBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinf
 	/* Validate SPARQL update pattern and variable mapping */
 	ValidateSPARQLUpdatePattern(state);
 
+	/*
+	 * Inserts are loaded through the Graph Store Protocol if the server has
+	 * a graph_store_url. The pattern is serialized once here, with its
+	 * variables, to reject constructs N-Triples cannot express before any
+	 * row is sent, and to find out whether it writes into named graphs.
+	 */
+	if (operation == CMD_INSERT && state->graph_store_url)
+	{
+		StringInfoData ntriples;
+		bool has_graph = false;
+		char *errmsg;
+
+		initStringInfo(&ntriples);
+		if (!SPARQLTriplesToNTriples(&ntriples, state->sparql_update_pattern, state->prefixes,
+									 true, &has_graph, &errmsg))
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					 errmsg("'%s' cannot be sent to '%s': %s",
+							RDF_TABLE_OPTION_SPARQL_UPDATE_PATTERN, RDF_SERVER_OPTION_GRAPH_STORE_URL, errmsg),
+					 errhint("Remove the '%s' option of the SERVER to insert with SPARQL UPDATE.",
+							 RDF_SERVER_OPTION_GRAPH_STORE_URL)));
+		pfree(ntriples.data);
+
+		state->endpoint = state->graph_store_url;
+		state->graph_store_format = has_graph ? SPARQL_NQUADS_CONTENT_TYPE : SPARQL_NTRIPLES_CONTENT_TYPE;
+
+		elog(DEBUG1, "%s: loading inserts into '%s' as %s", __func__,
+			 state->endpoint, state->graph_store_format);
+	}
+
 	/* Validate that all mapped columns are of type rdfnode */
 	for (int i = 0; i < state->numcols; i++)
 	{
@@ -3306,10 +4726,38 @@ static void rdfBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinf
 	state->batch_count = 0;
 	initStringInfo(&state->batch_statements);
 
-	/* Store state in ResultRelInfo */
-	rinfo->ri_FdwState = state;
+	return state;
+}
 
-	elog(DEBUG1, "%s exit", __func__);
+/*
+ * AppendDataBlock
+ * ---------------
+ * Adds the triples of a row to the batch buffer. Consecutive rows of the
+ * same operation are collected in a single INSERT DATA or DELETE DATA block,
+ * so that the triplestore parses and applies the whole batch as one
+ * operation instead of one per row. A row of the other operation closes the
+ * block and opens a new one, which keeps the inserts and deletes in the
+ * order of the rows. The last block is closed by FlushSPARQLStatements().
+ *
+ * state    : SPARQL, SERVER and FOREIGN TABLE info
+ * operation: SPARQL_INSERT or SPARQL_DELETE
+ * triples  : triples of the row, without a trailing dot
+ */
+static void AppendDataBlock(RDFfdwState *state, RDFfdwQueryType operation, const char *triples)
+{
+	if (state->batch_statements.len > 0 && state->batch_block == operation)
+	{
+		appendStringInfo(&state->batch_statements, " .\n%s", triples);
+		return;
+	}
+
+	if (state->batch_statements.len > 0)
+		appendStringInfoString(&state->batch_statements, " };\n");
+
+	appendStringInfo(&state->batch_statements, "%s DATA { %s",
+					 operation == SPARQL_INSERT ? "INSERT" : "DELETE", triples);
+
+	state->batch_block = operation;
 }
 
 /*
@@ -3319,33 +4767,60 @@ static void rdfBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *rinf
  */
 static void FlushSPARQLStatements(RDFfdwState *state)
 {
-	StringInfoData final_query;
+	RDFfdwRequestBody body;
+	MemoryContext oldcontext;
 
 	if (state->batch_count == 0)
 		return;
 
 	elog(DEBUG1, "%s: flushing batch of %d statement(s)", __func__, state->batch_count);
 
-	initStringInfo(&final_query);
+	/*
+	 * The request is built and sent in the temporary context, which is reset
+	 * afterwards, so that memory does not grow with the number of batches
+	 * of large INSERT ... SELECT and COPY FROM statements.
+	 */
+	MemoryContextReset(state->temp_cxt);
+	oldcontext = MemoryContextSwitchTo(state->temp_cxt);
 
-	/* Add prefixes if needed */
-	if (state->prefix_context)
+	memset(&body, 0, sizeof(RDFfdwRequestBody));
+	body.parts[0] = "";
+	body.parts[1] = state->batch_statements.data;
+	body.parts[2] = "";
+
+	/* N-Triples and N-Quads are sent as they are, with full IRIs */
+	if (!state->graph_store_format)
 	{
-		appendStringInfoString(&final_query, state->sparql_prefixes);
-		appendStringInfoString(&final_query, "\n");
+		/* Add prefixes if needed */
+		if (state->prefix_context)
+			body.parts[0] = psprintf("%s\n", state->sparql_prefixes);
+
+		/* Close the last data block */
+		body.parts[2] = " };\n";
 	}
 
-	/* Append all batched statements */
-	appendStringInfoString(&final_query, state->batch_statements.data);
+	for (int i = 0; i < 3; i++)
+		body.lengths[i] = strlen(body.parts[i]);
 
-	/* Execute the batched statements */
-	state->sparql = final_query.data;
+	/*
+	 * Execute the batched statements. The body is read by libcurl from the
+	 * batch buffer, instead of being copied into a single query string.
+	 */
+	state->sparql = NULL;
+	state->sparql_resultset = NULL;
+	state->request_body = &body;
 
 	if (ExecuteSPARQL(state) != REQUEST_SUCCESS)
 		ereport(ERROR,
 				(errcode(ERRCODE_FDW_ERROR),
 				 errmsg("failed to execute batched SPARQL statements")));
 
+	state->request_body = NULL;
+	state->sparql_resultset = NULL;
+
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(state->temp_cxt);
+
 	/* Reset batch buffer */
 	resetStringInfo(&state->batch_statements);
 	state->batch_count = 0;
@@ -3353,12 +4828,18 @@ static void FlushSPARQLStatements(RDFfdwState *state)
 	elog(DEBUG1, "%s: batch flushed successfully", __func__);
 }
 
-static TupleTableSlot *rdfExecForeignInsert(EState *estate,
-											ResultRelInfo *rinfo,
-											TupleTableSlot *slot,
-											TupleTableSlot *planSlot)
+/*
+ * AppendInsertStatement
+ * ---------------------
+ * Substitutes the variables of 'sparql_update_pattern' with the values of
+ * the row in 'slot' and adds the resulting INSERT DATA statement to the
+ * batch buffer, which is sent by FlushSPARQLStatements().
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ * slot : row to be inserted
+ */
+static void AppendInsertStatement(RDFfdwState *state, TupleTableSlot *slot)
 {
-	RDFfdwState *state;
 	TupleDesc tupdesc = slot->tts_tupleDescriptor;
 	MemoryContext oldcontext;
 	StringInfoData sparql_insert;
@@ -3366,15 +4847,6 @@ static TupleTableSlot *rdfExecForeignInsert(EState *estate,
 	Datum datum;
 	bool isnull;
 
-	elog(DEBUG1, "%s called", __func__);
-
-	/* State must be initialized by rdfBeginForeignModify */
-	state = (RDFfdwState *)rinfo->ri_FdwState;
-	if (!state)
-		ereport(ERROR,
-				(errcode(ERRCODE_INTERNAL_ERROR),
-				 errmsg("%s failed to initialize state", __func__)));
-
 	/* Switch to temporary context for per-row allocations */
 	MemoryContextReset(state->temp_cxt);
 	oldcontext = MemoryContextSwitchTo(state->temp_cxt);
@@ -3456,30 +4928,119 @@ static TupleTableSlot *rdfExecForeignInsert(EState *estate,
 		sparql_insert.len = len;
 	}
 
-	/* Add this statement to the batch buffer */
-	appendStringInfo(&state->batch_statements, "INSERT DATA { %s };\n", sparql_insert.data);
+	if (state->graph_store_format)
+	{
+		/* Add the triples to the N-Triples (or N-Quads) document of the batch */
+		bool has_graph = false;
+		char *errmsg;
+
+		if (!SPARQLTriplesToNTriples(&state->batch_statements, sparql_insert.data, state->prefixes,
+									 false, &has_graph, &errmsg))
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_ERROR),
+					 errmsg("cannot serialize row as %s: %s", state->graph_store_format, errmsg)));
+	}
+	else
+	{
+		/* Add the triples to the INSERT DATA block of the batch */
+		AppendDataBlock(state, SPARQL_INSERT, sparql_insert.data);
+	}
 
 	state->batch_count++;
 	state->sparql_query_type = SPARQL_INSERT;
 
+	MemoryContextSwitchTo(oldcontext);
+
 	elog(DEBUG1, "%s: added row to batch (%d/%d)", __func__, state->batch_count, state->batch_size);
+}
+
+static TupleTableSlot *rdfExecForeignInsert(EState *estate,
+											ResultRelInfo *rinfo,
+											TupleTableSlot *slot,
+											TupleTableSlot *planSlot)
+{
+	RDFfdwState *state;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	/* State must be initialized by rdfBeginForeignModify */
+	state = (RDFfdwState *)rinfo->ri_FdwState;
+	if (!state)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("%s failed to initialize state", __func__)));
+
+	AppendInsertStatement(state, slot);
 
 	/* Flush batch if it's full */
 	if (state->batch_count >= state->batch_size)
-	{
-		MemoryContextSwitchTo(oldcontext);
 		FlushSPARQLStatements(state);
-		oldcontext = MemoryContextSwitchTo(state->temp_cxt);
-	}
-
-	/* Clean up temp context for next row */
-	MemoryContextSwitchTo(oldcontext);
 
 	elog(DEBUG1, "%s exit", __func__);
 
 	return slot;
 }
 
+#if PG_VERSION_NUM >= 140000
+/*
+ * rdfExecForeignBatchInsert
+ * -------------------------
+ * Inserts the rows collected by the executor, whose number is set by
+ * rdfGetForeignModifyBatchSize(), with a single SPARQL UPDATE request.
+ */
+static TupleTableSlot **rdfExecForeignBatchInsert(EState *estate,
+												  ResultRelInfo *rinfo,
+												  TupleTableSlot **slots,
+												  TupleTableSlot **planSlots,
+												  int *numSlots)
+{
+	RDFfdwState *state;
+
+	elog(DEBUG1, "%s called with %d rows", __func__, *numSlots);
+
+	/* State must be initialized by rdfBeginForeignModify */
+	state = (RDFfdwState *)rinfo->ri_FdwState;
+	if (!state)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("%s failed to initialize state", __func__)));
+
+	for (int i = 0; i < *numSlots; i++)
+		AppendInsertStatement(state, slots[i]);
+
+	FlushSPARQLStatements(state);
+
+	elog(DEBUG1, "%s exit", __func__);
+
+	return slots;
+}
+
+/*
+ * rdfGetForeignModifyBatchSize
+ * ----------------------------
+ * Number of rows the executor collects for rdfExecForeignBatchInsert(),
+ * which is the 'batch_size' of the SERVER. Rows are inserted one at a time
+ * if the statement needs to see each of them as soon as it is inserted,
+ * i.e. with RETURNING, WITH CHECK OPTION or row-level INSERT triggers.
+ */
+static int rdfGetForeignModifyBatchSize(ResultRelInfo *rinfo)
+{
+	RDFfdwState *state = (RDFfdwState *)rinfo->ri_FdwState;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	if (!state ||
+		rinfo->ri_projectReturning != NULL ||
+		rinfo->ri_WithCheckOptions != NIL ||
+		(rinfo->ri_TrigDesc &&
+		 (rinfo->ri_TrigDesc->trig_insert_before_row ||
+		  rinfo->ri_TrigDesc->trig_insert_after_row)))
+		return 1;
+
+	return Max(state->batch_size, 1);
+}
+#endif /* PG_VERSION_NUM >= 140000 */
+
 static TupleTableSlot *rdfExecForeignDelete(EState *estate,
 											ResultRelInfo *rinfo,
 											TupleTableSlot *slot,
@@ -3606,10 +5167,8 @@ static TupleTableSlot *rdfExecForeignDelete(EState *estate,
 		sparql_delete.len = len;
 	}
 
-	/* Add this statement to the batch buffer */
-	appendStringInfoString(&state->batch_statements, "DELETE DATA { ");
-	appendStringInfoString(&state->batch_statements, sparql_delete.data);
-	appendStringInfoString(&state->batch_statements, " };\n");
+	/* Add the triples to the DELETE DATA block of the batch */
+	AppendDataBlock(state, SPARQL_DELETE, sparql_delete.data);
 
 	state->batch_count++;
 	state->sparql_query_type = SPARQL_DELETE;
@@ -3885,12 +5444,12 @@ static TupleTableSlot *rdfExecForeignUpdate(EState *estate,
 	}
 
 	/*
-	 * Add this UPDATE statement (DELETE + INSERT) to the batch buffer.
-	 * SPARQL UPDATE uses DELETE { old_pattern } INSERT { new_pattern } WHERE { }
-	 * For fully-specified triples (no variables), we can use an empty WHERE clause.
+	 * Add this UPDATE statement (DELETE + INSERT) to the batch buffer. The
+	 * old triples of a row are deleted before its new ones are inserted, so
+	 * every row gets a DELETE DATA and an INSERT DATA block of its own.
 	 */
-	appendStringInfo(&state->batch_statements, "DELETE DATA { %s };\n", sparql_delete.data);
-	appendStringInfo(&state->batch_statements, "INSERT DATA { %s };\n", sparql_insert.data);
+	AppendDataBlock(state, SPARQL_DELETE, sparql_delete.data);
+	AppendDataBlock(state, SPARQL_INSERT, sparql_insert.data);
 
 	state->batch_count++;
 	state->sparql_query_type = SPARQL_UPDATE;
@@ -3931,3786 +5490,8437 @@ static void rdfEndForeignModify(EState *estate, ResultRelInfo *rinfo)
 	elog(DEBUG1, "%s exit", __func__);
 }
 
-#if PG_VERSION_NUM >= 110000
-static void rdfBeginForeignInsert(ModifyTableState *mtstate,
-								  ResultRelInfo *resultRelInfo)
+#if PG_VERSION_NUM >= 90600
+/*
+ * rdfPlanDirectModify
+ * -------------------
+ * Decides whether an UPDATE or DELETE can be sent to the triplestore as a
+ * single SPARQL UPDATE request (enable_direct_modify), instead of fetching
+ * the rows to be modified and sending DELETE DATA and INSERT DATA blocks
+ * with their values. This is the case if all conditions of the WHERE clause
+ * were pushed down, so that the rows are exactly the solutions of the graph
+ * pattern of the foreign table, and the new values of an UPDATE are
+ * constants. The triples of 'sparql_update_pattern' are then modified by a
+ * DELETE { ... } INSERT { ... } WHERE { ... } operation, whose WHERE clause
+ * is the graph pattern and FILTER expressions of the scan.
+ *
+ * root          : Planner info
+ * plan          : ModifyTable plan node
+ * resultRelation: range table index of the foreign table
+ * subplan_index : index of the subplan scanning the foreign table
+ *
+ * returns true if the scan was turned into a direct modification
+ */
+static bool rdfPlanDirectModify(PlannerInfo *root, ModifyTable *plan,
+								Index resultRelation, int subplan_index)
 {
-	ereport(ERROR,
-			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-			 errmsg("COPY FROM is not supported by rdf_fdw")));
-}
+	CmdType operation = plan->operation;
+	Plan *subplan;
+	ForeignScan *fscan;
+	RelOptInfo *baserel;
+	RDFfdwState *state;
+	SPARQLQuery *query;
+	List *names = NIL;
+	List *terms = NIL;
+	char *sparql_using = "";
+	StringInfoData where_graph;
+	StringInfoData sparql;
+	StringInfoData count;
 
-static void rdfEndForeignInsert(EState *estate, ResultRelInfo *resultRelInfo)
-{
-	ereport(ERROR,
-			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-			 errmsg("COPY FROM is not supported by rdf_fdw")));
-}
-#endif /*PG_VERSION_NUM >= 110000*/
+	elog(DEBUG1, "%s called", __func__);
 
-static void LoadRDFTableInfo(RDFfdwState *state)
-{
-	ListCell *cell;
-	TupleDesc tupdesc;
-	StringInfoData deprecated_cols;
-	Relation rel;
+	if (operation != CMD_UPDATE && operation != CMD_DELETE)
+		return false;
 
-	elog(DEBUG1, "%s called", __func__);
+	/* RETURNING needs the values of the modified rows */
+	if (plan->returningLists != NIL)
+		return false;
 
-#if PG_VERSION_NUM < 130000
-	rel = heap_open(state->foreigntableid, NoLock);
+	/*
+	 * The foreign table must be scanned by the subplan itself. Joins with
+	 * other tables and inheritance trees are modified row by row.
+	 */
+#if PG_VERSION_NUM >= 140000
+	subplan = outerPlan(plan);
 #else
-	rel = table_open(state->foreigntableid, NoLock);
+	subplan = (Plan *)list_nth(plan->plans, subplan_index);
 #endif
 
-	initStringInfo(&deprecated_cols);
-	state->numcols = rel->rd_att->natts;
-	tupdesc = rel->rd_att;
+	if (!IsA(subplan, ForeignScan))
+		return false;
+
+	fscan = (ForeignScan *)subplan;
+
+	if (fscan->scan.scanrelid != resultRelation)
+		return false;
 
 	/*
-	 *Loading FOREIGN TABLE strucuture (columns and their OPTION values)
+	 * Conditions evaluated locally and values bound at execution time, see
+	 * BindParameters(), cannot be part of the WHERE clause of the update.
 	 */
-	state->rdfTable = (struct RDFfdwTable *)palloc0(sizeof(struct RDFfdwTable));
-	state->rdfTable->cols = (struct RDFfdwColumn **)palloc0(sizeof(struct RDFfdwColumn *) * state->numcols);
+	if (fscan->scan.plan.qual != NIL || fscan->fdw_exprs != NIL)
+		return false;
+
+	baserel = find_base_rel(root, resultRelation);
+	state = (RDFfdwState *)baserel->fdw_private;
+
+	if (state == NULL || !state->enable_direct_modify || !state->enable_pushdown ||
+		!state->is_sparql_parsable || state->has_unparsable_conds || state->values_chunks != NIL)
+		return false;
+
+	/*
+	 * Every row must be a solution of the graph pattern, with all variables
+	 * of the triple pattern bound: no solution modifiers or aggregates, and
+	 * no OPTIONAL or UNION, whose unbound variables fail the row by row
+	 * modification.
+	 */
+	query = state->sparql_query;
+
+	if (query == NULL || SPARQLQueryNeedsSubquery(query) || query->distinct || query->reduced ||
+		query->has_optional || query->has_union)
+		return false;
+
+	if (!state->sparql_update_pattern || strlen(state->sparql_update_pattern) == 0)
+		return false;
 
 	for (int i = 0; i < state->numcols; i++)
 	{
-		List *options = GetForeignColumnOptions(state->foreigntableid, i + 1);
-		ListCell *lc;
+		RDFfdwColumn *col = state->rdfTable->cols[i];
 
-		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
-		state->rdfTable->cols[i] = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
+		if (!col->sparqlvar || !ContainsSPARQLVariable(state->sparql_update_pattern, col->sparqlvar))
+			continue;
 
-		/*
-		 * Setting foreign table colmuns's default values.
-		 */
-		state->rdfTable->cols[i]->pushable = true;
-		state->rdfTable->cols[i]->nodetype = RDF_COLUMN_OPTION_NODETYPE_LITERAL;
-		state->rdfTable->cols[i]->used = false;
+		if (col->pgtype != RDFNODEOID || col->expression ||
+			!ContainsSPARQLVariable(state->sparql_where, col->sparqlvar))
+		{
+			elog(DEBUG1, "%s exit: variable '%s' is not bound by the graph pattern", __func__, col->sparqlvar);
+			return false;
+		}
+	}
 
-		if (attr->atttypid == RDFNODEOID)
-			elog(DEBUG2, "  %s: (%d) adding data type RDFNODEOID", __func__, i);
-		else
-			elog(DEBUG2, "  %s: (%d) adding data type %u", __func__, i, attr->atttypid);
+	/*
+	 * The variables of the columns set by an UPDATE are replaced by their
+	 * new values in the INSERT template. The other variables keep the values
+	 * bound by the WHERE clause.
+	 */
+	if (operation == CMD_UPDATE)
+	{
+		List *tlist = NIL;
+		List *attnums = NIL;
+		ListCell *lc;
+		ListCell *lc2;
 
-		state->rdfTable->cols[i]->pgtype = attr->atttypid;
-		state->rdfTable->cols[i]->name = pstrdup(NameStr(attr->attname));
-		state->rdfTable->cols[i]->pgtypmod = attr->atttypmod;
-		state->rdfTable->cols[i]->pgattnum = attr->attnum;
+#if PG_VERSION_NUM >= 140000
+		get_translated_update_targetlist(root, resultRelation, &tlist, &attnums);
+#else
+		RangeTblEntry *rte = planner_rt_fetch(resultRelation, root);
+		int member = -1;
 
-		if (attr->atttypid != RDFNODEOID)
+		while ((member = bms_next_member(rte->updatedCols, member)) >= 0)
 		{
-			if (deprecated_cols.len > 0)
-				appendStringInfoString(&deprecated_cols, ", ");
+			AttrNumber attnum = member + FirstLowInvalidHeapAttributeNumber;
+			TargetEntry *tle;
 
-			appendStringInfoString(&deprecated_cols, NameStr(attr->attname));
+			if (attnum <= InvalidAttrNumber)
+				return false;
+
+			tle = get_tle_by_resno(fscan->scan.plan.targetlist, attnum);
+
+			if (tle == NULL)
+				return false;
+
+			tlist = lappend(tlist, tle);
+			attnums = lappend_int(attnums, attnum);
 		}
+#endif
 
-		foreach (lc, options)
+		forboth(lc, tlist, lc2, attnums)
 		{
-			DefElem *def = (DefElem *)lfirst(lc);
+			TargetEntry *tle = (TargetEntry *)lfirst(lc);
+			AttrNumber attnum = lfirst_int(lc2);
+			RDFfdwColumn *col = NULL;
+			Const *constant;
+			char *term;
+
+			for (int i = 0; i < state->numcols; i++)
+				if (state->rdfTable->cols[i]->pgattnum == attnum)
+					col = state->rdfTable->cols[i];
+
+			if (col == NULL || !col->sparqlvar ||
+				!ContainsSPARQLVariable(state->sparql_update_pattern, col->sparqlvar))
+				continue;
 
-			if (state->rdfTable->cols[i]->pgtype == RDFNODEOID && strcmp(def->defname, RDF_COLUMN_OPTION_VARIABLE) != 0)
-			{
-				ereport(ERROR,
-						(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
-						 errmsg("invalid option \"%s\" for column \"%s\"",
-								def->defname, state->rdfTable->cols[i]->name),
-						 errhint("rdfnode columns accept only the \"%s\" option.", RDF_COLUMN_OPTION_VARIABLE)));
-			}
-			else if (strcmp(def->defname, RDF_COLUMN_OPTION_VARIABLE) == 0)
-			{
-				elog(DEBUG2, "  %s: (%d) adding sparql variable > '%s'", __func__, i, defGetString(def));
-				state->rdfTable->cols[i]->sparqlvar = pstrdup(defGetString(def));
-			}
-			else if (strcmp(def->defname, RDF_COLUMN_OPTION_EXPRESSION) == 0)
-			{
-				elog(DEBUG2, "  %s: (%d) adding sparql expression > '%s'", __func__, i, defGetString(def));
-				state->rdfTable->cols[i]->expression = pstrdup(defGetString(def));
-				state->rdfTable->cols[i]->pushable = IsExpressionPushable(defGetString(def));
-				elog(DEBUG2, "  %s: (%d) is expression pushable? > '%s'", __func__, i,
-					 state->rdfTable->cols[i]->pushable ? "true" : "false");
-			}
-			else if (strcmp(def->defname, RDF_COLUMN_OPTION_LITERALTYPE) == 0 || strcmp(def->defname, RDF_COLUMN_OPTION_LITERAL_TYPE) == 0)
-			{
-				elog(DEBUG2, "  %s: (%d) adding sparql literal data type > '%s'", __func__, i, defGetString(def));
-				state->rdfTable->cols[i]->literaltype = pstrdup(defGetString(def));
-			}
-			else if (strcmp(def->defname, RDF_COLUMN_OPTION_NODETYPE) == 0)
+			if (!IsA(tle->expr, Const))
 			{
-				elog(DEBUG2, "  %s: (%d) adding sparql node data type > '%s'", __func__, i, defGetString(def));
-				state->rdfTable->cols[i]->nodetype = pstrdup(defGetString(def));
+				elog(DEBUG1, "%s exit: new value of column '%s' is not a constant", __func__, col->name);
+				return false;
 			}
-			else if (strcmp(def->defname, RDF_COLUMN_OPTION_LANGUAGE) == 0)
+
+			constant = (Const *)tle->expr;
+
+			/* NULL values and blank nodes are rejected by rdfExecForeignUpdate */
+			if (constant->constisnull || constant->consttype != RDFNODEOID)
+				return false;
+
+			term = DatumToString(constant->constvalue, col->pgtype);
+
+			if (isBlank(term))
+				return false;
+
+			for (const char *p = term; *p; p++)
 			{
-				elog(DEBUG2, "  %s: (%d) adding literal language tag > '%s'", __func__, i, defGetString(def));
-				state->rdfTable->cols[i]->language = pstrdup(defGetString(def));
+				if (*p == '\n' || *p == '\r' || *p == '\t')
+				{
+					term = EscapeSPARQLLiteral(term);
+					break;
+				}
 			}
+
+			names = lappend(names, pstrdup(col->sparqlvar + 1));
+			terms = lappend(terms, term);
 		}
 	}
 
-	if (deprecated_cols.len > 0)
-		ereport(WARNING,
-				(errcode(ERRCODE_WARNING_DEPRECATED_FEATURE),
-				 errmsg("the rdf_fdw FOREIGN TABLE \"%s\" has columns using native PostgreSQL types which are deprecated: %s",
-						RelationGetRelationName(rel), deprecated_cols.data),
-				 errhint("Use the \"rdfnode\" type instead.")));
+	/* the same WHERE clause as the SPARQL query of the scan, see CreateSPARQL() */
+	initStringInfo(&where_graph);
 
-#if PG_VERSION_NUM < 130000
-	heap_close(rel, NoLock);
-#else
-	table_close(rel, NoLock);
-#endif
+	if (state->sparql_filter && strlen(state->sparql_filter) > 0)
+		appendStringInfo(&where_graph, "{%s\n ## rdf_fdw pushdown conditions ##\n%s}", state->sparql_where, state->sparql_filter);
+	else
+		appendStringInfo(&where_graph, "{%s}", state->sparql_where);
 
-	/*
-	 * Loading FOREIGN TABLE OPTIONS
-	 */
-	foreach (cell, state->foreign_table->options)
-	{
-		DefElem *def = lfirst_node(DefElem, cell);
+	/* the FROM and FROM NAMED clauses of the query become USING and USING NAMED */
+	if (state->sparql_from && strlen(state->sparql_from) > 0)
+		sparql_using = str_replace(psprintf("\n%s", state->sparql_from), "\nFROM ", "\nUSING ") + 1;
 
-		if (strcmp(RDF_TABLE_OPTION_SPARQL, def->defname) == 0)
-		{
-			state->raw_sparql = defGetString(def);
-			state->is_sparql_parsable = IsSPARQLParsable(state);
-		}
-		else if (strcmp(RDF_TABLE_OPTION_SPARQL_UPDATE_PATTERN, def->defname) == 0)
-			state->sparql_update_pattern = defGetString(def);
-		else if (strcmp(RDF_TABLE_OPTION_READONLY, def->defname) == 0)
-			state->readonly = defGetBoolean(def);
-		else if (strcmp(RDF_TABLE_OPTION_LOG_SPARQL, def->defname) == 0)
-			state->log_sparql = defGetBoolean(def);
-		else if (strcmp(RDF_TABLE_OPTION_ENABLE_PUSHDOWN, def->defname) == 0)
-			state->enable_pushdown = defGetBoolean(def);
-	}
+	initStringInfo(&sparql);
+	appendStringInfo(&sparql, "%s\nDELETE { %s }\n", state->sparql_prefixes, state->sparql_update_pattern);
+
+	if (operation == CMD_UPDATE)
+		appendStringInfo(&sparql, "INSERT { %s }\n",
+						 RenameSPARQLVariables(state->sparql_update_pattern, "", names, terms));
+
+	appendStringInfo(&sparql, "%sWHERE %s", sparql_using, where_graph.data);
+
+	/* SPARQL UPDATE does not report the number of rows, see rdfIterateDirectModify() */
+	initStringInfo(&count);
+	appendStringInfo(&count, "%s\nSELECT (COUNT(*) AS ?rdf_fdw_count)\n%s%s",
+					 state->sparql_prefixes, state->sparql_from, where_graph.data);
+
+	elog(DEBUG2, "%s: sending %s as a single SPARQL UPDATE:\n%s", __func__,
+		 operation == CMD_UPDATE ? "UPDATE" : "DELETE", sparql.data);
+
+	fscan->operation = operation;
+#if PG_VERSION_NUM >= 140000
+	fscan->resultRelation = resultRelation;
+#endif
+	fscan->fdw_private = list_make3(makeString(sparql.data),
+									makeString(count.data),
+									makeInteger(plan->canSetTag));
 
 	elog(DEBUG1, "%s exit", __func__);
+	return true;
 }
 
-static int rdfIsForeignRelUpdatable(Relation rel)
+/*
+ * rdfBeginDirectModify
+ * --------------------
+ * Loads the SERVER, FOREIGN TABLE and USER MAPPING info of a direct UPDATE
+ * or DELETE planned by rdfPlanDirectModify(). Nothing is loaded for a plain
+ * EXPLAIN, which leaves node->fdw_state NULL.
+ */
+static void rdfBeginDirectModify(ForeignScanState *node, int eflags)
 {
-	bool readonly = false;
-	ListCell *lc;
-	ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
-	ForeignServer *server = GetForeignServer(table->serverid);
+	ForeignScan *fsplan = (ForeignScan *)node->ss.ps.plan;
+	RDFfdwState *state;
 
-	foreach(lc, server->options)
-	{
-		DefElem *def = (DefElem *) lfirst(lc);
-		if (strcmp(def->defname, RDF_SERVER_OPTION_READONLY) == 0)
-			readonly = defGetBoolean(def);
-	}
+	elog(DEBUG1, "%s called", __func__);
 
-	foreach(lc, table->options)
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
 	{
-		DefElem *def = (DefElem *) lfirst(lc);
-		if (strcmp(def->defname, RDF_TABLE_OPTION_READONLY) == 0)
-			readonly = defGetBoolean(def);
+		elog(DEBUG1, "%s exit: EXPLAIN only", __func__);
+		return;
 	}
 
-	/* if readonly, no need to look for update triple pattern */
-	if (readonly)
-    	return 0;
+	state = CreateModifyState(node->ss.ss_currentRelation, fsplan->operation, RDF_DEFAULT_BATCH_SIZE);
+	state->sparql = strVal(list_nth(fsplan->fdw_private, 0));
+	state->sparql_count = strVal(list_nth(fsplan->fdw_private, 1));
+	state->set_processed = intVal(list_nth(fsplan->fdw_private, 2)) != 0;
 
-	foreach (lc, table->options)
+	/* not executed yet, see rdfIterateDirectModify */
+	state->rowcount = -1;
+
+	node->fdw_state = (void *)state;
+
+	elog(DEBUG1, "%s exit", __func__);
+}
+
+/*
+ * rdfIterateDirectModify
+ * ----------------------
+ * Sends the SPARQL UPDATE of a direct UPDATE or DELETE. SPARQL UPDATE does
+ * not report how many solutions of the WHERE clause were modified, so they
+ * are counted with a SELECT request to the endpoint beforehand, if the row
+ * count of the command or of EXPLAIN ANALYZE is needed. No rows are
+ * returned.
+ */
+static TupleTableSlot *rdfIterateDirectModify(ForeignScanState *node)
+{
+	RDFfdwState *state = (RDFfdwState *)node->fdw_state;
+	EState *estate = node->ss.ps.state;
+	Instrumentation *instr = node->ss.ps.instrument;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	if (state->rowcount < 0)
 	{
-		DefElem *def = (DefElem *)lfirst(lc);
+		double rows = 0;
 
-		if (strcmp(def->defname, RDF_TABLE_OPTION_SPARQL_UPDATE_PATTERN) == 0)
+		if (state->set_processed || instr)
 		{
-			char *pattern = defGetString(def);
+			RDFfdwState *count_state;
+			ListCell *cell;
 
-			if (pattern && strlen(pattern) > 0)
-				return (1 << CMD_INSERT) | (1 << CMD_UPDATE) | (1 << CMD_DELETE);
+			/*
+			 * The rows are counted with a copy of the state, sent to the
+			 * query endpoint of the SERVER instead of its update_url.
+			 */
+			count_state = (RDFfdwState *)palloc(sizeof(RDFfdwState));
+			memcpy(count_state, state, sizeof(RDFfdwState));
+			count_state->sparql = state->sparql_count;
+			count_state->sparql_resultset = NULL;
+			count_state->sparql_query_type = SPARQL_SELECT;
+
+			foreach (cell, state->server->options)
+			{
+				DefElem *def = (DefElem *)lfirst(cell);
+
+				if (strcmp(RDF_SERVER_OPTION_SELECT_URL, def->defname) == 0)
+					count_state->endpoint = defGetString(def);
+			}
+
+			/* the SPARQL UPDATE is not sent without a row count */
+			if (ExecuteSPARQL(count_state) != REQUEST_SUCCESS)
+				ereport(ERROR,
+						(errcode(ERRCODE_FDW_ERROR),
+						 errmsg("failed to count the rows affected by the SPARQL UPDATE")));
+
+			rows = ReadRemoteCount(count_state, "?rdf_fdw_count");
+
+			if (rows < 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_FDW_ERROR),
+						 errmsg("failed to count the rows affected by the SPARQL UPDATE"),
+						 errdetail("The endpoint returned no valid count for the query:\n%s", state->sparql_count)));
 		}
+
+		if (ExecuteSPARQL(state) != REQUEST_SUCCESS)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_ERROR),
+					 errmsg("failed to execute SPARQL UPDATE")));
+
+		state->sparql_resultset = NULL;
+		state->rowcount = (int)rows;
+
+		if (state->set_processed)
+			estate->es_processed += state->rowcount;
+
+		if (instr)
+			instr->tuplecount += state->rowcount;
 	}
 
-	/* read-only: no triple pattern found */
-	return 0;
+	elog(DEBUG1, "%s exit", __func__);
+
+	return ExecClearTuple(node->ss.ss_ScanTupleSlot);
 }
 
-static void LoadRDFServerInfo(RDFfdwState *state)
+static void rdfEndDirectModify(ForeignScanState *node)
 {
+	RDFfdwState *state = (RDFfdwState *)node->fdw_state;
+
 	elog(DEBUG1, "%s called", __func__);
 
-	if (state->server)
-	{
-		ListCell *cell;
+	if (state)
+		pfree(state);
 
-		foreach (cell, state->server->options)
-		{
-			DefElem *def = lfirst_node(DefElem, cell);
+	elog(DEBUG1, "%s exit", __func__);
+}
 
-			if (strcmp(RDF_SERVER_OPTION_UPDATE_URL, def->defname) == 0 &&
-				(state->sparql_query_type == SPARQL_INSERT ||
-				 state->sparql_query_type == SPARQL_DELETE ||
-				 state->sparql_query_type == SPARQL_UPDATE))
-				state->endpoint = defGetString(def);
+static void rdfExplainDirectModify(ForeignScanState *node, ExplainState *es)
+{
+	ForeignScan *fsplan = (ForeignScan *)node->ss.ps.plan;
+	ForeignTable *table = GetForeignTable(RelationGetRelid(node->ss.ss_currentRelation));
+	ForeignServer *server = GetForeignServer(table->serverid);
 
-			else if (strcmp(RDF_SERVER_OPTION_SELECT_URL, def->defname) == 0 &&
-					 !state->endpoint)
-				state->endpoint = defGetString(def);
+	/* node->fdw_state is not set for a plain EXPLAIN, see rdfBeginDirectModify */
+	ExplainPropertyText("Foreign Server", server->servername, es);
 
-			else if (strcmp(RDF_SERVER_OPTION_FORMAT, def->defname) == 0)
-				state->format = defGetString(def);
+	/* SPARQL UPDATE sent to the endpoint, in a single line */
+	ExplainPropertyText("Remote Update", str_replace(strVal(linitial(fsplan->fdw_private)), "\n", " "), es);
+}
 
-			else if (strcmp(RDF_SERVER_OPTION_CUSTOMPARAM, def->defname) == 0)
-				state->custom_params = defGetString(def);
+/*
+ * ContainsSPARQLVariable
+ * ----------------------
+ * Checks whether a SPARQL fragment uses a variable, written either with '?'
+ * or '$'.
+ *
+ * fragment: SPARQL fragment, e.g. a graph pattern
+ * variable: SPARQL variable, e.g. "?s"
+ *
+ * returns true if the variable appears in the fragment
+ */
+static bool ContainsSPARQLVariable(const char *fragment, const char *variable)
+{
+	const char *name = variable + 1;
+	size_t len = strlen(name);
+	const char *p = fragment;
 
-			else if (strcmp(RDF_SERVER_OPTION_HTTP_PROXY, def->defname) == 0)
-			{
-				state->proxy = defGetString(def);
-				state->proxy_type = RDF_SERVER_OPTION_HTTP_PROXY;
-			}
-			else if (strcmp(RDF_SERVER_OPTION_HTTPS_PROXY, def->defname) == 0)
-			{
-				state->proxy = defGetString(def);
-				state->proxy_type = RDF_SERVER_OPTION_HTTPS_PROXY;
-			}
+	if (fragment == NULL || len == 0)
+		return false;
 
-			/* these options are now tied to USER MAPPING */
-			if (strcmp(RDF_USERMAPPING_OPTION_PROXYUSER, def->defname) == 0 ||
-				strcmp(RDF_USERMAPPING_OPTION_PROXYPASSWORD, def->defname) == 0)
-			{
-				ereport(WARNING,
-						(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
-						 errmsg("option \"%s\" is no longer valid for SERVER", def->defname),
-						 errhint("Specify proxy credentials in USER MAPPING instead: "
-								 "CREATE USER MAPPING FOR ... SERVER ... OPTIONS (proxy_user '...', proxy_password '...');")));
-			}
+	while ((p = strstr(p, name)) != NULL)
+	{
+		if (p > fragment && (p[-1] == '?' || p[-1] == '$') &&
+			!isalnum((unsigned char)p[len]) && p[len] != '_')
+			return true;
 
-			else if (strcmp(RDF_SERVER_OPTION_FETCH_SIZE, def->defname) == 0)
-			{
-				char *tailpt;
-				char *fetch_size_str = defGetString(def);
-				state->fetch_size = strtol(fetch_size_str, &tailpt, 0);
-			}
-			else if (strcmp(RDF_SERVER_OPTION_BATCH_SIZE, def->defname) == 0)
-			{
-				char *tailpt;
-				char *batch_size_str = defGetString(def);
-				state->batch_size = strtol(batch_size_str, &tailpt, 0);
-			}
-			else if (strcmp(RDF_SERVER_OPTION_CONNECTRETRY, def->defname) == 0)
-			{
-				char *tailpt;
-				char *maxretry_str = defGetString(def);
-				state->max_retries = strtol(maxretry_str, &tailpt, 0);
-			}
-			else if (strcmp(RDF_SERVER_OPTION_MAX_RESPONSE_SIZE, def->defname) == 0)
-			{
-				char *tailpt;
-				char *max_size_str = defGetString(def);
-				state->max_response_size = strtol(max_size_str, &tailpt, 0);
-			}
-			else if (strcmp(RDF_SERVER_OPTION_READONLY, def->defname) == 0)
-				state->readonly = defGetBoolean(def);
-			else if (strcmp(RDF_SERVER_OPTION_REQUEST_REDIRECT, def->defname) == 0)
-				state->request_redirect = defGetBoolean(def);
-			else if (strcmp(RDF_SERVER_OPTION_REQUEST_MAX_REDIRECT, def->defname) == 0)
-			{
-				char *tailpt;
-				char *maxredirect_str = defGetString(def);
-				state->request_max_redirect = strtol(maxredirect_str, &tailpt, 0);
-			}
-			else if (strcmp(RDF_SERVER_OPTION_CONNECTTIMEOUT, def->defname) == 0)
-			{
-				char *tailpt;
-				char *timeout_str = defGetString(def);
-				state->connect_timeout = strtol(timeout_str, &tailpt, 0);
-			}
-			else if (strcmp(RDF_SERVER_OPTION_REQUEST_TIMEOUT, def->defname) == 0)
-			{
-				char *tailpt;
-				char *timeout_str = defGetString(def);
-				state->request_timeout = strtol(timeout_str, &tailpt, 0);
-			}
-			else if (strcmp(RDF_SERVER_OPTION_ENABLE_PUSHDOWN, def->defname) == 0)
-				state->enable_pushdown = defGetBoolean(def);
+		p += len;
+	}
 
-			else if (strcmp(RDF_SERVER_OPTION_ENABLE_XML_HUGE, def->defname) == 0)
-				state->enable_xml_huge = defGetBoolean(def);
+	return false;
+}
+#endif /* PG_VERSION_NUM */
 
-			else if (strcmp(RDF_SERVER_OPTION_QUERY_PARAM, def->defname) == 0)
-				state->query_param = defGetString(def);
+#if PG_VERSION_NUM >= 110000
+/*
+ * rdfBeginForeignInsert
+ * ---------------------
+ * Prepares the insertion of the rows of COPY FROM, or of rows routed into
+ * a foreign table that is a partition, which are then passed to
+ * rdfExecForeignInsert() or rdfExecForeignBatchInsert() and sent in the
+ * same batches as the rows of INSERT statements.
+ *
+ * COPY passes a dummy 'mtstate' that has no plan, which is also how
+ * postgres_fdw tells it apart. Its rows are inserted in batches of
+ * RDF_DEFAULT_COPY_BATCH_SIZE rows, unless the SERVER sets batch_size. The
+ * request bodies are streamed from the batch buffer, which is reused for
+ * every batch, so memory does not grow with the size of the input.
+ */
+static void rdfBeginForeignInsert(ModifyTableState *mtstate,
+								  ResultRelInfo *resultRelInfo)
+{
+	bool is_copy = mtstate == NULL || mtstate->ps.plan == NULL;
 
-			else if (strcmp(RDF_SERVER_OPTION_BASE_URI, def->defname) == 0)
-				state->base_uri = defGetString(def);
+	elog(DEBUG1, "%s called", __func__);
 
-			else if (strcmp(RDF_SERVER_OPTION_PREFIX_CONTEXT, def->defname) == 0)
-				state->prefix_context = defGetString(def);
-		}
-	}
+	resultRelInfo->ri_FdwState = CreateModifyState(resultRelInfo->ri_RelationDesc, CMD_INSERT,
+												   is_copy ? RDF_DEFAULT_COPY_BATCH_SIZE : RDF_DEFAULT_BATCH_SIZE);
 
 	elog(DEBUG1, "%s exit", __func__);
 }
 
-static void LoadRDFUserMapping(RDFfdwState *state)
+static void rdfEndForeignInsert(EState *estate, ResultRelInfo *resultRelInfo)
 {
+	elog(DEBUG1, "%s called", __func__);
 
-	Datum datum;
-	HeapTuple tp;
-	bool isnull;
-	UserMapping *um;
-	List *options = NIL;
+	/* Flush the last batch, as for INSERT statements */
+	rdfEndForeignModify(estate, resultRelInfo);
+
+	elog(DEBUG1, "%s exit", __func__);
+}
+#endif /*PG_VERSION_NUM >= 110000*/
+
+static void LoadRDFTableInfo(RDFfdwState *state)
+{
 	ListCell *cell;
-	bool usermatch = true;
+	RDFfdwTableCacheEntry *entry;
 
 	elog(DEBUG1, "%s called", __func__);
 
-	tp = SearchSysCache2(USERMAPPINGUSERSERVER,
-						 ObjectIdGetDatum(GetUserId()),
-						 ObjectIdGetDatum(state->server->serverid));
-
-	if (!HeapTupleIsValid(tp))
-	{
-		elog(DEBUG2, "%s: not found for the specific user -- try PUBLIC", __func__);
-		tp = SearchSysCache2(USERMAPPINGUSERSERVER,
-							 ObjectIdGetDatum(InvalidOid),
-							 ObjectIdGetDatum(state->server->serverid));
-	}
+	entry = GetTableCacheEntry(state);
 
-	if (!HeapTupleIsValid(tp))
+	if (!entry->valid)
 	{
-		elog(DEBUG2, "%s: user mapping not found for user \"%s\", server \"%s\"",
-			 __func__, MappingUserName(GetUserId()), state->server->servername);
-
-		usermatch = false;
-	}
+		TupleDesc tupdesc;
+		StringInfoData deprecated_cols;
+		Relation rel;
 
-	if (usermatch)
-	{
-		elog(DEBUG2, "%s: setting UserMapping", __func__);
-		um = (UserMapping *)palloc(sizeof(UserMapping));
-#if PG_VERSION_NUM >= 120000
-		um->umid = ((Form_pg_user_mapping)GETSTRUCT(tp))->oid;
-#elif PG_VERSION_NUM >= 90600
-		um->umid = HeapTupleGetOid(tp);
+#if PG_VERSION_NUM < 130000
+		rel = heap_open(state->foreigntableid, NoLock);
+#else
+		rel = table_open(state->foreigntableid, NoLock);
 #endif
-		um->userid = GetUserId();
-		um->serverid = state->server->serverid;
 
-		elog(DEBUG2, "%s: extract the umoptions", __func__);
-		datum = SysCacheGetAttr(USERMAPPINGUSERSERVER,
-								tp,
-								Anum_pg_user_mapping_umoptions,
-								&isnull);
-		if (isnull)
-			um->options = NIL;
-		else
-			um->options = untransformRelOptions(datum);
+		initStringInfo(&deprecated_cols);
+		state->numcols = rel->rd_att->natts;
+		tupdesc = rel->rd_att;
 
-		if (um->options != NIL)
+		/*
+		 *Loading FOREIGN TABLE strucuture (columns and their OPTION values)
+		 */
+		state->rdfTable = (struct RDFfdwTable *)palloc0(sizeof(struct RDFfdwTable));
+		state->rdfTable->cols = (struct RDFfdwColumn **)palloc0(sizeof(struct RDFfdwColumn *) * state->numcols);
+
+		for (int i = 0; i < state->numcols; i++)
 		{
-			options = list_concat(options, um->options);
+			List *options = GetForeignColumnOptions(state->foreigntableid, i + 1);
+			ListCell *lc;
 
-			foreach (cell, options)
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+			state->rdfTable->cols[i] = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
+
+			/*
+			 * Setting foreign table colmuns's default values.
+			 */
+			state->rdfTable->cols[i]->pushable = true;
+			state->rdfTable->cols[i]->nodetype = RDF_COLUMN_OPTION_NODETYPE_LITERAL;
+			state->rdfTable->cols[i]->used = false;
+
+			if (attr->atttypid == RDFNODEOID)
+				elog(DEBUG2, "  %s: (%d) adding data type RDFNODEOID", __func__, i);
+			else
+				elog(DEBUG2, "  %s: (%d) adding data type %u", __func__, i, attr->atttypid);
+
+			state->rdfTable->cols[i]->pgtype = attr->atttypid;
+			state->rdfTable->cols[i]->name = pstrdup(NameStr(attr->attname));
+			state->rdfTable->cols[i]->pgtypmod = attr->atttypmod;
+			state->rdfTable->cols[i]->pgattnum = attr->attnum;
+			state->rdfTable->cols[i]->notnull = attr->attnotnull;
+
+			if (attr->atttypid != RDFNODEOID)
 			{
-				DefElem *def = (DefElem *)lfirst(cell);
+				if (deprecated_cols.len > 0)
+					appendStringInfoString(&deprecated_cols, ", ");
 
-				if (strcmp(def->defname, RDF_USERMAPPING_OPTION_USER) == 0)
+				appendStringInfoString(&deprecated_cols, NameStr(attr->attname));
+			}
+
+			foreach (lc, options)
+			{
+				DefElem *def = (DefElem *)lfirst(lc);
+
+				if (state->rdfTable->cols[i]->pgtype == RDFNODEOID && strcmp(def->defname, RDF_COLUMN_OPTION_VARIABLE) != 0)
 				{
-					state->user = pstrdup(defGetString(def));
-					elog(DEBUG2, "%s: %s '%s'", __func__, def->defname, state->user);
+					ereport(ERROR,
+							(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+							 errmsg("invalid option \"%s\" for column \"%s\"",
+									def->defname, state->rdfTable->cols[i]->name),
+							 errhint("rdfnode columns accept only the \"%s\" option.", RDF_COLUMN_OPTION_VARIABLE)));
 				}
-				else if (strcmp(def->defname, RDF_USERMAPPING_OPTION_PASSWORD) == 0)
+				else if (strcmp(def->defname, RDF_COLUMN_OPTION_VARIABLE) == 0)
 				{
-					state->password = pstrdup(defGetString(def));
-					elog(DEBUG2, "%s: %s '*******'", __func__, def->defname);
+					elog(DEBUG2, "  %s: (%d) adding sparql variable > '%s'", __func__, i, defGetString(def));
+					state->rdfTable->cols[i]->sparqlvar = pstrdup(defGetString(def));
 				}
-				else if (strcmp(def->defname, RDF_USERMAPPING_OPTION_TOKEN) == 0)
+				else if (strcmp(def->defname, RDF_COLUMN_OPTION_EXPRESSION) == 0)
 				{
-					state->token = pstrdup(defGetString(def));
-					elog(DEBUG2, "%s: %s '*******'", __func__, def->defname);
+					elog(DEBUG2, "  %s: (%d) adding sparql expression > '%s'", __func__, i, defGetString(def));
+					state->rdfTable->cols[i]->expression = pstrdup(defGetString(def));
+					state->rdfTable->cols[i]->pushable = IsExpressionPushable(defGetString(def));
+					elog(DEBUG2, "  %s: (%d) is expression pushable? > '%s'", __func__, i,
+						 state->rdfTable->cols[i]->pushable ? "true" : "false");
 				}
-				else if (strcmp(def->defname, RDF_USERMAPPING_OPTION_PROXYUSER) == 0)
+				else if (strcmp(def->defname, RDF_COLUMN_OPTION_LITERALTYPE) == 0 || strcmp(def->defname, RDF_COLUMN_OPTION_LITERAL_TYPE) == 0)
 				{
-					state->proxy_user = pstrdup(defGetString(def));
-					elog(DEBUG2, "%s: proxy user '%s'", __func__, def->defname);
+					elog(DEBUG2, "  %s: (%d) adding sparql literal data type > '%s'", __func__, i, defGetString(def));
+					state->rdfTable->cols[i]->literaltype = pstrdup(defGetString(def));
 				}
-				else if (strcmp(def->defname, RDF_USERMAPPING_OPTION_PROXYPASSWORD) == 0)
+				else if (strcmp(def->defname, RDF_COLUMN_OPTION_NODETYPE) == 0)
 				{
-					state->proxy_user_password = pstrdup(defGetString(def));
-					elog(DEBUG2, "%s: proxy password '*******'", __func__);
+					elog(DEBUG2, "  %s: (%d) adding sparql node data type > '%s'", __func__, i, defGetString(def));
+					state->rdfTable->cols[i]->nodetype = pstrdup(defGetString(def));
+					state->rdfTable->cols[i]->has_nodetype = true;
+				}
+				else if (strcmp(def->defname, RDF_COLUMN_OPTION_LANGUAGE) == 0)
+				{
+					elog(DEBUG2, "  %s: (%d) adding literal language tag > '%s'", __func__, i, defGetString(def));
+					state->rdfTable->cols[i]->language = pstrdup(defGetString(def));
 				}
 			}
 		}
 
-		ReleaseSysCache(tp);
+		StoreTableCacheEntry(entry, state, RelationGetRelationName(rel),
+							 deprecated_cols.len > 0 ? deprecated_cols.data : NULL);
+
+#if PG_VERSION_NUM < 130000
+		heap_close(rel, NoLock);
+#else
+		table_close(rel, NoLock);
+#endif
+	}
+	else
+	{
+		elog(DEBUG2, "  %s: using cached columns of FOREIGN TABLE %u", __func__, state->foreigntableid);
+		state->numcols = entry->numcols;
+		state->rdfTable = CopyRDFfdwTable(entry->rdfTable, entry->numcols);
+	}
+
+	if (entry->deprecated_cols)
+		ereport(WARNING,
+				(errcode(ERRCODE_WARNING_DEPRECATED_FEATURE),
+				 errmsg("the rdf_fdw FOREIGN TABLE \"%s\" has columns using native PostgreSQL types which are deprecated: %s",
+						entry->relname, entry->deprecated_cols),
+				 errhint("Use the \"rdfnode\" type instead.")));
+
+	/*
+	 * Loading FOREIGN TABLE OPTIONS
+	 */
+	foreach (cell, state->foreign_table->options)
+	{
+		DefElem *def = lfirst_node(DefElem, cell);
+
+		if (strcmp(RDF_TABLE_OPTION_SPARQL, def->defname) == 0)
+		{
+			state->raw_sparql = defGetString(def);
+			state->sparql_query = GetSPARQLQuery(state, entry);
+			state->is_sparql_parsable = IsSPARQLParsable(state);
+		}
+		else if (strcmp(RDF_TABLE_OPTION_SPARQL_UPDATE_PATTERN, def->defname) == 0)
+			state->sparql_update_pattern = defGetString(def);
+		else if (strcmp(RDF_TABLE_OPTION_READONLY, def->defname) == 0)
+			state->readonly = defGetBoolean(def);
+		else if (strcmp(RDF_TABLE_OPTION_LOG_SPARQL, def->defname) == 0)
+			state->log_sparql = defGetBoolean(def);
+		else if (strcmp(RDF_TABLE_OPTION_ENABLE_PUSHDOWN, def->defname) == 0)
+			state->enable_pushdown = defGetBoolean(def);
+		else if (strcmp(RDF_TABLE_OPTION_ENABLE_STREAMING, def->defname) == 0)
+			state->enable_streaming = defGetBoolean(def);
+		else if (strcmp(RDF_TABLE_OPTION_USE_REMOTE_ESTIMATE, def->defname) == 0)
+			state->use_remote_estimate = defGetBoolean(def);
+		else if (strcmp(RDF_TABLE_OPTION_ENABLE_TERM_BINDING, def->defname) == 0)
+			state->enable_term_binding = defGetBoolean(def);
+		else if (strcmp(RDF_TABLE_OPTION_ENABLE_DIRECT_MODIFY, def->defname) == 0)
+			state->enable_direct_modify = defGetBoolean(def);
+		else if (strcmp(RDF_TABLE_OPTION_VALUES_THRESHOLD, def->defname) == 0)
+			state->values_threshold = (int)strtol(defGetString(def), NULL, 0);
+	}
+
+	/*
+	 * Conditions on deprecated string columns are pushed down as literals,
+	 * unless the column sets a 'nodetype', so they would no longer match the
+	 * IRIs they used to. The conditions on tables whose SPARQL query contains
+	 * UNION, MINUS, sub-selects or solution modifiers were always evaluated
+	 * locally, which is kept for these columns.
+	 */
+	if (state->sparql_query && SPARQLQueryIsComposite(state->sparql_query))
+	{
+		for (int i = 0; i < state->numcols; i++)
+		{
+			RDFfdwColumn *col = state->rdfTable->cols[i];
+
+			if (col->pgtype != RDFNODEOID && IsStringDataType(col->pgtype) &&
+				!col->has_nodetype && !col->literaltype && !col->language)
+			{
+				elog(DEBUG2, "  %s: conditions on column \"%s\" are evaluated locally", __func__, col->name);
+				col->pushable = false;
+			}
+		}
 	}
 
 	elog(DEBUG1, "%s exit", __func__);
 }
 
+
 /*
- * SerializePlanData
- * -----------------
- * Converts parameters into Const variables, so that it can be properly
- * stored by the plan
+ * GetTableCacheEntry
+ * ------------------
+ * Returns the TableCache entry of the FOREIGN TABLE, creating the cache (and
+ * registering its invalidation callbacks) on first use. An entry that was
+ * just created, or whose table was altered since it was stored, is returned
+ * with 'valid' set to false, and must be filled with StoreTableCacheEntry().
  *
  * state: SPARQL, SERVER and FOREIGN TABLE info
  *
- * returns a List containing all converted parameterrs.
+ * returns the cache entry of state->foreigntableid
  */
-static List *SerializePlanData(RDFfdwState *state)
+static RDFfdwTableCacheEntry *GetTableCacheEntry(RDFfdwState *state)
 {
-	List *result = NIL;
-
-	elog(DEBUG1, "%s called", __func__);
-
-	result = lappend(result, IntToConst((int)state->numcols));
-	result = lappend(result, CStringToConst(state->sparql));
-	result = lappend(result, CStringToConst(state->sparql_prefixes));
-	result = lappend(result, CStringToConst(state->sparql_select));
-	result = lappend(result, CStringToConst(state->sparql_from));
-	result = lappend(result, CStringToConst(state->sparql_where));
-	result = lappend(result, CStringToConst(state->sparql_filter));
-	result = lappend(result, CStringToConst(state->sparql_filter_expr));
-	result = lappend(result, CStringToConst(state->sparql_orderby));
-	result = lappend(result, CStringToConst(state->sparql_limit));
-	result = lappend(result, CStringToConst(state->raw_sparql));
-	result = lappend(result, CStringToConst(state->endpoint));
-	result = lappend(result, CStringToConst(state->query_param));
-	result = lappend(result, CStringToConst(state->format));
-	result = lappend(result, CStringToConst(state->proxy));
-	result = lappend(result, CStringToConst(state->proxy_type));
-	result = lappend(result, CStringToConst(state->proxy_user));
-	result = lappend(result, CStringToConst(state->proxy_user_password));
-	result = lappend(result, CStringToConst(state->custom_params));
-	result = lappend(result, CStringToConst(state->user));
-	result = lappend(result, CStringToConst(state->password));
-	result = lappend(result, CStringToConst(state->token));
-	result = lappend(result, IntToConst((int)state->request_redirect));
-	result = lappend(result, IntToConst((int)state->enable_pushdown));
-	result = lappend(result, IntToConst((int)state->is_sparql_parsable));
-	result = lappend(result, IntToConst((int)state->log_sparql));
-	result = lappend(result, IntToConst((int)state->has_unparsable_conds));
-	result = lappend(result, IntToConst((int)state->request_max_redirect));
-	result = lappend(result, IntToConst((int)state->connect_timeout));
-	result = lappend(result, IntToConst((int)state->request_timeout));
-	result = lappend(result, IntToConst((int)state->max_retries));
-	result = lappend(result, IntToConst((int)state->max_response_size));
-	result = lappend(result, OidToConst(state->foreigntableid));
+	RDFfdwTableCacheEntry *entry;
+	bool found;
 
-	elog(DEBUG2, "%s: serializing table with %d columns", __func__, state->numcols);
-	for (int i = 0; i < state->numcols; ++i)
+	if (TableCache == NULL)
 	{
-		elog(DEBUG2, "%s: column name '%s'", __func__, state->rdfTable->cols[i]->name);
-		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->name));
+		HASHCTL ctl;
 
-		elog(DEBUG2, "%s: sparqlvar '%s'", __func__, state->rdfTable->cols[i]->sparqlvar);
-		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->sparqlvar));
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(RDFfdwTableCacheEntry);
+		TableCache = hash_create("rdf_fdw foreign tables", 32, &ctl, HASH_ELEM | HASH_BLOBS);
 
-		elog(DEBUG2, "%s: expression '%s'", __func__, state->rdfTable->cols[i]->expression);
-		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->expression));
+		/*
+		 * Table OPTIONS are stored in pg_foreign_table, whereas changes of
+		 * columns and their OPTIONS only invalidate the relcache entry.
+		 */
+		CacheRegisterSyscacheCallback(FOREIGNTABLEREL, TableCacheInvalCallback, (Datum)0);
+		CacheRegisterRelcacheCallback(TableCacheRelcacheCallback, (Datum)0);
+	}
 
-		elog(DEBUG2, "%s: literaltype '%s'", __func__, state->rdfTable->cols[i]->literaltype);
-		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->literaltype));
+	entry = (RDFfdwTableCacheEntry *)hash_search(TableCache, &state->foreigntableid, HASH_ENTER, &found);
 
-		elog(DEBUG2, "%s: literal_format '%s'", __func__, state->rdfTable->cols[i]->literal_fomat);
-		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->literal_fomat));
+	if (!found)
+	{
+		entry->valid = false;
+		entry->hashvalue = GetSysCacheHashValue1(FOREIGNTABLEREL,
+												 ObjectIdGetDatum(state->foreigntableid));
+		entry->cxt = NULL;
+		entry->relname = NULL;
+		entry->numcols = 0;
+		entry->rdfTable = NULL;
+		entry->deprecated_cols = NULL;
+		entry->query = NULL;
+	}
 
-		elog(DEBUG2, "%s: nodetype '%s'", __func__, state->rdfTable->cols[i]->nodetype);
-		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->nodetype));
+	return entry;
+}
 
-		elog(DEBUG2, "%s: language '%s'", __func__, state->rdfTable->cols[i]->language);
-		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->language));
+/*
+ * StoreTableCacheEntry
+ * --------------------
+ * Copies the columns just loaded into 'state' into the cache entry, replacing
+ * whatever the entry held before, and marks it as valid. The parsed SPARQL
+ * query is added by GetSPARQLQuery().
+ *
+ * entry          : cache entry of state->foreigntableid
+ * state          : SPARQL, SERVER and FOREIGN TABLE info
+ * relname        : FOREIGN TABLE name
+ * deprecated_cols: columns not using the rdfnode type, or NULL
+ */
+static void StoreTableCacheEntry(RDFfdwTableCacheEntry *entry, RDFfdwState *state, const char *relname, const char *deprecated_cols)
+{
+	MemoryContext oldcxt;
 
-		if (state->rdfTable->cols[i]->pgtype == RDFNODEOID)
-			elog(DEBUG2, "%s: pgtype 'RDFNODEOID'", __func__);
-		else
-			elog(DEBUG2, "%s: pgtype '%u'", __func__, state->rdfTable->cols[i]->pgtype);
-		result = lappend(result, OidToConst(state->rdfTable->cols[i]->pgtype));
+	if (entry->cxt != NULL)
+		MemoryContextDelete(entry->cxt);
 
-		elog(DEBUG2, "%s: pgtypmod '%d'", __func__, state->rdfTable->cols[i]->pgtypmod);
-		result = lappend(result, IntToConst(state->rdfTable->cols[i]->pgtypmod));
+	entry->cxt = AllocSetContextCreate(CacheMemoryContext,
+									   "rdf_fdw foreign table",
+									   ALLOCSET_SMALL_SIZES);
 
-		elog(DEBUG2, "%s: pgattnum '%d'", __func__, state->rdfTable->cols[i]->pgattnum);
-		result = lappend(result, IntToConst(state->rdfTable->cols[i]->pgattnum));
+	oldcxt = MemoryContextSwitchTo(entry->cxt);
+	entry->relname = pstrdup(relname);
+	entry->numcols = state->numcols;
+	entry->rdfTable = CopyRDFfdwTable(state->rdfTable, state->numcols);
+	entry->deprecated_cols = deprecated_cols ? pstrdup(deprecated_cols) : NULL;
+	entry->query = NULL;
+	MemoryContextSwitchTo(oldcxt);
 
-		elog(DEBUG2, "%s: used '%d'", __func__, state->rdfTable->cols[i]->used);
-		result = lappend(result, IntToConst(state->rdfTable->cols[i]->used));
+	entry->valid = true;
+}
 
-		elog(DEBUG2, "%s: pushable '%d'", __func__, state->rdfTable->cols[i]->pushable);
-		result = lappend(result, IntToConst(state->rdfTable->cols[i]->pushable));
-	}
+/*
+ * CopyRDFfdwTable
+ * ---------------
+ * Copies the columns of a FOREIGN TABLE and their OPTIONS into the current
+ * memory context. The input functions set by InitColumnInput() are not
+ * copied.
+ *
+ * table  : columns to be copied
+ * numcols: number of columns in 'table'
+ *
+ * returns the copy of 'table'
+ */
+static RDFfdwTable *CopyRDFfdwTable(RDFfdwTable *table, int numcols)
+{
+	RDFfdwTable *result = (RDFfdwTable *)palloc0(sizeof(RDFfdwTable));
 
-	result = lappend(result, CStringToConst(state->server->servername));
-	result = lappend(result, IntToConst((int)state->batch_size));
+	result->cols = (RDFfdwColumn **)palloc0(sizeof(RDFfdwColumn *) * numcols);
+
+	for (int i = 0; i < numcols; i++)
+	{
+		RDFfdwColumn *col = (RDFfdwColumn *)palloc(sizeof(RDFfdwColumn));
+
+		memcpy(col, table->cols[i], sizeof(RDFfdwColumn));
+		col->name = pstrdup(col->name);
+		col->sparqlvar = col->sparqlvar ? pstrdup(col->sparqlvar) : NULL;
+		col->expression = col->expression ? pstrdup(col->expression) : NULL;
+		col->literaltype = col->literaltype ? pstrdup(col->literaltype) : NULL;
+		col->literal_fomat = col->literal_fomat ? pstrdup(col->literal_fomat) : NULL;
+		col->nodetype = col->nodetype ? pstrdup(col->nodetype) : NULL;
+		col->language = col->language ? pstrdup(col->language) : NULL;
+		col->typinput = NULL;
+
+		result->cols[i] = col;
+	}
 
-	elog(DEBUG1, "%s exit", __func__);
 	return result;
 }
 
 /*
- * DeserializePlanData
- * -------------------
- * Converts Const variables created using SerializePlanData back
- * into pointers.
- *
- * IMPORTANT: fields must be extracted in the EXACT same order they were
- * appended in SerializePlanData(); any mismatch silently produces wrong values.
+ * GetSPARQLQuery
+ * --------------
+ * Returns the clauses of the FOREIGN TABLE's SPARQL query. The query is
+ * parsed the first time the table is used in a backend, or after it was
+ * altered, and the result is kept in its TableCache entry for all subsequent
+ * planning cycles. The query is parsed into the current memory context
+ * before it is copied into the cache, so that an ERROR of a malformed query
+ * leaves no half-parsed query behind.
  *
  * state: SPARQL, SERVER and FOREIGN TABLE info
+ * entry: cache entry of state->foreigntableid
  *
- * returns a RDFfdwState containing all converted parameterrs.
+ * returns a copy of the cached clauses in the current memory context
  */
-static struct RDFfdwState *DeserializePlanData(List *list)
+static SPARQLQuery *GetSPARQLQuery(RDFfdwState *state, RDFfdwTableCacheEntry *entry)
 {
-	struct RDFfdwState *state = (struct RDFfdwState *)palloc0(sizeof(RDFfdwState));
-	ListCell *cell = list_head(list);
-
 	elog(DEBUG1, "%s called", __func__);
 
-	state->numcols = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	state->rowcount = 0;
-	state->pagesize = 0;
-	cell = list_next(list, cell);
-
-	state->sparql = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->sparql_prefixes = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->sparql_select = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->sparql_from = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->sparql_where = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->sparql_filter = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->sparql_filter_expr = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->sparql_orderby = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->sparql_limit = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->raw_sparql = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->endpoint = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
-
-	state->query_param = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+	Assert(entry->cxt != NULL);
 
-	state->format = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+	if (entry->query == NULL)
+	{
+		SPARQLQuery *query = SPARQLParseQuery(state->raw_sparql);
+		MemoryContext oldcxt;
 
-	state->proxy = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+		if (query->error)
+			elog(DEBUG2, "  %s: SPARQL query cannot be parsed: %s", __func__, query->error);
 
-	state->proxy_type = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+		oldcxt = MemoryContextSwitchTo(entry->cxt);
+		entry->query = SPARQLCopyQuery(query);
+		MemoryContextSwitchTo(oldcxt);
+	}
+	else
+		elog(DEBUG2, "  %s: using cached query of FOREIGN TABLE %u", __func__, state->foreigntableid);
 
-	state->proxy_user = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+	elog(DEBUG1, "%s exit", __func__);
+	return SPARQLCopyQuery(entry->query);
+}
 
-	state->proxy_user_password = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+/*
+ * TableCacheInvalCallback
+ * -----------------------
+ * Syscache invalidation callback for pg_foreign_table, e.g. after an ALTER
+ * FOREIGN TABLE ... OPTIONS. The affected entries are only marked as invalid,
+ * as they might still be in use, and are loaded again when the table is used
+ * next.
+ */
+static void TableCacheInvalCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	HASH_SEQ_STATUS scan;
+	RDFfdwTableCacheEntry *entry;
 
-	state->custom_params = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+	Assert(TableCache != NULL);
 
-	state->user = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+	hash_seq_init(&scan, TableCache);
+	while ((entry = (RDFfdwTableCacheEntry *)hash_seq_search(&scan)) != NULL)
+	{
+		if (hashvalue == 0 || entry->hashvalue == hashvalue)
+			entry->valid = false;
+	}
+}
 
-	state->password = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+/*
+ * TableCacheRelcacheCallback
+ * --------------------------
+ * Relcache invalidation callback, called e.g. when columns of a FOREIGN TABLE
+ * are added, dropped, renamed or have their OPTIONS changed. An InvalidOid
+ * invalidates all entries.
+ */
+static void TableCacheRelcacheCallback(Datum arg, Oid relid)
+{
+	RDFfdwTableCacheEntry *entry;
 
-	state->token = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+	Assert(TableCache != NULL);
 
-	state->request_redirect = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+	if (OidIsValid(relid))
+	{
+		entry = (RDFfdwTableCacheEntry *)hash_search(TableCache, &relid, HASH_FIND, NULL);
 
-	state->enable_pushdown = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+		if (entry)
+			entry->valid = false;
+	}
+	else
+	{
+		HASH_SEQ_STATUS scan;
 
-	state->is_sparql_parsable = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+		hash_seq_init(&scan, TableCache);
+		while ((entry = (RDFfdwTableCacheEntry *)hash_seq_search(&scan)) != NULL)
+			entry->valid = false;
+	}
+}
 
-	state->log_sparql = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+static int rdfIsForeignRelUpdatable(Relation rel)
+{
+	bool readonly = false;
+	ListCell *lc;
+	ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+	ForeignServer *server = GetForeignServer(table->serverid);
 
-	state->has_unparsable_conds = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+	foreach(lc, server->options)
+	{
+		DefElem *def = (DefElem *) lfirst(lc);
+		if (strcmp(def->defname, RDF_SERVER_OPTION_READONLY) == 0)
+			readonly = defGetBoolean(def);
+	}
 
-	state->request_max_redirect = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+	foreach(lc, table->options)
+	{
+		DefElem *def = (DefElem *) lfirst(lc);
+		if (strcmp(def->defname, RDF_TABLE_OPTION_READONLY) == 0)
+			readonly = defGetBoolean(def);
+	}
 
-	state->connect_timeout = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+	/* if readonly, no need to look for update triple pattern */
+	if (readonly)
+    	return 0;
 
-	state->request_timeout = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+	foreach (lc, table->options)
+	{
+		DefElem *def = (DefElem *)lfirst(lc);
 
-	state->max_retries = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+		if (strcmp(def->defname, RDF_TABLE_OPTION_SPARQL_UPDATE_PATTERN) == 0)
+		{
+			char *pattern = defGetString(def);
 
-	state->max_response_size = (long)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+			if (pattern && strlen(pattern) > 0)
+				return (1 << CMD_INSERT) | (1 << CMD_UPDATE) | (1 << CMD_DELETE);
+		}
+	}
 
-	state->foreigntableid = DatumGetObjectId(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+	/* read-only: no triple pattern found */
+	return 0;
+}
 
-	elog(DEBUG2, "  %s: deserializing table with %d columns", __func__, state->numcols);
-	state->rdfTable = (struct RDFfdwTable *)palloc0(sizeof(struct RDFfdwTable));
-	state->rdfTable->cols = (struct RDFfdwColumn **)palloc0(sizeof(struct RDFfdwColumn *) * state->numcols);
+static void LoadRDFServerInfo(RDFfdwState *state)
+{
+	elog(DEBUG1, "%s called", __func__);
 
-	for (int i = 0; i < state->numcols; ++i)
+	if (state->server)
 	{
-		state->rdfTable->cols[i] = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
-
-		state->rdfTable->cols[i]->name = ConstToCString(lfirst(cell));
-		cell = list_next(list, cell);
-		elog(DEBUG2, "  %s: column name '%s'", __func__, state->rdfTable->cols[i]->name);
-
-		state->rdfTable->cols[i]->sparqlvar = ConstToCString(lfirst(cell));
-		cell = list_next(list, cell);
+		ListCell *cell;
 
-		state->rdfTable->cols[i]->expression = ConstToCString(lfirst(cell));
-		cell = list_next(list, cell);
+		foreach (cell, state->server->options)
+		{
+			DefElem *def = lfirst_node(DefElem, cell);
 
-		state->rdfTable->cols[i]->literaltype = ConstToCString(lfirst(cell));
-		cell = list_next(list, cell);
+			if (strcmp(RDF_SERVER_OPTION_UPDATE_URL, def->defname) == 0 &&
+				(state->sparql_query_type == SPARQL_INSERT ||
+				 state->sparql_query_type == SPARQL_DELETE ||
+				 state->sparql_query_type == SPARQL_UPDATE))
+				state->endpoint = defGetString(def);
 
-		state->rdfTable->cols[i]->literal_fomat = ConstToCString(lfirst(cell));
-		cell = list_next(list, cell);
+			else if (strcmp(RDF_SERVER_OPTION_SELECT_URL, def->defname) == 0 &&
+					 !state->endpoint)
+				state->endpoint = defGetString(def);
 
-		state->rdfTable->cols[i]->nodetype = ConstToCString(lfirst(cell));
-		cell = list_next(list, cell);
+			else if (strcmp(RDF_SERVER_OPTION_GRAPH_STORE_URL, def->defname) == 0)
+				state->graph_store_url = defGetString(def);
 
-		state->rdfTable->cols[i]->language = ConstToCString(lfirst(cell));
-		cell = list_next(list, cell);
+			else if (strcmp(RDF_SERVER_OPTION_FORMAT, def->defname) == 0)
+				state->format = defGetString(def);
 
-		state->rdfTable->cols[i]->pgtype = DatumGetObjectId(((Const *)lfirst(cell))->constvalue);
-		cell = list_next(list, cell);
+			else if (strcmp(RDF_SERVER_OPTION_CUSTOMPARAM, def->defname) == 0)
+				state->custom_params = defGetString(def);
 
-		state->rdfTable->cols[i]->pgtypmod = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-		cell = list_next(list, cell);
+			else if (strcmp(RDF_SERVER_OPTION_HTTP_PROXY, def->defname) == 0)
+			{
+				state->proxy = defGetString(def);
+				state->proxy_type = RDF_SERVER_OPTION_HTTP_PROXY;
+			}
+			else if (strcmp(RDF_SERVER_OPTION_HTTPS_PROXY, def->defname) == 0)
+			{
+				state->proxy = defGetString(def);
+				state->proxy_type = RDF_SERVER_OPTION_HTTPS_PROXY;
+			}
 
-		state->rdfTable->cols[i]->pgattnum = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-		cell = list_next(list, cell);
+			/* these options are now tied to USER MAPPING */
+			if (strcmp(RDF_USERMAPPING_OPTION_PROXYUSER, def->defname) == 0 ||
+				strcmp(RDF_USERMAPPING_OPTION_PROXYPASSWORD, def->defname) == 0)
+			{
+				ereport(WARNING,
+						(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+						 errmsg("option \"%s\" is no longer valid for SERVER", def->defname),
+						 errhint("Specify proxy credentials in USER MAPPING instead: "
+								 "CREATE USER MAPPING FOR ... SERVER ... OPTIONS (proxy_user '...', proxy_password '...');")));
+			}
 
-		state->rdfTable->cols[i]->used = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-		cell = list_next(list, cell);
+			else if (strcmp(RDF_SERVER_OPTION_FETCH_SIZE, def->defname) == 0)
+			{
+				char *tailpt;
+				char *fetch_size_str = defGetString(def);
+				state->fetch_size = strtol(fetch_size_str, &tailpt, 0);
+			}
+			else if (strcmp(RDF_SERVER_OPTION_BATCH_SIZE, def->defname) == 0)
+			{
+				char *tailpt;
+				char *batch_size_str = defGetString(def);
+				state->batch_size = strtol(batch_size_str, &tailpt, 0);
+			}
+			else if (strcmp(RDF_SERVER_OPTION_CONNECTRETRY, def->defname) == 0)
+			{
+				char *tailpt;
+				char *maxretry_str = defGetString(def);
+				state->max_retries = strtol(maxretry_str, &tailpt, 0);
+			}
+			else if (strcmp(RDF_SERVER_OPTION_MAX_RESPONSE_SIZE, def->defname) == 0)
+			{
+				char *tailpt;
+				char *max_size_str = defGetString(def);
+				state->max_response_size = strtol(max_size_str, &tailpt, 0);
+			}
+			else if (strcmp(RDF_SERVER_OPTION_READONLY, def->defname) == 0)
+				state->readonly = defGetBoolean(def);
+			else if (strcmp(RDF_SERVER_OPTION_REQUEST_REDIRECT, def->defname) == 0)
+				state->request_redirect = defGetBoolean(def);
+			else if (strcmp(RDF_SERVER_OPTION_REQUEST_MAX_REDIRECT, def->defname) == 0)
+			{
+				char *tailpt;
+				char *maxredirect_str = defGetString(def);
+				state->request_max_redirect = strtol(maxredirect_str, &tailpt, 0);
+			}
+			else if (strcmp(RDF_SERVER_OPTION_CONNECTTIMEOUT, def->defname) == 0)
+			{
+				char *tailpt;
+				char *timeout_str = defGetString(def);
+				state->connect_timeout = strtol(timeout_str, &tailpt, 0);
+			}
+			else if (strcmp(RDF_SERVER_OPTION_REQUEST_TIMEOUT, def->defname) == 0)
+			{
+				char *tailpt;
+				char *timeout_str = defGetString(def);
+				state->request_timeout = strtol(timeout_str, &tailpt, 0);
+			}
+			else if (strcmp(RDF_SERVER_OPTION_ENABLE_PUSHDOWN, def->defname) == 0)
+				state->enable_pushdown = defGetBoolean(def);
 
-		state->rdfTable->cols[i]->pushable = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-		cell = list_next(list, cell);
-	}
+			else if (strcmp(RDF_SERVER_OPTION_ENABLE_XML_HUGE, def->defname) == 0)
+				state->enable_xml_huge = defGetBoolean(def);
 
-	state->server = (ForeignServer *)palloc0(sizeof(ForeignServer));
-	state->server->servername = ConstToCString(lfirst(cell));
-	cell = list_next(list, cell);
+			else if (strcmp(RDF_SERVER_OPTION_ENABLE_STREAMING, def->defname) == 0)
+				state->enable_streaming = defGetBoolean(def);
 
-	state->batch_size = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
-	cell = list_next(list, cell);
+			else if (strcmp(RDF_SERVER_OPTION_USE_REMOTE_ESTIMATE, def->defname) == 0)
+				state->use_remote_estimate = defGetBoolean(def);
 
-	elog(DEBUG1, "%s exit", __func__);
-	return state;
-}
+			else if (strcmp(RDF_SERVER_OPTION_ENABLE_TERM_BINDING, def->defname) == 0)
+				state->enable_term_binding = defGetBoolean(def);
 
-static size_t CURLWriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp)
-{
-	size_t realsize = size * nmemb;
-	struct MemoryStruct *mem = (struct MemoryStruct *)userp;
-	char *ptr;
+			else if (strcmp(RDF_SERVER_OPTION_ENABLE_DIRECT_MODIFY, def->defname) == 0)
+				state->enable_direct_modify = defGetBoolean(def);
 
-	elog(DEBUG3, "%s called", __func__);
+			else if (strcmp(RDF_SERVER_OPTION_VALUES_THRESHOLD, def->defname) == 0)
+				state->values_threshold = (int)strtol(defGetString(def), NULL, 0);
 
-	if (mem->max_size > 0 && mem->size + realsize > mem->max_size)
-		ereport(ERROR,
-				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
-				 errmsg("SPARQL response exceeds max_response_size limit of %zu bytes", mem->max_size),
-				 errhint("Increase max_response_size in CREATE SERVER or refine your SPARQL query to return fewer results.")));
+			else if (strcmp(RDF_SERVER_OPTION_MAX_VALUES_SIZE, def->defname) == 0)
+				state->max_values_size = strtol(defGetString(def), NULL, 0);
 
-	ptr = repalloc(mem->memory, mem->size + realsize + 1);
+			else if (strcmp(RDF_SERVER_OPTION_REMOTE_ESTIMATE_TTL, def->defname) == 0)
+			{
+				char *tailpt;
+				char *ttl_str = defGetString(def);
+				state->remote_estimate_ttl = strtol(ttl_str, &tailpt, 0);
+			}
 
-	mem->memory = ptr;
-	memcpy(&(mem->memory[mem->size]), contents, realsize);
-	mem->size += realsize;
-	mem->memory[mem->size] = 0;
+			else if (strcmp(RDF_SERVER_OPTION_QUERY_PARAM, def->defname) == 0)
+				state->query_param = defGetString(def);
 
-	elog(DEBUG3, "%s exit: returning '%lu' (realsize)", __func__, realsize);
-	return realsize;
+			else if (strcmp(RDF_SERVER_OPTION_BASE_URI, def->defname) == 0)
+				state->base_uri = defGetString(def);
+
+			else if (strcmp(RDF_SERVER_OPTION_PREFIX_CONTEXT, def->defname) == 0)
+				state->prefix_context = defGetString(def);
+		}
+	}
+
+	elog(DEBUG1, "%s exit", __func__);
 }
 
-static size_t CURLHeaderCallback(char *contents, size_t size, size_t nmemb, void *userp)
+static void LoadRDFUserMapping(RDFfdwState *state)
 {
 
-	size_t realsize = size * nmemb;
-	struct MemoryStruct *mem = (struct MemoryStruct *)userp;
-	char *ptr;
-	char *sparqlxml = "content-type: application/sparql-results+xml";
-	char *sparqlxmlutf8 = "content-type: application/sparql-results+xml; charset=utf-8";
-	char *rdfxml = "content-type: application/rdf+xml";
-	char *rdfxmlutf8 = "content-type: application/rdf+xml;charset=utf-8";
+	Datum datum;
+	HeapTuple tp;
+	bool isnull;
+	UserMapping *um;
+	List *options = NIL;
+	ListCell *cell;
+	bool usermatch = true;
 
-	elog(DEBUG3, "%s called", __func__);
+	elog(DEBUG1, "%s called", __func__);
 
-	Assert(contents);
+	tp = SearchSysCache2(USERMAPPINGUSERSERVER,
+						 ObjectIdGetDatum(GetUserId()),
+						 ObjectIdGetDatum(state->server->serverid));
 
-	/* is it a "content-type" entry? "*/
-	if (strncasecmp(contents, sparqlxml, 13) == 0)
+	if (!HeapTupleIsValid(tp))
 	{
+		elog(DEBUG2, "%s: not found for the specific user -- try PUBLIC", __func__);
+		tp = SearchSysCache2(USERMAPPINGUSERSERVER,
+							 ObjectIdGetDatum(InvalidOid),
+							 ObjectIdGetDatum(state->server->serverid));
+	}
 
-		if (strncasecmp(contents, sparqlxml, strlen(sparqlxml)) != 0 &&
-			strncasecmp(contents, sparqlxmlutf8, strlen(sparqlxmlutf8)) != 0 &&
-			strncasecmp(contents, rdfxml, strlen(rdfxml)) != 0 &&
-			strncasecmp(contents, rdfxmlutf8, strlen(rdfxmlutf8)) != 0)
-		{
-			/* remove crlf */
-			contents[strlen(contents) - 2] = '\0';
-			elog(DEBUG3, "%s: unsupported header entry: \"%s\"", __func__, contents);
-			elog(DEBUG3, "%s: %s", __func__, mem->memory);
-			return realsize;
-		}
+	if (!HeapTupleIsValid(tp))
+	{
+		elog(DEBUG2, "%s: user mapping not found for user \"%s\", server \"%s\"",
+			 __func__, MappingUserName(GetUserId()), state->server->servername);
+
+		usermatch = false;
 	}
 
-	ptr = repalloc(mem->memory, mem->size + realsize + 1);
+	if (usermatch)
+	{
+		elog(DEBUG2, "%s: setting UserMapping", __func__);
+		um = (UserMapping *)palloc(sizeof(UserMapping));
+#if PG_VERSION_NUM >= 120000
+		um->umid = ((Form_pg_user_mapping)GETSTRUCT(tp))->oid;
+#elif PG_VERSION_NUM >= 90600
+		um->umid = HeapTupleGetOid(tp);
+#endif
+		um->userid = GetUserId();
+		um->serverid = state->server->serverid;
 
-	if (!ptr)
-		ereport(ERROR,
-				(errcode(ERRCODE_FDW_OUT_OF_MEMORY),
-				 errmsg("[%s] out of memory (repalloc returned NULL)", __func__)));
+		elog(DEBUG2, "%s: extract the umoptions", __func__);
+		datum = SysCacheGetAttr(USERMAPPINGUSERSERVER,
+								tp,
+								Anum_pg_user_mapping_umoptions,
+								&isnull);
+		if (isnull)
+			um->options = NIL;
+		else
+			um->options = untransformRelOptions(datum);
 
-	mem->memory = ptr;
-	memcpy(&(mem->memory[mem->size]), contents, realsize);
-	mem->size += realsize;
-	mem->memory[mem->size] = 0;
+		if (um->options != NIL)
+		{
+			options = list_concat(options, um->options);
 
-	elog(DEBUG4, "%s: realsize='%lu'", __func__, realsize);
-	elog(DEBUG3, "%s exit", __func__);
-	return realsize;
-}
+			foreach (cell, options)
+			{
+				DefElem *def = (DefElem *)lfirst(cell);
 
-/*
- * IsSensitiveHeader
- * -----------------
- * Returns the field-name of a sensitive HTTP header if `line` begins with
- * one, or NULL otherwise.  Comparison is case-insensitive (RFC 9110 §5.1).
- */
-static const char *
-IsSensitiveHeader(const char *line)
-{
-	static const struct
-	{
-		const char *name;
-		size_t      len;
-	} sensitive_headers[] = {
-		{ "Authorization:",       sizeof("Authorization:")       - 1 },
-		{ "Proxy-Authorization:", sizeof("Proxy-Authorization:") - 1 },
-		{ NULL, 0 }
-	};
+				if (strcmp(def->defname, RDF_USERMAPPING_OPTION_USER) == 0)
+				{
+					state->user = pstrdup(defGetString(def));
+					elog(DEBUG2, "%s: %s '%s'", __func__, def->defname, state->user);
+				}
+				else if (strcmp(def->defname, RDF_USERMAPPING_OPTION_PASSWORD) == 0)
+				{
+					state->password = pstrdup(defGetString(def));
+					elog(DEBUG2, "%s: %s '*******'", __func__, def->defname);
+				}
+				else if (strcmp(def->defname, RDF_USERMAPPING_OPTION_TOKEN) == 0)
+				{
+					state->token = pstrdup(defGetString(def));
+					elog(DEBUG2, "%s: %s '*******'", __func__, def->defname);
+				}
+				else if (strcmp(def->defname, RDF_USERMAPPING_OPTION_PROXYUSER) == 0)
+				{
+					state->proxy_user = pstrdup(defGetString(def));
+					elog(DEBUG2, "%s: proxy user '%s'", __func__, def->defname);
+				}
+				else if (strcmp(def->defname, RDF_USERMAPPING_OPTION_PROXYPASSWORD) == 0)
+				{
+					state->proxy_user_password = pstrdup(defGetString(def));
+					elog(DEBUG2, "%s: proxy password '*******'", __func__);
+				}
+			}
+		}
 
-	for (int i = 0; sensitive_headers[i].name != NULL; i++)
-	{
-		if (strncasecmp(line, sensitive_headers[i].name,
-						sensitive_headers[i].len) == 0)
-			return sensitive_headers[i].name;
+		ReleaseSysCache(tp);
 	}
 
-	return NULL;
+	elog(DEBUG1, "%s exit", __func__);
 }
 
 /*
- * CURLDebugCallback
+ * SerializePlanData
  * -----------------
- * Custom libcurl debug callback. Routes all verbose output through
- * PostgreSQL's elog() at DEBUG3 level rather than writing directly to
- * stderr, and redacts Authorization headers so credentials are never
- * written to server logs.
+ * Converts parameters into Const variables, so that it can be properly
+ * stored by the plan
  *
- * handle  : the curl handle (unused)
- * type    : category of the debug data
- * data    : pointer to the debug data (NOT null-terminated)
- * size    : number of bytes in data
- * userptr : user-supplied pointer (unused)
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns a List containing all converted parameterrs.
  */
-static int
-CURLDebugCallback(CURL *handle, curl_infotype type, char *data, size_t size, void *userptr)
+static List *SerializePlanData(RDFfdwState *state)
 {
-	const char    *prefix;
-	StringInfoData buf;
+	List *result = NIL;
+	ListCell *cell;
 
-	switch (type)
-	{
-		case CURLINFO_TEXT:       prefix = "* "; break;
-		case CURLINFO_HEADER_IN:  prefix = "< "; break;
-		case CURLINFO_HEADER_OUT: prefix = "> "; break;
-		default:
-			return 0;	/* skip raw data blobs (bodies, SSL frames) */
-	}
+	elog(DEBUG1, "%s called", __func__);
 
-	/*
-	 * curl's data pointer is NOT null-terminated, so copy it into a palloc'd
-	 * buffer before using any string functions on it.
-	 */
-	initStringInfo(&buf);
-	appendBinaryStringInfo(&buf, data, (int) size);
+	result = lappend(result, IntToConst((int)state->numcols));
+	result = lappend(result, CStringToConst(state->sparql));
+	result = lappend(result, CStringToConst(state->sparql_prefixes));
+	result = lappend(result, CStringToConst(state->sparql_select));
+	result = lappend(result, CStringToConst(state->sparql_from));
+	result = lappend(result, CStringToConst(state->sparql_where));
+	result = lappend(result, CStringToConst(state->sparql_filter));
+	result = lappend(result, CStringToConst(state->sparql_filter_expr));
+	result = lappend(result, CStringToConst(state->sparql_orderby));
+	result = lappend(result, CStringToConst(state->sparql_limit));
+	result = lappend(result, CStringToConst(state->raw_sparql));
+	result = lappend(result, CStringToConst(state->endpoint));
+	result = lappend(result, CStringToConst(state->query_param));
+	result = lappend(result, CStringToConst(state->format));
+	result = lappend(result, CStringToConst(state->proxy));
+	result = lappend(result, CStringToConst(state->proxy_type));
+	result = lappend(result, CStringToConst(state->proxy_user));
+	result = lappend(result, CStringToConst(state->proxy_user_password));
+	result = lappend(result, CStringToConst(state->custom_params));
+	result = lappend(result, CStringToConst(state->user));
+	result = lappend(result, CStringToConst(state->password));
+	result = lappend(result, CStringToConst(state->token));
+	result = lappend(result, IntToConst((int)state->request_redirect));
+	result = lappend(result, IntToConst((int)state->enable_pushdown));
+	result = lappend(result, IntToConst((int)state->is_sparql_parsable));
+	result = lappend(result, IntToConst((int)state->log_sparql));
+	result = lappend(result, IntToConst((int)state->has_unparsable_conds));
+	result = lappend(result, IntToConst((int)state->request_max_redirect));
+	result = lappend(result, IntToConst((int)state->connect_timeout));
+	result = lappend(result, IntToConst((int)state->request_timeout));
+	result = lappend(result, IntToConst((int)state->max_retries));
+	result = lappend(result, IntToConst((int)state->max_response_size));
+	result = lappend(result, OidToConst(state->foreigntableid));
 
-	if (type == CURLINFO_HEADER_OUT)
+	elog(DEBUG2, "%s: serializing table with %d columns", __func__, state->numcols);
+	for (int i = 0; i < state->numcols; ++i)
 	{
-		/*
-		 * CURLINFO_HEADER_OUT delivers the entire outgoing request header
-		 * block (request line + all headers) as one multi-line chunk per
-		 * invocation.  Split it line-by-line so each sensitive header can be
-		 * redacted individually.
-		 */
-		char *pos = buf.data;
-
-		while (*pos != '\0')
-		{
-			char       *eol   = pos + strcspn(pos, "\r\n");
-			char        saved = *eol;
-			const char *match;
+		elog(DEBUG2, "%s: column name '%s'", __func__, state->rdfTable->cols[i]->name);
+		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->name));
 
-			*eol = '\0';	/* temporarily terminate the line */
+		elog(DEBUG2, "%s: sparqlvar '%s'", __func__, state->rdfTable->cols[i]->sparqlvar);
+		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->sparqlvar));
 
-			if (*pos != '\0')	/* skip blank lines */
-			{
-				match = IsSensitiveHeader(pos);
-				if (match)
-					elog(DEBUG3, "[curl] > %s [REDACTED]", match);
-				else
-					elog(DEBUG3, "[curl] > %s", pos);
-			}
+		elog(DEBUG2, "%s: expression '%s'", __func__, state->rdfTable->cols[i]->expression);
+		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->expression));
 
-			*eol = saved;
-			pos  = eol;
-			while (*pos == '\r' || *pos == '\n')
-				pos++;
-		}
-	}
-	else
-	{
-		const char *match;
+		elog(DEBUG2, "%s: literaltype '%s'", __func__, state->rdfTable->cols[i]->literaltype);
+		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->literaltype));
 
-		/* Strip trailing CRLF for cleaner log output. */
-		while (buf.len > 0 &&
-			   (buf.data[buf.len - 1] == '\n' || buf.data[buf.len - 1] == '\r'))
-			buf.data[--buf.len] = '\0';
+		elog(DEBUG2, "%s: literal_format '%s'", __func__, state->rdfTable->cols[i]->literal_fomat);
+		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->literal_fomat));
 
-		/*
-		 * Redact sensitive response headers.  Informational text lines
-		 * (CURLINFO_TEXT) are logged as-is — they never contain raw
-		 * credential values.
-		 */
-		match = (type == CURLINFO_HEADER_IN) ? IsSensitiveHeader(buf.data) : NULL;
-		if (match)
-			elog(DEBUG3, "[curl] %s%s [REDACTED]", prefix, match);
-		else
-			elog(DEBUG3, "[curl] %s%s", prefix, buf.data);
-	}
+		elog(DEBUG2, "%s: nodetype '%s'", __func__, state->rdfTable->cols[i]->nodetype);
+		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->nodetype));
 
-	pfree(buf.data);
-	return 0;
-}
+		elog(DEBUG2, "%s: language '%s'", __func__, state->rdfTable->cols[i]->language);
+		result = lappend(result, CStringToConst(state->rdfTable->cols[i]->language));
 
-/*
- * CURLProgressCallback
- * --------------------
- * Progress callback function for cURL requests. This allows us to
- * check for interruptions to immediatelly cancel the request.
- *
- * dltotal: Total bytes to download
- * dlnow: Bytes downloaded so far
- * ultotal: Total bytes to upload
- * ulnow: Bytes uploaded so far
- */
-static int CURLProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
-{
-	CHECK_FOR_INTERRUPTS();
+		if (state->rdfTable->cols[i]->pgtype == RDFNODEOID)
+			elog(DEBUG2, "%s: pgtype 'RDFNODEOID'", __func__);
+		else
+			elog(DEBUG2, "%s: pgtype '%u'", __func__, state->rdfTable->cols[i]->pgtype);
+		result = lappend(result, OidToConst(state->rdfTable->cols[i]->pgtype));
 
-	return 0;
-}
+		elog(DEBUG2, "%s: pgtypmod '%d'", __func__, state->rdfTable->cols[i]->pgtypmod);
+		result = lappend(result, IntToConst(state->rdfTable->cols[i]->pgtypmod));
 
-/*
- * GetRDFColumn
- * -------------
- * Returns the RDFfdwColumn mapped to the table column in `columname`
- *
- * state    : SPARQL, SERVER and FOREIGN TABLE info
- * columname: name of the FOREIGN TABLE column
- *
- * returns RDFfdwColumn loded with all its attributes
- */
-static struct RDFfdwColumn *GetRDFColumn(struct RDFfdwState *state, char *columnname)
-{
+		elog(DEBUG2, "%s: pgattnum '%d'", __func__, state->rdfTable->cols[i]->pgattnum);
+		result = lappend(result, IntToConst(state->rdfTable->cols[i]->pgattnum));
 
-	elog(DEBUG2, "%s called: column='%s'", __func__, columnname);
+		elog(DEBUG2, "%s: used '%d'", __func__, state->rdfTable->cols[i]->used);
+		result = lappend(result, IntToConst(state->rdfTable->cols[i]->used));
 
-	if (!columnname)
-	{
-		elog(DEBUG2, "%s exit: returning NULL (columnname is NULL)", __func__);
-		return NULL;
+		elog(DEBUG2, "%s: pushable '%d'", __func__, state->rdfTable->cols[i]->pushable);
+		result = lappend(result, IntToConst(state->rdfTable->cols[i]->pushable));
 	}
 
-	for (int i = 0; i < state->numcols; i++)
-	{
-		if (strcmp(state->rdfTable->cols[i]->name, columnname) == 0)
-		{
-			elog(DEBUG2, "%s exit: rerurning match for columname '%s'", __func__, columnname);
-			return state->rdfTable->cols[i];
-		}
-	}
+	result = lappend(result, CStringToConst(state->server->servername));
+	result = lappend(result, IntToConst((int)state->batch_size));
+	result = lappend(result, OidToConst(state->server->serverid));
+	result = lappend(result, IntToConst((int)state->enable_xml_huge));
+	result = lappend(result, IntToConst((int)state->enable_streaming));
+	result = lappend(result, IntToConst((int)state->is_join));
+	result = lappend(result, CStringToConst(state->sparql_groupby));
+	result = lappend(result, CStringToConst(state->sparql_having));
+
+	result = lappend(result, IntToConst(list_length(state->param_columns)));
+	foreach (cell, state->param_columns)
+		result = lappend(result, CStringToConst(strVal(lfirst(cell))));
+	result = lappend(result, CStringToConst(state->sparql_values));
+	result = lappend(result, CStringToConst(state->param_batch_sql));
+
+	result = lappend(result, IntToConst(list_length(state->values_chunks)));
+	foreach (cell, state->values_chunks)
+		result = lappend(result, CStringToConst((char *)lfirst(cell)));
 
-	elog(DEBUG2, "%s exit: rerurning NULL (no match found for '%s')", __func__, columnname);
-	return NULL;
+	elog(DEBUG1, "%s exit", __func__);
+	return result;
 }
 
 /*
- * InitSession
- * ----------
- * This function loads the 'OPTION' variables declared in SERVER and FOREIGN
- * TABLE statements. It also parses the raw_sparql query into its main clauses,
- * so that it can be later modified to match the SQL SELECT clause and commands
- * that can be pushed down to SPARQL
+ * DeserializePlanData
+ * -------------------
+ * Converts Const variables created using SerializePlanData back
+ * into pointers.
  *
- * state  : SPARQL, SERVER and FOREIGN TABLE info
- * baserel: Conditions and columns used in the SQL query
- * root   : Planner info
+ * IMPORTANT: fields must be extracted in the EXACT same order they were
+ * appended in SerializePlanData(); any mismatch silently produces wrong values.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns a RDFfdwState containing all converted parameterrs.
  */
-static void InitSession(struct RDFfdwState *state, RelOptInfo *baserel, PlannerInfo *root)
+static struct RDFfdwState *DeserializePlanData(List *list)
 {
-
-#if PG_VERSION_NUM >= 90600
-	List *columnlist = baserel->reltarget->exprs;
-#else
-	List *columnlist = baserel->reltargetlist;
-#endif
-	List *conditions = baserel->baserestrictinfo;
-	ListCell *cell;
-	StringInfoData select;
+	struct RDFfdwState *state = (struct RDFfdwState *)palloc0(sizeof(RDFfdwState));
+	ListCell *cell = list_head(list);
+	int nparams;
+	int nchunks;
 
 	elog(DEBUG1, "%s called", __func__);
 
-	RDFNODEOID = GetRDFNodeOID();
+	state->numcols = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	state->rowcount = 0;
+	state->pagesize = 0;
+	cell = list_next(list, cell);
 
-	/*
-	 * Setting session's default values.
-	 */
-	state->enable_pushdown = true;
-	state->enable_xml_huge = false;
-	state->log_sparql = false;
-	state->has_unparsable_conds = false;
-	state->query_param = RDF_DEFAULT_QUERY_PARAM;
-	state->format = RDF_DEFAULT_FORMAT;
-	state->connect_timeout = RDF_DEFAULT_CONNECTTIMEOUT;
-	state->request_timeout = RDF_DEFAULT_REQUEST_TIMEOUT;
-	state->max_retries = RDF_DEFAULT_MAXRETRY;
-	state->fetch_size = RDF_DEFAULT_FETCH_SIZE;
-	state->foreign_table = GetForeignTable(state->foreigntableid);
-	state->server = GetForeignServer(state->foreign_table->serverid);
-	state->sparql_query_type = SPARQL_SELECT;
+	state->sparql = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * Loading SERVER OPTIONS
-	 */
-	LoadRDFServerInfo(state);
+	state->sparql_prefixes = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * Loading FOREIGN TABLE structure and OPTIONS
-	 */
-	LoadRDFTableInfo(state);
+	state->sparql_select = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * Loading USER MAPPING (if any)
-	 */
-	LoadRDFUserMapping(state);
+	state->sparql_from = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * Marking columns used in the SQL query for SPARQL pushdown
-	 */
-	elog(DEBUG2, "%s: looking for columns in the SELECT entry list", __func__);
-	foreach (cell, columnlist)
-		SetUsedColumns((Expr *)lfirst(cell), state, baserel->relid);
+	state->sparql_where = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	elog(DEBUG2, "%s: looking for columns used in WHERE conditions", __func__);
-	foreach (cell, conditions)
-		SetUsedColumns((Expr *)lfirst(cell), state, baserel->relid);
-
-	/*
-	 * For tables with sparql_update_pattern (used for INSERT/DELETE operations),
-	 * we need to fetch ALL columns because DELETE operations need complete tuples
-	 * to build proper DELETE DATA/WHERE statements.
-	 * However, for SELECT queries, we should only fetch the requested columns.
-	 */
-	if (state->sparql_update_pattern && strlen(state->sparql_update_pattern) > 0 &&
-		state->sparql_query_type != SPARQL_SELECT)
-	{
-		elog(DEBUG2, "%s: sparql_update_pattern detected for non-SELECT operation - marking all columns as used", __func__);
-		for (int i = 0; i < state->numcols; i++)
-		{
-			if (!state->rdfTable->cols[i]->used)
-			{
-				elog(DEBUG2, "%s: marking column '%s' as used for UPDATE/DELETE operation",
-					 __func__, state->rdfTable->cols[i]->name);
-				state->rdfTable->cols[i]->used = true;
-			}
-		}
-	}
-
-	/*
-	 * Load prefixes from the SERVER's 'prefix_context' and from
-	 * the SPARQL query, if any.
-	 */
-	LoadPrefixes(state);
+	state->sparql_filter = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * We create the SPARQL SELECT clause according to the columns used in the
-	 * SQL SELECT. Functions calls and expressions are only pushed down if explicitly
-	 * declared in the 'expression' column OPTION.
-	 */
-	initStringInfo(&select);
-	for (int i = 0; i < state->numcols; i++)
-	{
-		if (state->rdfTable->cols[i]->used && !state->rdfTable->cols[i]->expression)
-			appendStringInfo(&select, "%s ", pstrdup(state->rdfTable->cols[i]->sparqlvar));
+	state->sparql_filter_expr = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-		else if (state->rdfTable->cols[i]->used && state->rdfTable->cols[i]->expression)
-			appendStringInfo(&select, "(%s AS %s) ", pstrdup(state->rdfTable->cols[i]->expression),
-							 pstrdup(state->rdfTable->cols[i]->sparqlvar));
-	}
+	state->sparql_orderby = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	state->sparql_select = pstrdup(select.data);
+	state->sparql_limit = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * Extract the graph patter from the SPARQL WHERE clause
-	 */
-	state->sparql_where = DeparseSPARQLWhereGraphPattern(state);
+	state->raw_sparql = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * Try to deparse SQL WHERE conditions, if any, to create SPARQL FILTER expressions
-	 * Only do this for parsable queries - non-parsable queries should evaluate all conditions locally
-	 */
-	if (state->is_sparql_parsable)
-		state->sparql_filter = DeparseSQLWhereConditions(state, baserel);
-	else
-	{
-		state->sparql_filter = "";
-		elog(DEBUG2, "%s: skipping WHERE condition parsing for non-parsable query", __func__);
-	}
+	state->endpoint = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * deparse SQL ORDER BY, if any, and convert it to SPARQL
-	 */
-	state->sparql_orderby = DeparseSQLOrderBy(state, root, baserel);
+	state->query_param = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * deparse SQL LIMIT, if any, and convert it to SPARQL
-	 */
-	state->sparql_limit = DeparseSQLLimit(state, root, baserel);
+	state->format = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	/*
-	 * deparse SPARQL FROM and FROM NAMED clauses, if any
-	 */
-	state->sparql_from = DeparseSPARQLFrom(state->raw_sparql);
+	state->proxy = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	elog(DEBUG1, "%s exit", __func__);
-}
+	state->proxy_type = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-/*
- * FetchNextBinding
- * ----------------
- * Loads the next binding from the record list 'state->recods' to return to
- * the client.
- *
- * state: SPARQL, SERVER and FOREIGN TABLE info
- *
- * returns xmlNodePtr containg the retrieved record or NULL if EOF.
- */
-static xmlNodePtr FetchNextBinding(RDFfdwState *state)
-{
-	ListCell *cell;
-	xmlNodePtr res;
+	state->proxy_user = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	elog(DEBUG3, "  %s: called > rowcount = %d/%d", __func__, state->rowcount, state->pagesize);
+	state->proxy_user_password = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	if (state->rowcount > state->pagesize)
-	{
-		elog(DEBUG3, "%s exit: returning NULL (EOF!)", __func__);
-		return NULL;
-	}
+	state->custom_params = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	cell = list_nth_cell(state->records, state->rowcount);
-	res = (xmlNodePtr)lfirst(cell);
+	state->user = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	elog(DEBUG3, "  %s exit: returning %d", __func__, state->rowcount);
+	state->password = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-	return res;
-}
+	state->token = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-/*
- * ExecuteSPARQL
- * -------------
- * Executes the SPARQL query in the endpoint set in the CREATE FOREIGN TABLE
- * and CREATE SERVER statements. The result set is loaded into 'state'.
- *
- * state: SPARQL, SERVER and FOREIGN TABLE info
- *
- * returns REQUEST_SUCCESS or REQUEST_FAIL
- */
-static int ExecuteSPARQL(RDFfdwState *state)
-{
-	CURLcode res;
-	StringInfoData url_buffer;
-	StringInfoData user_agent;
-	StringInfoData accept_header;
-	char errbuf[CURL_ERROR_SIZE];
-	struct MemoryStruct chunk;
-	struct MemoryStruct chunk_header;
-	struct curl_slist *headers = NULL;
-	long response_code;
+	state->request_redirect = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-	chunk.memory = palloc0(1);
-	chunk.size = 0; /* no data at this point */
-	chunk.max_size = (size_t) state->max_response_size;
-	chunk_header.memory = palloc0(1);
-	chunk_header.size = 0; /* no data at this point */
-	chunk_header.max_size = 0; /* no limit on headers */
+	state->enable_pushdown = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-	elog(DEBUG1, "%s called for %s operation", __func__,
-		 (state->sparql_query_type == SPARQL_INSERT) ? "INSERT" : (state->sparql_query_type == SPARQL_DELETE) ? "DELETE"
-															  : (state->sparql_query_type == SPARQL_UPDATE)	  ? "UPDATE"
-																											  : "SELECT/DESCRIBE");
+	state->is_sparql_parsable = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-	state->curl = curl_easy_init();
+	state->log_sparql = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-	initStringInfo(&accept_header);
-	appendStringInfo(&accept_header, "Accept: %s", state->format);
+	state->has_unparsable_conds = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-	if (state->log_sparql)
-		elog(INFO, "SPARQL query sent to '%s':\n%s\n", state->server->servername, state->sparql);
+	state->request_max_redirect = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-	/* For SPARQL UPDATE operations (INSERT, DELETE, UPDATE), use different approach */
-	if (state->sparql_query_type == SPARQL_INSERT ||
-		state->sparql_query_type == SPARQL_DELETE ||
-		state->sparql_query_type == SPARQL_UPDATE)
-	{
-		/* SPARQL UPDATE: send the update query directly in POST body with application/sparql-update */
-		elog(DEBUG1, "%s: using SPARQL UPDATE protocol", __func__);
+	state->connect_timeout = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		/* No need to build URL parameters for UPDATE */
-		initStringInfo(&url_buffer);
-	}
-	else
-	{
-		/* SPARQL SELECT/DESCRIBE: use URL-encoded form parameters */
-		char *escaped_url = curl_easy_escape(state->curl, state->sparql, 0);
+	state->request_timeout = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		initStringInfo(&url_buffer);
-		appendStringInfo(&url_buffer, "%s=%s", state->query_param, escaped_url);
+	state->max_retries = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		if (state->custom_params)
-			appendStringInfo(&url_buffer, "&%s", escaped_url);
+	state->max_response_size = (long)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		if (escaped_url)
-			curl_free(escaped_url);
+	state->foreigntableid = DatumGetObjectId(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		elog(DEBUG2, "  %s: url built > %s?%s", __func__, state->endpoint, url_buffer.data);
-	}
+	elog(DEBUG2, "  %s: deserializing table with %d columns", __func__, state->numcols);
+	state->rdfTable = (struct RDFfdwTable *)palloc0(sizeof(struct RDFfdwTable));
+	state->rdfTable->cols = (struct RDFfdwColumn **)palloc0(sizeof(struct RDFfdwColumn *) * state->numcols);
 
-	if (state->curl)
+	for (int i = 0; i < state->numcols; ++i)
 	{
-		errbuf[0] = 0;
+		state->rdfTable->cols[i] = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
 
-		curl_easy_setopt(state->curl, CURLOPT_URL, state->endpoint);
+		state->rdfTable->cols[i]->name = ConstToCString(lfirst(cell));
+		cell = list_next(list, cell);
+		elog(DEBUG2, "  %s: column name '%s'", __func__, state->rdfTable->cols[i]->name);
 
-		/* CURLOPT_PROTOCOLS was deprecated in libcurl 7.85 and its enum flags removed
-		 * in 8.0; use the string-based CURLOPT_PROTOCOLS_STR on newer versions. */
-#if ((LIBCURL_VERSION_MAJOR == 7 && LIBCURL_VERSION_MINOR < 85) || LIBCURL_VERSION_MAJOR < 7)
-		curl_easy_setopt(state->curl, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS);
-#else
-		curl_easy_setopt(state->curl, CURLOPT_PROTOCOLS_STR, "http,https");
-#endif
+		state->rdfTable->cols[i]->sparqlvar = ConstToCString(lfirst(cell));
+		cell = list_next(list, cell);
 
-		curl_easy_setopt(state->curl, CURLOPT_ERRORBUFFER, errbuf);
+		state->rdfTable->cols[i]->expression = ConstToCString(lfirst(cell));
+		cell = list_next(list, cell);
 
-		curl_easy_setopt(state->curl, CURLOPT_CONNECTTIMEOUT, state->connect_timeout);
-		curl_easy_setopt(state->curl, CURLOPT_TIMEOUT, state->request_timeout);
-		elog(DEBUG2, "  %s: connect_timeout > %ld", __func__, state->connect_timeout);
-		elog(DEBUG2, "  %s: request_timeout > %ld", __func__, state->request_timeout);
-		elog(DEBUG2, "  %s: max retry > %ld", __func__, state->max_retries);
+		state->rdfTable->cols[i]->literaltype = ConstToCString(lfirst(cell));
+		cell = list_next(list, cell);
 
-		if (state->proxy)
-		{
-			elog(DEBUG2, "  %s: proxy URL > '%s'", __func__, state->proxy);
+		state->rdfTable->cols[i]->literal_fomat = ConstToCString(lfirst(cell));
+		cell = list_next(list, cell);
 
-			curl_easy_setopt(state->curl, CURLOPT_PROXY, state->proxy);
+		state->rdfTable->cols[i]->nodetype = ConstToCString(lfirst(cell));
+		cell = list_next(list, cell);
 
-			if (strcmp(state->proxy_type, RDF_SERVER_OPTION_HTTP_PROXY) == 0)
-			{
-				elog(DEBUG2, "  %s: proxy protocol > 'HTTP'", __func__);
-				curl_easy_setopt(state->curl, CURLOPT_PROXYTYPE, CURLPROXY_HTTP);
-			}
-			else if (strcmp(state->proxy_type, RDF_SERVER_OPTION_HTTPS_PROXY) == 0)
-			{
-				elog(DEBUG2, "  %s: proxy protocol > 'HTTPS'", __func__);
-				curl_easy_setopt(state->curl, CURLOPT_PROXYTYPE, CURLPROXY_HTTPS);
-			}
+		state->rdfTable->cols[i]->language = ConstToCString(lfirst(cell));
+		cell = list_next(list, cell);
 
-			if (state->proxy_user)
-			{
-				elog(DEBUG2, "  %s: entering proxy user ('%s').", __func__, state->proxy_user);
-				curl_easy_setopt(state->curl, CURLOPT_PROXYUSERNAME, state->proxy_user);
-			}
+		state->rdfTable->cols[i]->pgtype = DatumGetObjectId(((Const *)lfirst(cell))->constvalue);
+		cell = list_next(list, cell);
 
-			if (state->proxy_user_password)
-			{
-				elog(DEBUG2, "  %s: entering proxy user's password.", __func__);
-				curl_easy_setopt(state->curl, CURLOPT_PROXYPASSWORD, state->proxy_user_password);
-			}
-		}
+		state->rdfTable->cols[i]->pgtypmod = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+		cell = list_next(list, cell);
 
-		if (state->request_redirect == true)
-		{
+		state->rdfTable->cols[i]->pgattnum = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+		cell = list_next(list, cell);
 
-			elog(DEBUG2, "  %s: setting request redirect: %d", __func__, state->request_redirect);
-			curl_easy_setopt(state->curl, CURLOPT_FOLLOWLOCATION, 1L);
+		state->rdfTable->cols[i]->used = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+		cell = list_next(list, cell);
 
-			/* Never forward credentials to a redirected host */
-			curl_easy_setopt(state->curl, CURLOPT_UNRESTRICTED_AUTH, 0L);
+		state->rdfTable->cols[i]->pushable = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+		cell = list_next(list, cell);
+	}
 
-			if (state->request_max_redirect)
-			{
-				elog(DEBUG2, "  %s: setting maxredirs: %ld", __func__, state->request_max_redirect);
-				curl_easy_setopt(state->curl, CURLOPT_MAXREDIRS, state->request_max_redirect);
-			}
-		}
+	state->server = (ForeignServer *)palloc0(sizeof(ForeignServer));
+	state->server->servername = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-		/* Set POST data based on query type */
-		if (state->sparql_query_type == SPARQL_INSERT ||
-			state->sparql_query_type == SPARQL_DELETE ||
-			state->sparql_query_type == SPARQL_UPDATE)
-		{
-			/* For SPARQL UPDATE: send raw SPARQL update in POST body */
-			elog(DEBUG1, "%s: setting SPARQL UPDATE body: %s", __func__, state->sparql);
-			curl_easy_setopt(state->curl, CURLOPT_POSTFIELDS, state->sparql);
-			curl_easy_setopt(state->curl, CURLOPT_POSTFIELDSIZE, (long)strlen(state->sparql));
-		}
-		else
-		{
-			/* For SPARQL SELECT/DESCRIBE: send URL-encoded parameters */
-			curl_easy_setopt(state->curl, CURLOPT_POSTFIELDS, url_buffer.data);
-		}
-
-		curl_easy_setopt(state->curl, CURLOPT_HEADERFUNCTION, CURLHeaderCallback);
-		curl_easy_setopt(state->curl, CURLOPT_HEADERDATA, (void *)&chunk_header);
+	state->batch_size = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		/* For SPARQL UPDATE operations, collect the response body so that
-		 * error details (e.g. auth failure messages) can be surfaced in the
-		 * PostgreSQL error.  max_size is reset to 0 (unlimited) to avoid a
-		 * false "exceeds max_response_size" error when the endpoint returns
-		 * a large body on a successful update (e.g. QLever JSON). */
-		if (state->sparql_query_type == SPARQL_INSERT ||
-			state->sparql_query_type == SPARQL_DELETE ||
-			state->sparql_query_type == SPARQL_UPDATE)
-			chunk.max_size = 0;
+	state->server->serverid = DatumGetObjectId(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		curl_easy_setopt(state->curl, CURLOPT_WRITEFUNCTION, CURLWriteMemoryCallback);
-		curl_easy_setopt(state->curl, CURLOPT_WRITEDATA, (void *)&chunk);
+	state->enable_xml_huge = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		/* Don't use CURLOPT_FAILONERROR so we can capture error response bodies */
-		curl_easy_setopt(state->curl, CURLOPT_FAILONERROR, 0L);
+	state->enable_streaming = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		/*
-		 * Enable libcurl verbose output, but route it exclusively through
-		 * CURLDebugCallback instead of stderr. The callback emits at DEBUG3
-		 * (gated by log_min_messages) and redacts Authorization headers so
-		 * credentials are never written to server logs.
-		 */
-		curl_easy_setopt(state->curl, CURLOPT_VERBOSE, 1L);
-		curl_easy_setopt(state->curl, CURLOPT_DEBUGFUNCTION, CURLDebugCallback);
-		curl_easy_setopt(state->curl, CURLOPT_DEBUGDATA, NULL);
+	state->is_join = (bool)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		/* Set the progress callback function */
-		curl_easy_setopt(state->curl, CURLOPT_XFERINFOFUNCTION, CURLProgressCallback);
+	state->sparql_groupby = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-		/* Optional: Pass user data to the callback (NULL in this case) */
-		curl_easy_setopt(state->curl, CURLOPT_XFERINFODATA, NULL);
+	state->sparql_having = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-		/* Enable progress callback */
-		curl_easy_setopt(state->curl, CURLOPT_NOPROGRESS, 0L);
+	nparams = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		initStringInfo(&user_agent);
-		appendStringInfo(&user_agent, "PostgreSQL/%s rdf_fdw/%s libxml2/%s %s", PG_VERSION, FDW_VERSION, LIBXML_DOTTED_VERSION, curl_version());
-		curl_easy_setopt(state->curl, CURLOPT_USERAGENT, user_agent.data);
+	for (int i = 0; i < nparams; i++)
+	{
+		state->param_columns = lappend(state->param_columns, makeString(ConstToCString(lfirst(cell))));
+		cell = list_next(list, cell);
+	}
 
-		/* Set headers based on query type */
-		if (state->sparql_query_type == SPARQL_INSERT ||
-			state->sparql_query_type == SPARQL_DELETE ||
-			state->sparql_query_type == SPARQL_UPDATE)
-		{
-			/* For SPARQL UPDATE: use application/sparql-update content type */
-			headers = curl_slist_append(headers, "Content-Type: application/sparql-update");
-			elog(DEBUG1, "%s: setting Content-Type: application/sparql-update", __func__);
-		}
-		else
-		{
-			/* For SPARQL SELECT/DESCRIBE: use standard accept header */
-			headers = curl_slist_append(headers, accept_header.data);
-		}
+	state->sparql_values = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-		/*
-		 * Bearer token authentication as defined by RFC 6750
-		 * (https://datatracker.ietf.org/doc/html/rfc6750).
-		 * This is the standard mechanism for OAuth 2.0 token-based
-		 * authentication.
-		 */
-		if (state->token)
-		{
-			StringInfoData auth_header;
-			initStringInfo(&auth_header);
-			appendStringInfo(&auth_header, "Authorization: Bearer %s", state->token);
-			headers = curl_slist_append(headers, auth_header.data);
-			elog(DEBUG2, "%s: setting Authorization: Bearer [REDACTED]", __func__);
-		}
+	state->param_batch_sql = ConstToCString(lfirst(cell));
+	cell = list_next(list, cell);
 
-		curl_easy_setopt(state->curl, CURLOPT_HTTPHEADER, headers);
+	nchunks = (int)DatumGetInt32(((Const *)lfirst(cell))->constvalue);
+	cell = list_next(list, cell);
 
-		if (state->user && state->password)
-		{
-			curl_easy_setopt(state->curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-			curl_easy_setopt(state->curl, CURLOPT_USERNAME, state->user);
-			curl_easy_setopt(state->curl, CURLOPT_PASSWORD, state->password);
-		}
-		else if (state->user && !state->password)
-		{
-			curl_easy_setopt(state->curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-			curl_easy_setopt(state->curl, CURLOPT_USERNAME, state->user);
-		}
+	for (int i = 0; i < nchunks; i++)
+	{
+		state->values_chunks = lappend(state->values_chunks, ConstToCString(lfirst(cell)));
+		cell = list_next(list, cell);
+	}
 
-		elog(DEBUG2, "  %s: performing cURL request ... ", __func__);
+	elog(DEBUG1, "%s exit", __func__);
+	return state;
+}
 
-		res = curl_easy_perform(state->curl);
+static size_t CURLWriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+	size_t realsize = size * nmemb;
+	struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+	char *ptr;
 
-		/* Always get response code - even if cURL failed */
-		curl_easy_getinfo(state->curl, CURLINFO_RESPONSE_CODE, &response_code);
+	elog(DEBUG3, "%s called", __func__);
 
-		elog(DEBUG2, "  %s: cURL result=%d, HTTP status=%ld, response size=%zu",
-			 __func__, res, response_code, chunk.size);
+	if (mem->max_size > 0 && mem->size + realsize > mem->max_size)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("SPARQL response exceeds max_response_size limit of %zu bytes", mem->max_size),
+				 errhint("Increase max_response_size in CREATE SERVER or refine your SPARQL query to return fewer results.")));
 
-		/* Only retry on network errors (no response received), not on HTTP errors or HTTP successes */
-		if (res != CURLE_OK && response_code == 0)
-		{
-			for (long i = 1; i <= state->max_retries && (res = curl_easy_perform(state->curl)) != CURLE_OK; i++)
-			{
-				elog(WARNING, "%s: request to '%s' failed (%ld)", __func__, state->server->servername, i);
-				/* Reset chunk memory for retry */
-				chunk.size = 0;
-				chunk_header.size = 0;
-			}
-			/* Update response code after retries */
-			curl_easy_getinfo(state->curl, CURLINFO_RESPONSE_CODE, &response_code);
-		}
+	ptr = repalloc(mem->memory, mem->size + realsize + 1);
 
-		/* Check for HTTP errors first (with FAILONERROR=false, we get the response body) */
-		if (response_code >= 400)
-		{
-			/* HTTP error - response body should contain error details */
-			elog(DEBUG1, "%s: HTTP error %ld, response size=%zu, header size=%zu",
-				 __func__, response_code, chunk.size, chunk_header.size);
+	mem->memory = ptr;
+	memcpy(&(mem->memory[mem->size]), contents, realsize);
+	mem->size += realsize;
+	mem->memory[mem->size] = 0;
 
-			if (chunk_header.size > 0 && chunk_header.memory)
-				elog(DEBUG2, "%s: response headers:\n%s", __func__, chunk_header.memory);
+	elog(DEBUG3, "%s exit: returning '%lu' (realsize)", __func__, realsize);
+	return realsize;
+}
 
-			if (state->xmldoc)
-				xmlFreeDoc(state->xmldoc);
+/*
+ * CURLStreamWriteCallback
+ * -----------------------
+ * Write callback of streamed SELECT requests (enable_streaming). Response
+ * bodies of successful requests are pushed straight into the SPARQL XML,
+ * JSON or TSV parser, without keeping a copy of them. Bodies of HTTP errors are buffered
+ * instead, so that ReportRequestError() can show them to the user.
+ */
+static size_t CURLStreamWriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+	size_t realsize = size * nmemb;
+	RDFfdwStream *stream = (RDFfdwStream *)userp;
+	long response_code = 0;
+	instr_time start;
 
-			{
-				StringInfoData display_body;
-				bool has_body = (chunk.size > 0 && chunk.memory);
+	elog(DEBUG3, "%s called", __func__);
 
-				initStringInfo(&display_body);
+	curl_easy_getinfo(stream->curl, CURLINFO_RESPONSE_CODE, &response_code);
 
-				if (has_body)
-				{
-					/*
-					 * Truncate the error body before logging or including in
-					 * error messages.  Endpoints may return large HTML pages on
-					 * errors (e.g. from misconfigured proxies), which would
-					 * flood server logs.
-					 */
-					if (chunk.size > RDF_FDW_MAX_ERROR_BODY)
-					{
-						appendBinaryStringInfo(&display_body, chunk.memory, RDF_FDW_MAX_ERROR_BODY);
-						appendStringInfoString(&display_body, "... (truncated)");
-					}
-					else
-					{
-						appendStringInfoString(&display_body, chunk.memory);
-					}
-					elog(DEBUG1, "%s: error response body: %s", __func__, display_body.data);
-				}
-				else
-				{
-					elog(DEBUG1, "%s: no response body available for HTTP error %ld", __func__, response_code);
-				}
+	if (response_code >= 400)
+		return CURLWriteMemoryCallback(contents, size, nmemb, &stream->error_body);
 
-				curl_slist_free_all(headers);
-				curl_easy_cleanup(state->curl);
+	/* error_body.max_size holds the server's max_response_size */
+	if (stream->error_body.max_size > 0 && stream->received + realsize > stream->error_body.max_size)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("SPARQL response exceeds max_response_size limit of %zu bytes", stream->error_body.max_size),
+				 errhint("Increase max_response_size in CREATE SERVER or refine your SPARQL query to return fewer results.")));
 
-				if (response_code == 400)
-					ereport(ERROR,
-							(errcode(ERRCODE_SYNTAX_ERROR),
-							 errmsg("bad request on server \"%s\" (HTTP 400)", state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0,
-							 errhint("Check the SPARQL query syntax.")));
-				else if (response_code == 401)
-					ereport(ERROR,
-							(errcode(ERRCODE_INVALID_AUTHORIZATION_SPECIFICATION),
-							 errmsg("authentication failed on server \"%s\" (HTTP 401)", state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0,
-							 errhint("Check the credentials in the USER MAPPING for PostgreSQL user \"%s\".", GetUserNameFromId(GetUserId(), false))));
-				else if (response_code == 403)
-					ereport(ERROR,
-							(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
-							 errmsg("access denied on server \"%s\" (HTTP 403)", state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0,
-							 errhint("The server understood the request but the authenticated user lacks permission to access the endpoint.")));
-				else if (response_code == 404)
-					ereport(ERROR,
-							(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
-							 errmsg("endpoint not found on server \"%s\" (HTTP 404)", state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0,
-							 errhint("Check the endpoint URL: \"%s\".", state->endpoint)));
-				else if (response_code == 406)
-					ereport(ERROR,
-							(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
-							errmsg("unacceptable response format on server \"%s\" (HTTP 406)", state->server->servername),
-							has_body ? errdetail("%s", display_body.data) : 0,
-							errhint("The endpoint does not support the requested format. "
-									"Check the 'format' option in CREATE SERVER.")));
-				else if (response_code == 407)
-					ereport(ERROR,
-							(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
-							 errmsg("proxy authentication required on server \"%s\" (HTTP 407)", state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0,
-							 errhint("The endpoint requires proxy authentication. Check the proxy settings.")));
-				else if (response_code == 429)
-					ereport(ERROR,
-							(errcode(ERRCODE_FDW_ERROR),
-							 errmsg("too many requests on server \"%s\" (HTTP 429)", state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0,
-							 errhint("The endpoint is rate-limiting requests. Consider reducing query frequency or adding a delay between requests.")));
-				else if (response_code == 500)
-					ereport(ERROR,
-							(errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
-							 errmsg("internal error on server \"%s\" (HTTP 500)", state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0));
-				else if (response_code == 503)
-					ereport(ERROR,
-							(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
-							 errmsg("service unavailable on server \"%s\" (HTTP 503)", state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0,
-							 errhint("The endpoint is temporarily unavailable. Try again later.")));
-				else
-					ereport(ERROR,
-							(errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
-							 errmsg("HTTP %ld error on server \"%s\"", response_code, state->server->servername),
-							 has_body ? errdetail("%s", display_body.data) : 0));
-			}
-		}
-		else if (res != CURLE_OK)
-		{
-			/* cURL/network error */
-			size_t len = strlen(errbuf);
-			const char *curl_err = curl_easy_strerror(res);
-			fprintf(stderr, "\nlibcurl: (%d) ", res);
+	stream->received += realsize;
 
-			xmlFreeDoc(state->xmldoc);
-			curl_slist_free_all(headers);
-			curl_easy_cleanup(state->curl);
+	INSTR_TIME_SET_ZERO(start);
+	if (stream->stats && stream->stats->timing)
+		INSTR_TIME_SET_CURRENT(start);
 
-			if (len)
-			{
-				ereport(ERROR,
-						(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
-						 errmsg("unable to connect to '%s'", state->server->servername),
-						 errdetail("%s (curl error code %u).", curl_err, res)));
-			}
-			else
-			{
-				ereport(ERROR,
-						(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
-						 errmsg("%s => (%u) '%s'\n", __func__, res, curl_err)));
-			}
-		}
+	if (stream->tsv)
+	{
+		if (!SPARQLTsvParseChunk(stream->tsv, (const char *)contents, realsize, false))
+			elog(ERROR, "%s: failed to parse SPARQL TSV result: %s", __func__, SPARQLTsvGetError(stream->tsv));
+	}
+	else if (stream->json)
+	{
+		if (!SPARQLJsonParseChunk(stream->json, (const char *)contents, realsize, false))
+			elog(ERROR, "%s: failed to parse SPARQL JSON result: %s", __func__, SPARQLJsonGetError(stream->json));
+	}
+	else if (xmlParseChunk(stream->parser, (const char *)contents, (int)realsize, 0) != 0)
+	{
+		const xmlError *err = xmlCtxtGetLastError(stream->parser);
+		if (err)
+			elog(ERROR, "%s: failed to parse SPARQL XML result: %s", __func__, err->message);
 		else
-		{
-			/* Success - HTTP 2xx */
-			state->sparql_resultset = pstrdup(chunk.memory);
-
-			elog(DEBUG4, "%s: http response header = \n%s", __func__, chunk_header.memory);
-			elog(DEBUG4, "%s: xml document \n\n%s", __func__, chunk.memory);
-			elog(DEBUG2, "%s: http response code = %ld", __func__, response_code);
-			elog(DEBUG2, "%s: http response size = %ld", __func__, chunk.size);
-		}
+			elog(ERROR, "%s: failed to parse SPARQL XML result (unknown error)", __func__);
 	}
 
-	pfree(chunk.memory);
-	pfree(chunk_header.memory);
-	curl_slist_free_all(headers);
-	curl_easy_cleanup(state->curl);
+	if (stream->stats && stream->stats->timing)
+		AddElapsedTime(&stream->stats->parse_time, start);
 
-	/*
-	 * We thrown an error in case the SPARQL endpoint returns an empty XML doc
-	 */
-	if (!state->sparql_resultset)
+	elog(DEBUG3, "%s exit: returning '%lu' (realsize)", __func__, realsize);
+	return realsize;
+}
+
+static size_t CURLHeaderCallback(char *contents, size_t size, size_t nmemb, void *userp)
+{
+
+	size_t realsize = size * nmemb;
+	struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+	char *ptr;
+	char *sparqlxml = "content-type: application/sparql-results+xml";
+	char *sparqlxmlutf8 = "content-type: application/sparql-results+xml; charset=utf-8";
+	char *rdfxml = "content-type: application/rdf+xml";
+	char *rdfxmlutf8 = "content-type: application/rdf+xml;charset=utf-8";
+	char *sparqljson = "content-type: application/sparql-results+json";
+	char *sparqltsv = "content-type: text/tab-separated-values";
+
+	elog(DEBUG3, "%s called", __func__);
+
+	Assert(contents);
+
+	/* is it a "content-type" entry? "*/
+	if (strncasecmp(contents, sparqlxml, 13) == 0)
 	{
-		elog(DEBUG1, "%s exit: REQUEST_FAIL", __func__);
-		return REQUEST_FAIL;
+
+		if (strncasecmp(contents, sparqlxml, strlen(sparqlxml)) != 0 &&
+			strncasecmp(contents, sparqlxmlutf8, strlen(sparqlxmlutf8)) != 0 &&
+			strncasecmp(contents, rdfxml, strlen(rdfxml)) != 0 &&
+			strncasecmp(contents, rdfxmlutf8, strlen(rdfxmlutf8)) != 0 &&
+			strncasecmp(contents, sparqljson, strlen(sparqljson)) != 0 &&
+			strncasecmp(contents, sparqltsv, strlen(sparqltsv)) != 0)
+		{
+			/* remove crlf */
+			contents[strlen(contents) - 2] = '\0';
+			elog(DEBUG3, "%s: unsupported header entry: \"%s\"", __func__, contents);
+			elog(DEBUG3, "%s: %s", __func__, mem->memory);
+			return realsize;
+		}
 	}
 
-	elog(DEBUG1, "%s exit: REQUEST_SUCCESS", __func__);
-	return REQUEST_SUCCESS;
+	ptr = repalloc(mem->memory, mem->size + realsize + 1);
+
+	if (!ptr)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_OUT_OF_MEMORY),
+				 errmsg("[%s] out of memory (repalloc returned NULL)", __func__)));
+
+	mem->memory = ptr;
+	memcpy(&(mem->memory[mem->size]), contents, realsize);
+	mem->size += realsize;
+	mem->memory[mem->size] = 0;
+
+	elog(DEBUG4, "%s: realsize='%lu'", __func__, realsize);
+	elog(DEBUG3, "%s exit", __func__);
+	return realsize;
 }
 
 /*
- * LoadRDFData
- * ---------------
- *
- * Parses the result set loaded into 'state->xmldoc' into records.
- * For SELECT queries, it delegates to the original LoadRDFData.
- * For DESCRIBE queries, it parses the RDF/XML response using libxml2 and stores
- * the parsed XML document in state->xmldoc for later processing by DescribeIRI().
- *
- * state: SPARQL, SERVER and FOREIGN TABLE info
+ * CURLReadBodyCallback
+ * --------------------
+ * Copies the next bytes of a RDFfdwRequestBody into libcurl's upload
+ * buffer, moving on to the next part once one is completely sent.
+ * Returns 0 at the end of the body.
  */
-static void LoadRDFData(RDFfdwState *state)
+static size_t CURLReadBodyCallback(char *buffer, size_t size, size_t nitems, void *userp)
 {
-	int options = XML_PARSE_NOBLANKS | XML_PARSE_NONET;
-
-	elog(DEBUG1, "%s called", __func__);
+	RDFfdwRequestBody *body = (RDFfdwRequestBody *)userp;
+	size_t room = size * nitems;
+	size_t copied = 0;
 
-	/* Enable XML_PARSE_HUGE if needed */
-	if (state->enable_xml_huge)
+	while (room > 0 && body->part < 3)
 	{
-		options |= XML_PARSE_HUGE;
-		elog(DEBUG1, "%s: enabling XML_PARSE_HUGE", __func__);
-	}
+		size_t left = body->lengths[body->part] - body->offset;
+		size_t n = Min(left, room);
 
-	if (state->sparql_query_type == SPARQL_DESCRIBE)
-	{
-		/* Execute the SPARQL DESCRIBE query */
-		if (ExecuteSPARQL(state) != REQUEST_SUCCESS)
-			elog(ERROR, "%s -> SPARQL DESCRIBE query failed: '%s'", __func__, state->endpoint);
+		memcpy(buffer + copied, body->parts[body->part] + body->offset, n);
+		copied += n;
+		room -= n;
+		body->offset += n;
 
-		/* Free existing xmldoc before allocating new one */
-		if (state->xmldoc)
+		if (body->offset == body->lengths[body->part])
 		{
-			elog(DEBUG2, "%s: freeing existing xmldoc", __func__);
-			xmlFreeDoc(state->xmldoc);
-			state->xmldoc = NULL;
+			body->part++;
+			body->offset = 0;
 		}
+	}
 
-		/* Parse the RDF/XML response */
-		state->xmldoc = xmlReadMemory(
-			state->sparql_resultset,
-			strlen(state->sparql_resultset),
-			NULL, NULL,
-			options);
+	elog(DEBUG4, "%s: %lu bytes", __func__, copied);
+	return copied;
+}
 
-		/* Free sparql_resultset as we no longer need it */
-		if (state->sparql_resultset)
-		{
-			pfree(state->sparql_resultset);
-			state->sparql_resultset = NULL;
-		}
+/*
+ * CURLSeekBodyCallback
+ * --------------------
+ * Moves a RDFfdwRequestBody to an absolute position, which libcurl asks
+ * for when the body has to be sent again, e.g. after a redirect or an
+ * authentication challenge.
+ */
+static int CURLSeekBodyCallback(void *userp, curl_off_t offset, int origin)
+{
+	RDFfdwRequestBody *body = (RDFfdwRequestBody *)userp;
+	size_t position = (size_t)offset;
 
-		if (state->xmldoc == NULL)
-		{
-			const xmlError *err = xmlGetLastError();
-			if (err)
-				elog(ERROR, "%s: failed to parse RDF/XML: %s", __func__, err->message);
-			else
-				elog(ERROR, "%s: failed to parse RDF/XML (unknown error)", __func__);
-		}
+	if (origin != SEEK_SET)
+		return CURL_SEEKFUNC_CANTSEEK;
 
-		elog(DEBUG1, "%s exit: RDF/XML parsed successfully", __func__);
-	}
-	else
+	body->part = 0;
+	body->offset = 0;
+
+	while (body->part < 3 && position >= body->lengths[body->part])
 	{
-		/* Handle SELECT queries */
-		xmlNodePtr results;
-		xmlNodePtr root;
+		position -= body->lengths[body->part];
+		body->part++;
+	}
 
-		state->rowcount = 0;
-		state->records = NIL;
+	if (body->part < 3)
+		body->offset = position;
+	else if (position > 0)
+		return CURL_SEEKFUNC_FAIL;
 
-		/* Execute the SPARQL query */
-		if (ExecuteSPARQL(state) != REQUEST_SUCCESS)
-		{
-			if (state->xmldoc)
-				xmlFreeDoc(state->xmldoc);
-			elog(ERROR, "%s -> SPARQL failed: '%s'", __func__, state->endpoint);
-		}
+	return CURL_SEEKFUNC_OK;
+}
 
-		elog(DEBUG2, "  %s: loading 'xmlroot'", __func__);
+/*
+ * IsSensitiveHeader
+ * -----------------
+ * Returns the field-name of a sensitive HTTP header if `line` begins with
+ * one, or NULL otherwise.  Comparison is case-insensitive (RFC 9110 §5.1).
+ */
+static const char *
+IsSensitiveHeader(const char *line)
+{
+	static const struct
+	{
+		const char *name;
+		size_t      len;
+	} sensitive_headers[] = {
+		{ "Authorization:",       sizeof("Authorization:")       - 1 },
+		{ "Proxy-Authorization:", sizeof("Proxy-Authorization:") - 1 },
+		{ NULL, 0 }
+	};
 
-		/* Free existing xmldoc before allocating new one */
-		if (state->xmldoc)
-		{
-			elog(DEBUG2, "	%s: freeing existing xmldoc", __func__);
-			xmlFreeDoc(state->xmldoc);
-			state->xmldoc = NULL;
-		}
+	for (int i = 0; sensitive_headers[i].name != NULL; i++)
+	{
+		if (strncasecmp(line, sensitive_headers[i].name,
+						sensitive_headers[i].len) == 0)
+			return sensitive_headers[i].name;
+	}
 
-		/* Parse the SPARQL result XML */
-		state->xmldoc = xmlReadMemory(
-			state->sparql_resultset,
-			strlen(state->sparql_resultset),
-			NULL, NULL,
-			options);
+	return NULL;
+}
 
-		/* We no longer need sparql_resultset, so let's free it */
-		if (state->sparql_resultset)
-		{
-			pfree(state->sparql_resultset);
-			state->sparql_resultset = NULL;
-		}
+/*
+ * CURLDebugCallback
+ * -----------------
+ * Custom libcurl debug callback. Routes all verbose output through
+ * PostgreSQL's elog() at DEBUG3 level rather than writing directly to
+ * stderr, and redacts Authorization headers so credentials are never
+ * written to server logs.
+ *
+ * handle  : the curl handle (unused)
+ * type    : category of the debug data
+ * data    : pointer to the debug data (NOT null-terminated)
+ * size    : number of bytes in data
+ * userptr : user-supplied pointer (unused)
+ */
+static int
+CURLDebugCallback(CURL *handle, curl_infotype type, char *data, size_t size, void *userptr)
+{
+	const char    *prefix;
+	StringInfoData buf;
 
-		if (state->xmldoc == NULL)
-		{
-			const xmlError *err = xmlGetLastError();
-			if (err)
-				elog(ERROR, "%s: failed to parse SPARQL XML result: %s", __func__, err->message);
-			else
-				elog(ERROR, "%s: failed to parse SPARQL XML result (unknown error)", __func__);
-		}
+	switch (type)
+	{
+		case CURLINFO_TEXT:       prefix = "* "; break;
+		case CURLINFO_HEADER_IN:  prefix = "< "; break;
+		case CURLINFO_HEADER_OUT: prefix = "> "; break;
+		default:
+			return 0;	/* skip raw data blobs (bodies, SSL frames) */
+	}
 
-		root = xmlDocGetRootElement(state->xmldoc);
+	/*
+	 * curl's data pointer is NOT null-terminated, so copy it into a palloc'd
+	 * buffer before using any string functions on it.
+	 */
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf, data, (int) size);
 
-		if (root == NULL)
-		{
-			xmlFreeDoc(state->xmldoc);
-			state->xmldoc = NULL;
-			elog(ERROR, "%s: SPARQL XML result has no root element", __func__);
-		}
+	if (type == CURLINFO_HEADER_OUT)
+	{
+		/*
+		 * CURLINFO_HEADER_OUT delivers the entire outgoing request header
+		 * block (request line + all headers) as one multi-line chunk per
+		 * invocation.  Split it line-by-line so each sensitive header can be
+		 * redacted individually.
+		 */
+		char *pos = buf.data;
 
-		for (results = root->children; results != NULL; results = results->next)
+		while (*pos != '\0')
 		{
-			if (xmlStrcmp(results->name, (xmlChar *)"results") == 0)
-			{
-				xmlNodePtr record;
+			char       *eol   = pos + strcspn(pos, "\r\n");
+			char        saved = *eol;
+			const char *match;
 
-				for (record = results->children; record != NULL; record = record->next)
-				{
-					if (xmlStrcmp(record->name, (xmlChar *)"result") == 0)
-					{
-						state->records = lappend(state->records, record);
-						state->pagesize++;
+			*eol = '\0';	/* temporarily terminate the line */
 
-						elog(DEBUG2, "  %s: appending record %d", __func__, state->pagesize);
-					}
-				}
+			if (*pos != '\0')	/* skip blank lines */
+			{
+				match = IsSensitiveHeader(pos);
+				if (match)
+					elog(DEBUG3, "[curl] > %s [REDACTED]", match);
+				else
+					elog(DEBUG3, "[curl] > %s", pos);
 			}
+
+			*eol = saved;
+			pos  = eol;
+			while (*pos == '\r' || *pos == '\n')
+				pos++;
 		}
+	}
+	else
+	{
+		const char *match;
 
-		if (state->log_sparql)
-			elog(INFO, "SPARQL returned %d %s.\n", state->pagesize, state->pagesize == 1 ? "record" : "records");
+		/* Strip trailing CRLF for cleaner log output. */
+		while (buf.len > 0 &&
+			   (buf.data[buf.len - 1] == '\n' || buf.data[buf.len - 1] == '\r'))
+			buf.data[--buf.len] = '\0';
 
-		elog(DEBUG1, "%s exit: SELECT query processed", __func__);
+		/*
+		 * Redact sensitive response headers.  Informational text lines
+		 * (CURLINFO_TEXT) are logged as-is — they never contain raw
+		 * credential values.
+		 */
+		match = (type == CURLINFO_HEADER_IN) ? IsSensitiveHeader(buf.data) : NULL;
+		if (match)
+			elog(DEBUG3, "[curl] %s%s [REDACTED]", prefix, match);
+		else
+			elog(DEBUG3, "[curl] %s%s", prefix, buf.data);
 	}
+
+	pfree(buf.data);
+	return 0;
 }
 
 /*
- * SetUsedColumns
- * --------------
- * Marks FOREIGN TABLE's columns as used if they're used in the SQL query. This is
- * useful to get the mapped 'variable' OPTIONs, so that we can build a SPARQL SELECT
- * only with the required variables.
+ * CURLProgressCallback
+ * --------------------
+ * Progress callback function for cURL requests. This allows us to
+ * check for interruptions to immediatelly cancel the request.
  *
- * state: SPARQL, SERVER and FOREIGN TABLE info
+ * dltotal: Total bytes to download
+ * dlnow: Bytes downloaded so far
+ * ultotal: Total bytes to upload
+ * ulnow: Bytes uploaded so far
  */
-static void SetUsedColumns(Expr *expr, struct RDFfdwState *state, int foreignrelid)
+static int CURLProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
 {
-	Var *variable;
-	ListCell *cell;
+	CHECK_FOR_INTERRUPTS();
 
-	elog(DEBUG2, "%s called: expression='%d'", __func__, expr->type);
+	return 0;
+}
 
-	switch (expr->type)
-	{
-	case T_RestrictInfo:
-		SetUsedColumns(((RestrictInfo *)expr)->clause, state, foreignrelid);
-		break;
-	case T_TargetEntry:
-		SetUsedColumns(((TargetEntry *)expr)->expr, state, foreignrelid);
-		break;
-	case T_Const:
-	case T_Param:
-	case T_CaseTestExpr:
-	case T_CoerceToDomainValue:
-	case T_CurrentOfExpr:
-#if PG_VERSION_NUM >= 100000
-	case T_NextValueExpr:
-#endif
-		break;
-	case T_Var:
+/*
+ * GetRDFColumn
+ * -------------
+ * Returns the RDFfdwColumn mapped to the table column in `columname`
+ *
+ * state    : SPARQL, SERVER and FOREIGN TABLE info
+ * columname: name of the FOREIGN TABLE column
+ *
+ * returns RDFfdwColumn loded with all its attributes
+ */
+static struct RDFfdwColumn *GetRDFColumn(struct RDFfdwState *state, char *columnname)
+{
 
-		variable = (Var *)expr;
+	elog(DEBUG2, "%s called: column='%s'", __func__, columnname);
 
-		/* ignore columns belonging to a different foreign table */
-		if (variable->varno != foreignrelid)
-		{
-			elog(WARNING, "%s: column belonging to a different foreign table", __func__);
-			break;
-		}
+	if (!columnname)
+	{
+		elog(DEBUG2, "%s exit: returning NULL (columnname is NULL)", __func__);
+		return NULL;
+	}
 
-		/* ignore system columns */
-		if (variable->varattno < 0)
+	for (int i = 0; i < state->numcols; i++)
+	{
+		if (strcmp(state->rdfTable->cols[i]->name, columnname) == 0)
 		{
-			elog(WARNING, "%s: ignoring system column", __func__);
-			break;
+			elog(DEBUG2, "%s exit: rerurning match for columname '%s'", __func__, columnname);
+			return state->rdfTable->cols[i];
 		}
+	}
 
-		for (int i = 0; i < state->numcols; i++)
-		{
-			if (state->rdfTable->cols[i]->pgattnum == variable->varattno)
-			{
+	elog(DEBUG2, "%s exit: rerurning NULL (no match found for '%s')", __func__, columnname);
+	return NULL;
+}
+
+/*
+ * InitSession
+ * ----------
+ * This function loads the 'OPTION' variables declared in SERVER and FOREIGN
+ * TABLE statements. It also parses the raw_sparql query into its main clauses,
+ * so that it can be later modified to match the SQL SELECT clause and commands
+ * that can be pushed down to SPARQL
+ *
+ * state  : SPARQL, SERVER and FOREIGN TABLE info
+ * baserel: Conditions and columns used in the SQL query
+ * root   : Planner info
+ */
+static void InitSession(struct RDFfdwState *state, RelOptInfo *baserel, PlannerInfo *root)
+{
+
+#if PG_VERSION_NUM >= 90600
+	List *columnlist = baserel->reltarget->exprs;
+#else
+	List *columnlist = baserel->reltargetlist;
+#endif
+	List *conditions = baserel->baserestrictinfo;
+	ListCell *cell;
+	StringInfoData select;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	RDFNODEOID = GetRDFNodeOID();
+
+	/*
+	 * Setting session's default values.
+	 */
+	state->enable_pushdown = true;
+	state->enable_xml_huge = false;
+	state->enable_streaming = false;
+	state->use_remote_estimate = false;
+	state->remote_estimate_ttl = RDF_DEFAULT_REMOTE_ESTIMATE_TTL;
+	state->enable_term_binding = false;
+	state->enable_direct_modify = false;
+	state->values_threshold = 0;
+	state->max_values_size = 0;
+	state->log_sparql = false;
+	state->has_unparsable_conds = false;
+	state->query_param = RDF_DEFAULT_QUERY_PARAM;
+	state->format = RDF_DEFAULT_FORMAT;
+	state->connect_timeout = RDF_DEFAULT_CONNECTTIMEOUT;
+	state->request_timeout = RDF_DEFAULT_REQUEST_TIMEOUT;
+	state->max_retries = RDF_DEFAULT_MAXRETRY;
+	state->fetch_size = RDF_DEFAULT_FETCH_SIZE;
+	state->foreign_table = GetForeignTable(state->foreigntableid);
+	state->server = GetForeignServer(state->foreign_table->serverid);
+	state->sparql_query_type = SPARQL_SELECT;
+
+	/*
+	 * Loading SERVER OPTIONS
+	 */
+	LoadRDFServerInfo(state);
+
+	/*
+	 * Loading FOREIGN TABLE structure and OPTIONS
+	 */
+	LoadRDFTableInfo(state);
+
+	/*
+	 * Loading USER MAPPING (if any)
+	 */
+	LoadRDFUserMapping(state);
+
+	/*
+	 * Marking columns used in the SQL query for SPARQL pushdown
+	 */
+	elog(DEBUG2, "%s: looking for columns in the SELECT entry list", __func__);
+	foreach (cell, columnlist)
+		SetUsedColumns((Expr *)lfirst(cell), state, baserel->relid);
+
+	elog(DEBUG2, "%s: looking for columns used in WHERE conditions", __func__);
+	foreach (cell, conditions)
+		SetUsedColumns((Expr *)lfirst(cell), state, baserel->relid);
+
+	/*
+	 * For tables with sparql_update_pattern (used for INSERT/DELETE operations),
+	 * we need to fetch ALL columns because DELETE operations need complete tuples
+	 * to build proper DELETE DATA/WHERE statements.
+	 * However, for SELECT queries, we should only fetch the requested columns.
+	 */
+	if (state->sparql_update_pattern && strlen(state->sparql_update_pattern) > 0 &&
+		state->sparql_query_type != SPARQL_SELECT)
+	{
+		elog(DEBUG2, "%s: sparql_update_pattern detected for non-SELECT operation - marking all columns as used", __func__);
+		for (int i = 0; i < state->numcols; i++)
+		{
+			if (!state->rdfTable->cols[i]->used)
+			{
+				elog(DEBUG2, "%s: marking column '%s' as used for UPDATE/DELETE operation",
+					 __func__, state->rdfTable->cols[i]->name);
 				state->rdfTable->cols[i]->used = true;
-				elog(DEBUG2, "%s: column '%s' (%d) required in the SQL query", __func__, state->rdfTable->cols[i]->name, i);
-				break;
 			}
-		}
+		}
+	}
+
+	/*
+	 * Load prefixes from the SERVER's 'prefix_context' and from
+	 * the SPARQL query, if any.
+	 */
+	LoadPrefixes(state);
+
+	/*
+	 * We create the SPARQL SELECT clause according to the columns used in the
+	 * SQL SELECT. Functions calls and expressions are only pushed down if explicitly
+	 * declared in the 'expression' column OPTION.
+	 */
+	initStringInfo(&select);
+	for (int i = 0; i < state->numcols; i++)
+	{
+		if (state->rdfTable->cols[i]->used && !state->rdfTable->cols[i]->expression)
+			appendStringInfo(&select, "%s ", pstrdup(state->rdfTable->cols[i]->sparqlvar));
+
+		else if (state->rdfTable->cols[i]->used && state->rdfTable->cols[i]->expression)
+			appendStringInfo(&select, "(%s AS %s) ", pstrdup(state->rdfTable->cols[i]->expression),
+							 pstrdup(state->rdfTable->cols[i]->sparqlvar));
+	}
+
+	state->sparql_select = pstrdup(select.data);
+
+	/*
+	 * Extract the graph patter from the SPARQL WHERE clause
+	 */
+	state->sparql_where = DeparseSPARQLWhereGraphPattern(state);
+
+	/*
+	 * Try to deparse SQL WHERE conditions, if any, to create SPARQL FILTER expressions
+	 * Only do this for parsable queries - non-parsable queries should evaluate all conditions locally
+	 */
+	if (state->is_sparql_parsable)
+		state->sparql_filter = DeparseSQLWhereConditions(state, baserel, root);
+	else
+	{
+		state->sparql_filter = "";
+		elog(DEBUG2, "%s: skipping WHERE condition parsing for non-parsable query", __func__);
+	}
+
+	/*
+	 * deparse SQL ORDER BY, if any, and convert it to SPARQL
+	 */
+	state->sparql_orderby = DeparseSQLOrderBy(state, baserel, root->query_pathkeys);
+
+	/*
+	 * deparse SQL LIMIT, if any, and convert it to SPARQL
+	 */
+	state->sparql_limit = DeparseSQLLimit(state, root, baserel);
+
+	/*
+	 * deparse SPARQL FROM and FROM NAMED clauses, if any
+	 */
+	state->sparql_from = DeparseSPARQLFrom(state);
+
+	elog(DEBUG1, "%s exit", __func__);
+}
+
+/*
+ * FetchNextBinding
+ * ----------------
+ * Loads the next binding from the record list 'state->recods' to return to
+ * the client.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns xmlNodePtr containg the retrieved record or NULL if EOF.
+ */
+static xmlNodePtr FetchNextBinding(RDFfdwState *state)
+{
+	ListCell *cell;
+	xmlNodePtr res;
+
+	elog(DEBUG3, "  %s: called > rowcount = %d/%d", __func__, state->rowcount, state->pagesize);
+
+	/* streamed records are fetched by rdfIterateForeignScan */
+	if (state->stream)
+		return state->stream->current;
+
+	if (state->rowcount > state->pagesize)
+	{
+		elog(DEBUG3, "%s exit: returning NULL (EOF!)", __func__);
+		return NULL;
+	}
+
+	cell = list_nth_cell(state->records, state->rowcount);
+	res = (xmlNodePtr)lfirst(cell);
+
+	elog(DEBUG3, "  %s exit: returning %d", __func__, state->rowcount);
+
+	return res;
+}
+
+/*
+ * FetchNextTsvRow
+ * ---------------
+ * Counterpart of FetchNextBinding for SPARQL TSV results: returns the
+ * fields of the next row of 'state->tsv', or of the row fetched last from
+ * a streamed request.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns the fields of the row or NULL if EOF.
+ */
+static char **FetchNextTsvRow(RDFfdwState *state)
+{
+	char **row;
+
+	elog(DEBUG3, "  %s: called > rowcount = %d/%d", __func__, state->rowcount, state->pagesize);
+
+	if (state->stream)
+		return state->stream->row;
+
+	row = SPARQLTsvNextRow(state->tsv);
+
+	elog(DEBUG3, "  %s exit", __func__);
+
+	return row;
+}
+
+/*
+ * FetchNextJsonRow
+ * ----------------
+ * Counterpart of FetchNextBinding for SPARQL JSON results: returns the
+ * terms of the next row of 'state->json', or of the row fetched last from
+ * a streamed request.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns the terms of the row or NULL if EOF.
+ */
+static SPARQLJsonTerm *FetchNextJsonRow(RDFfdwState *state)
+{
+	SPARQLJsonTerm *row;
+
+	elog(DEBUG3, "  %s: called > rowcount = %d/%d", __func__, state->rowcount, state->pagesize);
+
+	if (state->stream)
+		return state->stream->json_row;
+
+	row = SPARQLJsonNextRow(state->json);
+
+	elog(DEBUG3, "  %s exit", __func__);
+
+	return row;
+}
+
+/*
+ * ResolveTsvFields
+ * ----------------
+ * Looks up the field of each column's variable in the header of a TSV
+ * result set, so that rows are read by position instead of by name. Done
+ * once per result set. 'state->tsv_fields' must be allocated by the caller,
+ * in a memory context that lives as long as the result set.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ * tsv  : TSV result set whose header was already received
+ */
+static void ResolveTsvFields(RDFfdwState *state, SPARQLTsvParser *tsv)
+{
+	Assert(state->tsv_fields != NULL);
+
+	for (int i = 0; i < state->numcols; i++)
+	{
+		state->tsv_fields[i] = SPARQLTsvGetVariableIndex(tsv, state->rdfTable->cols[i]->sparqlvar);
+
+		elog(DEBUG2, "%s: column '%s' (%s) -> field %d", __func__,
+			 state->rdfTable->cols[i]->name, state->rdfTable->cols[i]->sparqlvar, state->tsv_fields[i]);
+	}
+}
+
+/*
+ * GetConnection
+ * -------------
+ * Returns the cached libcurl handle for the server and current user, creating
+ * the connection cache (and registering its invalidation callbacks) on first
+ * use. A handle found in the cache is reset with curl_easy_reset(), which
+ * clears all options but keeps its live connections, DNS cache and TLS
+ * session ids, so the caller must set every option it needs again.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns the cache entry holding the handle (entry->curl may be NULL if
+ * libcurl could not create a new handle)
+ */
+static RDFfdwConnCacheEntry *GetConnection(RDFfdwState *state)
+{
+	RDFfdwConnCacheKey key;
+	RDFfdwConnCacheEntry *entry;
+	bool found;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	if (ConnectionCache == NULL)
+	{
+		HASHCTL ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(RDFfdwConnCacheKey);
+		ctl.entrysize = sizeof(RDFfdwConnCacheEntry);
+		ConnectionCache = hash_create("rdf_fdw connections", 8, &ctl, HASH_ELEM | HASH_BLOBS);
+
+		CacheRegisterSyscacheCallback(FOREIGNSERVEROID, ConnectionCacheInvalCallback, (Datum)0);
+#if PG_VERSION_NUM >= 90600
+		CacheRegisterSyscacheCallback(USERMAPPINGOID, ConnectionCacheInvalCallback, (Datum)0);
+#endif /* PG_VERSION_NUM */
+	}
+
+	MemSet(&key, 0, sizeof(key));
+	key.serverid = state->server->serverid;
+	key.userid = GetUserId();
+
+	entry = (RDFfdwConnCacheEntry *)hash_search(ConnectionCache, &key, HASH_ENTER, &found);
+
+	if (!found)
+	{
+		entry->curl = NULL;
+		entry->busy = false;
+		entry->invalidated = false;
+		entry->requests = 0;
+		entry->reused = 0;
+	}
+
+	if (entry->curl && entry->busy)
+	{
+		/*
+		 * The last transfer on this handle was interrupted by an ERROR (e.g.
+		 * a query cancel raised from CURLProgressCallback), so libcurl never
+		 * returned from curl_easy_perform(). The handle's internal state is
+		 * unknown, so it is not reused, but it is still cleaned up to close
+		 * its connection.
+		 */
+		elog(DEBUG2, "  %s: closing handle left over by an aborted request", __func__);
+		curl_easy_cleanup(entry->curl);
+		entry->curl = NULL;
+	}
+	else if (entry->curl && entry->invalidated)
+	{
+		elog(DEBUG2, "  %s: server or user mapping changed, closing cached connection", __func__);
+		curl_easy_cleanup(entry->curl);
+		entry->curl = NULL;
+	}
+
+	if (entry->curl == NULL)
+	{
+		entry->curl = curl_easy_init();
+		entry->busy = false;
+		entry->invalidated = false;
+		entry->server_hashvalue = GetSysCacheHashValue1(FOREIGNSERVEROID,
+														ObjectIdGetDatum(key.serverid));
+		elog(DEBUG2, "  %s: new handle for server \"%s\"", __func__, state->server->servername);
+	}
+	else
+	{
+		curl_easy_reset(entry->curl);
+		elog(DEBUG2, "  %s: reusing cached handle for server \"%s\"", __func__, state->server->servername);
+	}
+
+	elog(DEBUG1, "%s exit", __func__);
+	return entry;
+}
+
+/*
+ * ConnectionCacheInvalCallback
+ * ----------------------------
+ * Syscache invalidation callback for FOREIGNSERVEROID and USERMAPPINGOID.
+ * Marks the affected cache entries as invalid, so that GetConnection()
+ * closes their connections and opens new ones on next use. We don't know
+ * the user mapping oid of scans planned in other transactions, so any
+ * user mapping change invalidates all entries; they are rare enough.
+ */
+static void ConnectionCacheInvalCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	HASH_SEQ_STATUS scan;
+	RDFfdwConnCacheEntry *entry;
+
+	Assert(ConnectionCache != NULL);
+
+	hash_seq_init(&scan, ConnectionCache);
+	while ((entry = (RDFfdwConnCacheEntry *)hash_seq_search(&scan)) != NULL)
+	{
+		/*
+		 * Entries whose handle is currently checked out by a streamed scan
+		 * are marked as well, so that the handle is not put back into the
+		 * cache once the scan is over.
+		 */
+		if (hashvalue == 0 ||
+			cacheid != FOREIGNSERVEROID ||
+			entry->server_hashvalue == hashvalue)
+			entry->invalidated = true;
+	}
+}
+
+/*
+ * SetCURLOptions
+ * --------------
+ * Sets all libcurl options needed to send the SPARQL request in 'state' with
+ * the handle 'state->curl': URL and POST body, timeouts, proxy, redirects,
+ * callbacks, headers and credentials. The response body is collected into
+ * 'chunk' and the response headers into 'chunk_header'.
+ *
+ * state       : SPARQL, SERVER and FOREIGN TABLE info
+ * errbuf      : buffer for libcurl error messages (CURL_ERROR_SIZE)
+ * chunk       : buffer for the response body
+ * chunk_header: buffer for the response headers
+ *
+ * returns the list of HTTP headers set in the request, which must be freed
+ * with curl_slist_free_all() once the request is done.
+ */
+static struct curl_slist *SetCURLOptions(RDFfdwState *state, char *errbuf, struct MemoryStruct *chunk, struct MemoryStruct *chunk_header)
+{
+	StringInfoData url_buffer;
+	StringInfoData user_agent;
+	StringInfoData accept_header;
+	struct curl_slist *headers = NULL;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	initStringInfo(&accept_header);
+	appendStringInfo(&accept_header, "Accept: %s", state->format);
+
+	/* For SPARQL UPDATE operations (INSERT, DELETE, UPDATE), use different approach */
+	if (state->sparql_query_type == SPARQL_INSERT ||
+		state->sparql_query_type == SPARQL_DELETE ||
+		state->sparql_query_type == SPARQL_UPDATE)
+	{
+		/* SPARQL UPDATE: send the update query directly in POST body with application/sparql-update */
+		elog(DEBUG1, "%s: using SPARQL UPDATE protocol", __func__);
+
+		/* No need to build URL parameters for UPDATE */
+		initStringInfo(&url_buffer);
+	}
+	else
+	{
+		/* SPARQL SELECT/DESCRIBE: use URL-encoded form parameters */
+		char *escaped_url = curl_easy_escape(state->curl, state->sparql, 0);
+
+		initStringInfo(&url_buffer);
+		appendStringInfo(&url_buffer, "%s=%s", state->query_param, escaped_url);
+
+		if (state->custom_params)
+			appendStringInfo(&url_buffer, "&%s", escaped_url);
+
+		if (escaped_url)
+			curl_free(escaped_url);
+
+		elog(DEBUG2, "  %s: url built > %s?%s", __func__, state->endpoint, url_buffer.data);
+	}
+
+	errbuf[0] = 0;
+
+	curl_easy_setopt(state->curl, CURLOPT_URL, state->endpoint);
+
+	/* CURLOPT_PROTOCOLS was deprecated in libcurl 7.85 and its enum flags removed
+	 * in 8.0; use the string-based CURLOPT_PROTOCOLS_STR on newer versions. */
+#if ((LIBCURL_VERSION_MAJOR == 7 && LIBCURL_VERSION_MINOR < 85) || LIBCURL_VERSION_MAJOR < 7)
+	curl_easy_setopt(state->curl, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS);
+#else
+	curl_easy_setopt(state->curl, CURLOPT_PROTOCOLS_STR, "http,https");
+#endif
+
+	curl_easy_setopt(state->curl, CURLOPT_ERRORBUFFER, errbuf);
+
+	curl_easy_setopt(state->curl, CURLOPT_CONNECTTIMEOUT, state->connect_timeout);
+	curl_easy_setopt(state->curl, CURLOPT_TIMEOUT, state->request_timeout);
+	elog(DEBUG2, "  %s: connect_timeout > %ld", __func__, state->connect_timeout);
+	elog(DEBUG2, "  %s: request_timeout > %ld", __func__, state->request_timeout);
+	elog(DEBUG2, "  %s: max retry > %ld", __func__, state->max_retries);
+
+	if (state->proxy)
+	{
+		elog(DEBUG2, "  %s: proxy URL > '%s'", __func__, state->proxy);
+
+		curl_easy_setopt(state->curl, CURLOPT_PROXY, state->proxy);
+
+		if (strcmp(state->proxy_type, RDF_SERVER_OPTION_HTTP_PROXY) == 0)
+		{
+			elog(DEBUG2, "  %s: proxy protocol > 'HTTP'", __func__);
+			curl_easy_setopt(state->curl, CURLOPT_PROXYTYPE, CURLPROXY_HTTP);
+		}
+		else if (strcmp(state->proxy_type, RDF_SERVER_OPTION_HTTPS_PROXY) == 0)
+		{
+			elog(DEBUG2, "  %s: proxy protocol > 'HTTPS'", __func__);
+			curl_easy_setopt(state->curl, CURLOPT_PROXYTYPE, CURLPROXY_HTTPS);
+		}
+
+		if (state->proxy_user)
+		{
+			elog(DEBUG2, "  %s: entering proxy user ('%s').", __func__, state->proxy_user);
+			curl_easy_setopt(state->curl, CURLOPT_PROXYUSERNAME, state->proxy_user);
+		}
+
+		if (state->proxy_user_password)
+		{
+			elog(DEBUG2, "  %s: entering proxy user's password.", __func__);
+			curl_easy_setopt(state->curl, CURLOPT_PROXYPASSWORD, state->proxy_user_password);
+		}
+	}
+
+	if (state->request_redirect == true)
+	{
+
+		elog(DEBUG2, "  %s: setting request redirect: %d", __func__, state->request_redirect);
+		curl_easy_setopt(state->curl, CURLOPT_FOLLOWLOCATION, 1L);
+
+		/* Never forward credentials to a redirected host */
+		curl_easy_setopt(state->curl, CURLOPT_UNRESTRICTED_AUTH, 0L);
+
+		if (state->request_max_redirect)
+		{
+			elog(DEBUG2, "  %s: setting maxredirs: %ld", __func__, state->request_max_redirect);
+			curl_easy_setopt(state->curl, CURLOPT_MAXREDIRS, state->request_max_redirect);
+		}
+	}
+
+	/* Set POST data based on query type */
+	if (state->sparql_query_type == SPARQL_INSERT ||
+		state->sparql_query_type == SPARQL_DELETE ||
+		state->sparql_query_type == SPARQL_UPDATE)
+	{
+		if (state->request_body)
+		{
+			/* Batched updates: stream the body from its parts */
+			RDFfdwRequestBody *body = state->request_body;
+			curl_off_t size = (curl_off_t)(body->lengths[0] + body->lengths[1] + body->lengths[2]);
+
+			elog(DEBUG1, "%s: streaming request body of %ld bytes", __func__, (long)size);
+
+			body->part = 0;
+			body->offset = 0;
+
+			curl_easy_setopt(state->curl, CURLOPT_POST, 1L);
+			curl_easy_setopt(state->curl, CURLOPT_READFUNCTION, CURLReadBodyCallback);
+			curl_easy_setopt(state->curl, CURLOPT_READDATA, (void *)body);
+			curl_easy_setopt(state->curl, CURLOPT_SEEKFUNCTION, CURLSeekBodyCallback);
+			curl_easy_setopt(state->curl, CURLOPT_SEEKDATA, (void *)body);
+			curl_easy_setopt(state->curl, CURLOPT_POSTFIELDSIZE_LARGE, size);
+		}
+		else
+		{
+			/* For SPARQL UPDATE: send raw SPARQL update in POST body */
+			elog(DEBUG1, "%s: setting SPARQL UPDATE body: %s", __func__, state->sparql);
+			curl_easy_setopt(state->curl, CURLOPT_POSTFIELDS, state->sparql);
+			curl_easy_setopt(state->curl, CURLOPT_POSTFIELDSIZE, (long)strlen(state->sparql));
+		}
+	}
+	else
+	{
+		/*
+		 * For SPARQL SELECT/DESCRIBE: send URL-encoded parameters. libcurl
+		 * does not copy CURLOPT_POSTFIELDS, so url_buffer must outlive the
+		 * request - it is allocated in the caller's memory context.
+		 */
+		curl_easy_setopt(state->curl, CURLOPT_POSTFIELDS, url_buffer.data);
+	}
+
+	curl_easy_setopt(state->curl, CURLOPT_HEADERFUNCTION, CURLHeaderCallback);
+	curl_easy_setopt(state->curl, CURLOPT_HEADERDATA, (void *)chunk_header);
+
+	/* For SPARQL UPDATE operations, collect the response body so that
+	 * error details (e.g. auth failure messages) can be surfaced in the
+	 * PostgreSQL error.  max_size is reset to 0 (unlimited) to avoid a
+	 * false "exceeds max_response_size" error when the endpoint returns
+	 * a large body on a successful update (e.g. QLever JSON). */
+	if (state->sparql_query_type == SPARQL_INSERT ||
+		state->sparql_query_type == SPARQL_DELETE ||
+		state->sparql_query_type == SPARQL_UPDATE)
+		chunk->max_size = 0;
+
+	curl_easy_setopt(state->curl, CURLOPT_WRITEFUNCTION, CURLWriteMemoryCallback);
+	curl_easy_setopt(state->curl, CURLOPT_WRITEDATA, (void *)chunk);
+
+	/* Don't use CURLOPT_FAILONERROR so we can capture error response bodies */
+	curl_easy_setopt(state->curl, CURLOPT_FAILONERROR, 0L);
+
+	/*
+	 * Enable libcurl verbose output, but route it exclusively through
+	 * CURLDebugCallback instead of stderr. The callback emits at DEBUG3
+	 * (gated by log_min_messages) and redacts Authorization headers so
+	 * credentials are never written to server logs.
+	 */
+	curl_easy_setopt(state->curl, CURLOPT_VERBOSE, 1L);
+	curl_easy_setopt(state->curl, CURLOPT_DEBUGFUNCTION, CURLDebugCallback);
+	curl_easy_setopt(state->curl, CURLOPT_DEBUGDATA, NULL);
+
+	/* Set the progress callback function */
+	curl_easy_setopt(state->curl, CURLOPT_XFERINFOFUNCTION, CURLProgressCallback);
+
+	/* Optional: Pass user data to the callback (NULL in this case) */
+	curl_easy_setopt(state->curl, CURLOPT_XFERINFODATA, NULL);
+
+	/* Enable progress callback */
+	curl_easy_setopt(state->curl, CURLOPT_NOPROGRESS, 0L);
+
+	initStringInfo(&user_agent);
+	appendStringInfo(&user_agent, "PostgreSQL/%s rdf_fdw/%s libxml2/%s %s", PG_VERSION, FDW_VERSION, LIBXML_DOTTED_VERSION, curl_version());
+	curl_easy_setopt(state->curl, CURLOPT_USERAGENT, user_agent.data);
+
+	/* Set headers based on query type */
+	if (state->graph_store_format)
+	{
+		/* Graph Store Protocol: the body is an RDF document, not an update */
+		StringInfoData content_type;
+
+		initStringInfo(&content_type);
+		appendStringInfo(&content_type, "Content-Type: %s", state->graph_store_format);
+		headers = curl_slist_append(headers, content_type.data);
+		elog(DEBUG1, "%s: setting %s", __func__, content_type.data);
+	}
+	else if (state->sparql_query_type == SPARQL_INSERT ||
+		state->sparql_query_type == SPARQL_DELETE ||
+		state->sparql_query_type == SPARQL_UPDATE)
+	{
+		/* For SPARQL UPDATE: use application/sparql-update content type */
+		headers = curl_slist_append(headers, "Content-Type: application/sparql-update");
+		elog(DEBUG1, "%s: setting Content-Type: application/sparql-update", __func__);
+	}
+	else
+	{
+		/* For SPARQL SELECT/DESCRIBE: use standard accept header */
+		headers = curl_slist_append(headers, accept_header.data);
+	}
+
+	/*
+	 * Bearer token authentication as defined by RFC 6750
+	 * (https://datatracker.ietf.org/doc/html/rfc6750).
+	 * This is the standard mechanism for OAuth 2.0 token-based
+	 * authentication.
+	 */
+	if (state->token)
+	{
+		StringInfoData auth_header;
+		initStringInfo(&auth_header);
+		appendStringInfo(&auth_header, "Authorization: Bearer %s", state->token);
+		headers = curl_slist_append(headers, auth_header.data);
+		elog(DEBUG2, "%s: setting Authorization: Bearer [REDACTED]", __func__);
+	}
+
+	curl_easy_setopt(state->curl, CURLOPT_HTTPHEADER, headers);
+
+	if (state->user && state->password)
+	{
+		curl_easy_setopt(state->curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+		curl_easy_setopt(state->curl, CURLOPT_USERNAME, state->user);
+		curl_easy_setopt(state->curl, CURLOPT_PASSWORD, state->password);
+	}
+	else if (state->user && !state->password)
+	{
+		curl_easy_setopt(state->curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+		curl_easy_setopt(state->curl, CURLOPT_USERNAME, state->user);
+	}
+
+	elog(DEBUG1, "%s exit", __func__);
+	return headers;
+}
+
+/*
+ * UpdateConnectionStats
+ * ---------------------
+ * Records a finished request in the connection cache entry 'conn' and logs
+ * how many of its requests could reuse an already open connection.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ * conn : connection cache entry used for the request
+ * res  : result of the transfer
+ */
+static void UpdateConnectionStats(RDFfdwState *state, RDFfdwConnCacheEntry *conn, CURLcode res)
+{
+	long num_connects = 0;
+
+	/*
+	 * CURLINFO_NUM_CONNECTS is the number of new connections libcurl had
+	 * to open for the last transfer, so 0 means a cached one was reused.
+	 */
+	conn->requests++;
+	if (res == CURLE_OK &&
+		curl_easy_getinfo(state->curl, CURLINFO_NUM_CONNECTS, &num_connects) == CURLE_OK &&
+		num_connects == 0)
+		conn->reused++;
+
+	elog(DEBUG1, "%s: connection reuse on server \"%s\": %ld of %ld requests (%.1f%%)",
+		 __func__, state->server->servername, conn->reused, conn->requests,
+		 100.0 * (double)conn->reused / (double)conn->requests);
+}
+
+/*
+ * UpdateScanStats
+ * ---------------
+ * Adds the timings and sizes of a finished request to the counters shown
+ * by EXPLAIN (ANALYZE). Does nothing if the scan is not instrumented. If
+ * the request was retried, the timings are those of its last attempt.
+ *
+ * state  : SPARQL, SERVER and FOREIGN TABLE info
+ * curl   : easy handle of the request
+ * retries: number of times the request was repeated after network errors
+ * decoded: response body bytes handed to the write callback
+ */
+static void UpdateScanStats(RDFfdwState *state, CURL *curl, long retries, size_t decoded)
+{
+	RDFfdwScanStats *stats = state->stats;
+
+	if (!stats)
+		return;
+
+	stats->requests++;
+	stats->retries += retries;
+	stats->bytes_decoded += (double)decoded;
+
+	/* the *_T variants (microseconds and curl_off_t) exist since libcurl 7.61 */
+#if ((LIBCURL_VERSION_MAJOR == 7 && LIBCURL_VERSION_MINOR < 61) || LIBCURL_VERSION_MAJOR < 7)
+	{
+		double connect = 0;
+		double first_byte = 0;
+		double total = 0;
+		double size = 0;
+
+		curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &connect);
+		curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME, &first_byte);
+		curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &total);
+		curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD, &size);
+
+		stats->connect_time += connect * 1000.0;
+		stats->first_byte_time += first_byte * 1000.0;
+		stats->transfer_time += total * 1000.0;
+		stats->bytes += size;
+	}
+#else
+	{
+		curl_off_t connect = 0;
+		curl_off_t first_byte = 0;
+		curl_off_t total = 0;
+		curl_off_t size = 0;
+
+		curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+		curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &first_byte);
+		curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+		curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &size);
+
+		stats->connect_time += (double)connect / 1000.0;
+		stats->first_byte_time += (double)first_byte / 1000.0;
+		stats->transfer_time += (double)total / 1000.0;
+		stats->bytes += (double)size;
+	}
+#endif
+}
+
+/*
+ * AddElapsedTime
+ * --------------
+ * Adds the milliseconds elapsed since 'start' to 'counter'.
+ */
+static void AddElapsedTime(double *counter, instr_time start)
+{
+	instr_time duration;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+	*counter += INSTR_TIME_GET_MILLISEC(duration);
+}
+
+/*
+ * ReportRequestError
+ * ------------------
+ * Raises an ERROR describing a failed SPARQL request: either an HTTP error
+ * status returned by the endpoint (with a truncated copy of the response
+ * body as detail) or a libcurl/network error. This function does not return.
+ *
+ * state        : SPARQL, SERVER and FOREIGN TABLE info
+ * res          : result of the transfer
+ * response_code: HTTP status code (0 if no response was received)
+ * chunk        : response body
+ * chunk_header : response headers
+ * errbuf       : libcurl error buffer
+ */
+static void ReportRequestError(RDFfdwState *state, CURLcode res, long response_code, struct MemoryStruct *chunk, struct MemoryStruct *chunk_header, char *errbuf)
+{
+	/* Check for HTTP errors first (with FAILONERROR=false, we get the response body) */
+	if (response_code >= 400)
+	{
+		StringInfoData display_body;
+		bool has_body = (chunk->size > 0 && chunk->memory);
+
+		/* HTTP error - response body should contain error details */
+		elog(DEBUG1, "%s: HTTP error %ld, response size=%zu, header size=%zu",
+			 __func__, response_code, chunk->size, chunk_header->size);
+
+		if (chunk_header->size > 0 && chunk_header->memory)
+			elog(DEBUG2, "%s: response headers:\n%s", __func__, chunk_header->memory);
+
+		if (state->xmldoc)
+			xmlFreeDoc(state->xmldoc);
+
+		initStringInfo(&display_body);
+
+		if (has_body)
+		{
+			/*
+			 * Truncate the error body before logging or including in
+			 * error messages.  Endpoints may return large HTML pages on
+			 * errors (e.g. from misconfigured proxies), which would
+			 * flood server logs.
+			 */
+			if (chunk->size > RDF_FDW_MAX_ERROR_BODY)
+			{
+				appendBinaryStringInfo(&display_body, chunk->memory, RDF_FDW_MAX_ERROR_BODY);
+				appendStringInfoString(&display_body, "... (truncated)");
+			}
+			else
+			{
+				appendStringInfoString(&display_body, chunk->memory);
+			}
+			elog(DEBUG1, "%s: error response body: %s", __func__, display_body.data);
+		}
+		else
+		{
+			elog(DEBUG1, "%s: no response body available for HTTP error %ld", __func__, response_code);
+		}
+
+		if (response_code == 400)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("bad request on server \"%s\" (HTTP 400)", state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0,
+					 errhint("Check the SPARQL query syntax.")));
+		else if (response_code == 401)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_AUTHORIZATION_SPECIFICATION),
+					 errmsg("authentication failed on server \"%s\" (HTTP 401)", state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0,
+					 errhint("Check the credentials in the USER MAPPING for PostgreSQL user \"%s\".", GetUserNameFromId(GetUserId(), false))));
+		else if (response_code == 403)
+			ereport(ERROR,
+					(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+					 errmsg("access denied on server \"%s\" (HTTP 403)", state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0,
+					 errhint("The server understood the request but the authenticated user lacks permission to access the endpoint.")));
+		else if (response_code == 404)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+					 errmsg("endpoint not found on server \"%s\" (HTTP 404)", state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0,
+					 errhint("Check the endpoint URL: \"%s\".", state->endpoint)));
+		else if (response_code == 406)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+					errmsg("unacceptable response format on server \"%s\" (HTTP 406)", state->server->servername),
+					has_body ? errdetail("%s", display_body.data) : 0,
+					errhint("The endpoint does not support the requested format. "
+							"Check the 'format' option in CREATE SERVER.")));
+		else if (response_code == 407)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+					 errmsg("proxy authentication required on server \"%s\" (HTTP 407)", state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0,
+					 errhint("The endpoint requires proxy authentication. Check the proxy settings.")));
+		else if (response_code == 429)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_ERROR),
+					 errmsg("too many requests on server \"%s\" (HTTP 429)", state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0,
+					 errhint("The endpoint is rate-limiting requests. Consider reducing query frequency or adding a delay between requests.")));
+		else if (response_code == 500)
+			ereport(ERROR,
+					(errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+					 errmsg("internal error on server \"%s\" (HTTP 500)", state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0));
+		else if (response_code == 503)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+					 errmsg("service unavailable on server \"%s\" (HTTP 503)", state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0,
+					 errhint("The endpoint is temporarily unavailable. Try again later.")));
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+					 errmsg("HTTP %ld error on server \"%s\"", response_code, state->server->servername),
+					 has_body ? errdetail("%s", display_body.data) : 0));
+	}
+	else
+	{
+		/* cURL/network error */
+		size_t len = strlen(errbuf);
+		const char *curl_err = curl_easy_strerror(res);
+		fprintf(stderr, "\nlibcurl: (%d) ", res);
+
+		xmlFreeDoc(state->xmldoc);
+
+		if (len)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+					 errmsg("unable to connect to '%s'", state->server->servername),
+					 errdetail("%s (curl error code %u).", curl_err, res)));
+		}
+		else
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+					 errmsg("%s => (%u) '%s'\n", __func__, res, curl_err)));
+		}
+	}
+}
+
+/*
+ * ExecuteSPARQL
+ * -------------
+ * Executes the SPARQL query in the endpoint set in the CREATE FOREIGN TABLE
+ * and CREATE SERVER statements. The result set is loaded into 'state'.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns REQUEST_SUCCESS or REQUEST_FAIL
+ */
+static int ExecuteSPARQL(RDFfdwState *state)
+{
+	CURLcode res;
+	char errbuf[CURL_ERROR_SIZE];
+	struct MemoryStruct chunk;
+	struct MemoryStruct chunk_header;
+	struct curl_slist *headers = NULL;
+	long response_code;
+	long retries = 0;
+	RDFfdwConnCacheEntry *conn;
+
+	chunk.memory = palloc0(1);
+	chunk.size = 0; /* no data at this point */
+	chunk.max_size = (size_t) state->max_response_size;
+	chunk_header.memory = palloc0(1);
+	chunk_header.size = 0; /* no data at this point */
+	chunk_header.max_size = 0; /* no limit on headers */
+
+	elog(DEBUG1, "%s called for %s operation", __func__,
+		 (state->sparql_query_type == SPARQL_INSERT) ? "INSERT" : (state->sparql_query_type == SPARQL_DELETE) ? "DELETE"
+															  : (state->sparql_query_type == SPARQL_UPDATE)	  ? "UPDATE"
+																											  : "SELECT/DESCRIBE");
+
+	conn = GetConnection(state);
+	state->curl = conn->curl;
+
+	if (state->log_sparql && state->request_body)
+		elog(INFO, "SPARQL query sent to '%s':\n%s%s%s\n", state->server->servername,
+			 state->request_body->parts[0], state->request_body->parts[1], state->request_body->parts[2]);
+	else if (state->log_sparql)
+		elog(INFO, "SPARQL query sent to '%s':\n%s\n", state->server->servername, state->sparql);
+
+	if (state->curl)
+	{
+		headers = SetCURLOptions(state, errbuf, &chunk, &chunk_header);
+
+		elog(DEBUG2, "  %s: performing cURL request ... ", __func__);
+
+		/*
+		 * Flag the cached handle as busy while libcurl owns it, so that
+		 * GetConnection() can tell whether an ERROR escaped mid-transfer.
+		 */
+		conn->busy = true;
+
+		res = curl_easy_perform(state->curl);
+
+		/* Always get response code - even if cURL failed */
+		curl_easy_getinfo(state->curl, CURLINFO_RESPONSE_CODE, &response_code);
+
+		elog(DEBUG2, "  %s: cURL result=%d, HTTP status=%ld, response size=%zu",
+			 __func__, res, response_code, chunk.size);
+
+		/* Only retry on network errors (no response received), not on HTTP errors or HTTP successes */
+		if (res != CURLE_OK && response_code == 0)
+		{
+			if (state->request_body)
+			{
+				state->request_body->part = 0;
+				state->request_body->offset = 0;
+			}
+
+			for (retries = 1; retries <= state->max_retries && (res = curl_easy_perform(state->curl)) != CURLE_OK; retries++)
+			{
+				elog(WARNING, "%s: request to '%s' failed (%ld)", __func__, state->server->servername, retries);
+				/* Reset chunk memory for retry */
+				chunk.size = 0;
+				chunk_header.size = 0;
+				/* Send the request body again from its beginning */
+				if (state->request_body)
+				{
+					state->request_body->part = 0;
+					state->request_body->offset = 0;
+				}
+			}
+			retries = Min(retries, state->max_retries);
+			/* Update response code after retries */
+			curl_easy_getinfo(state->curl, CURLINFO_RESPONSE_CODE, &response_code);
+		}
+
+		conn->busy = false;
+
+		UpdateConnectionStats(state, conn, res);
+		UpdateScanStats(state, state->curl, retries, chunk.size);
+
+		if (response_code >= 400 || res != CURLE_OK)
+		{
+			curl_slist_free_all(headers);
+			ReportRequestError(state, res, response_code, &chunk, &chunk_header, errbuf);
+		}
+		else
+		{
+			/* Success - HTTP 2xx */
+			state->sparql_resultset = pstrdup(chunk.memory);
+
+			elog(DEBUG4, "%s: http response header = \n%s", __func__, chunk_header.memory);
+			elog(DEBUG4, "%s: xml document \n\n%s", __func__, chunk.memory);
+			elog(DEBUG2, "%s: http response code = %ld", __func__, response_code);
+			elog(DEBUG2, "%s: http response size = %ld", __func__, chunk.size);
+		}
+	}
+
+	pfree(chunk.memory);
+	pfree(chunk_header.memory);
+	curl_slist_free_all(headers);
+
+	/*
+	 * We thrown an error in case the SPARQL endpoint returns an empty XML doc
+	 */
+	if (!state->sparql_resultset)
+	{
+		elog(DEBUG1, "%s exit: REQUEST_FAIL", __func__);
+		return REQUEST_FAIL;
+	}
+
+	elog(DEBUG1, "%s exit: REQUEST_SUCCESS", __func__);
+	return REQUEST_SUCCESS;
+}
+
+/*
+ * LoadRDFData
+ * ---------------
+ *
+ * Parses the result set loaded into 'state->xmldoc' into records.
+ * For SELECT queries, it delegates to the original LoadRDFData.
+ * For DESCRIBE queries, it parses the RDF/XML response using libxml2 and stores
+ * the parsed XML document in state->xmldoc for later processing by DescribeIRI().
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ */
+static void LoadRDFData(RDFfdwState *state)
+{
+	int options = XML_PARSE_NOBLANKS | XML_PARSE_NONET;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	/* Enable XML_PARSE_HUGE if needed */
+	if (state->enable_xml_huge)
+	{
+		options |= XML_PARSE_HUGE;
+		elog(DEBUG1, "%s: enabling XML_PARSE_HUGE", __func__);
+	}
+
+	if (state->sparql_query_type == SPARQL_DESCRIBE)
+	{
+		/* Execute the SPARQL DESCRIBE query */
+		if (ExecuteSPARQL(state) != REQUEST_SUCCESS)
+			elog(ERROR, "%s -> SPARQL DESCRIBE query failed: '%s'", __func__, state->endpoint);
+
+		/* Free existing xmldoc before allocating new one */
+		if (state->xmldoc)
+		{
+			elog(DEBUG2, "%s: freeing existing xmldoc", __func__);
+			xmlFreeDoc(state->xmldoc);
+			state->xmldoc = NULL;
+		}
+
+		/* Parse the RDF/XML response */
+		state->xmldoc = xmlReadMemory(
+			state->sparql_resultset,
+			strlen(state->sparql_resultset),
+			NULL, NULL,
+			options);
+
+		/* Free sparql_resultset as we no longer need it */
+		if (state->sparql_resultset)
+		{
+			pfree(state->sparql_resultset);
+			state->sparql_resultset = NULL;
+		}
+
+		if (state->xmldoc == NULL)
+		{
+			const xmlError *err = xmlGetLastError();
+			if (err)
+				elog(ERROR, "%s: failed to parse RDF/XML: %s", __func__, err->message);
+			else
+				elog(ERROR, "%s: failed to parse RDF/XML (unknown error)", __func__);
+		}
+
+		elog(DEBUG1, "%s exit: RDF/XML parsed successfully", __func__);
+	}
+	else
+	{
+		/* Handle SELECT queries */
+		xmlNodePtr results;
+		xmlNodePtr root;
+		instr_time start;
+
+		state->rowcount = 0;
+		state->records = NIL;
+
+		/* Execute the SPARQL query */
+		if (ExecuteSPARQL(state) != REQUEST_SUCCESS)
+		{
+			if (state->xmldoc)
+				xmlFreeDoc(state->xmldoc);
+			elog(ERROR, "%s -> SPARQL failed: '%s'", __func__, state->endpoint);
+		}
+
+		INSTR_TIME_SET_ZERO(start);
+		if (state->stats && state->stats->timing)
+			INSTR_TIME_SET_CURRENT(start);
+
+		elog(DEBUG2, "  %s: loading 'xmlroot'", __func__);
+
+		/* Free existing xmldoc before allocating new one */
+		if (state->xmldoc)
+		{
+			elog(DEBUG2, "	%s: freeing existing xmldoc", __func__);
+			xmlFreeDoc(state->xmldoc);
+			state->xmldoc = NULL;
+		}
+
+		if (state->tsv)
+		{
+			elog(DEBUG2, "	%s: freeing existing TSV result", __func__);
+			SPARQLTsvFreeParser(state->tsv);
+			state->tsv = NULL;
+		}
+
+		if (state->json)
+		{
+			elog(DEBUG2, "	%s: freeing existing JSON result", __func__);
+			SPARQLJsonFreeParser(state->json);
+			state->json = NULL;
+		}
+
+		if (IsSPARQLTsvFormat(state->format))
+		{
+			char *tsv_error = NULL;
+
+			/*
+			 * SPARQL TSV results are not turned into a document. The reader
+			 * takes over the response buffer, and the rows are converted
+			 * into tuples straight from it, one line at a time.
+			 */
+			state->tsv = SPARQLTsvReadMemory(
+				state->sparql_resultset,
+				strlen(state->sparql_resultset),
+				&tsv_error);
+			state->sparql_resultset = NULL;
+
+			if (state->tsv == NULL)
+				elog(ERROR, "%s: failed to parse SPARQL TSV result: %s", __func__, tsv_error);
+
+			state->tsv_fields = (int *)palloc(state->numcols * sizeof(int));
+			ResolveTsvFields(state, state->tsv);
+
+			state->pagesize = SPARQLTsvCountRows(state->tsv);
+
+			if (state->stats)
+			{
+				state->stats->rows += state->pagesize;
+
+				if (state->stats->timing)
+					AddElapsedTime(&state->stats->parse_time, start);
+			}
+
+			if (state->log_sparql)
+				elog(INFO, "SPARQL returned %d %s.\n", state->pagesize, state->pagesize == 1 ? "record" : "records");
+
+			elog(DEBUG1, "%s exit: SELECT query processed", __func__);
+			return;
+		}
+
+		if (IsSPARQLJsonFormat(state->format))
+		{
+			/*
+			 * SPARQL JSON results are not turned into a document either.
+			 * Only the terms of the columns' variables are decoded, into
+			 * rows that are converted into tuples just like TSV rows.
+			 */
+			state->json = CreateJsonParser(state, true);
+
+			if (!SPARQLJsonParseChunk(state->json, state->sparql_resultset, strlen(state->sparql_resultset), true))
+				elog(ERROR, "%s: failed to parse SPARQL JSON result: %s", __func__, SPARQLJsonGetError(state->json));
+
+			pfree(state->sparql_resultset);
+			state->sparql_resultset = NULL;
+
+			state->pagesize = SPARQLJsonCountRows(state->json);
+
+			if (state->stats)
+			{
+				state->stats->rows += state->pagesize;
+
+				if (state->stats->timing)
+					AddElapsedTime(&state->stats->parse_time, start);
+			}
+
+			if (state->log_sparql)
+				elog(INFO, "SPARQL returned %d %s.\n", state->pagesize, state->pagesize == 1 ? "record" : "records");
+
+			elog(DEBUG1, "%s exit: SELECT query processed", __func__);
+			return;
+		}
+
+		CreateBindingMap(state);
+
+		/* Parse the SPARQL result XML */
+		state->xmldoc = xmlReadMemory(
+			state->sparql_resultset,
+			strlen(state->sparql_resultset),
+			NULL, NULL,
+			options);
+
+		/* We no longer need sparql_resultset, so let's free it */
+		if (state->sparql_resultset)
+		{
+			pfree(state->sparql_resultset);
+			state->sparql_resultset = NULL;
+		}
+
+		if (state->xmldoc == NULL)
+		{
+			const xmlError *err = xmlGetLastError();
+			if (err)
+				elog(ERROR, "%s: failed to parse SPARQL XML result: %s", __func__, err->message);
+			else
+				elog(ERROR, "%s: failed to parse SPARQL XML result (unknown error)", __func__);
+		}
+
+		root = xmlDocGetRootElement(state->xmldoc);
+
+		if (root == NULL)
+		{
+			xmlFreeDoc(state->xmldoc);
+			state->xmldoc = NULL;
+			elog(ERROR, "%s: SPARQL XML result has no root element", __func__);
+		}
+
+		for (results = root->children; results != NULL; results = results->next)
+		{
+			if (xmlStrcmp(results->name, (xmlChar *)"results") == 0)
+			{
+				xmlNodePtr record;
+
+				for (record = results->children; record != NULL; record = record->next)
+				{
+					if (xmlStrcmp(record->name, (xmlChar *)"result") == 0)
+					{
+						state->records = lappend(state->records, record);
+						state->pagesize++;
+
+						elog(DEBUG2, "  %s: appending record %d", __func__, state->pagesize);
+					}
+				}
+			}
+		}
+
+		if (state->stats)
+		{
+			state->stats->rows += state->pagesize;
+
+			if (state->stats->timing)
+				AddElapsedTime(&state->stats->parse_time, start);
+		}
+
+		if (state->log_sparql)
+			elog(INFO, "SPARQL returned %d %s.\n", state->pagesize, state->pagesize == 1 ? "record" : "records");
+
+		elog(DEBUG1, "%s exit: SELECT query processed", __func__);
+	}
+}
+
+/*
+ * BeginStreamingSPARQL
+ * --------------------
+ * Starts a SELECT request whose result is parsed while it is downloaded
+ * (enable_streaming). Instead of waiting for the whole response, the request
+ * is attached to a curl multi handle and driven by FetchNextStreamedBinding()
+ * from rdfIterateForeignScan, so the first tuples are returned as soon as the
+ * first <result> elements arrive.
+ *
+ * The easy handle is checked out of the connection cache for the lifetime of
+ * the stream, and all libcurl and libxml2 resources are released by a reset
+ * callback of 'cxt' in case the scan is aborted by an ERROR.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ * cxt  : memory context of the request, reset to send it again
+ */
+static void BeginStreamingSPARQL(RDFfdwState *state, MemoryContext cxt)
+{
+	RDFfdwStream *stream;
+	MemoryContextCallback *callback;
+	MemoryContext oldcxt;
+	CURLMcode mc;
+	int options = XML_PARSE_NOBLANKS | XML_PARSE_NONET | XML_PARSE_NODICT;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	/* Enable XML_PARSE_HUGE if needed */
+	if (state->enable_xml_huge)
+	{
+		options |= XML_PARSE_HUGE;
+		elog(DEBUG1, "%s: enabling XML_PARSE_HUGE", __func__);
+	}
+
+	oldcxt = MemoryContextSwitchTo(cxt);
+
+	stream = (RDFfdwStream *)palloc0(sizeof(RDFfdwStream));
+	stream->error_body.memory = palloc0(1);
+	stream->error_body.max_size = (size_t)state->max_response_size;
+	stream->header.memory = palloc0(1);
+
+	callback = (MemoryContextCallback *)palloc0(sizeof(MemoryContextCallback));
+	callback->func = StreamResetCallback;
+	callback->arg = (void *)stream;
+	MemoryContextRegisterResetCallback(cxt, callback);
+
+	state->stream = stream;
+	state->rowcount = 0;
+	stream->stats = state->stats;
+
+	stream->conn = GetConnection(state);
+	stream->curl = stream->conn->curl;
+	stream->conn->curl = NULL;
+	state->curl = stream->curl;
+
+	if (stream->curl == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+				 errmsg("unable to initialize a request to server \"%s\"", state->server->servername)));
+
+	if (state->log_sparql)
+		elog(INFO, "SPARQL query sent to '%s':\n%s\n", state->server->servername, state->sparql);
+
+	stream->headers = SetCURLOptions(state, stream->errbuf, &stream->error_body, &stream->header);
+	curl_easy_setopt(stream->curl, CURLOPT_WRITEFUNCTION, CURLStreamWriteCallback);
+	curl_easy_setopt(stream->curl, CURLOPT_WRITEDATA, (void *)stream);
+
+	if (IsSPARQLTsvFormat(state->format))
+	{
+		/* resolved once the header arrives, see FetchNextStreamedBinding */
+		stream->tsv = SPARQLTsvCreateParser();
+		state->tsv_fields = (int *)palloc(state->numcols * sizeof(int));
+	}
+	else if (IsSPARQLJsonFormat(state->format))
+		stream->json = CreateJsonParser(state, false);
+	else
+	{
+		stream->parser = xmlCreatePushParserCtxt(NULL, NULL, NULL, 0, NULL);
+
+		if (stream->parser == NULL)
+			elog(ERROR, "%s: unable to create XML push parser", __func__);
+
+		xmlCtxtUseOptions(stream->parser, options);
+
+		CreateBindingMap(state);
+	}
+
+	stream->multi = curl_multi_init();
+
+	if (stream->multi == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+				 errmsg("unable to initialize a request to server \"%s\"", state->server->servername)));
+
+	mc = curl_multi_add_handle(stream->multi, stream->curl);
+
+	if (mc != CURLM_OK)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+				 errmsg("unable to initialize a request to server \"%s\"", state->server->servername),
+				 errdetail("%s", curl_multi_strerror(mc))));
+
+	stream->attached = true;
+
+	MemoryContextSwitchTo(oldcxt);
+
+	elog(DEBUG1, "%s exit", __func__);
+}
+
+/*
+ * EndStreamingSPARQL
+ * ------------------
+ * Releases the libcurl and libxml2 resources of a streamed request and gives
+ * the easy handle back to the connection cache. Interrupting the transfer
+ * before it is complete (e.g. a LIMIT evaluated locally) closes its
+ * connection. Safe to call more than once.
+ *
+ * stream: streamed request
+ */
+static void EndStreamingSPARQL(RDFfdwStream *stream)
+{
+	if (stream == NULL)
+		return;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	if (stream->multi)
+	{
+		if (stream->attached)
+			curl_multi_remove_handle(stream->multi, stream->curl);
+
+		curl_multi_cleanup(stream->multi);
+		stream->multi = NULL;
+		stream->attached = false;
+	}
+
+	if (stream->curl)
+	{
+		/*
+		 * Hand the handle back, unless the cache got a new one in the
+		 * meantime or an ERROR was raised inside curl_multi_perform() (e.g. a
+		 * query cancel raised from CURLProgressCallback). In the latter case
+		 * libcurl never returned and the handle's state is unknown, so it is
+		 * not reused, but it is still cleaned up to close its connection.
+		 */
+		if (stream->conn->curl == NULL && !stream->conn->invalidated && !stream->busy)
+			stream->conn->curl = stream->curl;
+		else
+		{
+			if (stream->busy)
+				elog(DEBUG2, "  %s: closing handle of an aborted request", __func__);
+
+			curl_easy_cleanup(stream->curl);
+		}
+
+		stream->curl = NULL;
+	}
+
+	stream->busy = false;
+
+	if (stream->headers)
+	{
+		curl_slist_free_all(stream->headers);
+		stream->headers = NULL;
+	}
+
+	if (stream->parser)
+	{
+		if (stream->parser->myDoc)
+		{
+			xmlFreeDoc(stream->parser->myDoc);
+			stream->parser->myDoc = NULL;
+		}
+
+		xmlFreeParserCtxt(stream->parser);
+		stream->parser = NULL;
+	}
+
+	if (stream->json)
+	{
+		SPARQLJsonFreeParser(stream->json);
+		stream->json = NULL;
+	}
+
+	if (stream->tsv)
+	{
+		SPARQLTsvFreeParser(stream->tsv);
+		stream->tsv = NULL;
+	}
+
+	stream->results = NULL;
+	stream->current = NULL;
+	stream->row = NULL;
+	stream->json_row = NULL;
+
+	elog(DEBUG1, "%s exit", __func__);
+}
+
+/*
+ * StreamResetCallback
+ * -------------------
+ * Memory context reset callback that makes sure a streamed request does not
+ * leak libcurl or libxml2 resources when its scan is aborted by an ERROR.
+ */
+static void StreamResetCallback(void *arg)
+{
+	EndStreamingSPARQL((RDFfdwStream *)arg);
+}
+
+/*
+ * PumpStream
+ * ----------
+ * Waits for socket activity on a streamed request and lets libcurl process
+ * it, which feeds all received data into the XML push parser. Finishes the
+ * request once libcurl reports the transfer as done.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ */
+static void PumpStream(RDFfdwState *state)
+{
+	RDFfdwStream *stream = state->stream;
+	CURLMcode mc;
+	CURLMsg *msg;
+	int running = 0;
+	int pending = 0;
+
+	elog(DEBUG3, "%s called", __func__);
+
+	mc = curl_multi_wait(stream->multi, NULL, 0, RDF_STREAM_POLL_TIMEOUT, NULL);
+
+	if (mc == CURLM_OK)
+	{
+		stream->busy = true;
+		mc = curl_multi_perform(stream->multi, &running);
+		stream->busy = false;
+	}
+
+	if (mc != CURLM_OK)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+				 errmsg("unable to perform request on server \"%s\"", state->server->servername),
+				 errdetail("%s", curl_multi_strerror(mc))));
+
+	CHECK_FOR_INTERRUPTS();
+
+	while ((msg = curl_multi_info_read(stream->multi, &pending)) != NULL)
+	{
+		if (msg->msg == CURLMSG_DONE)
+			FinishStream(state, msg->data.result);
+	}
+
+	elog(DEBUG3, "%s exit", __func__);
+}
+
+/*
+ * FinishStream
+ * ------------
+ * Handles the end of a streamed transfer: retries requests that failed
+ * before any response was received, reports HTTP and network errors, and
+ * terminates the XML push parser.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ * res  : result of the transfer
+ */
+static void FinishStream(RDFfdwState *state, CURLcode res)
+{
+	RDFfdwStream *stream = state->stream;
+	long response_code = 0;
+	instr_time start;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	curl_easy_getinfo(stream->curl, CURLINFO_RESPONSE_CODE, &response_code);
+
+	elog(DEBUG2, "  %s: cURL result=%d, HTTP status=%ld, response size=%zu",
+		 __func__, res, response_code, stream->received);
+
+	curl_multi_remove_handle(stream->multi, stream->curl);
+	stream->attached = false;
+
+	/* Only retry on network errors (no response received), not on HTTP errors or HTTP successes */
+	if (res != CURLE_OK && response_code == 0 && stream->received == 0 &&
+		stream->retries < state->max_retries)
+	{
+		stream->retries++;
+		elog(WARNING, "%s: request to '%s' failed (%ld)", __func__, state->server->servername, stream->retries);
+
+		stream->header.size = 0;
+
+		if (curl_multi_add_handle(stream->multi, stream->curl) == CURLM_OK)
+		{
+			stream->attached = true;
+			return;
+		}
+	}
+
+	UpdateConnectionStats(state, stream->conn, res);
+	UpdateScanStats(state, stream->curl, stream->retries, stream->received);
+
+	if (response_code >= 400 || res != CURLE_OK)
+		ReportRequestError(state, res, response_code, &stream->error_body, &stream->header, stream->errbuf);
+
+	INSTR_TIME_SET_ZERO(start);
+	if (stream->stats && stream->stats->timing)
+		INSTR_TIME_SET_CURRENT(start);
+
+	/* tell the parser that the document is complete */
+	if (stream->tsv)
+	{
+		if (!SPARQLTsvParseChunk(stream->tsv, NULL, 0, true))
+			elog(ERROR, "%s: failed to parse SPARQL TSV result: %s", __func__, SPARQLTsvGetError(stream->tsv));
+	}
+	else if (stream->json)
+	{
+		if (!SPARQLJsonParseChunk(stream->json, NULL, 0, true))
+			elog(ERROR, "%s: failed to parse SPARQL JSON result: %s", __func__, SPARQLJsonGetError(stream->json));
+	}
+	else if (xmlParseChunk(stream->parser, NULL, 0, 1) != 0)
+	{
+		const xmlError *err = xmlCtxtGetLastError(stream->parser);
+		if (err)
+			elog(ERROR, "%s: failed to parse SPARQL XML result: %s", __func__, err->message);
+		else
+			elog(ERROR, "%s: failed to parse SPARQL XML result (unknown error)", __func__);
+	}
+
+	if (stream->stats && stream->stats->timing)
+		AddElapsedTime(&stream->stats->parse_time, start);
+
+	stream->done = true;
+
+	elog(DEBUG1, "%s exit", __func__);
+}
+
+/*
+ * NextStreamedResult
+ * ------------------
+ * Looks for the next complete <result> element in the partially parsed
+ * document of a streamed request. A node is complete once the parser has
+ * moved past it, i.e. it has a next sibling, the parser is back at the
+ * <results> level, or the document is done. The <result> returned
+ * by the previous call is freed here, as soon as the parser no longer needs
+ * it, which keeps the document small regardless of the size of the result set.
+ *
+ * stream: streamed request
+ *
+ * returns the next complete <result> node, or NULL if none is available yet
+ */
+static xmlNodePtr NextStreamedResult(RDFfdwStream *stream)
+{
+	xmlNodePtr node;
+	xmlNodePtr next;
+
+	if (stream->results == NULL)
+	{
+		xmlNodePtr root;
+
+		if (stream->parser->myDoc == NULL ||
+			(root = xmlDocGetRootElement(stream->parser->myDoc)) == NULL)
+			return NULL;
+
+		for (node = root->children; node != NULL; node = node->next)
+		{
+			if (node->type == XML_ELEMENT_NODE && xmlStrcmp(node->name, (xmlChar *)"results") == 0)
+			{
+				stream->results = node;
+				break;
+			}
+		}
+
+		if (stream->results == NULL)
+			return NULL;
+	}
+
+	if (stream->current != NULL)
+	{
+		/*
+		 * The parser may still append text to the last child of <results>,
+		 * so the previous record is only freed once it has a successor.
+		 */
+		if (stream->current->next == NULL && !stream->done)
+			return NULL;
+
+		node = stream->current->next;
+		xmlUnlinkNode(stream->current);
+		xmlFreeNode(stream->current);
+		stream->current = NULL;
+	}
+	else
+		node = stream->results->children;
+
+	for (; node != NULL; node = next)
+	{
+		next = node->next;
+
+		/* the last child may still be under construction */
+		if (next == NULL && !stream->done && stream->parser->node != stream->results)
+			return NULL;
+
+		if (node->type == XML_ELEMENT_NODE && xmlStrcmp(node->name, (xmlChar *)"result") == 0)
+		{
+			stream->current = node;
+			return node;
+		}
+
+		/* discard anything else found between <result> elements */
+		if (next != NULL || stream->done)
+		{
+			xmlUnlinkNode(node);
+			xmlFreeNode(node);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * FetchNextStreamedBinding
+ * ------------------------
+ * Fetches the next record of a streamed request, downloading and parsing
+ * more data from the endpoint until one is complete. The record is kept in
+ * 'stream->current' (<result> element), 'stream->row' (TSV row) or
+ * 'stream->json_row' (JSON row).
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns true if a record was fetched or false if EOF.
+ */
+static bool FetchNextStreamedBinding(RDFfdwState *state)
+{
+	RDFfdwStream *stream = state->stream;
+
+	elog(DEBUG3, "%s called", __func__);
+
+	for (;;)
+	{
+		if (stream->tsv)
+		{
+			if ((stream->row = SPARQLTsvNextRow(stream->tsv)) != NULL)
+			{
+				if (state->rowcount == 0)
+					ResolveTsvFields(state, stream->tsv);
+				break;
+			}
+		}
+		else if (stream->json)
+		{
+			if ((stream->json_row = SPARQLJsonNextRow(stream->json)) != NULL)
+				break;
+		}
+		else if (NextStreamedResult(stream) != NULL)
+			break;
+
+		if (stream->done)
+		{
+			if (state->log_sparql)
+				elog(INFO, "SPARQL returned %d %s.\n", state->rowcount, state->rowcount == 1 ? "record" : "records");
+
+			elog(DEBUG3, "%s exit: returning 'false' (EOF!)", __func__);
+			return false;
+		}
+
+		PumpStream(state);
+	}
+
+	elog(DEBUG3, "%s exit", __func__);
+	return true;
+}
+
+/*
+ * SetUsedColumns
+ * --------------
+ * Marks FOREIGN TABLE's columns as used if they're used in the SQL query. This is
+ * useful to get the mapped 'variable' OPTIONs, so that we can build a SPARQL SELECT
+ * only with the required variables.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ */
+static void SetUsedColumns(Expr *expr, struct RDFfdwState *state, int foreignrelid)
+{
+	Var *variable;
+	ListCell *cell;
+
+	elog(DEBUG2, "%s called: expression='%d'", __func__, expr->type);
+
+	switch (expr->type)
+	{
+	case T_RestrictInfo:
+		SetUsedColumns(((RestrictInfo *)expr)->clause, state, foreignrelid);
+		break;
+	case T_TargetEntry:
+		SetUsedColumns(((TargetEntry *)expr)->expr, state, foreignrelid);
+		break;
+	case T_Const:
+	case T_Param:
+	case T_CaseTestExpr:
+	case T_CoerceToDomainValue:
+	case T_CurrentOfExpr:
+#if PG_VERSION_NUM >= 100000
+	case T_NextValueExpr:
+#endif
+		break;
+	case T_Var:
+
+		variable = (Var *)expr;
+
+		/* ignore columns belonging to a different foreign table */
+		if (variable->varno != foreignrelid)
+		{
+			elog(WARNING, "%s: column belonging to a different foreign table", __func__);
+			break;
+		}
+
+		/* ignore system columns */
+		if (variable->varattno < 0)
+		{
+			elog(WARNING, "%s: ignoring system column", __func__);
+			break;
+		}
+
+		for (int i = 0; i < state->numcols; i++)
+		{
+			if (state->rdfTable->cols[i]->pgattnum == variable->varattno)
+			{
+				state->rdfTable->cols[i]->used = true;
+				elog(DEBUG2, "%s: column '%s' (%d) required in the SQL query", __func__, state->rdfTable->cols[i]->name, i);
+				break;
+			}
+		}
+
+		break;
+	case T_Aggref:
+		foreach (cell, ((Aggref *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		foreach (cell, ((Aggref *)expr)->aggorder)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		foreach (cell, ((Aggref *)expr)->aggdistinct)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_WindowFunc:
+		foreach (cell, ((WindowFunc *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+#if PG_VERSION_NUM < 120000
+	case T_ArrayRef:
+	{
+		ArrayRef *ref = (ArrayRef *)expr;
+#else
+	case T_SubscriptingRef:
+	{
+		SubscriptingRef *ref = (SubscriptingRef *)expr;
+#endif
+
+		foreach (cell, ref->refupperindexpr)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		foreach (cell, ref->reflowerindexpr)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		SetUsedColumns(ref->refexpr, state, foreignrelid);
+		SetUsedColumns(ref->refassgnexpr, state, foreignrelid);
+		break;
+	}
+	case T_FuncExpr:
+		foreach (cell, ((FuncExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_OpExpr:
+		foreach (cell, ((OpExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_DistinctExpr:
+		foreach (cell, ((DistinctExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_NullIfExpr:
+		foreach (cell, ((NullIfExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_ScalarArrayOpExpr:
+		foreach (cell, ((ScalarArrayOpExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_BoolExpr:
+		foreach (cell, ((BoolExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_SubPlan:
+	{
+		SubPlan *subplan = (SubPlan *)expr;
+
+		SetUsedColumns((Expr *)(subplan->testexpr), state, foreignrelid);
+
+		foreach (cell, subplan->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+	}
+	break;
+	case T_AlternativeSubPlan:
+		/* examine only first alternative */
+		SetUsedColumns((Expr *)linitial(((AlternativeSubPlan *)expr)->subplans), state, foreignrelid);
+		break;
+	case T_NamedArgExpr:
+		SetUsedColumns(((NamedArgExpr *)expr)->arg, state, foreignrelid);
+		break;
+	case T_FieldSelect:
+		SetUsedColumns(((FieldSelect *)expr)->arg, state, foreignrelid);
+		break;
+	case T_RelabelType:
+		SetUsedColumns(((RelabelType *)expr)->arg, state, foreignrelid);
+		break;
+	case T_CoerceViaIO:
+		SetUsedColumns(((CoerceViaIO *)expr)->arg, state, foreignrelid);
+		break;
+	case T_ArrayCoerceExpr:
+		SetUsedColumns(((ArrayCoerceExpr *)expr)->arg, state, foreignrelid);
+		break;
+	case T_ConvertRowtypeExpr:
+		SetUsedColumns(((ConvertRowtypeExpr *)expr)->arg, state, foreignrelid);
+		break;
+	case T_CollateExpr:
+		SetUsedColumns(((CollateExpr *)expr)->arg, state, foreignrelid);
+		break;
+	case T_CaseExpr:
+		foreach (cell, ((CaseExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		SetUsedColumns(((CaseExpr *)expr)->arg, state, foreignrelid);
+		SetUsedColumns(((CaseExpr *)expr)->defresult, state, foreignrelid);
+		break;
+	case T_CaseWhen:
+		SetUsedColumns(((CaseWhen *)expr)->expr, state, foreignrelid);
+		SetUsedColumns(((CaseWhen *)expr)->result, state, foreignrelid);
+		break;
+	case T_ArrayExpr:
+		foreach (cell, ((ArrayExpr *)expr)->elements)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_RowExpr:
+		foreach (cell, ((RowExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_RowCompareExpr:
+		foreach (cell, ((RowCompareExpr *)expr)->largs)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		foreach (cell, ((RowCompareExpr *)expr)->rargs)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_CoalesceExpr:
+		foreach (cell, ((CoalesceExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_MinMaxExpr:
+		foreach (cell, ((MinMaxExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_XmlExpr:
+		foreach (cell, ((XmlExpr *)expr)->named_args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		foreach (cell, ((XmlExpr *)expr)->args)
+		{
+			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+		}
+		break;
+	case T_NullTest:
+		SetUsedColumns(((NullTest *)expr)->arg, state, foreignrelid);
+		break;
+	case T_BooleanTest:
+		SetUsedColumns(((BooleanTest *)expr)->arg, state, foreignrelid);
+		break;
+	case T_CoerceToDomain:
+		SetUsedColumns(((CoerceToDomain *)expr)->arg, state, foreignrelid);
+		break;
+	case T_PlaceHolderVar:
+		SetUsedColumns(((PlaceHolderVar *)expr)->phexpr, state, foreignrelid);
+		break;
+#if PG_VERSION_NUM >= 100000
+	case T_SQLValueFunction:
+		break; /* contains no column references */
+#endif		   /* PG_VERSION_NUM */
+	default:
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("unknown node type found: %d.", expr->type)));
+		break;
+	}
+
+	elog(DEBUG2, "%s exit", __func__);
+}
+
+/*
+ * CreateSPARQL
+ * ------------
+ * Creates the final SPARQL query sent to the server, which might includes the
+ * pushdown of SQL instructions. The query will be loaded into 'state->sparql'
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ * root : Planner info
+ */
+static void CreateSPARQL(RDFfdwState *state, PlannerInfo *root)
+{
+	StringInfoData where_graph;
+	StringInfoData sparql;
+	const char *modifier = DeparseSPARQLModifier(state);
+
+	initStringInfo(&sparql);
+	initStringInfo(&where_graph);
+
+	elog(DEBUG2, "%s called", __func__);
+
+	if (state->sparql_filter && strlen(state->sparql_filter) > 0)
+		appendStringInfo(&where_graph, "{%s\n ## rdf_fdw pushdown conditions ##\n%s}", pstrdup(state->sparql_where), pstrdup(state->sparql_filter));
+	else
+		appendStringInfo(&where_graph, "{%s}", pstrdup(state->sparql_where));
+	/*
+	 * if the raw SPARQL query contains a DISTINCT or REDUCED modifier, this must be
+	 * added into the new SELECT clause
+	 */
+	if (state->is_sparql_parsable == true && modifier != NULL)
+	{
+		elog(DEBUG2, "  %s: SPARQL is valid and contains a %s modifier > pushing down %s", __func__, modifier, modifier);
+		appendStringInfo(&sparql, "%s\nSELECT %s %s\n%s%s",
+						 state->sparql_prefixes,
+						 modifier,
+						 strlen(state->sparql_select) == 0 ? " * " : state->sparql_select,
+						 state->sparql_from,
+						 where_graph.data);
+	}
+	/*
+	 * if the raw SPARQL query does not contain a DISTINCT but the SQL query does,
+	 * this must be added into the new SELECT clause
+	 */
+	else if (state->is_sparql_parsable &&
+			 root &&								/* was the PlanerInfo provided? */
+			 root->parse->distinctClause != NULL && /* is there a DISTINCT clause in the PlanerInfo?*/
+			 !root->parse->hasDistinctOn)			/* does the DISTINCT clause have a DISTINCT ON?*/
+	{
+		appendStringInfo(&sparql, "%s\nSELECT DISTINCT %s\n%s%s",
+						 state->sparql_prefixes,
+						 strlen(state->sparql_select) == 0 ? " * " : state->sparql_select,
+						 state->sparql_from,
+						 where_graph.data);
+	}
+	else
+	{
+		appendStringInfo(&sparql, "%s\nSELECT %s\n%s%s",
+						 state->sparql_prefixes,
+						 strlen(state->sparql_select) == 0 ? " * " : state->sparql_select,
+						 state->sparql_from,
+						 where_graph.data);
+	}
+	/*
+	 * if the SQL query contains an ORDER BY, we try to push it down.
+	 */
+	if (state->is_sparql_parsable && state->sparql_orderby)
+	{
+		elog(DEBUG2, "  %s: pushing down ORDER BY clause > 'ORDER BY %s'", __func__, state->sparql_orderby);
+		appendStringInfo(&sparql, "\nORDER BY%s", pstrdup(state->sparql_orderby));
+	}
+
+	/*
+	 * Pushing down LIMIT (OFFSET) to the SPARQL query if the SQL query contains them.
+	 * If the SPARQL query set in the CREATE TABLE statement already contains a LIMIT,
+	 * this won't be pushed.
+	 */
+	if (state->sparql_limit)
+	{
+		elog(DEBUG2, "  %s: pushing down LIMIT clause > '%s'", __func__, state->sparql_limit);
+		appendStringInfo(&sparql, "\n%s", state->sparql_limit);
+	}
+
+	state->sparql = pstrdup(NameStr(sparql));
+
+	elog(DEBUG1, "%s exit", __func__);
+}
+
+/*
+ * EstimateRemoteRows
+ * ------------------
+ * Asks the SPARQL endpoint for the number of solutions of the foreign table's
+ * graph pattern, including the FILTER expressions of the WHERE conditions
+ * that were pushed down (use_remote_estimate). ORDER BY and LIMIT are left
+ * out, and DISTINCT solutions are counted in a subquery. The result is kept
+ * in a backend-local cache for 'remote_estimate_ttl' seconds, so that a query
+ * planned repeatedly does not pay a round trip to the endpoint every time.
+ * A failed request does not fail the query: a WARNING is raised instead,
+ * and the caller falls back to the default estimate.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info, loaded by InitSession()
+ * root : Planner info, or NULL if not called by the planner
+ *
+ * returns the number of solutions, or -1 if the endpoint returned no count
+ */
+static double EstimateRemoteRows(RDFfdwState *state, PlannerInfo *root)
+{
+	StringInfoData query;
+	RDFfdwEstimateCacheKey key;
+	RDFfdwEstimateCacheEntry *entry = NULL;
+	RDFfdwState *count_state;
+	MemoryContext oldcxt = CurrentMemoryContext;
+	const char *modifier;
+	volatile double rows = -1;
+	bool distinct;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	modifier = DeparseSPARQLModifier(state);
+	distinct = (modifier != NULL && strcmp(modifier, "DISTINCT") == 0) ||
+			   (root != NULL && root->parse->distinctClause != NULL && !root->parse->hasDistinctOn);
+
+	initStringInfo(&query);
+
+	if (distinct)
+		appendStringInfo(&query, "%s\nSELECT (COUNT(*) AS ?rdf_fdw_count)\n%s{SELECT DISTINCT %s WHERE {%s\n%s}}",
+						 state->sparql_prefixes,
+						 state->sparql_from,
+						 strlen(state->sparql_select) == 0 ? "*" : state->sparql_select,
+						 state->sparql_where,
+						 state->sparql_filter);
+	else
+		appendStringInfo(&query, "%s\nSELECT (COUNT(*) AS ?rdf_fdw_count)\n%s{%s\n%s}",
+						 state->sparql_prefixes,
+						 state->sparql_from,
+						 state->sparql_where,
+						 state->sparql_filter);
+
+	if (state->remote_estimate_ttl > 0)
+	{
+		bool found;
+
+		if (EstimateCache == NULL)
+		{
+			HASHCTL ctl;
+
+			MemSet(&ctl, 0, sizeof(ctl));
+			ctl.keysize = sizeof(RDFfdwEstimateCacheKey);
+			ctl.entrysize = sizeof(RDFfdwEstimateCacheEntry);
+			EstimateCache = hash_create("rdf_fdw remote estimates", 32, &ctl, HASH_ELEM | HASH_BLOBS);
+		}
+
+		MemSet(&key, 0, sizeof(key));
+		key.foreigntableid = state->foreigntableid;
+		key.queryhash = DatumGetUInt32(hash_any((unsigned char *)query.data, query.len));
+
+		if (hash_get_num_entries(EstimateCache) >= RDF_ESTIMATE_CACHE_SIZE)
+			PruneEstimateCache();
+
+		entry = (RDFfdwEstimateCacheEntry *)hash_search(EstimateCache, &key, HASH_ENTER, &found);
+
+		if (!found)
+			entry->query = NULL;
+		else if (entry->query != NULL && strcmp(entry->query, query.data) == 0 &&
+				 !TimestampDifferenceExceeds(entry->fetched, GetCurrentTimestamp(),
+											 (int)Min(state->remote_estimate_ttl, INT_MAX / 1000) * 1000))
+		{
+			elog(DEBUG1, "%s exit: returning cached estimate %.0f", __func__, entry->rows);
+			return entry->rows;
+		}
+	}
+
+	/*
+	 * The request is sent with a copy of the state, so that the result set
+	 * and the libcurl handle of the scan are not touched.
+	 */
+	count_state = (RDFfdwState *)palloc(sizeof(RDFfdwState));
+	memcpy(count_state, state, sizeof(RDFfdwState));
+	count_state->sparql = query.data;
+	count_state->sparql_resultset = NULL;
+	count_state->sparql_query_type = SPARQL_SELECT;
+
+	PG_TRY();
+	{
+		if (ExecuteSPARQL(count_state) == REQUEST_SUCCESS)
+			rows = ReadRemoteCount(count_state, "?rdf_fdw_count");
+	}
+	PG_CATCH();
+	{
+		ErrorData *edata;
+
+		MemoryContextSwitchTo(oldcxt);
+		edata = CopyErrorData();
+
+		/* a query cancel or a shutdown request must not be swallowed */
+		if (edata->sqlerrcode == ERRCODE_QUERY_CANCELED ||
+			edata->sqlerrcode == ERRCODE_ADMIN_SHUTDOWN)
+			PG_RE_THROW();
+
+		FlushErrorState();
+
+		ereport(WARNING,
+				(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+				 errmsg("could not retrieve the remote row estimate of FOREIGN TABLE \"%s\"",
+						get_rel_name(state->foreigntableid)),
+				 errdetail("%s", edata->message)));
+
+		FreeErrorData(edata);
+	}
+	PG_END_TRY();
+
+	if (rows < 0)
+	{
+		elog(DEBUG1, "%s exit: the endpoint returned no count", __func__);
+		return -1;
+	}
+
+	if (entry != NULL)
+	{
+		if (entry->query != NULL)
+			pfree(entry->query);
+
+		entry->query = MemoryContextStrdup(TopMemoryContext, query.data);
+		entry->rows = rows;
+		entry->fetched = GetCurrentTimestamp();
+		entry->expires = TimestampTzPlusMilliseconds(entry->fetched,
+													 (int64)Min(state->remote_estimate_ttl, INT_MAX / 1000) * 1000);
+	}
+
+	elog(DEBUG1, "%s exit: returning %.0f", __func__, rows);
+	return rows;
+}
+
+/*
+ * PruneEstimateCache
+ * ------------------
+ * Removes the expired entries of the remote estimate cache, and the oldest
+ * one if it is still full, so that it does not grow with every new query
+ * planned in the session.
+ */
+static void PruneEstimateCache(void)
+{
+	HASH_SEQ_STATUS status;
+	RDFfdwEstimateCacheEntry *entry;
+	RDFfdwEstimateCacheEntry *oldest = NULL;
+	TimestampTz now = GetCurrentTimestamp();
+
+	hash_seq_init(&status, EstimateCache);
+
+	while ((entry = (RDFfdwEstimateCacheEntry *)hash_seq_search(&status)) != NULL)
+	{
+		if (entry->query != NULL && entry->expires > now)
+			continue;
+
+		if (entry->query != NULL)
+			pfree(entry->query);
+
+		hash_search(EstimateCache, &entry->key, HASH_REMOVE, NULL);
+	}
+
+	if (hash_get_num_entries(EstimateCache) < RDF_ESTIMATE_CACHE_SIZE)
+		return;
+
+	hash_seq_init(&status, EstimateCache);
+
+	while ((entry = (RDFfdwEstimateCacheEntry *)hash_seq_search(&status)) != NULL)
+	{
+		if (oldest == NULL || entry->fetched < oldest->fetched)
+			oldest = entry;
+	}
+
+	elog(DEBUG2, "%s: cache is full, removing its oldest entry", __func__);
+
+	pfree(oldest->query);
+	hash_search(EstimateCache, &oldest->key, HASH_REMOVE, NULL);
+}
+
+/*
+ * ReadRemoteCount
+ * ---------------
+ * Reads the value of 'variable' in the first record of the result set in
+ * 'state->sparql_resultset', which is expected to be a single row with the
+ * result of a COUNT aggregate, in any of the supported result formats. The
+ * result set is freed.
+ *
+ * state   : SPARQL, SERVER and FOREIGN TABLE info
+ * variable: SPARQL variable holding the count, e.g. "?c"
+ *
+ * returns the count, or -1 if the result set contains no valid count
+ */
+static double ReadRemoteCount(RDFfdwState *state, const char *variable)
+{
+	char *value = NULL;
+	char *endptr;
+	double count;
+
+	if (IsSPARQLTsvFormat(state->format))
+	{
+		char *tsv_error = NULL;
+		SPARQLTsvParser *tsv = SPARQLTsvReadMemory(state->sparql_resultset,
+												   strlen(state->sparql_resultset),
+												   &tsv_error);
+		state->sparql_resultset = NULL;
+
+		if (tsv == NULL)
+		{
+			elog(DEBUG1, "%s: failed to parse SPARQL TSV result: %s", __func__, tsv_error);
+			return -1;
+		}
+		else
+		{
+			int field = SPARQLTsvGetVariableIndex(tsv, variable);
+			char **row = SPARQLTsvNextRow(tsv);
+
+			if (field >= 0 && row != NULL && row[field] != NULL)
+			{
+				SPARQLTsvTerm term;
+
+				SPARQLTsvDecodeTerm(row[field], &term);
+
+				if (term.type == SPARQL_TSV_LITERAL && term.value != NULL)
+					value = pstrdup(term.value);
+			}
+
+			SPARQLTsvFreeParser(tsv);
+		}
+	}
+	else if (IsSPARQLJsonFormat(state->format))
+	{
+		SPARQLJsonParser *json = SPARQLJsonCreateParser(false);
+		int field = SPARQLJsonAddVariable(json, variable);
+		bool parsed = SPARQLJsonParseChunk(json, state->sparql_resultset, strlen(state->sparql_resultset), true);
+
+		pfree(state->sparql_resultset);
+		state->sparql_resultset = NULL;
+
+		if (!parsed)
+		{
+			elog(DEBUG1, "%s: failed to parse SPARQL JSON result: %s", __func__, SPARQLJsonGetError(json));
+			SPARQLJsonFreeParser(json);
+			return -1;
+		}
+		else
+		{
+			SPARQLJsonTerm *row = SPARQLJsonNextRow(json);
+
+			if (field >= 0 && row != NULL && row[field].type == SPARQL_JSON_LITERAL)
+				value = pstrdup(row[field].value);
+
+			SPARQLJsonFreeParser(json);
+		}
+	}
+	else
+	{
+		xmlDocPtr doc = xmlReadMemory(state->sparql_resultset,
+									  strlen(state->sparql_resultset),
+									  NULL, NULL,
+									  XML_PARSE_NOBLANKS | XML_PARSE_NONET);
+		xmlNodePtr root;
+
+		pfree(state->sparql_resultset);
+		state->sparql_resultset = NULL;
+
+		if (doc == NULL)
+		{
+			elog(DEBUG1, "%s: failed to parse SPARQL XML result", __func__);
+			return -1;
+		}
+
+		root = xmlDocGetRootElement(doc);
+
+		for (xmlNodePtr results = root ? root->children : NULL; results != NULL && value == NULL; results = results->next)
+		{
+			if (xmlStrcmp(results->name, (xmlChar *)"results") != 0)
+				continue;
+
+			for (xmlNodePtr record = results->children; record != NULL && value == NULL; record = record->next)
+			{
+				if (xmlStrcmp(record->name, (xmlChar *)"result") != 0)
+					continue;
+
+				for (xmlNodePtr binding = record->children; binding != NULL && value == NULL; binding = binding->next)
+				{
+					xmlChar *name;
+
+					if (binding->type != XML_ELEMENT_NODE)
+						continue;
+
+					name = xmlGetProp(binding, (xmlChar *)RDF_XML_NAME_TAG);
+
+					if (name != NULL && xmlStrcmp(name, (xmlChar *)(variable + 1)) == 0)
+					{
+						xmlChar *content = xmlNodeGetContent(binding);
+
+						value = pstrdup((char *)content);
+						xmlFree(content);
+					}
+
+					if (name != NULL)
+						xmlFree(name);
+				}
+
+				/* only the first record holds the count */
+				break;
+			}
+		}
+
+		xmlFreeDoc(doc);
+	}
+
+	if (value == NULL)
+	{
+		elog(DEBUG1, "%s: no value found for '%s' in the result set", __func__, variable);
+		return -1;
+	}
+
+	errno = 0;
+	count = strtod(value, &endptr);
+
+	if (errno != 0 || endptr == value || *endptr != '\0' || count < 0 || isinf(count) || isnan(count))
+	{
+		elog(DEBUG1, "%s: invalid count '%s'", __func__, value);
+		return -1;
+	}
+
+	return count;
+}
+
+#if PG_VERSION_NUM >= 120000
+/*
+ * GetRDFColumnByAttnum
+ * --------------------
+ * Returns the column of a FOREIGN TABLE with the attribute number 'attnum'.
+ *
+ * state : SPARQL, SERVER and FOREIGN TABLE info
+ * attnum: attribute number of the column
+ *
+ * returns the RDFfdwColumn of the attribute or NULL if it does not exist
+ */
+static struct RDFfdwColumn *GetRDFColumnByAttnum(struct RDFfdwState *state, AttrNumber attnum)
+{
+	for (int i = 0; i < state->numcols; i++)
+	{
+		if (state->rdfTable->cols[i]->pgattnum == attnum)
+			return state->rdfTable->cols[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * IsRelationPushable
+ * ------------------
+ * Checks if the scan of a FOREIGN TABLE can take part in a join or an
+ * aggregation that is pushed down to the endpoint: its graph pattern must be
+ * parsable, all its conditions must have been pushed down, and its SPARQL
+ * query may not contain solution modifiers that apply to the table alone.
+ *
+ * rel: base relation of the FOREIGN TABLE
+ *
+ * returns 'true' if the scan can be part of a remote join or aggregation
+ */
+static bool IsRelationPushable(RelOptInfo *rel)
+{
+	RDFfdwState *state = (RDFfdwState *)rel->fdw_private;
+	ListCell *cell;
+
+	if (rel->reloptkind != RELOPT_BASEREL || state == NULL)
+		return false;
+
+	if (!state->enable_pushdown || !state->is_sparql_parsable || state->has_unparsable_conds)
+		return false;
+
+	/*
+	 * A DISTINCT or REDUCED modifier applies to the whole query. Modifiers
+	 * of a query used as a sub-select, e.g. with an OFFSET, only apply to
+	 * the sub-select.
+	 */
+	if (DeparseSPARQLModifier(state) != NULL)
+		return false;
+
+	foreach (cell, rel->baserestrictinfo)
+	{
+		if (!list_member_ptr(state->remote_conds, lfirst(cell)))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * AppendJoinPattern
+ * -----------------
+ * Appends the graph pattern and pushed down FILTER expressions of one side
+ * of a join as a group, with its variables renamed by RenameSPARQLVariables.
+ *
+ * buf    : buffer the group is appended to
+ * state  : SPARQL, SERVER and FOREIGN TABLE info of the join side
+ * prefix : prefix of the renamed variables
+ * names  : variables shared with the other side (see RenameSPARQLVariables)
+ * targets: variables replacing the ones in 'names'
+ */
+static void AppendJoinPattern(StringInfo buf, RDFfdwState *state, const char *prefix, List *names, List *targets)
+{
+	char *where = RenameSPARQLVariables(state->sparql_where, prefix, names, targets);
+
+	if (state->sparql_filter && strlen(state->sparql_filter) > 0)
+		appendStringInfo(buf, "{%s\n%s}", where, RenameSPARQLVariables(state->sparql_filter, prefix, names, targets));
+	else
+		appendStringInfo(buf, "{%s}", where);
+}
+
+/*
+ * CreateJoinState
+ * ---------------
+ * Creates the state of a join between two FOREIGN TABLEs of the same SERVER,
+ * so that it can be executed by the endpoint as a single SPARQL query. The
+ * variables and blank nodes of both graph patterns are renamed apart (with
+ * the prefixes 'r1_' and 'r2_'), and each join clause becomes a FILTER of the
+ * combined pattern. Columns with nodetype 'iri' joined by an INNER JOIN share
+ * a single variable instead, so that the endpoint evaluates them as an
+ * ordinary join of both patterns. The inner pattern of a LEFT JOIN is placed
+ * in an OPTIONAL group, together with the FILTER of the join clauses.
+ *
+ * The columns of the new state follow the join relation's target list, which
+ * is the scan tuple of the ForeignScan (see rdfGetForeignPlan).
+ *
+ * root        : Planner info
+ * joinrel     : join relation
+ * outerrel    : outer relation of the join
+ * innerrel    : inner relation of the join
+ * jointype    : JOIN_INNER or JOIN_LEFT
+ * restrictlist: clauses of the join
+ *
+ * returns the state of the join, or NULL if it cannot be pushed down
+ */
+static RDFfdwState *CreateJoinState(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel, RelOptInfo *innerrel, JoinType jointype, List *restrictlist)
+{
+	RDFfdwState *outer = (RDFfdwState *)outerrel->fdw_private;
+	RDFfdwState *inner = (RDFfdwState *)innerrel->fdw_private;
+	RDFfdwState *jstate;
+	List *outer_cols = NIL;
+	List *inner_cols = NIL;
+	List *shared_names = NIL;
+	List *shared_targets = NIL;
+	List *prefixes;
+	List *selected = NIL;
+	ListCell *cell;
+	ListCell *ocell;
+	ListCell *icell;
+	StringInfoData filter;
+	StringInfoData select;
+	StringInfoData where;
+	StringInfoData sparql_prefixes;
+	StringInfoData sparql;
+	int i = 0;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	if (!IsRelationPushable(outerrel) || !IsRelationPushable(innerrel))
+	{
+		elog(DEBUG2, "%s: at least one of the tables cannot be part of a remote join", __func__);
+		return NULL;
+	}
+
+	if (outer->server->serverid != inner->server->serverid ||
+		strcmp(outer->sparql_from ? outer->sparql_from : "", inner->sparql_from ? inner->sparql_from : "") != 0)
+	{
+		elog(DEBUG2, "%s: tables query different servers or datasets", __func__);
+		return NULL;
+	}
+
+	/*
+	 * Both queries share a single prologue, so a prefix may only be declared
+	 * by both tables if it stands for the same IRI.
+	 */
+	prefixes = list_copy(outer->prefixes);
+
+	foreach (icell, inner->prefixes)
+	{
+		RDFPrefix *prefix = (RDFPrefix *)lfirst(icell);
+		bool found = false;
+
+		foreach (ocell, prefixes)
+		{
+			RDFPrefix *existing = (RDFPrefix *)lfirst(ocell);
+
+			if (strcmp(existing->prefix, prefix->prefix) != 0)
+				continue;
+
+			if (strcmp(existing->url, prefix->url) != 0)
+			{
+				elog(DEBUG2, "%s: prefix '%s' has different IRIs in the joined tables", __func__, prefix->prefix);
+				return NULL;
+			}
+
+			found = true;
+			break;
+		}
+
+		if (!found)
+			prefixes = lappend(prefixes, prefix);
+	}
+
+	/*
+	 * Only equality conditions between columns of both tables are pushed
+	 * down. If a single clause cannot be translated, the join is left to
+	 * PostgreSQL.
+	 */
+	foreach (cell, restrictlist)
+	{
+		RestrictInfo *ri = lfirst_node(RestrictInfo, cell);
+		OpExpr *op;
+		Var *left;
+		Var *right;
+		char *opname;
+		RDFfdwColumn *ocol;
+		RDFfdwColumn *icol;
+
+		/* conditions applied after an outer join are not part of OPTIONAL */
+		if (jointype == JOIN_LEFT && RINFO_IS_PUSHED_DOWN(ri, joinrel->relids))
+			return NULL;
+
+		if (!IsA(ri->clause, OpExpr))
+			return NULL;
+
+		op = (OpExpr *)ri->clause;
+
+		if (list_length(op->args) != 2 ||
+			!IsA(linitial(op->args), Var) || !IsA(lsecond(op->args), Var))
+			return NULL;
+
+		opname = get_opname(op->opno);
+
+		if (!opname || strcmp(opname, "=") != 0)
+			return NULL;
+
+		left = (Var *)linitial(op->args);
+		right = (Var *)lsecond(op->args);
+
+		if (bms_is_member(left->varno, innerrel->relids))
+		{
+			Var *tmp = left;
+
+			left = right;
+			right = tmp;
+		}
+
+		if (!bms_is_member(left->varno, outerrel->relids) || !bms_is_member(right->varno, innerrel->relids))
+			return NULL;
+
+		ocol = GetRDFColumnByAttnum(outer, left->varattno);
+		icol = GetRDFColumnByAttnum(inner, right->varattno);
+
+		if (!ocol || !icol || !ocol->sparqlvar || !icol->sparqlvar ||
+			!ocol->pushable || !icol->pushable ||
+			ocol->expression || icol->expression ||
+			ocol->pgtype != icol->pgtype)
+		{
+			elog(DEBUG2, "%s: join clause cannot be pushed down", __func__);
+			return NULL;
+		}
+
+		if (IsStringDataType(ocol->pgtype) &&
+			((ocol->literal_fomat && strcmp(ocol->literal_fomat, RDF_COLUMN_OPTION_VALUE_LITERAL_RAW) == 0) ||
+			 (icol->literal_fomat && strcmp(icol->literal_fomat, RDF_COLUMN_OPTION_VALUE_LITERAL_RAW) == 0)))
+			return NULL;
+
+		if (ocol->pgtype != RDFNODEOID && !IsStringDataType(ocol->pgtype) &&
+			strcmp(ocol->literaltype ? ocol->literaltype : "", icol->literaltype ? icol->literaltype : "") != 0)
+			return NULL;
+
+		outer_cols = lappend(outer_cols, ocol);
+		inner_cols = lappend(inner_cols, icol);
+
+		if (jointype == JOIN_INNER &&
+			ocol->nodetype && strcmp(ocol->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0 &&
+			icol->nodetype && strcmp(icol->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0)
+		{
+			char *name = icol->sparqlvar + 1;
+			bool shared = false;
+
+			foreach (icell, shared_names)
+			{
+				if (strcmp((char *)lfirst(icell), name) == 0)
+					shared = true;
+			}
+
+			if (!shared)
+			{
+				shared_names = lappend(shared_names, name);
+				shared_targets = lappend(shared_targets, RenameSPARQLVariables(ocol->sparqlvar, "r1_", NIL, NIL));
+			}
+		}
+	}
+
+	initStringInfo(&filter);
+
+	forboth(ocell, outer_cols, icell, inner_cols)
+	{
+		RDFfdwColumn *ocol = (RDFfdwColumn *)lfirst(ocell);
+		RDFfdwColumn *icol = (RDFfdwColumn *)lfirst(icell);
+		char *ovar = RenameSPARQLVariables(ocol->sparqlvar, "r1_", NIL, NIL);
+		char *ivar = RenameSPARQLVariables(icol->sparqlvar, "r2_", shared_names, shared_targets);
+
+		/* already joined by a shared variable */
+		if (strcmp(ovar, ivar) == 0)
+			continue;
+
+		if (IsStringDataType(ocol->pgtype))
+			appendStringInfo(&filter, " FILTER(STR(%s) = STR(%s))\n", ovar, ivar);
+		else
+			appendStringInfo(&filter, " FILTER(%s = %s)\n", ovar, ivar);
+	}
+
+	/*
+	 * The join state is based on the outer table, as both share the server,
+	 * its options and the user mapping.
+	 */
+	jstate = (RDFfdwState *)palloc0(sizeof(RDFfdwState));
+	memcpy(jstate, outer, sizeof(RDFfdwState));
+
+	jstate->numcols = list_length(joinrel->reltarget->exprs);
+
+	if (jstate->numcols == 0)
+		return NULL;
+
+	jstate->rdfTable = (RDFfdwTable *)palloc0(sizeof(RDFfdwTable));
+	jstate->rdfTable->name = psprintf("%s, %s", outer->rdfTable->name, inner->rdfTable->name);
+	jstate->rdfTable->cols = (RDFfdwColumn **)palloc0(sizeof(RDFfdwColumn *) * jstate->numcols);
+
+	initStringInfo(&select);
+
+	foreach (cell, joinrel->reltarget->exprs)
+	{
+		Var *var = (Var *)lfirst(cell);
+		bool is_outer;
+		RDFfdwColumn *col;
+		RDFfdwColumn *jcol;
+		bool found = false;
+
+		if (!IsA(var, Var) || var->varattno <= 0 || var->varlevelsup != 0)
+			return NULL;
+
+		is_outer = bms_is_member(var->varno, outerrel->relids);
+		col = GetRDFColumnByAttnum(is_outer ? outer : inner, var->varattno);
+
+		if (!col || !col->sparqlvar)
+			return NULL;
+
+		jcol = (RDFfdwColumn *)palloc(sizeof(RDFfdwColumn));
+		memcpy(jcol, col, sizeof(RDFfdwColumn));
+
+		jcol->sparqlvar = RenameSPARQLVariables(col->sparqlvar, is_outer ? "r1_" : "r2_",
+												is_outer ? NIL : shared_names, is_outer ? NIL : shared_targets);
+		jcol->expression = RenameSPARQLVariables(col->expression, is_outer ? "r1_" : "r2_",
+												 is_outer ? NIL : shared_names, is_outer ? NIL : shared_targets);
+		jcol->used = true;
+		jstate->rdfTable->cols[i++] = jcol;
+
+		/* variables bound to more than one column are projected only once */
+		foreach (ocell, selected)
+		{
+			if (strcmp((char *)lfirst(ocell), jcol->sparqlvar) == 0)
+				found = true;
+		}
+
+		if (found)
+			continue;
+
+		selected = lappend(selected, jcol->sparqlvar);
+
+		if (jcol->expression)
+			appendStringInfo(&select, "(%s AS %s) ", jcol->expression, jcol->sparqlvar);
+		else
+			appendStringInfo(&select, "%s ", jcol->sparqlvar);
+	}
+
+	initStringInfo(&where);
+	AppendJoinPattern(&where, outer, "r1_", NIL, NIL);
+	appendStringInfoChar(&where, '\n');
+
+	if (jointype == JOIN_INNER)
+	{
+		AppendJoinPattern(&where, inner, "r2_", shared_names, shared_targets);
+		appendStringInfo(&where, "\n%s", filter.data);
+	}
+	else
+	{
+		appendStringInfoString(&where, "OPTIONAL {");
+		AppendJoinPattern(&where, inner, "r2_", NIL, NIL);
+		appendStringInfo(&where, "\n%s}\n", filter.data);
+	}
+
+	initStringInfo(&sparql_prefixes);
+
+	foreach (cell, prefixes)
+	{
+		RDFPrefix *p = (RDFPrefix *)lfirst(cell);
+		appendStringInfo(&sparql_prefixes, "PREFIX %s: <%s>\n", p->prefix, p->url);
+	}
+
+	initStringInfo(&sparql);
+	appendStringInfo(&sparql, "%s\nSELECT %s\n%s{%s}",
+					 sparql_prefixes.data,
+					 select.data,
+					 outer->sparql_from ? outer->sparql_from : "",
+					 where.data);
+
+	jstate->is_join = true;
+	jstate->scan_tlist = joinrel->reltarget->exprs;
+	jstate->prefixes = prefixes;
+	jstate->sparql_prefixes = sparql_prefixes.data;
+	jstate->sparql_select = select.data;
+	jstate->sparql_where = where.data;
+	jstate->sparql_filter = NULL;
+	jstate->sparql_filter_expr = NULL;
+	jstate->sparql_orderby = NULL;
+	jstate->sparql_limit = NULL;
+	jstate->sparql = sparql.data;
+	jstate->remote_conds = NIL;
+	jstate->log_sparql = outer->log_sparql || inner->log_sparql;
+
+	elog(DEBUG2, "%s: remote join query\n\n%s", __func__, jstate->sparql);
+
+	return jstate;
+}
+
+/*
+ * DeparseAggref
+ * -------------
+ * Deparses an aggregate call into a SPARQL 1.1 aggregate. COUNT, SUM, AVG,
+ * MIN and MAX of pg_catalog are pushed down for columns whose values are
+ * compared and added up the same way in SPARQL (numbers, dates and times),
+ * and the rdfnode aggregates of the sparql schema for rdfnode columns. SUM,
+ * AVG and GROUP_CONCAT are only pushed down with a GROUP BY clause, as over
+ * an empty set they return 0 or "" in SPARQL, but NULL in PostgreSQL.
+ *
+ * state : SPARQL, SERVER and FOREIGN TABLE info, including the GROUP BY clause
+ * aggref: aggregate call
+ *
+ * returns a string containing a SPARQL aggregate or NULL if not pushable
+ */
+static char *DeparseAggref(struct RDFfdwState *state, Aggref *aggref)
+{
+	bool grouped = state->sparql_groupby && strlen(state->sparql_groupby) > 0;
+	bool is_sparql;
+	char *aggname;
+	char *nspname;
+	char *function = NULL;
+	char *arg;
+	TargetEntry *te;
+	Var *var;
+	RDFfdwColumn *col;
+
+	elog(DEBUG2, "%s called", __func__);
+
+	/* FILTER, ORDER BY, ordered-set and partial aggregation have no SPARQL equivalent */
+	if (aggref->aggfilter || aggref->aggorder != NIL || aggref->aggvariadic ||
+		aggref->aggkind != AGGKIND_NORMAL || aggref->aggsplit != AGGSPLIT_SIMPLE)
+		return NULL;
+
+	aggname = get_func_name(aggref->aggfnoid);
+	nspname = get_namespace_name(get_func_namespace(aggref->aggfnoid));
+
+	if (!aggname || !nspname)
+		return NULL;
+
+	is_sparql = strcmp(nspname, "sparql") == 0;
+
+	if (!is_sparql && strcmp(nspname, "pg_catalog") != 0)
+		return NULL;
+
+	if (aggref->aggstar)
+		return !is_sparql && strcmp(aggname, "count") == 0 ? psprintf("%s(*)", RDF_SPARQL_AGGREGATE_FUNCTION_COUNT) : NULL;
+
+	if (aggref->args == NIL)
+		return NULL;
+
+	te = linitial_node(TargetEntry, aggref->args);
+	var = (Var *)te->expr;
+
+	if (!IsA(var, Var) || var->varlevelsup != 0 || var->varattno <= 0)
+		return NULL;
+
+	col = GetRDFColumnByAttnum(state, var->varattno);
+
+	if (!col || !col->pushable || !col->sparqlvar)
+		return NULL;
+
+	/* distinct RDF terms may be the same value in PostgreSQL, e.g. "a"@en and "a"@de */
+	if (aggref->aggdistinct != NIL && col->pgtype != RDFNODEOID)
+		return NULL;
+
+	arg = psprintf("%s%s", aggref->aggdistinct != NIL ? "DISTINCT " : "",
+				   col->expression ? col->expression : col->sparqlvar);
+
+	if (is_sparql)
+	{
+		/* the rdfnode aggregates of the sparql schema */
+		if (col->pgtype != RDFNODEOID)
+			return NULL;
+
+		if (strcmp(aggname, "group_concat") == 0 && list_length(aggref->args) == 2 && grouped)
+		{
+			Const *separator = (Const *)lsecond_node(TargetEntry, aggref->args)->expr;
+
+			if (!IsA(separator, Const) || separator->constisnull || separator->consttype != TEXTOID)
+				return NULL;
+
+			return psprintf("%s(%s; SEPARATOR=%s)", RDF_SPARQL_AGGREGATE_FUNCTION_GROUPCONCAT, arg,
+							cstring_to_rdfliteral(TextDatumGetCString(separator->constvalue)));
+		}
+
+		if (strcmp(aggname, "sample") == 0)
+			function = RDF_SPARQL_AGGREGATE_FUNCTION_SAMPLE;
+	}
+	else
+	{
+		bool numeric = col->pgtype == INT2OID || col->pgtype == INT4OID || col->pgtype == INT8OID ||
+					   col->pgtype == FLOAT4OID || col->pgtype == FLOAT8OID || col->pgtype == NUMERICOID;
+		bool temporal = col->pgtype == DATEOID || col->pgtype == TIMESTAMPOID || col->pgtype == TIMESTAMPTZOID;
+
+		/* PostgreSQL compares and adds up values, SPARQL RDF terms */
+		if (strcmp(aggname, "count") == 0)
+			function = RDF_SPARQL_AGGREGATE_FUNCTION_COUNT;
+		else if (!numeric && !(temporal && (strcmp(aggname, "min") == 0 || strcmp(aggname, "max") == 0)))
+			return NULL;
+	}
+
+	if (list_length(aggref->args) != 1)
+		return NULL;
+
+	if (strcmp(aggname, "min") == 0)
+		function = RDF_SPARQL_AGGREGATE_FUNCTION_MIN;
+	else if (strcmp(aggname, "max") == 0)
+		function = RDF_SPARQL_AGGREGATE_FUNCTION_MAX;
+	else if (strcmp(aggname, "sum") == 0 && grouped)
+		function = RDF_SPARQL_AGGREGATE_FUNCTION_SUM;
+	else if (strcmp(aggname, "avg") == 0 && grouped)
+		function = RDF_SPARQL_AGGREGATE_FUNCTION_AVG;
+
+	if (function == NULL)
+		return NULL;
+
+	return psprintf("%s(%s)", function, arg);
+}
+
+/*
+ * CreateGroupingState
+ * -------------------
+ * Creates the state of an aggregation over a FOREIGN TABLE, so that the
+ * endpoint computes the groups and aggregates with a SPARQL 1.1 aggregate
+ * query (GROUP BY and HAVING). The grouping columns must be plain columns,
+ * and the aggregates of the target list and the HAVING clause must all be
+ * translatable (see DeparseAggref). Expressions on top of aggregates, e.g.
+ * count(*) + 1, are computed locally from the scan tuple.
+ *
+ * The columns of the new state are the grouping columns followed by the
+ * aggregates, in the order of 'scan_tlist', which becomes the scan tuple of
+ * the ForeignScan (see rdfGetForeignPlan).
+ *
+ * root     : Planner info
+ * input_rel: base relation of the FOREIGN TABLE
+ * target   : target list of the aggregation
+ * having   : conditions of the HAVING clause (implicitly ANDed)
+ *
+ * returns the state of the aggregation, or NULL if it cannot be pushed down
+ */
+static RDFfdwState *CreateGroupingState(PlannerInfo *root, RelOptInfo *input_rel, PathTarget *target, List *having)
+{
+	RDFfdwState *state = (RDFfdwState *)input_rel->fdw_private;
+	RDFfdwState *gstate;
+	Query *parse = root->parse;
+	List *tlist = NIL;
+	List *cols = NIL;
+	ListCell *cell;
+	StringInfoData select;
+	StringInfoData groupby;
+	StringInfoData having_clause;
+	StringInfoData sparql;
+	int naggs = 0;
+	int i = 0;
+
+	elog(DEBUG1, "%s called", __func__);
+
+	if (!IsRelationPushable(input_rel))
+	{
+		elog(DEBUG2, "%s: the table cannot be part of a remote aggregation", __func__);
+		return NULL;
+	}
+
+	gstate = (RDFfdwState *)palloc0(sizeof(RDFfdwState));
+	memcpy(gstate, state, sizeof(RDFfdwState));
+
+	initStringInfo(&select);
+	initStringInfo(&groupby);
+	initStringInfo(&having_clause);
+
+	/* grouping columns */
+	foreach (cell, target->exprs)
+	{
+		Expr *expr = (Expr *)lfirst(cell);
+		Index sgref = get_pathtarget_sortgroupref(target, i++);
+		Var *var = (Var *)expr;
+		RDFfdwColumn *col;
+
+		if (!sgref || !get_sortgroupref_clause_noerr(sgref, parse->groupClause))
+			continue;
+
+		if (!IsA(expr, Var) || var->varno != input_rel->relid || var->varattno <= 0)
+			return NULL;
+
+		col = GetRDFColumnByAttnum(state, var->varattno);
+
+		if (!col || !col->pushable || col->expression || !col->sparqlvar)
+			return NULL;
+
+		/*
+		 * SPARQL groups RDF terms and PostgreSQL their values, so strings that
+		 * only differ in their language tag or datatype would end up in
+		 * different groups.
+		 */
+		if (IsStringDataType(col->pgtype) &&
+			!(col->nodetype && strcmp(col->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0) &&
+			!(col->language && strcmp(col->language, "*") != 0) &&
+			!(col->literal_fomat && strcmp(col->literal_fomat, RDF_COLUMN_OPTION_VALUE_LITERAL_RAW) == 0) &&
+			!col->literaltype)
+		{
+			elog(DEBUG2, "%s: column '%s' cannot be grouped remotely", __func__, col->name);
+			return NULL;
+		}
+
+		tlist = lappend(tlist, expr);
+		cols = lappend(cols, col);
+		appendStringInfo(&select, "%s ", col->sparqlvar);
+		appendStringInfo(&groupby, "%s ", col->sparqlvar);
+	}
+
+	gstate->sparql_groupby = groupby.data;
+
+	/* aggregates, which may be part of expressions that are computed locally */
+	i = 0;
+	foreach (cell, target->exprs)
+	{
+		Expr *expr = (Expr *)lfirst(cell);
+		Index sgref = get_pathtarget_sortgroupref(target, i++);
+		List *nodes;
+		ListCell *ncell;
+
+		if (sgref && get_sortgroupref_clause_noerr(sgref, parse->groupClause))
+			continue;
+
+		nodes = pull_var_clause((Node *)expr, PVC_INCLUDE_AGGREGATES | PVC_INCLUDE_PLACEHOLDERS);
+
+		foreach (ncell, nodes)
+		{
+			Node *node = (Node *)lfirst(ncell);
+			RDFfdwColumn *col;
+			char *aggregate;
+
+			if (list_member(tlist, node))
+				continue;
+
+			/* columns outside of aggregates must be grouping columns */
+			if (!IsA(node, Aggref))
+				return NULL;
+
+			aggregate = DeparseAggref(gstate, (Aggref *)node);
+
+			if (aggregate == NULL)
+			{
+				elog(DEBUG2, "%s: aggregate cannot be pushed down", __func__);
+				return NULL;
+			}
+
+			col = (RDFfdwColumn *)palloc0(sizeof(RDFfdwColumn));
+			col->name = psprintf("rdf_fdw_agg%d", ++naggs);
+			col->sparqlvar = psprintf("?rdf_fdw_agg%d", naggs);
+			col->pgtype = exprType(node);
+			col->pgtypmod = -1;
+			col->pgattnum = list_length(tlist) + 1;
+			col->used = true;
+
+			tlist = lappend(tlist, node);
+			cols = lappend(cols, col);
+			appendStringInfo(&select, "(%s AS %s) ", aggregate, col->sparqlvar);
+		}
+	}
+
+	if (cols == NIL)
+		return NULL;
+
+	foreach (cell, having)
+	{
+		char *condition = DeparseExpr(gstate, input_rel, (Expr *)lfirst(cell));
+
+		if (condition == NULL)
+		{
+			elog(DEBUG2, "%s: HAVING condition cannot be pushed down", __func__);
+			return NULL;
+		}
+
+		appendStringInfo(&having_clause, "(%s) ", condition);
+	}
+
+	initStringInfo(&sparql);
+
+	if (state->sparql_filter && strlen(state->sparql_filter) > 0)
+		appendStringInfo(&sparql, "%s\nSELECT %s\n%s{%s\n ## rdf_fdw pushdown conditions ##\n%s}",
+						 state->sparql_prefixes, select.data, state->sparql_from,
+						 state->sparql_where, state->sparql_filter);
+	else
+		appendStringInfo(&sparql, "%s\nSELECT %s\n%s{%s}",
+						 state->sparql_prefixes, select.data, state->sparql_from, state->sparql_where);
+
+	if (groupby.len > 0)
+		appendStringInfo(&sparql, "\nGROUP BY %s", groupby.data);
+
+	if (having_clause.len > 0)
+		appendStringInfo(&sparql, "\nHAVING %s", having_clause.data);
+
+	gstate->numcols = list_length(cols);
+	gstate->rdfTable = (RDFfdwTable *)palloc0(sizeof(RDFfdwTable));
+	gstate->rdfTable->name = state->rdfTable->name;
+	gstate->rdfTable->cols = (RDFfdwColumn **)palloc0(sizeof(RDFfdwColumn *) * gstate->numcols);
+
+	i = 0;
+	foreach (cell, cols)
+		gstate->rdfTable->cols[i++] = (RDFfdwColumn *)lfirst(cell);
+
+	gstate->scan_tlist = tlist;
+	gstate->sparql_select = select.data;
+	gstate->sparql_having = having_clause.data;
+	gstate->sparql_orderby = NULL;
+	gstate->sparql_limit = NULL;
+	gstate->sparql = sparql.data;
+
+	elog(DEBUG2, "%s: remote aggregate query\n\n%s", __func__, gstate->sparql);
+
+	return gstate;
+}
+#endif /* PG_VERSION_NUM >= 120000 */
+
+/*
+ * CreateTuple
+ * -----------
+ * Populates a TupleTableSlot with values extracted from a single SPARQL
+ * result binding (an <result> XML node).
+ *
+ * The function performs the following steps:
+ *   - Sets all columns to NULL, as unbound variables have no <binding>.
+ *   - Walks the <binding> elements of the record once, finding the columns
+ *     of each variable (e.g., "?foo") in 'state->binding_map'.
+ *   - Converts the RDF term of each binding to a PostgreSQL Datum of the
+ *     column's type with BindingToDatum().
+ *
+ * Parameters:
+ *   slot  - Tuple slot to be filled and returned to the executor.
+ *   state - Foreign scan state, including column metadata and result document pointer.
+ *
+ * The function assumes that FetchNextBinding(state) returns a pointer to the next
+ * <result> node in the SPARQL XML result set.
+ */
+static void CreateTuple(TupleTableSlot *slot, RDFfdwState *state)
+{
+	xmlNodePtr record;
+	xmlNodePtr result;
+
+	if (state->tsv || (state->stream && state->stream->tsv))
+	{
+		CreateTupleFromTsv(slot, state);
+		return;
+	}
+
+	if (state->json || (state->stream && state->stream->json))
+	{
+		CreateTupleFromJson(slot, state);
+		return;
+	}
+
+	record = FetchNextBinding(state);
+
+	elog(DEBUG3, "%s called ", __func__);
+
+	ExecClearTuple(slot);
+
+	for (int i = 0; i < state->numcols; i++)
+		slot->tts_isnull[i] = true;
+
+	for (result = record->children; result != NULL; result = result->next)
+	{
+		RDFfdwBindingEntry *entry = LookupBinding(state, result);
+		ListCell *cell;
+
+		if (entry == NULL)
+			continue;
+
+		foreach (cell, entry->columns)
+		{
+			int i = lfirst_int(cell);
+
+			slot->tts_isnull[i] = !BindingToDatum(state->rdfTable->cols[i], result, &slot->tts_values[i]);
+		}
+	}
+
+	ExecStoreVirtualTuple(slot);
+
+	elog(DEBUG3, "%s exit", __func__);
+}
+
+/*
+ * CreateBindingMap
+ * ----------------
+ * Creates 'state->binding_map', which maps the name of each SPARQL variable
+ * (without '?') to the columns it is bound to, so that the bindings of every
+ * record are assigned to their columns with a single hash lookup, instead
+ * of comparing the name of every binding with the variable of every column.
+ * The keys are copies of the variable names, which SPARQL doesn't limit in
+ * length. The map is created in the current memory context, once per scan.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ */
+static void CreateBindingMap(RDFfdwState *state)
+{
+	HASHCTL ctl;
+
+	if (state->binding_map != NULL)
+		return;
+
+	elog(DEBUG2, "%s called", __func__);
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(char *);
+	ctl.entrysize = sizeof(RDFfdwBindingEntry);
+	ctl.hash = StringKeyHash;
+	ctl.match = StringKeyMatch;
+	ctl.hcxt = CurrentMemoryContext;
+
+	state->binding_map = hash_create("rdf_fdw binding map", Max(state->numcols, 8), &ctl,
+									 HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+
+	for (int i = 0; i < state->numcols; i++)
+	{
+		char *sparqlvar = state->rdfTable->cols[i]->sparqlvar;
+		char *variable;
+		RDFfdwBindingEntry *entry;
+		bool found;
+
+		if (sparqlvar == NULL || strlen(sparqlvar) < 2)
+			continue;
+
+		/* skip the leading '?' (or '$') of the variable */
+		variable = sparqlvar + 1;
+		entry = (RDFfdwBindingEntry *)hash_search(state->binding_map, &variable, HASH_ENTER, &found);
+
+		if (!found)
+		{
+			entry->variable = pstrdup(variable);
+			entry->columns = NIL;
+		}
+
+		entry->columns = lappend_int(entry->columns, i);
+
+		elog(DEBUG2, "%s: variable '%s' -> column '%s'", __func__, sparqlvar, state->rdfTable->cols[i]->name);
+	}
+}
+
+/*
+ * LookupBinding
+ * -------------
+ * Finds the columns of a <binding> element in 'state->binding_map'. The
+ * name attribute is read in place, without copying it.
+ *
+ * state  : SPARQL, SERVER and FOREIGN TABLE info
+ * binding: <binding name="..."> element of a record
+ *
+ * returns the map entry of the binding's variable, or NULL if it is not
+ * bound to any column.
+ */
+static RDFfdwBindingEntry *LookupBinding(RDFfdwState *state, xmlNodePtr binding)
+{
+	xmlAttrPtr name;
+	char *variable;
+
+	if (binding->type != XML_ELEMENT_NODE)
+		return NULL;
+
+	name = xmlHasProp(binding, (xmlChar *)RDF_XML_NAME_TAG);
+
+	if (name == NULL || name->children == NULL || name->children->content == NULL)
+		return NULL;
+
+	variable = (char *)name->children->content;
+
+	return (RDFfdwBindingEntry *)hash_search(state->binding_map, &variable, HASH_FIND, NULL);
+}
+
+/*
+ * StringKeyHash
+ * -------------
+ * Hash function of the maps whose keys are pointers to null-terminated
+ * strings of any length, e.g. 'state->binding_map' and 'state->param_batch'.
+ */
+static uint32 StringKeyHash(const void *key, Size keysize)
+{
+	const char *str = *(char *const *)key;
+
+	return DatumGetUInt32(hash_any((const unsigned char *)str, strlen(str)));
+}
+
+/*
+ * StringKeyMatch
+ * --------------
+ * Comparison function of the maps whose keys are pointers to strings (see
+ * StringKeyHash).
+ */
+static int StringKeyMatch(const void *key1, const void *key2, Size keysize)
+{
+	return strcmp(*(char *const *)key1, *(char *const *)key2);
+}
+
+/*
+ * BindingToDatum
+ * --------------
+ * Converts the RDF term of a <binding> element (<uri>, <bnode> or <literal>)
+ * into a Datum of the column's data type.
+ *
+ * rdfnode columns get the term in its RDF syntax (see RDFNodeFromTerm):
+ * IRIs are enclosed in angle brackets, blank nodes get the "_:" prefix and
+ * literals are quoted and get their language tag or datatype. Any other
+ * type gets the lexical value, which is converted by CreateDatum().
+ *
+ * IMPORTANT: the content at this point is raw lexical content, in which
+ * libxml2 has already unescaped XML entities (e.g., &quot; becomes ").
+ * We must NOT pass it through lex() which would misinterpret quote
+ * characters as RDF syntax. Instead, the rdfnode is constructed directly
+ * from the raw content.
+ *
+ * The content and attributes are read in place when the element has a
+ * single text node, which is how SPARQL XML results are parsed.
+ *
+ * col    : column the value belongs to
+ * binding: <binding> element of a record
+ * datum  : converted value
+ *
+ * returns false if the binding holds no RDF term (SQL NULL)
+ */
+static bool BindingToDatum(RDFfdwColumn *col, xmlNodePtr binding, Datum *datum)
+{
+	xmlNodePtr value;
+	xmlChar *content = NULL;
+	const xmlChar *node_type;
+	char *node_value;
+
+	for (value = binding->children; value != NULL; value = value->next)
+		if (value->type == XML_ELEMENT_NODE)
+			break;
+
+	if (value == NULL)
+	{
+		elog(DEBUG2, "%s: no value found for column '%s' (%s)", __func__, col->name, col->sparqlvar);
+		return false;
+	}
+
+	node_type = value->name;
+
+	/*
+	 * Empty RDF literals (like "" or ""@en or ""^^xsd:string) are empty
+	 * elements. We need to distinguish between:
+	 * 1. Empty literal "" - a valid RDF value (empty string)
+	 * 2. Unbound variable - absence of binding (SQL NULL)
+	 *
+	 * If we're inside a <literal>, <uri>, or <bnode> element, then
+	 * missing content means empty string, not unbound.
+	 */
+	if (xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_LITERAL) != 0 &&
+		xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_URI) != 0 &&
+		xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_BNODE) != 0)
+	{
+		/* Unbound variable or unexpected element - treat as NULL */
+		elog(DEBUG2, "%s: no value found for column '%s' (%s)", __func__, col->name, col->sparqlvar);
+		return false;
+	}
+
+	if (value->children == NULL)
+		node_value = "";
+	else if (value->children->type == XML_TEXT_NODE && value->children->next == NULL)
+		node_value = (char *)value->children->content;
+	else
+	{
+		content = xmlNodeGetContent(value);
+		node_value = content ? (char *)content : "";
+	}
+
+	elog(DEBUG3, "%s: setting pg column > '%s' (type > '%d'), sparqlvar > '%s', value > '%s', node_type > '%s'",
+		 __func__, col->name, col->pgtype, col->sparqlvar, node_value, node_type);
+
+	if (col->pgtype == RDFNODEOID)
+	{
+		if (xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_URI) == 0)
+			*datum = RDFNodeFromTerm(RDF_TERM_IRI, node_value, NULL, NULL);
+		else if (xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_BNODE) == 0)
+			*datum = RDFNodeFromTerm(RDF_TERM_BNODE, node_value, NULL, NULL);
+		else
+		{
+			xmlAttrPtr datatype = xmlHasProp(value, (xmlChar *)RDF_SPARQL_RESULT_LITERAL_DATATYPE);
+			xmlAttrPtr lang = xmlHasProp(value, (xmlChar *)RDF_SPARQL_RESULT_LITERAL_LANG);
+
+			*datum = RDFNodeFromTerm(RDF_TERM_LITERAL, node_value,
+									 datatype && datatype->children ? (char *)datatype->children->content : NULL,
+									 lang && lang->children ? (char *)lang->children->content : NULL);
+		}
+	}
+	else
+		*datum = CreateDatum(col, node_value);
+
+	if (content)
+		xmlFree(content);
+
+	return true;
+}
+
+/*
+ * RDFNodeFromTerm
+ * ---------------
+ * Creates an rdfnode from the parts of an RDF term of a SPARQL result.
+ * In the common case (no quotes, backslashes or other characters with a
+ * meaning in the RDF syntax) the value of rdfnode_in is known beforehand:
+ * <value>, _:value, "value", "value"@lang (primary subtag lowercased) or
+ * "value"^^<datatype>. It is then written straight into the varlena,
+ * without building the literal and parsing it again. All other terms are
+ * serialized and given to rdfnode_in.
+ *
+ * type    : kind of RDF term
+ * value   : IRI, blank node label or lexical form of a literal
+ * datatype: datatype IRI of typed literals, or NULL
+ * lang    : language tag of literals, or NULL
+ *
+ * returns the rdfnode Datum
+ */
+static Datum RDFNodeFromTerm(RDFfdwTermType type, char *value, char *datatype, char *lang)
+{
+	const char *prefix;
+	const char *suffix = "";
+	const char *annotation = "";
+	size_t len;
+	size_t prefix_len;
+	size_t annotation_len = 0;
+	rdfnode *result;
+	char *node;
+
+	if (type == RDF_TERM_IRI && IsVerbatimTermValue(value, true))
+	{
+		prefix = "<";
+		suffix = ">";
+	}
+	else if (type == RDF_TERM_BNODE && *value != '\0')
+		prefix = "_:";
+	else if (type == RDF_TERM_LITERAL && IsVerbatimTermValue(value, false) &&
+			 (datatype == NULL || IsVerbatimDatatype(datatype)) &&
+			 (datatype != NULL || lang == NULL || IsVerbatimLanguageTag(lang)))
+	{
+		prefix = "\"";
+
+		if (datatype)
+		{
+			suffix = "\"^^<";
+			annotation = datatype;
+			annotation_len = strlen(datatype);
+		}
+		else if (lang)
+		{
+			suffix = "\"@";
+			annotation = lang;
+			annotation_len = strlen(lang);
+		}
+		else
+			suffix = "\"";
+	}
+	else
+	{
+		char *literal;
+
+		if (type == RDF_TERM_IRI)
+			literal = iri(value);
+		else if (type == RDF_TERM_BNODE)
+			literal = psprintf("_:%s", value);
+		else
+		{
+			/* Build literal with proper quote escaping */
+			literal = cstring_to_rdfliteral(value);
+
+			if (datatype)
+				literal = strdt(literal, datatype);
+			else if (lang)
+				literal = strlang(literal, lang);
+		}
+
+		return DirectFunctionCall1(rdfnode_in, CStringGetDatum(literal));
+	}
+
+	prefix_len = strlen(prefix);
+	len = prefix_len + strlen(value) + strlen(suffix) + annotation_len + (datatype ? 1 : 0);
+
+	result = (rdfnode *)palloc(VARHDRSZ + len);
+	SET_VARSIZE(result, VARHDRSZ + len);
+
+	node = result->vl_data;
+	memcpy(node, prefix, prefix_len);
+	node += prefix_len;
+	memcpy(node, value, strlen(value));
+	node += strlen(value);
+	memcpy(node, suffix, strlen(suffix));
+	node += strlen(suffix);
+	memcpy(node, annotation, annotation_len);
+
+	/* primary language subtags are always lowercase */
+	if (lang && !datatype)
+		for (char *c = node; c < node + annotation_len && *c != '-'; c++)
+			*c = pg_tolower((unsigned char)*c);
+
+	if (datatype)
+		node[annotation_len] = '>';
+
+	return PointerGetDatum(result);
+}
+
+/*
+ * IsVerbatimTermValue
+ * -------------------
+ * Checks if a value can be written into an rdfnode as it is, i.e. if it is
+ * not empty and has none of the characters that rdfnode_in would escape or
+ * interpret: quotes, backslashes, '@' and '^' anywhere, and a leading '<'
+ * or "_:". IRIs can't contain whitespace either.
+ */
+static bool IsVerbatimTermValue(const char *value, bool iri)
+{
+	if (*value == '\0' || *value == '<' || (value[0] == '_' && value[1] == ':'))
+		return false;
+
+	for (const char *p = value; *p; p++)
+	{
+		if (*p == '"' || *p == '\\' || *p == '@' || *p == '^')
+			return false;
+
+		if (iri && isspace((unsigned char)*p))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * IsVerbatimDatatype
+ * ------------------
+ * Checks if a datatype IRI can be written into an rdfnode as it is, i.e.
+ * if strdt() would neither expand nor reject it.
+ */
+static bool IsVerbatimDatatype(const char *datatype)
+{
+	if (*datatype == '\0' || strncmp(datatype, "xsd:", 4) == 0 ||
+		(datatype[0] == '_' && datatype[1] == ':'))
+		return false;
+
+	for (const char *p = datatype; *p; p++)
+		if (*p == '"' || *p == '\\' || *p == '@' || *p == '^' ||
+			*p == '<' || *p == '>' || isspace((unsigned char)*p))
+			return false;
+
+	return true;
+}
+
+/*
+ * IsVerbatimLanguageTag
+ * ---------------------
+ * Checks if a language tag has the form [a-zA-Z]{1,8}(-[a-zA-Z0-9]{1,8})*,
+ * which is what rdfnode_in accepts (see is_valid_language_tag). Invalid
+ * tags are left to rdfnode_in, which reports them.
+ */
+static bool IsVerbatimLanguageTag(const char *lang)
+{
+	const char *p = lang;
+	int n = 0;
+
+	while (isalpha((unsigned char)*p) && n < 8)
+		p++, n++;
+
+	if (n == 0)
+		return false;
+
+	while (*p == '-')
+	{
+		p++;
+		n = 0;
+
+		while (isalnum((unsigned char)*p) && n < 8)
+			p++, n++;
+
+		if (n == 0)
+			return false;
+	}
+
+	return *p == '\0';
+}
+
+/*
+ * TsvFieldToDatum
+ * ---------------
+ * Converts the RDF term of a SPARQL TSV field into a Datum of the column's
+ * data type. rdfnode columns get the term built from its parts, just like
+ * for SPARQL XML results (see RDFNodeFromTerm), all other types its
+ * unescaped lexical form.
+ *
+ * col : column the value belongs to
+ * term: bound RDF term decoded from the field
+ *
+ * returns the converted Datum
+ */
+static Datum TsvFieldToDatum(RDFfdwColumn *col, SPARQLTsvTerm *term)
+{
+	if (col->pgtype == RDFNODEOID)
+		return RDFNodeFromTerm(term->type == SPARQL_TSV_IRI ? RDF_TERM_IRI : term->type == SPARQL_TSV_BNODE ? RDF_TERM_BNODE : RDF_TERM_LITERAL,
+							   term->value, term->datatype, term->lang);
+
+	return CreateDatum(col, term->value);
+}
+
+/*
+ * CreateTupleFromTsv
+ * ------------------
+ * Counterpart of CreateTuple for SPARQL TSV results. Each column reads the
+ * field of its variable by position, and only the fields of the columns
+ * are decoded. Empty fields are unbound variables and become NULL, just
+ * like variables that are missing from the result set.
+ *
+ * slot  : tuple slot to be filled and returned to the executor.
+ * state : foreign scan state, including column metadata and the TSV result.
+ */
+static void CreateTupleFromTsv(TupleTableSlot *slot, RDFfdwState *state)
+{
+	char **row = FetchNextTsvRow(state);
+
+	elog(DEBUG3, "%s called ", __func__);
+
+	ExecClearTuple(slot);
+
+	if (row == NULL)
+		elog(ERROR, "%s: SPARQL TSV result has fewer rows than expected", __func__);
+
+	for (int i = 0; i < state->numcols; i++)
+	{
+		RDFfdwColumn *col = state->rdfTable->cols[i];
+		SPARQLTsvTerm term;
+
+		if (state->tsv_fields[i] < 0)
+		{
+			slot->tts_isnull[i] = true;
+			continue;
+		}
+
+		SPARQLTsvDecodeTerm(row[state->tsv_fields[i]], &term);
+
+		if (term.type == SPARQL_TSV_UNBOUND)
+		{
+			elog(DEBUG3, "%s: no value found for column '%s' (%s)", __func__, col->name, col->sparqlvar);
+			slot->tts_isnull[i] = true;
+			continue;
+		}
+
+		elog(DEBUG3, "%s: setting pg column > '%s' (type > '%d'), sparqlvar > '%s', value > '%s'",
+			 __func__, col->name, col->pgtype, col->sparqlvar, row[state->tsv_fields[i]]);
+
+		slot->tts_values[i] = TsvFieldToDatum(col, &term);
+		slot->tts_isnull[i] = false;
+	}
+
+	ExecStoreVirtualTuple(slot);
+
+	elog(DEBUG3, "%s exit", __func__);
+}
+
+/*
+ * CreateJsonParser
+ * ----------------
+ * Creates a SPARQL JSON parser for the result set of a scan, registering
+ * the variable of each column, and sets 'state->json_fields' to the
+ * position of each column's term in the rows. Both are allocated in the
+ * current memory context, which must live as long as the result set.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ * keep : keep consumed rows, see SPARQLJsonCreateParser
+ *
+ * returns the new parser
+ */
+static SPARQLJsonParser *CreateJsonParser(RDFfdwState *state, bool keep)
+{
+	SPARQLJsonParser *json = SPARQLJsonCreateParser(keep);
+
+	state->json_fields = (int *)palloc(state->numcols * sizeof(int));
+
+	for (int i = 0; i < state->numcols; i++)
+	{
+		state->json_fields[i] = SPARQLJsonAddVariable(json, state->rdfTable->cols[i]->sparqlvar);
+
+		elog(DEBUG2, "%s: column '%s' (%s) -> term %d", __func__,
+			 state->rdfTable->cols[i]->name, state->rdfTable->cols[i]->sparqlvar, state->json_fields[i]);
+	}
+
+	return json;
+}
+
+/*
+ * JsonTermToDatum
+ * ---------------
+ * Converts an RDF term of a SPARQL JSON row into a Datum of the column's
+ * data type, just like TsvFieldToDatum does for TSV fields.
+ *
+ * col : column the value belongs to
+ * term: bound RDF term of the column's variable
+ *
+ * returns the converted Datum
+ */
+static Datum JsonTermToDatum(RDFfdwColumn *col, SPARQLJsonTerm *term)
+{
+	if (col->pgtype == RDFNODEOID)
+		return RDFNodeFromTerm(term->type == SPARQL_JSON_IRI ? RDF_TERM_IRI : term->type == SPARQL_JSON_BNODE ? RDF_TERM_BNODE : RDF_TERM_LITERAL,
+							   term->value, term->datatype, term->lang);
+
+	return CreateDatum(col, term->value);
+}
+
+/*
+ * CreateTupleFromJson
+ * -------------------
+ * Counterpart of CreateTuple for SPARQL JSON results. Each column reads the
+ * term of its variable by position. Variables without a binding in the
+ * row become NULL.
+ *
+ * slot  : tuple slot to be filled and returned to the executor.
+ * state : foreign scan state, including column metadata and the JSON result.
+ */
+static void CreateTupleFromJson(TupleTableSlot *slot, RDFfdwState *state)
+{
+	SPARQLJsonTerm *row = FetchNextJsonRow(state);
+
+	elog(DEBUG3, "%s called ", __func__);
+
+	ExecClearTuple(slot);
+
+	if (row == NULL)
+		elog(ERROR, "%s: SPARQL JSON result has fewer rows than expected", __func__);
+
+	for (int i = 0; i < state->numcols; i++)
+	{
+		RDFfdwColumn *col = state->rdfTable->cols[i];
+		SPARQLJsonTerm *term;
+
+		if (state->json_fields[i] < 0 || row[state->json_fields[i]].type == SPARQL_JSON_UNBOUND)
+		{
+			elog(DEBUG3, "%s: no value found for column '%s' (%s)", __func__, col->name, col->sparqlvar);
+			slot->tts_isnull[i] = true;
+			continue;
+		}
+
+		term = &row[state->json_fields[i]];
+
+		elog(DEBUG3, "%s: setting pg column > '%s' (type > '%d'), sparqlvar > '%s', value > '%s'",
+			 __func__, col->name, col->pgtype, col->sparqlvar, term->value);
+
+		slot->tts_values[i] = JsonTermToDatum(col, term);
+		slot->tts_isnull[i] = false;
+	}
+
+	ExecStoreVirtualTuple(slot);
+
+	elog(DEBUG3, "%s exit", __func__);
+}
+
+/*
+ * DatumToString
+ * -------------
+ * Converts a 'Datum' into a char*.
+ *
+ * datum: Data to be converted to char*
+ * type : Oid of the data type to be converted
+ *
+ * returns a char* with the string representation of a Datum or an empty string.
+ */
+static char *DatumToString(Datum datum, Oid type)
+{
+	StringInfoData result;
+	regproc typoutput;
+	HeapTuple tuple;
+	char *str;
+	text *t;
+
+	if (type == RDFNODEOID)
+		elog(DEBUG3, "%s called: type='(RDFNODEOID)' ", __func__);
+	else
+		elog(DEBUG3, "%s called: type='%u' ", __func__, type);
+
+	/* get the type's output function */
+	tuple = SearchSysCache1(TYPEOID, ObjectIdGetDatum(type));
+	if (!HeapTupleIsValid(tuple))
+	{
+		elog(ERROR, "%s: cache lookup failed for type %u", __func__, type);
+	}
+	typoutput = ((Form_pg_type)GETSTRUCT(tuple))->typoutput;
+	ReleaseSysCache(tuple);
+
+	initStringInfo(&result);
+	if (type == RDFNODEOID)
+	{
+		str = DatumGetCString(OidFunctionCall1(typoutput, datum));
+		appendStringInfo(&result, "%s", str);
+	}
+	else
+		switch (type)
+		{
+		case TEXTOID:
+		case CHAROID:
+		case BPCHAROID:
+		case VARCHAROID:
+		case NAMEOID:
+		case UUIDOID:
+		case INT8OID:
+		case INT2OID:
+		case INT4OID:
+		case OIDOID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case NUMERICOID:
+			str = DatumGetCString(OidFunctionCall1(typoutput, datum));
+			appendStringInfo(&result, "%s", str);
+			break;
+		case DATEOID:
+			t = DatumGetTextP(DirectFunctionCall1(date_to_rdfnode, datum));
+			appendStringInfo(&result, "%s", text_to_cstring(t));
+			break;
+		case TIMEOID:
+			t = DatumGetTextP(DirectFunctionCall1(time_to_rdfnode, datum));
+			appendStringInfo(&result, "%s", text_to_cstring(t));
+			break;
+		case TIMETZOID:
+			t = DatumGetTextP(DirectFunctionCall1(timetz_to_rdfnode, datum));
+			appendStringInfo(&result, "%s", text_to_cstring(t));
+			break;
+		case TIMESTAMPOID:
+			t = DatumGetTextP(DirectFunctionCall1(timestamp_to_rdfnode, datum));
+			appendStringInfo(&result, "%s", text_to_cstring(t));
+			break;
+		case TIMESTAMPTZOID:
+			t = DatumGetTextP(DirectFunctionCall1(timestamptz_to_rdfnode, datum));
+			appendStringInfo(&result, "%s", text_to_cstring(t));
+			break;
+		case BOOLOID:
+			t = DatumGetTextP(DirectFunctionCall1(boolean_to_rdfnode, datum));
+			appendStringInfo(&result, "%s", text_to_cstring(t));
+			break;
+		default:
+			elog(DEBUG1, "%s exit: returning NULL (unknown data type)", __func__);
+			return NULL;
+		}
+
+	elog(DEBUG3, "%s exit: returning '%s'", __func__, result.data);
+	return result.data;
+}
+
+/*
+ * DeparseExpr
+ * -----------
+ * Deparses SQL expressions and converts them into SPARQL expressions
+ *
+ * state     : SPARQL, SERVER and FOREIGN TABLE info
+ * foreignrel: Conditions and columns used in the SQL query
+ * expr      : Expression to be deparsed
+ *
+ * returns a string containing a SPARQL expression or NULL if not parseable
+ */
+static char *DeparseExpr(struct RDFfdwState *state, RelOptInfo *foreignrel, Expr *expr)
+{
+	char *arg, *opername, *left, *right, oprkind;
+	Const *constant;
+	OpExpr *oper;
+	ScalarArrayOpExpr *arrayoper;
+	Var *variable;
+	HeapTuple tuple;
+	StringInfoData result;
+	Oid leftargtype, rightargtype;
+	int index;
+	ArrayExpr *array;
+	ArrayCoerceExpr *arraycoerce;
+	Expr *rightexpr;
+	Expr *leftexpr;
+	bool first_arg, isNull;
+	ArrayIterator iterator;
+	Datum datum;
+	ListCell *cell;
+	BooleanTest *btest;
+	BoolExpr *boolexpr;
+	FuncExpr *func;
+	struct RDFfdwColumn *col = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
+
+	elog(DEBUG2, "%s called:  expr->type='%u'", __func__, expr->type);
+
+	if (expr == NULL)
+	{
+		elog(DEBUG2, "%s: returning NULL (expr is NULL)", __func__);
+		return NULL;
+	}
+
+	switch (nodeTag(expr))
+	{
+	case T_Const:
+		elog(DEBUG2, "%s [T_Const] called: expr->type=%u", __func__, expr->type);
+		constant = (Const *)expr;
+		if (constant->constisnull)
+		{
+			elog(DEBUG2, "%s [T_Const]: returning NULL (constant is NULL)", __func__);
+			return NULL;
+		}
+		else
+		{
+			/* get a string representation of the value */
+			char *c = DatumToString(constant->constvalue, constant->consttype);
+			if (c == NULL)
+			{
+				elog(DEBUG2, "%s [T_Const]: returning NULL (DatumToString returned NULL)", __func__);
+				return NULL;
+			}
+			else
+			{
+				char *l = lang(c);
+				char *dt = datatype(c);
+				char *lex_str = lex(c);
+				bool needs_escaping = false;
+
+				/* Check if the lexical value contains control characters that need escaping */
+				for (const char *p = lex_str; *p; p++)
+				{
+					if (*p == '\n' || *p == '\r' || *p == '\t')
+					{
+						needs_escaping = true;
+						break;
+					}
+				}
+
+				/* Escape control characters in the lexical value if needed */
+				if (needs_escaping)
+					lex_str = EscapeSPARQLLiteral(c);
+
+				initStringInfo(&result);
+
+				if (strlen(l) != 0)
+					appendStringInfo(&result, "%s", strlang(lex_str, l));
+				else if (strstr(c, "\"^^"))
+					appendStringInfo(&result, "%s", strdt(lex_str, dt));
+				else
+					appendStringInfo(&result, "%s", lex_str);
+			}
+		}
+		elog(DEBUG2, "%s [T_Const]: reached end of block with result='%s'", __func__, result.data);
+		break;
+	case T_Var:
+
+		elog(DEBUG2, "%s [T_Var]: start (expr->type='%u')", __func__, expr->type);
+		variable = (Var *)expr;
+
+		if (variable->vartype == BOOLOID)
+		{
+			elog(DEBUG2, "%s [T_Var]: returning NULL (variable type is a BOOLOID)", __func__);
+			return NULL;
+		}
+
+		index = state->numcols - 1;
+
+		while (index >= 0 && state->rdfTable->cols[index]->pgattnum != variable->varattno)
+			--index;
+
+		/* if no foreign table column is found, return NULL */
+		if (index == -1)
+		{
+			elog(DEBUG1, "%s [T_Var]: returning NULL (no table column found)", __func__);
+			return NULL;
+		}
+
+		initStringInfo(&result);
+		appendStringInfo(&result, "%s", state->rdfTable->cols[index]->name);
+
+		elog(DEBUG2, "  %s [T_Var]: index='%d', result='%s'", __func__,
+			 index, state->rdfTable->cols[index]->name);
+
+		break;
+	case T_BoolExpr:
+		boolexpr = (BoolExpr *) expr;
+
+		if (boolexpr->boolop == NOT_EXPR)
+		{
+			/* NOT always has exactly one argument */
+			char *inner = DeparseExpr(state, foreignrel,
+									(Expr *) linitial(boolexpr->args));
+
+			/* if the inner expression is not pushable, neither is the NOT */
+			if (inner == NULL)
+				return NULL;
+
+			return psprintf("(!%s)", inner);
+		}
+
+		/* Todo: OR_EXPR and AND_EXPR will be added here in the future */
+		return NULL;
+	case T_OpExpr:
+		elog(DEBUG2, "%s [T_OpExpr]: start (expr->type='%u')", __func__, expr->type);
+		oper = (OpExpr *)expr;
+		initStringInfo(&result);
+
+		tuple = SearchSysCache1(OPEROID, ObjectIdGetDatum(oper->opno));
+		if (!HeapTupleIsValid(tuple))
+		{
+			elog(ERROR, "cache lookup failed for operator %u", oper->opno);
+		}
+		opername = pstrdup(((Form_pg_operator)GETSTRUCT(tuple))->oprname.data);
+		oprkind = ((Form_pg_operator)GETSTRUCT(tuple))->oprkind;
+		leftargtype = ((Form_pg_operator)GETSTRUCT(tuple))->oprleft;
+		rightargtype = ((Form_pg_operator)GETSTRUCT(tuple))->oprright;
+		ReleaseSysCache(tuple);
+
+		/* don't push condition down if the right argument can't be translated into a SPARQL value*/
+		if (!canHandleType(rightargtype))
+		{
+			elog(DEBUG2, "%s [T_OpExpr]: returning NULL: cannot handle data type", __func__);
+			return NULL;
+		}
+
+		/* the operators that we can translate */
+		if (strcmp(opername, "=") == 0 ||
+			(strcmp(opername, ">") == 0 && rightargtype != TEXTOID && rightargtype != BPCHAROID && rightargtype != NAMEOID && rightargtype != CHAROID) ||
+			(strcmp(opername, "<") == 0 && rightargtype != TEXTOID && rightargtype != BPCHAROID && rightargtype != NAMEOID && rightargtype != CHAROID) ||
+			(strcmp(opername, ">=") == 0 && rightargtype != TEXTOID && rightargtype != BPCHAROID && rightargtype != NAMEOID && rightargtype != CHAROID) ||
+			(strcmp(opername, "<=") == 0 && rightargtype != TEXTOID && rightargtype != BPCHAROID && rightargtype != NAMEOID && rightargtype != CHAROID) ||
+			strcmp(opername, "+") == 0 ||
+			strcmp(opername, "*") == 0 ||
+			strcmp(opername, "!=") == 0 ||
+			strcmp(opername, "<>") == 0 ||
+			strcmp(opername, "~~") == 0 ||
+			strcmp(opername, "!~~") == 0 ||
+			strcmp(opername, "~~*") == 0 ||
+			strcmp(opername, "!~~*") == 0)
+		{
+			/* SPARQL does not negate with <> */
+			if (strcmp(opername, "<>") == 0)
+				opername = "!=";
+
+			elog(DEBUG2, "%s [T_OpExpr]: deparsing operand of left expression", __func__);
+			left = DeparseExpr(state, foreignrel, linitial(oper->args));
+			elog(DEBUG2, "%s [T_OpExpr]: left operand returned => %s", __func__, left);
+
+			if (left == NULL)
+			{
+				elog(DEBUG2, "%s [T_OpExpr]: returning NULL (left argument couldn't be deparsed)", __func__);
+				return NULL;
+			}
+
+			if (oprkind == 'b')
+			{
+				StringInfoData left_filter_arg;
+				StringInfoData right_filter_arg;
+				struct RDFfdwColumn *right_column = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
+				struct RDFfdwColumn *left_column = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
+
+				elog(DEBUG2, "  %s [T_OpExpr]: deparsing left and right expressions", __func__);
+				leftexpr = linitial(oper->args);
+				rightexpr = lsecond(oper->args);
+
+				elog(DEBUG2, "  %s [T_OpExpr]: deparsing operand of right expression, type %u", __func__, rightexpr->type);
+				right = DeparseExpr(state, foreignrel, rightexpr);
+
+				elog(DEBUG2, "  %s [T_OpExpr]: [%s] left type %u, [%s] right type %u", __func__, left, leftexpr->type, right, rightexpr->type);
+
+				if (right == NULL)
+				{
+					elog(DEBUG2, "%s [T_OpExpr]: returning NULL (right argument couldn't be deparsed)", __func__);
+					return NULL;
+				}
+
+				initStringInfo(&left_filter_arg);
+				initStringInfo(&right_filter_arg);
+
+				left_column = GetRDFColumn(state, left);
+
+				if (leftexpr->type == T_Var && (!left_column || !left_column->pushable))
+				{
+					elog(DEBUG2, "%s [T_OpExpr]: returning NULL (column of left argument is invalid or not pushable)", __func__);
+					return NULL;
+				}
+
+				elog(DEBUG2, "%s [T_OpExpr]: getting right column based on '%s' ... ", __func__, right);
+				right_column = GetRDFColumn(state, right);
+
+				if (rightexpr->type == T_Var && (!right_column || !right_column->pushable))
+				{
+					elog(DEBUG2, "%s [T_OpExpr]: returning NULL (column of right argument is invalid or not pushable)", __func__);
+					return NULL;
+				}
+
+				/* if the column contains an expression we use it in all FILTER expressions*/
+				if (left_column && left_column->expression)
+				{
+					elog(DEBUG2, "%s [T_OpExpr]: adding expression '%s' for left expression", __func__, left_column->expression);
+					appendStringInfo(&left_filter_arg, "%s", left_column->expression);
+				}
+				/* check if the argument is a string (T_Const) */
+				else if (IsStringDataType(leftargtype) && leftexpr->type == T_Const)
+				{
+					if (right_column)
+					{
+						/*
+						 * if the argument is a IRI/URI we must wrap it with IRI(), so that it
+						 * can be handled as such in the FILTER expressions.
+						 */
+						if (right_column->nodetype && strcmp(right_column->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0)
+							appendStringInfo(&left_filter_arg, "IRI(\"%s\")", left);
+						else if (right_column->language)
+						{
+							if (strcmp(right_column->language, "*") == 0)
+								appendStringInfo(&left_filter_arg, "%s", cstring_to_rdfliteral(left));
+							else
+								appendStringInfo(&left_filter_arg, "%s", strlang(left, right_column->language));
+						}
+						else if (right_column->literaltype)
+							appendStringInfo(&left_filter_arg, "%s", strdt(left, right_column->literaltype));
+						else if (isIRI(left) || isBlank(left))
+							appendStringInfo(&left_filter_arg, "%s", left);
+						else
+							appendStringInfo(&left_filter_arg, "%s", cstring_to_rdfliteral(left));
+					}
+					else if (isIRI(left))
+						appendStringInfo(&left_filter_arg, "%s", left);
+					else
+					{
+						char *xsd_type = MapSPARQLDatatype(leftargtype);
+						char *literal = cstring_to_rdfliteral(left);
+
+						if (xsd_type && isPlainLiteral(literal) && rightargtype == RDFNODEOID)
+							appendStringInfo(&left_filter_arg, "%s^^<%s%s>",
+											 literal,
+											 RDF_XSD_BASE_URI,
+											 MapSPARQLDatatype(leftargtype));
+						else
+							appendStringInfo(&left_filter_arg, "%s", cstring_to_rdfliteral(left));
+					}
+				}
+				/* check if the argument is a column */
+				else if (left_column && leftexpr->type == T_Var)
+				{
+					/*
+					 * we wrap the column name (sparqlvar) with STR() if the column's language
+					 * is set to * (all languages)
+					 */
+					if (left_column->language && strcmp(left_column->language, "*") == 0)
+						appendStringInfo(&left_filter_arg, "STR(%s)", left_column->sparqlvar);
+					/* set the sparqlvar to the FILTER expression */
+					else
+						appendStringInfo(&left_filter_arg, "%s", left_column->sparqlvar);
+				}
+				else if (leftexpr->type == T_FuncExpr)
+				{
+					/* We try to resolve the column name <-> sparql variable one last time */
+					left_column = GetRDFColumn(state, left);
+
+					if (left_column)
+						appendStringInfo(&left_filter_arg, "%s", left_column->sparqlvar);
+					else
+						appendStringInfo(&left_filter_arg, "%s", left);
+				}
+				else
+				{
+					appendStringInfo(&left_filter_arg, "%s", left);
+				}
+
+				/* if the column contains an expression we use it in all FILTER expressions*/
+				if (right_column && right_column->expression)
+				{
+					elog(DEBUG2, "%s [T_OpExpr]: adding expression '%s' for left expression", __func__, right_column->expression);
+					appendStringInfo(&right_filter_arg, "%s", right_column->expression);
+				}
+				/* check if the argument is a string (T_Const) */
+				else if (IsStringDataType(rightargtype) && rightexpr->type == T_Const)
+				{
+					if (left_column)
+					{
+						if (left_column->nodetype && strcmp(left_column->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0)
+							appendStringInfo(&right_filter_arg, "IRI(\"%s\")", right);
+						else if (left_column->language)
+						{
+							if (strcmp(left_column->language, "*") == 0)
+								appendStringInfo(&right_filter_arg, "%s", cstring_to_rdfliteral(right));
+							else
+								appendStringInfo(&right_filter_arg, "%s", strlang(right, left_column->language));
+						}
+						else if (left_column->literaltype)
+							appendStringInfo(&right_filter_arg, "%s", strdt(right, left_column->literaltype));
+						else if (isIRI(right) || isBlank(right))
+							appendStringInfo(&right_filter_arg, "%s", right);
+						else
+						{
+
+							appendStringInfo(&right_filter_arg, "%s", cstring_to_rdfliteral(right));
+						}
+					}
+					else if (isIRI(right))
+						appendStringInfo(&right_filter_arg, "%s", right);
+					else
+					{
+						char *xsd_type = MapSPARQLDatatype(rightargtype);
+						char *literal = cstring_to_rdfliteral(right);
+
+						if (xsd_type && isPlainLiteral(literal) && leftargtype == RDFNODEOID)
+							appendStringInfo(&right_filter_arg, "%s^^<%s%s>",
+											 literal,
+											 RDF_XSD_BASE_URI,
+											 MapSPARQLDatatype(rightargtype));
+						else
+							appendStringInfo(&right_filter_arg, "%s", cstring_to_rdfliteral(right));
+					}
+				}
+				else if (rightexpr->type == T_Var)
+				{
+					if (right_column && right_column->language && strcmp(right_column->language, "*") == 0)
+						appendStringInfo(&right_filter_arg, "STR(%s)", right_column->sparqlvar);
+					else
+						appendStringInfo(&right_filter_arg, "%s", right_column->sparqlvar);
+				}
+				else if (rightexpr->type == T_FuncExpr)
+				{
+					/* We try to resolve the column name <-> sparql variable one last time */
+					right_column = GetRDFColumn(state, right);
+
+					if (right_column)
+						appendStringInfo(&right_filter_arg, "%s", right_column->sparqlvar);
+					else
+						appendStringInfo(&right_filter_arg, "%s", right);
+				}
+				else
+					appendStringInfo(&right_filter_arg, "%s", right);
+
+				elog(DEBUG2, "  %s [T_OpExpr]: left argument converted: '%s' => '%s'", __func__, left, NameStr(left_filter_arg));
+				elog(DEBUG2, "  %s [T_OpExpr]: oper  => '%s'", __func__, opername);
+				elog(DEBUG2, "  %s [T_OpExpr]: right argument converted: '%s' => '%s'", __func__, right, NameStr(right_filter_arg));
+
+				if (strcmp(opername, "~~") == 0 || strcmp(opername, "~~*") == 0 || strcmp(opername, "!~~") == 0 || strcmp(opername, "!~~*") == 0)
+				{
+					/*
+					 * If the left and right side arguments are not respectively T_Var and
+					 * T_Const it is not safe to push down the REGEX FILTER. We then let
+					 * the client to deal with it.
+					 */
+					if (leftexpr->type != T_Var && rightexpr->type != T_Const)
+					{
+						elog(DEBUG2, "%s [T_OpExpr]: returning NULL (type of left expression is not a T_Var and the right expression is not a T_Const)", __func__);
+						return NULL;
+					}
+
+					appendStringInfo(&result, "%s(%s,\"%s\"%s)",
+									 opername[0] == '!' ? "!REGEX" : "REGEX",
+									 NameStr(left_filter_arg),
+									 CreateRegexString(right),
+									 strcmp(opername, "~~*") == 0 || strcmp(opername, "!~~*") == 0 ? ",\"i\"" : "");
+				}
+				else
+				{
+					appendStringInfo(&result, "%s %s %s",
+									 NameStr(left_filter_arg),
+									 opername,
+									 NameStr(right_filter_arg));
+				}
+			}
+			else
+			{
+				elog(DEBUG2, "  %s [T_OpExpr]: unary operator not supported", __func__);
+			}
+		}
+		else
+		{
+			elog(DEBUG2, "  %s exit [T_OpExpr]: returning NULL (operator cannot be translated '%s')", __func__, opername);
+			return NULL;
+		}
+
+		break;
+	case T_BooleanTest:
+		elog(DEBUG2, "%s [T_BooleanTest]: start (expr->type='%u')", __func__, expr->type);
+		btest = (BooleanTest *)expr;
+
+		if (btest->arg->type != T_Var)
+		{
+			elog(DEBUG2, "  %s exit [T_BooleanTest]: returning NULL (argument type is not a T_Var)", __func__);
+			return NULL;
+		}
+
+		variable = (Var *)btest->arg;
+
+		index = state->numcols - 1;
+		while (index >= 0 && state->rdfTable->cols[index]->pgattnum != variable->varattno)
+			--index;
+
+		arg = state->rdfTable->cols[index]->name;
+
+		if (arg == NULL)
+		{
+			elog(DEBUG1, "  %s exit [T_BooleanTest]: returning NULL (column name is not valid)", __func__);
+			return NULL;
+		}
+
+		col = GetRDFColumn(state, arg);
+
+		if (!col)
+		{
+			elog(DEBUG2, "  %s exit [T_BooleanTest]: returning NULL (column not found)", __func__);
+			return NULL;
+		}
+
+		if (!col->pushable)
+		{
+			elog(DEBUG2, "  %s exit [T_BooleanTest]: returning NULL (column name is not pushable)", __func__);
+			return NULL;
+		}
+
+		initStringInfo(&result);
+
+		switch (btest->booltesttype)
+		{
+		case IS_TRUE:
+			appendStringInfo(&result, "%s = %s",
+							 col->expression ? col->expression : col->sparqlvar,
+							 !col->literaltype ? "\"true\"" : strdt("true", col->literaltype));
+			break;
+		case IS_NOT_TRUE:
+			appendStringInfo(&result, "%s != %s",
+							 col->expression ? col->expression : col->sparqlvar,
+							 !col->literaltype ? "\"true\"" : strdt("true", col->literaltype));
+			break;
+		case IS_FALSE:
+			appendStringInfo(&result, "%s = %s",
+							 col->expression ? col->expression : col->sparqlvar,
+							 !col->literaltype ? "\"false\"" : strdt("false", col->literaltype));
+			break;
+		case IS_NOT_FALSE:
+			appendStringInfo(&result, "%s != %s",
+							 col->expression ? col->expression : col->sparqlvar,
+							 !col->literaltype ? "\"false\"" : strdt("false", col->literaltype));
+			break;
+		default:
+			elog(DEBUG2, "  %s exit [T_BooleanTest]: returning NULL (unknown booltesttype)", __func__);
+			return NULL;
+		}
+
+		break;
+	case T_ScalarArrayOpExpr:
+		elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: start (expr->type='%u')", __func__, expr->type);
+		arrayoper = (ScalarArrayOpExpr *)expr;
+
+		/* get operator name, left argument type and schema */
+		tuple = SearchSysCache1(OPEROID, ObjectIdGetDatum(arrayoper->opno));
+		if (!HeapTupleIsValid(tuple))
+		{
+			elog(ERROR, "cache lookup failed for operator %u", arrayoper->opno);
+		}
+		opername = pstrdup(((Form_pg_operator)GETSTRUCT(tuple))->oprname.data);
+		leftargtype = ((Form_pg_operator)GETSTRUCT(tuple))->oprleft;
+		ReleaseSysCache(tuple);
+
+		/* don't try to push down anything but IN and NOT IN expressions */
+		if ((strcmp(opername, "=") != 0 || !arrayoper->useOr) && (strcmp(opername, "<>") != 0 || arrayoper->useOr))
+		{
+			elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (expression in not IN or NOT IN)", __func__);
+			return NULL;
+		}
+
+		if (!canHandleType(leftargtype))
+		{
+			elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (cannot handle left argument's datatype)", __func__);
+			return NULL;
+		}
+
+		/* the first (=initial) argument can be T_Var or T_Func */
+		leftexpr = (Expr *)linitial(arrayoper->args);
+		left = DeparseExpr(state, foreignrel, leftexpr);
+
+		if (left == NULL)
+		{
+			elog(DEBUG1, "%s exit [T_ScalarArrayOpExpr]: returning NULL (left argument couldn't be deparsed)", __func__);
+			return NULL;
+		}
+
+		initStringInfo(&result);
+
+		if (leftexpr->type == T_Var)
+		{
+			elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: left argument's dat type is T_Var (column)", __func__);
+			col = GetRDFColumn(state, left);
+
+			if (!col)
+			{
+				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (column of left argument is not valid)", __func__);
+				return NULL;
+			}
+
+			if (!col->pushable)
+			{
+				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (column is not pushable)", __func__);
+				return NULL;
+			}
+
+			if (strcmp(opername, "=") == 0)
+				appendStringInfo(&result, "%s IN (", !col->expression ? col->sparqlvar : col->expression);
+			else
+				appendStringInfo(&result, "%s NOT IN (", !col->expression ? col->sparqlvar : col->expression);
+		}
+		else if (leftexpr->type == T_FuncExpr)
+		{
+			elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: left argument's dat type is T_FuncExpr", __func__);
+			if (strcmp(opername, "=") == 0)
+				appendStringInfo(&result, "%s IN (", left);
+			else
+				appendStringInfo(&result, "%s NOT IN (", left);
+		}
+		else
+		{
+			elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL left argument type '%u' not supported", __func__, leftexpr->type);
+			return NULL;
+		}
+
+		/* the second (=last) argument can be Const, ArrayExpr or ArrayCoerceExpr */
+		rightexpr = (Expr *)llast(arrayoper->args);
+
+		switch (rightexpr->type)
+		{
+		case T_Const:
+			/* the second (=last) argument is a Const of ArrayType */
+			constant = (Const *)rightexpr;
+
+			/*
+			 * NULL isn't supported in Linked Data. A NULL "value" is rather represented
+			 * by the absence of a relation
+			 */
+			if (constant->constisnull)
+			{
+				elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: returning NULL (constant->constisnull)", __func__);
+				return NULL;
+			}
+			else
+			{
+				ArrayType *arr = DatumGetArrayTypeP(constant->constvalue);
+				StringInfoData type;
+				initStringInfo(&type);
+
+				/* loop through the array elements */
+				iterator = array_create_iterator(arr, 0);
+				first_arg = true;
+				while (array_iterate(iterator, &datum, &isNull))
+				{
+					char *c;
+
+					if (isNull)
+						c = "NULL";
+					else
+					{
+
+						c = DatumToString(datum, ARR_ELEMTYPE(arr));
+						if (c == NULL)
+						{
+							array_free_iterator(iterator);
+							return NULL;
+						}
+					}
+
+					if (IsStringDataType(leftargtype))
+					{
+						if (col && col->pgtype == RDFNODEOID)
+							appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", c);
+						else if (col && col->language)
+							appendStringInfo(&result, "%s%s",
+											 first_arg ? "" : ", ", strlang(c, col->language));
+						else if (col && col->literaltype)
+							appendStringInfo(&result, "%s%s",
+											 first_arg ? "" : ", ", strdt(c, col->literaltype));
+						else
+							appendStringInfo(&result, "%s%s",
+											 first_arg ? "" : ", ", str(c));
+					}
+					else
+						appendStringInfo(&result, "%s%s",
+										 first_arg ? "" : ", ", c);
+
+					/* append the argument */
+					first_arg = false;
+				}
+				array_free_iterator(iterator);
+
+				/* don't push down empty arrays, since the semantics for NOT x = ANY(<empty array>) differ */
+				if (first_arg)
+				{
+					elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: returning NULL (cannot push empty arrays)", __func__);
+					return NULL;
+				}
+			}
+
+			break;
+		case T_ArrayCoerceExpr:
+			/* the second (=last) argument is an ArrayCoerceExpr */
+			arraycoerce = (ArrayCoerceExpr *)rightexpr;
+
+			/* if the conversion requires more than binary coercion, don't push it down */
+#if PG_VERSION_NUM < 110000
+			if (arraycoerce->elemfuncid != InvalidOid)
+				return NULL;
+#else
+			if (arraycoerce->elemexpr && arraycoerce->elemexpr->type != T_RelabelType)
+			{
+				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (arraycoerce->elemexpr && arraycoerce->elemexpr->type != T_RelabelType)", __func__);
+				return NULL;
+			}
+#endif
+			if (arraycoerce->arg->type != T_ArrayExpr)
+			{
+				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (arraycoerce->arg->type != T_ArrayExpr)", __func__);
+				return NULL;
+			}
+
+			/* the actual array is here */
+			rightexpr = arraycoerce->arg;
+#if defined(__GNUC__) && __GNUC__ >= 7
+			__attribute__((fallthrough));
+#else
+			/* fall through */
+#endif
+			case T_ArrayExpr:
+			/* the second (=last) argument is an ArrayExpr */
+			array = (ArrayExpr *)rightexpr;
+
+			/* loop the array arguments */
+			first_arg = true;
+			foreach (cell, array->elements)
+			{
+				/* convert the argument to a string */
+				char *element = DeparseExpr(state, foreignrel, (Expr *)lfirst(cell));
+
+				/* if any element cannot be converted, give up */
+				if (element == NULL)
+				{
+					elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (unable to deparse element of T_ArrayExpr)", __func__);
+					return NULL;
+				}
+
+				/* append the argument */
+				appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", element);
+				first_arg = false;
+			}
+
+			/* don't push down empty arrays, since the semantics for NOT x = ANY(<empty array>) differ */
+			if (first_arg)
+			{
+				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (cannot push down empty arrays)", __func__);
+				return NULL;
+			}
+
+			break;
+		default:
+			elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (rightexpr->type not supported)", __func__);
+			return NULL;
+		}
+
+		/* parentheses close the FILTER expression */
+		appendStringInfo(&result, ")");
+
+		break;
+	case T_FuncExpr:
+		elog(DEBUG2, "%s [T_FuncExpr]: start (expr->type='%u')", __func__, expr->type);
+		func = (FuncExpr *)expr;
+
+		if (!canHandleType(func->funcresulttype))
+		{
+			return NULL;
+		}
+
+		/* do nothing for implicit casts */
+		if (func->funcformat == COERCE_IMPLICIT_CAST)
+		{
+			char *impcast = DeparseExpr(state, foreignrel, linitial(func->args));
+			elog(DEBUG2, "%s exit [T_FuncExpr]: returning '%s' (implicit cast) ", __func__, impcast);
+			return impcast;
+		}
+
+		/* get function name and schema */
+		tuple = SearchSysCache1(PROCOID, ObjectIdGetDatum(func->funcid));
+		if (!HeapTupleIsValid(tuple))
+		{
+			elog(ERROR, "%s [T_FuncExpr]: cache lookup failed for function %u", __func__, func->funcid);
+		}
+
+		opername = pstrdup(((Form_pg_proc)GETSTRUCT(tuple))->proname.data);
+		ReleaseSysCache(tuple);
+
+		elog(DEBUG2, "  %s [T_FuncExpr]: opername = %s", __func__, opername);
+
+		if (!IsFunctionPushable(opername))
+		{
+			elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (function not in pg_catalog and not pushable) ", __func__);
+			return NULL;
+		}
+
+		if (IsFunctionPushable(opername))
+		{
+			char *extract_type = "";
+			bool initarg = true;
+			StringInfoData args;
+			initStringInfo(&args);
+			initStringInfo(&result);
+
+			foreach (cell, func->args)
+			{
+				Expr *ex = lfirst(cell);
+				elog(DEBUG2, "%s [T_FuncExpr]: deparsing arguments for '%s'", __func__, opername);
+				arg = DeparseExpr(state, foreignrel, ex);
+
+				if (!arg)
+				{
+					elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (arg is NULL and opername = %s)", __func__, opername);
+					pfree(opername);
+					return NULL;
+				}
+
+				if (!initarg)
+				{
+					/*
+					 * We discard any further parameters of ROUND, as its equivalent
+					 * in SPARQL expects a single parameter.
+					 */
+					if (strcmp(opername, "round") == 0)
+						break;
+					else if (strcmp(opername, "extract") != 0)
+						appendStringInfo(&args, "%s", ", ");
+				}
+
+				col = GetRDFColumn(state, arg);
+
+				if (col)
+				{
+					appendStringInfo(&args, "%s", !col->expression ? col->sparqlvar : col->expression);
+				}
+				else
+				{
+					if (ex->type == T_Const)
+					{
+						Const *ct = (Const *)ex;
+
+						if (strcmp(opername, "extract") == 0 && initarg)
+						{
+							/*
+							 * in EXTRACT calls the first parameter becomes the function
+							 * call in SPARQL. So we leave this cycle after we parsed the
+							 * parameter.
+							 */
+							extract_type = FormatSQLExtractField(arg);
+							continue;
+						}
+
+						/* Return NULLL if the EXTRACT field cannot be converted to SPARQL */
+						if (strcmp(opername, "extract") == 0 && initarg && !arg)
+						{
+							elog(DEBUG1, "%s exit [T_FuncExpr]: returning NULL (EXTRACT field cannot be converted to SPARQL: '%s')", __func__, arg);
+							pfree(opername);
+							return NULL;
+						}
+						else if (IsStringDataType(ct->consttype) && strcmp(opername, "strdt") == 0)
+							appendStringInfo(&args, "%s", ExpandDatatypePrefix(arg));
+						else if (IsStringDataType(ct->consttype) && isIRI(arg))
+							appendStringInfo(&args, "%s", arg);
+						else if (IsStringDataType(ct->consttype))
+							appendStringInfo(&args, "%s", cstring_to_rdfliteral(arg));
+						else
+							appendStringInfo(&args, "%s", arg);
+					}
+					else
+						appendStringInfo(&args, "%s", arg);
+				}
+
+				initarg = false;
+			}
+
+			if (strcmp(opername, "upper") == 0)
+				appendStringInfo(&result, "UCASE(%s)", NameStr(args));
+			else if (strcmp(opername, "lower") == 0)
+				appendStringInfo(&result, "LCASE(%s)", NameStr(args));
+			else if (strcmp(opername, "length") == 0)
+				appendStringInfo(&result, "STRLEN(%s)", NameStr(args));
+			else if (strcmp(opername, "abs") == 0)
+				appendStringInfo(&result, "ABS(%s)", NameStr(args));
+			else if (strcmp(opername, "round") == 0)
+				appendStringInfo(&result, "ROUND(%s)", NameStr(args));
+			else if (strcmp(opername, "floor") == 0)
+				appendStringInfo(&result, "FLOOR(%s)", NameStr(args));
+			else if (strcmp(opername, "ceil") == 0)
+				appendStringInfo(&result, "CEIL(%s)", NameStr(args));
+			else if (strcmp(opername, "strstarts") == 0 || strcmp(opername, "starts_with") == 0)
+				appendStringInfo(&result, "STRSTARTS(%s)", NameStr(args));
+			else if (strcmp(opername, "strends") == 0)
+				appendStringInfo(&result, "STRENDS(%s)", NameStr(args));
+			else if (strcmp(opername, "strbefore") == 0)
+				appendStringInfo(&result, "STRBEFORE(%s)", NameStr(args));
+			else if (strcmp(opername, "strafter") == 0)
+				appendStringInfo(&result, "STRAFTER(%s)", NameStr(args));
+			else if (strcmp(opername, "strlang") == 0)
+				appendStringInfo(&result, "STRLANG(%s)", NameStr(args));
+			else if (strcmp(opername, "strdt") == 0)
+				appendStringInfo(&result, "STRDT(%s)", NameStr(args));
+			else if (strcmp(opername, "str") == 0)
+				appendStringInfo(&result, "STR(%s)", NameStr(args));
+			else if (strcmp(opername, "iri") == 0)
+				appendStringInfo(&result, "IRI(%s)", NameStr(args));
+			else if (strcmp(opername, "isiri") == 0)
+				appendStringInfo(&result, "isIRI(%s)", NameStr(args));
+			else if (strcmp(opername, "lang") == 0)
+				appendStringInfo(&result, "LANG(%s)", NameStr(args));
+			else if (strcmp(opername, "langmatches") == 0)
+				appendStringInfo(&result, "LANGMATCHES(%s)", NameStr(args));
+			else if (strcmp(opername, "datatype") == 0)
+				appendStringInfo(&result, "DATATYPE(%s)", NameStr(args));
+			else if (strcmp(opername, "substring") == 0)
+				appendStringInfo(&result, "SUBSTR(%s)", NameStr(args));
+			else if (strcmp(opername, "contains") == 0)
+				appendStringInfo(&result, "CONTAINS(%s)", NameStr(args));
+			else if (strcmp(opername, "encode_for_uri") == 0)
+				appendStringInfo(&result, "ENCODE_FOR_URI(%s)", NameStr(args));
+			else if (strcmp(opername, "isblank") == 0)
+				appendStringInfo(&result, "isBLANK(%s)", NameStr(args));
+			else if (strcmp(opername, "isnumeric") == 0)
+				appendStringInfo(&result, "ISNUMERIC(%s)", NameStr(args));
+			else if (strcmp(opername, "isliteral") == 0)
+				appendStringInfo(&result, "isLITERAL(%s)", NameStr(args));
+			else if (strcmp(opername, "bnode") == 0)
+				appendStringInfo(&result, "BNODE(%s)", NameStr(args));
+			else if (strcmp(opername, "lcase") == 0)
+				appendStringInfo(&result, "LCASE(%s)", NameStr(args));
+			else if (strcmp(opername, "ucase") == 0)
+				appendStringInfo(&result, "UCASE(%s)", NameStr(args));
+			else if (strcmp(opername, "strlen") == 0)
+				appendStringInfo(&result, "STRLEN(%s)", NameStr(args));
+			else if (strcmp(opername, "substr") == 0)
+				appendStringInfo(&result, "SUBSTR(%s)", NameStr(args));
+			else if (strcmp(opername, "concat") == 0)
+				appendStringInfo(&result, "CONCAT(%s)", NameStr(args));
+			else if (strcmp(opername, "replace") == 0)
+				appendStringInfo(&result, "REPLACE(%s)", NameStr(args));
+			else if (strcmp(opername, "year") == 0)
+				appendStringInfo(&result, "YEAR(%s)", NameStr(args));
+			else if (strcmp(opername, "month") == 0)
+				appendStringInfo(&result, "MONTH(%s)", NameStr(args));
+			else if (strcmp(opername, "day") == 0)
+				appendStringInfo(&result, "DAY(%s)", NameStr(args));
+			else if (strcmp(opername, "hours") == 0)
+				appendStringInfo(&result, "HOURS(%s)", NameStr(args));
+			else if (strcmp(opername, "minutes") == 0)
+				appendStringInfo(&result, "MINUTES(%s)", NameStr(args));
+			else if (strcmp(opername, "seconds") == 0)
+				appendStringInfo(&result, "SECONDS(%s)", NameStr(args));
+			else if (strcmp(opername, "timezone") == 0)
+				appendStringInfo(&result, "TIMEZONE(%s)", NameStr(args));
+			else if (strcmp(opername, "tz") == 0)
+				appendStringInfo(&result, "TZ(%s)", NameStr(args));
+			else if (strcmp(opername, "md5") == 0)
+				appendStringInfo(&result, "MD5(%s)", NameStr(args));
+			else if (strcmp(opername, "bound") == 0)
+				appendStringInfo(&result, "BOUND(%s)", NameStr(args));
+			else if (strcmp(opername, "sameterm") == 0)
+				appendStringInfo(&result, "SAMETERM(%s)", NameStr(args));
+			else if (strcmp(opername, "coalesce") == 0)
+				appendStringInfo(&result, "COALESCE(%s)", NameStr(args));
+			else if (strcmp(opername, "extract") == 0)
+				appendStringInfo(&result, "%s(%s)", extract_type, NameStr(args));
+			else if (strcmp(opername, "rdfnode_to_timestamp") == 0)
+				appendStringInfo(&result, "%s", NameStr(args));
+			else if (strcmp(opername, "rdfnode_to_timestamptz") == 0)
+				appendStringInfo(&result, "%s", NameStr(args));
+			else if (strcmp(opername, "rdfnode_to_times") == 0)
+				appendStringInfo(&result, "%s", NameStr(args));
+			else if (strcmp(opername, "rdfnode_to_timetz") == 0)
+				appendStringInfo(&result, "%s", NameStr(args));
+			else if (strcmp(opername, "rdfnode_to_boolean") == 0)
+				appendStringInfo(&result, "%s", NameStr(args));
+			else if (strcmp(opername, "boolean_to_rdfnode") == 0)
+				appendStringInfo(&result, "%s", NameStr(args));
+
+			else
+			{
+				elog(DEBUG2, "%s [T_FuncExpr]: returning NULL (unknown opername '%s')", __func__, opername);
+				return NULL;
+			}
 
-		break;
-	case T_Aggref:
-		foreach (cell, ((Aggref *)expr)->args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		foreach (cell, ((Aggref *)expr)->aggorder)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		foreach (cell, ((Aggref *)expr)->aggdistinct)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+			pfree(args.data);
 		}
-		break;
-	case T_WindowFunc:
-		foreach (cell, ((WindowFunc *)expr)->args)
+		/* in PostgreSQL 11 EXTRACT is internally called as DATE_PART */
+		else if (strcmp(opername, "date_part") == 0)
 		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-#if PG_VERSION_NUM < 120000
-	case T_ArrayRef:
-	{
-		ArrayRef *ref = (ArrayRef *)expr;
-#else
-	case T_SubscriptingRef:
-	{
-		SubscriptingRef *ref = (SubscriptingRef *)expr;
-#endif
+			Expr *field = linitial(func->args);
+			char *date_part_type = "";
 
-		foreach (cell, ref->refupperindexpr)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		foreach (cell, ref->reflowerindexpr)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		SetUsedColumns(ref->refexpr, state, foreignrelid);
-		SetUsedColumns(ref->refassgnexpr, state, foreignrelid);
-		break;
-	}
-	case T_FuncExpr:
-		foreach (cell, ((FuncExpr *)expr)->args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-	case T_OpExpr:
-		foreach (cell, ((OpExpr *)expr)->args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-	case T_DistinctExpr:
-		foreach (cell, ((DistinctExpr *)expr)->args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-	case T_NullIfExpr:
-		foreach (cell, ((NullIfExpr *)expr)->args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-	case T_ScalarArrayOpExpr:
-		foreach (cell, ((ScalarArrayOpExpr *)expr)->args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+			elog(DEBUG2, "%s [T_FuncExpr]: deparsing FIELD for '%s'", __func__, opername);
+			date_part_type = DeparseExpr(state, foreignrel, field);
+
+			if (!date_part_type)
+			{
+				elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (date_part_type is NULL and opername = '%s')", __func__, opername);
+				pfree(opername);
+				return NULL;
+			}
+
+			elog(DEBUG2, "%s [T_FuncExpr]: date_part FIELD '%s'", __func__, date_part_type);
+
+			date_part_type = FormatSQLExtractField(date_part_type);
+
+			if (date_part_type)
+			{
+				char *val;
+
+				elog(DEBUG2, "%s [T_FuncExpr]: deparsing VALUE for '%s'", __func__, opername);
+
+				val = DeparseExpr(state, foreignrel, lsecond(func->args));
+				col = GetRDFColumn(state, val);
+
+				initStringInfo(&result);
+
+				if (col)
+					appendStringInfo(&result, "%s(%s)", date_part_type, !col->expression ? col->sparqlvar : col->expression);
+				else
+					appendStringInfo(&result, "%s(\"%s\")", date_part_type, val);
+			}
+			else
+			{
+				elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (date_part_type is NULL)", __func__);
+				pfree(opername);
+				return NULL;
+			}
 		}
-		break;
-	case T_BoolExpr:
-		foreach (cell, ((BoolExpr *)expr)->args)
+		else if (strcmp(opername, "timestamp") == 0)
 		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-	case T_SubPlan:
-	{
-		SubPlan *subplan = (SubPlan *)expr;
+			char *value;
+			Expr *ex = linitial(func->args);
 
-		SetUsedColumns((Expr *)(subplan->testexpr), state, foreignrelid);
+			value = DeparseExpr(state, foreignrel, ex);
 
-		foreach (cell, subplan->args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+			if (!value)
+			{
+				elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (unable to deparse timestamp value)", __func__);
+				return NULL;
+			}
+
+			initStringInfo(&result);
+			appendStringInfo(&result, "%s", value);
 		}
-	}
-	break;
-	case T_AlternativeSubPlan:
-		/* examine only first alternative */
-		SetUsedColumns((Expr *)linitial(((AlternativeSubPlan *)expr)->subplans), state, foreignrelid);
-		break;
-	case T_NamedArgExpr:
-		SetUsedColumns(((NamedArgExpr *)expr)->arg, state, foreignrelid);
-		break;
-	case T_FieldSelect:
-		SetUsedColumns(((FieldSelect *)expr)->arg, state, foreignrelid);
-		break;
-	case T_RelabelType:
-		SetUsedColumns(((RelabelType *)expr)->arg, state, foreignrelid);
-		break;
-	case T_CoerceViaIO:
-		SetUsedColumns(((CoerceViaIO *)expr)->arg, state, foreignrelid);
-		break;
-	case T_ArrayCoerceExpr:
-		SetUsedColumns(((ArrayCoerceExpr *)expr)->arg, state, foreignrelid);
-		break;
-	case T_ConvertRowtypeExpr:
-		SetUsedColumns(((ConvertRowtypeExpr *)expr)->arg, state, foreignrelid);
-		break;
-	case T_CollateExpr:
-		SetUsedColumns(((CollateExpr *)expr)->arg, state, foreignrelid);
-		break;
-	case T_CaseExpr:
-		foreach (cell, ((CaseExpr *)expr)->args)
+		else
 		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+			elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (unable to push function '%s')", __func__, opername);
+			return NULL;
 		}
-		SetUsedColumns(((CaseExpr *)expr)->arg, state, foreignrelid);
-		SetUsedColumns(((CaseExpr *)expr)->defresult, state, foreignrelid);
-		break;
-	case T_CaseWhen:
-		SetUsedColumns(((CaseWhen *)expr)->expr, state, foreignrelid);
-		SetUsedColumns(((CaseWhen *)expr)->result, state, foreignrelid);
+
+		pfree(opername);
 		break;
 	case T_ArrayExpr:
-		foreach (cell, ((ArrayExpr *)expr)->elements)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-	case T_RowExpr:
-		foreach (cell, ((RowExpr *)expr)->args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-	case T_RowCompareExpr:
-		foreach (cell, ((RowCompareExpr *)expr)->largs)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		foreach (cell, ((RowCompareExpr *)expr)->rargs)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		break;
-	case T_CoalesceExpr:
-		foreach (cell, ((CoalesceExpr *)expr)->args)
+		elog(DEBUG2, "%s [T_ArrayExpr]: start (expr->type='%u')", __func__, expr->type);
+
+		/* this is exclusively for SPARQL COALESCE */
+		array = (ArrayExpr *)expr;
+		elog(DEBUG2, "%s [T_ArrayExpr]: function called", __func__);
+		initStringInfo(&result);
+
+		/* loop the array arguments */
+		first_arg = true;
+		foreach (cell, array->elements)
 		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+			Expr *element_expr = (Expr *)lfirst(cell);
+			char *element = DeparseExpr(state, foreignrel, element_expr);
+
+			/* if any element cannot be converted, give up */
+			if (element == NULL)
+			{
+				elog(DEBUG2, "%s exit [T_ArrayExpr]: returning NULL (unable to deparse element of T_ArrayExpr)", __func__);
+				return NULL;
+			}
+
+			col = GetRDFColumn(state, element);
+
+			if (col)
+				appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", col->sparqlvar);
+			else if (nodeTag(element_expr) == T_Const && isLiteral(element))
+			{
+				/*
+				 * this seems unnecessary, but it is important to expand
+				 * possible prefixed XSD predicates into their full URI.
+				 */
+				char *dt = datatype(element);
+
+				if (strlen(dt) != 0)
+					appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", strdt(element, dt));
+				else
+					appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", cstring_to_rdfliteral(element));
+			}
+			else if (nodeTag(element_expr) == T_Const)
+				appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", cstring_to_rdfliteral(element));
+			else
+				appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", element);
+
+			first_arg = false;
 		}
-		break;
-	case T_MinMaxExpr:
-		foreach (cell, ((MinMaxExpr *)expr)->args)
+
+		if (first_arg)
 		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+			elog(DEBUG2, "%s exit [T_ArrayExpr]: returning NULL (cannot push empty arrays)", __func__);
+			return NULL;
 		}
+
 		break;
-	case T_XmlExpr:
-		foreach (cell, ((XmlExpr *)expr)->named_args)
-		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
-		}
-		foreach (cell, ((XmlExpr *)expr)->args)
+#if PG_VERSION_NUM >= 120000
+	case T_Aggref:
+		elog(DEBUG2, "%s [T_Aggref] called", __func__);
+
+		arg = DeparseAggref(state, (Aggref *)expr);
+
+		if (arg == NULL)
 		{
-			SetUsedColumns((Expr *)lfirst(cell), state, foreignrelid);
+			elog(DEBUG2, "%s exit [T_Aggref]: returning NULL (aggregate cannot be pushed down)", __func__);
+			return NULL;
 		}
+
+		initStringInfo(&result);
+		appendStringInfoString(&result, arg);
 		break;
-	case T_NullTest:
-		SetUsedColumns(((NullTest *)expr)->arg, state, foreignrelid);
-		break;
-	case T_BooleanTest:
-		SetUsedColumns(((BooleanTest *)expr)->arg, state, foreignrelid);
-		break;
-	case T_CoerceToDomain:
-		SetUsedColumns(((CoerceToDomain *)expr)->arg, state, foreignrelid);
-		break;
-	case T_PlaceHolderVar:
-		SetUsedColumns(((PlaceHolderVar *)expr)->phexpr, state, foreignrelid);
-		break;
-#if PG_VERSION_NUM >= 100000
-	case T_SQLValueFunction:
-		break; /* contains no column references */
-#endif		   /* PG_VERSION_NUM */
+#endif /* PG_VERSION_NUM >= 120000 */
 	default:
-		ereport(ERROR,
-				(errcode(ERRCODE_INTERNAL_ERROR),
-				 errmsg("unknown node type found: %d.", expr->type)));
-		break;
+		elog(DEBUG2, "%s exit: returning NULL (expression not supported '%u')", __func__, expr->type);
+		return NULL;
 	}
 
-	elog(DEBUG2, "%s exit", __func__);
+	elog(DEBUG2, "%s exit: returning '%s'\n", __func__, result.data);
+	return result.data;
 }
 
 /*
- * CreateSPARQL
- * ------------
- * Creates the final SPARQL query sent to the server, which might includes the
- * pushdown of SQL instructions. The query will be loaded into 'state->sparql'
+ * IsSPARQLIRIRef
+ * --------------
+ * Checks if an IRI in angle brackets can be written as a SPARQL IRIREF,
+ * i.e. it contains none of the characters the grammar forbids inside of
+ * <...>. IRIs that cannot must be built from a literal with IRI().
  *
- * state: SPARQL, SERVER and FOREIGN TABLE info
- * root : Planner info
+ * term: IRI enclosed in angle brackets
+ *
+ * returns true if the IRI can be used as is in a SPARQL query
  */
-static void CreateSPARQL(RDFfdwState *state, PlannerInfo *root)
+static bool IsSPARQLIRIRef(char *term)
 {
-	StringInfoData where_graph;
-	StringInfoData sparql;
-
-	initStringInfo(&sparql);
-	initStringInfo(&where_graph);
-
-	elog(DEBUG2, "%s called", __func__);
-
-	if (state->sparql_filter && strlen(state->sparql_filter) > 0)
-		appendStringInfo(&where_graph, "{%s\n ## rdf_fdw pushdown conditions ##\n%s}", pstrdup(state->sparql_where), pstrdup(state->sparql_filter));
-	else
-		appendStringInfo(&where_graph, "{%s}", pstrdup(state->sparql_where));
-	/*
-	 * if the raw SPARQL query contains a DISTINCT modifier, this must be added into the
-	 * new SELECT clause
-	 */
-	if (state->is_sparql_parsable == true &&
-		LocateKeyword(state->raw_sparql, " \n", "DISTINCT", " \n?", NULL, 0) != RDF_KEYWORD_NOT_FOUND)
-	{
-		elog(DEBUG2, "  %s: SPARQL is valid and contains a DISTINCT modifier > pushing down DISTINCT", __func__);
-		appendStringInfo(&sparql, "%s\nSELECT DISTINCT %s\n%s%s",
-						 state->sparql_prefixes,
-						 strlen(state->sparql_select) == 0 ? " * " : state->sparql_select,
-						 state->sparql_from,
-						 where_graph.data);
-	}
-	/*
-	 * if the raw SPARQL query contains a REDUCED modifier, this must be added into the
-	 * new SELECT clause
-	 */
-	else if (state->is_sparql_parsable == true &&
-			 LocateKeyword(state->raw_sparql, " \n", "REDUCED", " \n?", NULL, 0) != RDF_KEYWORD_NOT_FOUND)
-	{
-		elog(DEBUG2, "  %s: SPARQL is valid and contains a REDUCED modifier > pushing down REDUCED", __func__);
-		appendStringInfo(&sparql, "%s\nSELECT REDUCED %s\n%s%s",
-						 state->sparql_prefixes,
-						 strlen(state->sparql_select) == 0 ? " * " : state->sparql_select,
-						 state->sparql_from,
-						 where_graph.data);
-	}
-	/*
-	 * if the raw SPARQL query does not contain a DISTINCT but the SQL query does,
-	 * this must be added into the new SELECT clause
-	 */
-	else if (state->is_sparql_parsable &&
-			 root &&																						/* was the PlanerInfo provided? */
-			 root->parse->distinctClause != NULL &&															/* is there a DISTINCT clause in the PlanerInfo?*/
-			 !root->parse->hasDistinctOn &&																	/* does the DISTINCT clause have a DISTINCT ON?*/
-			 LocateKeyword(state->raw_sparql, " \n", "DISTINCT", " \n?", NULL, 0) == RDF_KEYWORD_NOT_FOUND) /* does the SPARQL have a DISTINCT clause?*/
-	{
-		appendStringInfo(&sparql, "%s\nSELECT DISTINCT %s\n%s%s",
-						 state->sparql_prefixes,
-						 strlen(state->sparql_select) == 0 ? " * " : state->sparql_select,
-						 state->sparql_from,
-						 where_graph.data);
-	}
-	else
-	{
-		appendStringInfo(&sparql, "%s\nSELECT %s\n%s%s",
-						 state->sparql_prefixes,
-						 strlen(state->sparql_select) == 0 ? " * " : state->sparql_select,
-						 state->sparql_from,
-						 where_graph.data);
-	}
-	/*
-	 * if the SQL query contains an ORDER BY, we try to push it down.
-	 */
-	if (state->is_sparql_parsable && state->sparql_orderby)
-	{
-		elog(DEBUG2, "  %s: pushing down ORDER BY clause > 'ORDER BY %s'", __func__, state->sparql_orderby);
-		appendStringInfo(&sparql, "\nORDER BY%s", pstrdup(state->sparql_orderby));
-	}
-
-	/*
-	 * Pushing down LIMIT (OFFSET) to the SPARQL query if the SQL query contains them.
-	 * If the SPARQL query set in the CREATE TABLE statement already contains a LIMIT,
-	 * this won't be pushed.
-	 */
-	if (state->sparql_limit)
-	{
-		elog(DEBUG2, "  %s: pushing down LIMIT clause > '%s'", __func__, state->sparql_limit);
-		appendStringInfo(&sparql, "\n%s", state->sparql_limit);
-	}
+	if (!isIRI(term))
+		return false;
 
-	state->sparql = pstrdup(NameStr(sparql));
+	for (char *c = term + 1; c[1] != '\0'; c++)
+		if ((unsigned char)*c <= 0x20 || strchr("<>\"{}|^`\\", *c))
+			return false;
 
-	elog(DEBUG1, "%s exit", __func__);
+	return true;
 }
 
 /*
- * CreateTuple
- * -----------
- * Populates a TupleTableSlot with values extracted from a single SPARQL
- * result binding (an <result> XML node).
+ * DeparseTermBinding
+ * ------------------
+ * Converts an equality between a column and a constant into an inline
+ * VALUES block that binds the column's variable to the constant, e.g.
+ * film = '<http://ex.org/f1>' becomes VALUES ?film { <http://ex.org/f1> }
+ * (enable_term_binding). Unlike a FILTER, which is evaluated only after
+ * the graph pattern is matched, the bound term can be used by the endpoint
+ * to look up the matching triples directly.
  *
- * The function performs the following steps:
- *   - Iterates over columns defined in the foreign table.
- *   - Matches each column with the corresponding SPARQL variable (e.g., "?foo").
- *   - Extracts RDF term content, datatype, language tag, and node type from the XML.
- *   - Converts the RDF term to a PostgreSQL Datum using the appropriate input function.
- *   - Handles language-tagged literals, typed literals, IRIs, or plain strings.
- *   - Applies RDF-specific formatting if requested via the column's literal_format.
- *   - Handles type coercion using the PostgreSQL typinput function for each column.
+ * VALUES compares RDF terms, while the SQL operator compares values. Both
+ * only agree for IRIs and plain literals, so other literals (numbers,
+ * language-tagged and typed literals) are left to FILTER.
  *
- * Parameters:
- *   slot  - Tuple slot to be filled and returned to the executor.
- *   state - Foreign scan state, including column metadata and result document pointer.
+ * state  : SPARQL, SERVER and FOREIGN TABLE info
+ * baserel: foreign table being scanned
+ * expr   : condition of the SQL WHERE clause
  *
- * The function assumes that FetchNextBinding(state) returns a pointer to the next
- * <result> node in the SPARQL XML result set.
+ * returns the VALUES block, or NULL if the condition cannot be bound
  */
-static void CreateTuple(TupleTableSlot *slot, RDFfdwState *state)
+static char *DeparseTermBinding(struct RDFfdwState *state, RelOptInfo *baserel, Expr *expr)
 {
-	xmlNodePtr record;
-	xmlNodePtr result;
-	regproc typinput;
-	/*
-		MemoryContext old_cxt, tmp_cxt;
-
-		tmp_cxt = AllocSetContextCreate(CurrentMemoryContext,
-										"rdf_fdw temporary data",
-										ALLOCSET_SMALL_SIZES);
-		old_cxt = MemoryContextSwitchTo(tmp_cxt);
-	*/
-	record = FetchNextBinding(state);
-
-	elog(DEBUG3, "%s called ", __func__);
-
-	ExecClearTuple(slot);
-
-	for (int i = 0; i < state->numcols; i++)
-	{
-		bool match = false;
-		Oid pgtype = state->rdfTable->cols[i]->pgtype;
-		char *sparqlvar = state->rdfTable->cols[i]->sparqlvar;
-		char *colname = state->rdfTable->cols[i]->name;
-		int pgtypmod = state->rdfTable->cols[i]->pgtypmod;
-
-		for (result = record->children; result != NULL; result = result->next)
-		{
-			xmlChar *prop = xmlGetProp(result, (xmlChar *)RDF_XML_NAME_TAG);
-			StringInfoData name;
-
-			initStringInfo(&name);
-			appendStringInfo(&name, "?%s", (char *)prop);
-
-			if (strcmp(sparqlvar, name.data) == 0)
-			{
-				xmlNodePtr value;
-				match = true;
-
-				for (value = result->children; value != NULL; value = value->next)
-				{
-					HeapTuple tuple;
-					Datum datum;
-					StringInfoData literal_value;
-					xmlChar *datatype = xmlGetProp(value, (xmlChar *)RDF_SPARQL_RESULT_LITERAL_DATATYPE);
-					xmlChar *lang = xmlGetProp(value, (xmlChar *)RDF_SPARQL_RESULT_LITERAL_LANG);
-					xmlChar *content = xmlNodeGetContent(value->children);
-					const xmlChar *node_type = value->name;
-					char *node_value;
-
-					initStringInfo(&literal_value);
-					node_value = (char *)content;
-
-					/*
-					 * For empty RDF literals (like "" or ""@en or ""^^xsd:string),
-					 * xmlNodeGetContent may return NULL when the element is empty.
-					 * We need to distinguish between:
-					 * 1. Empty literal "" - a valid RDF value (empty string)
-					 * 2. Unbound variable - absence of binding (SQL NULL)
-					 *
-					 * If we're inside a <literal>, <uri>, or <bnode> element,
-					 * then NULL content means empty string, not unbound.
-					 */
-					if (!node_value)
-					{
-						/* Check if this is a bound RDF term (literal, uri, or bnode) */
-						if (xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_LITERAL) == 0 ||
-							xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_URI) == 0 ||
-							xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_BNODE) == 0)
-						{
-							/* Empty RDF term - use empty string */
-							node_value = "";
-							elog(DEBUG2, "%s: empty %s for column '%s' (%s)",
-								 __func__, (char *)node_type, colname, sparqlvar);
-						}
-						else
-						{
-							/* Unbound variable or unexpected element - treat as NULL */
-							elog(DEBUG2, "%s: no value found for column '%s' (%s)", __func__, colname, sparqlvar);
-
-							if (content)
-								xmlFree(content);
-							if (lang)
-								xmlFree(lang);
-							if (datatype)
-								xmlFree(datatype);
-							if (literal_value.data)
-								pfree(literal_value.data);
-							if (name.data)
-								pfree(name.data);
-
-							slot->tts_isnull[i] = true;
-							continue;
-						}
-					}
-
-					elog(DEBUG3, "%s: value='%s', lang='%s', datatye='%s', node_type='%s'",
-						 __func__, node_value, (char *)lang, (char *)datatype, node_type);
-
-					/*
-					 * If the column is an RDFNode, we need to check if it has a
-					 * datatype or a language tag. If it does, we need to format
-					 * it accordingly.
-					 *
-					 * IMPORTANT: node_value at this point is raw lexical content from
-					 * xmlNodeGetContent(), which has already unescaped XML entities
-					 * (e.g., &quot; becomes "). We must NOT pass it through lex()
-					 * which would misinterpret quote characters as RDF syntax.
-					 * Instead, construct the rdfnode directly from the raw content.
-					 */
-					if (state->rdfTable->cols[i]->pgtype == RDFNODEOID)
-					{
-						if (xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_URI) == 0)
-						{
-							appendStringInfo(&literal_value, "%s", iri(node_value));
-						}
-						else if (xmlStrcmp(node_type, (xmlChar *)RDF_SPARQL_RESULT_BNODE) == 0)
-						{
-							/* For blank nodes, preserve the label with _: prefix */
-							appendStringInfo(&literal_value, "_:%s", node_value);
-						}
-						else
-						{
-							/* Build literal with proper quote escaping */
-							char *escaped = cstring_to_rdfliteral(node_value);
-
-							if (datatype)
-								appendStringInfo(&literal_value, "%s", strdt(escaped, (char *)datatype));
-							else if (lang)
-								appendStringInfo(&literal_value, "%s", strlang(escaped, (char *)lang));
-							else
-								appendStringInfo(&literal_value, "%s", escaped);
-						}
-					}
-					else
-						appendStringInfo(&literal_value, "%s", node_value);
-
-					datum = CStringGetDatum(literal_value.data);
-					slot->tts_isnull[i] = false;
-
-					if (pgtype == RDFNODEOID)
-						elog(DEBUG3, "%s: setting pg column > '%s' (type > '(RDFNODEOID)'), sparqlvar > '%s'", __func__, colname, sparqlvar);
-					else
-						elog(DEBUG3, "%s: setting pg column > '%s' (type > '%d'), sparqlvar > '%s'", __func__, colname, pgtype, sparqlvar);
-
-					elog(DEBUG3, "%s: value > '%s'", __func__, node_value);
-
-					/* find the appropriate conversion function */
-					tuple = SearchSysCache1(TYPEOID, ObjectIdGetDatum(pgtype));
+	OpExpr *oper = (OpExpr *)expr;
+	struct RDFfdwColumn *col = NULL;
+	Expr *left;
+	Expr *right;
+	Var *variable;
+	Const *constant;
+	char *opername;
+	char *term;
 
-					if (!HeapTupleIsValid(tuple))
-					{
-						/* Cleanup before error */
-						if (content)
-							xmlFree(content);
-						if (lang)
-							xmlFree(lang);
-						if (datatype)
-							xmlFree(datatype);
-						if (prop)
-							xmlFree(prop);
-						if (name.data)
-        					pfree(name.data);
+	if (!IsA(expr, OpExpr) || list_length(oper->args) != 2)
+		return NULL;
 
-						ereport(ERROR,
-								(errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
-								 errmsg("cache lookup failed for type %u > column '%s(%s)'", pgtype, sparqlvar, sparqlvar)));
-					}
+	opername = get_opname(oper->opno);
 
-					typinput = ((Form_pg_type)GETSTRUCT(tuple))->typinput;
-					ReleaseSysCache(tuple);
+	if (!opername || strcmp(opername, "=") != 0)
+		return NULL;
 
-					if (pgtype == NUMERICOID || pgtype == TIMESTAMPOID || pgtype == TIMESTAMPTZOID || pgtype == VARCHAROID)
-					{
+#if PG_VERSION_NUM >= 120000
+	/* case insensitive collations would match other IRIs than the given one */
+	if (OidIsValid(oper->inputcollid) && !get_collation_isdeterministic(oper->inputcollid))
+		return NULL;
+#endif
 
-						slot->tts_values[i] = OidFunctionCall3(
-							typinput,
-							datum,
-							ObjectIdGetDatum(InvalidOid),
-							Int32GetDatum(pgtypmod));
-					}
-					else if (pgtype == RDFNODEOID)
-					{
-						slot->tts_values[i] = DirectFunctionCall1(rdfnode_in, datum);
-					}
-					else
-					{
-						slot->tts_values[i] = OidFunctionCall1(typinput, datum);
-					}
+	left = (Expr *)linitial(oper->args);
+	right = (Expr *)lsecond(oper->args);
 
-					/* Cleanup after successful processing */
-					if (content)
-						xmlFree(content);
-					if (lang)
-						xmlFree(lang);
-					if (datatype)
-						xmlFree(datatype);
-					if (literal_value.data)
-						pfree(literal_value.data);
-				}
-			}
+	/* varchar columns and constants are relabeled to text */
+	if (IsA(left, RelabelType))
+		left = ((RelabelType *)left)->arg;
+	if (IsA(right, RelabelType))
+		right = ((RelabelType *)right)->arg;
 
-			if (name.data)
-				pfree(name.data);
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		variable = (Var *)left;
+		constant = (Const *)right;
+	}
+	else if (IsA(left, Const) && IsA(right, Var))
+	{
+		variable = (Var *)right;
+		constant = (Const *)left;
+	}
+	else
+		return NULL;
 
-			if (prop)
-				xmlFree(prop);
-		}
+	if (variable->varno != baserel->relid || constant->constisnull)
+		return NULL;
 
-		if (!match)
+	for (int i = 0; i < state->numcols; i++)
+	{
+		if (state->rdfTable->cols[i]->pgattnum == variable->varattno)
 		{
-			elog(DEBUG3, "    %s: setting NULL for column '%s' (%s)", __func__, colname, sparqlvar);
-			slot->tts_isnull[i] = true;
+			col = state->rdfTable->cols[i];
+			break;
 		}
 	}
 
-	// MemoryContextSwitchTo(old_cxt);
-	// MemoryContextDelete(tmp_cxt);
+	if (!col || !col->pushable || col->expression)
+		return NULL;
+
+	term = DeparseBindableTerm(state, baserel, col, constant);
 
-	ExecStoreVirtualTuple(slot);
+	if (!term)
+		return NULL;
 
-	elog(DEBUG3, "%s exit", __func__);
+	return psprintf("VALUES %s { %s }", col->sparqlvar, term);
 }
 
-/*
- * DatumToString
- * -------------
- * Converts a 'Datum' into a char*.
+/*
+ * DeparseBindableTerm
+ * -------------------
+ * Converts a constant compared with a column into an RDF term that can be
+ * bound to the column's variable in a VALUES block, i.e. an IRI or a plain
+ * literal for rdfnode columns, or an IRI for columns with nodetype 'iri'.
  *
- * datum: Data to be converted to char*
- * type : Oid of the data type to be converted
+ * state   : SPARQL, SERVER and FOREIGN TABLE info
+ * baserel : foreign table being scanned
+ * col     : column the constant is compared with
+ * constant: value of the condition
  *
- * returns a char* with the string representation of a Datum or an empty string.
+ * returns the RDF term, or NULL if the constant cannot be bound
  */
-static char *DatumToString(Datum datum, Oid type)
+static char *DeparseBindableTerm(struct RDFfdwState *state, RelOptInfo *baserel, struct RDFfdwColumn *col, Const *constant)
 {
-	StringInfoData result;
-	regproc typoutput;
-	HeapTuple tuple;
-	char *str;
-	text *t;
+	char *value;
+	char *term;
 
-	if (type == RDFNODEOID)
-		elog(DEBUG3, "%s called: type='(RDFNODEOID)' ", __func__);
-	else
-		elog(DEBUG3, "%s called: type='%u' ", __func__, type);
+	if (constant->constisnull)
+		return NULL;
 
-	/* get the type's output function */
-	tuple = SearchSysCache1(TYPEOID, ObjectIdGetDatum(type));
-	if (!HeapTupleIsValid(tuple))
-	{
-		elog(ERROR, "%s: cache lookup failed for type %u", __func__, type);
-	}
-	typoutput = ((Form_pg_type)GETSTRUCT(tuple))->typoutput;
-	ReleaseSysCache(tuple);
+	value = DatumToString(constant->constvalue, constant->consttype);
 
-	initStringInfo(&result);
-	if (type == RDFNODEOID)
+	if (!value)
+		return NULL;
+
+	if (col->pgtype == RDFNODEOID && constant->consttype == RDFNODEOID)
 	{
-		str = DatumGetCString(OidFunctionCall1(typoutput, datum));
-		appendStringInfo(&result, "%s", str);
+		if (isIRI(value))
+			term = value;
+		else if (isLiteral(value) && isPlainLiteral(value))
+			term = DeparseExpr(state, baserel, (Expr *)constant);
+		else
+			return NULL;
 	}
+	else if (IsStringDataType(col->pgtype) && IsStringDataType(constant->consttype) &&
+			 col->nodetype && strcmp(col->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0)
+		term = isIRI(value) ? value : psprintf("<%s>", value);
 	else
-		switch (type)
-		{
-		case TEXTOID:
-		case CHAROID:
-		case BPCHAROID:
-		case VARCHAROID:
-		case NAMEOID:
-		case UUIDOID:
-		case INT8OID:
-		case INT2OID:
-		case INT4OID:
-		case OIDOID:
-		case FLOAT4OID:
-		case FLOAT8OID:
-		case NUMERICOID:
-			str = DatumGetCString(OidFunctionCall1(typoutput, datum));
-			appendStringInfo(&result, "%s", str);
-			break;
-		case DATEOID:
-			t = DatumGetTextP(DirectFunctionCall1(date_to_rdfnode, datum));
-			appendStringInfo(&result, "%s", text_to_cstring(t));
-			break;
-		case TIMEOID:
-			t = DatumGetTextP(DirectFunctionCall1(time_to_rdfnode, datum));
-			appendStringInfo(&result, "%s", text_to_cstring(t));
-			break;
-		case TIMETZOID:
-			t = DatumGetTextP(DirectFunctionCall1(timetz_to_rdfnode, datum));
-			appendStringInfo(&result, "%s", text_to_cstring(t));
-			break;
-		case TIMESTAMPOID:
-			t = DatumGetTextP(DirectFunctionCall1(timestamp_to_rdfnode, datum));
-			appendStringInfo(&result, "%s", text_to_cstring(t));
-			break;
-		case TIMESTAMPTZOID:
-			t = DatumGetTextP(DirectFunctionCall1(timestamptz_to_rdfnode, datum));
-			appendStringInfo(&result, "%s", text_to_cstring(t));
-			break;
-		case BOOLOID:
-			t = DatumGetTextP(DirectFunctionCall1(boolean_to_rdfnode, datum));
-			appendStringInfo(&result, "%s", text_to_cstring(t));
-			break;
-		default:
-			elog(DEBUG1, "%s exit: returning NULL (unknown data type)", __func__);
-			return NULL;
-		}
+		return NULL;
 
-	elog(DEBUG3, "%s exit: returning '%s'", __func__, result.data);
-	return result.data;
+	if (!term || (isIRI(term) && !IsSPARQLIRIRef(term)))
+		return NULL;
+
+	return term;
 }
 
 /*
- * DeparseExpr
- * -----------
- * Deparses SQL expressions and converts them into SPARQL expressions
+ * CompareTerms
+ * ------------
+ * qsort comparator of RDF terms, used to remove duplicates from IN lists.
+ */
+static int CompareTerms(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/*
+ * DeparseValuesList
+ * -----------------
+ * Converts an IN list with at least 'values_threshold' elements, e.g.
+ * film IN ('<http://ex.org/f1>', '<http://ex.org/f2>'), into VALUES blocks
+ * that bind the column's variable to its elements, instead of a FILTER
+ * with a long IN expression. Duplicate elements are removed, as every row
+ * of a VALUES block produces its own solutions.
  *
- * state     : SPARQL, SERVER and FOREIGN TABLE info
- * foreignrel: Conditions and columns used in the SQL query
- * expr      : Expression to be deparsed
+ * If 'split' is set, the elements are split into blocks of at most
+ * 'max_values_size' bytes, each of which is sent in a request of its own,
+ * see SendValuesChunk(). As in DeparseTermBinding(), only IRIs and plain
+ * literals can be bound.
  *
- * returns a string containing a SPARQL expression or NULL if not parseable
+ * state  : SPARQL, SERVER and FOREIGN TABLE info
+ * baserel: foreign table being scanned
+ * expr   : condition of the SQL WHERE clause
+ * split  : whether the elements may be split into several blocks
+ *
+ * returns a list of VALUES blocks, or NIL if the condition cannot be bound
  */
-static char *DeparseExpr(struct RDFfdwState *state, RelOptInfo *foreignrel, Expr *expr)
+static List *DeparseValuesList(struct RDFfdwState *state, RelOptInfo *baserel, Expr *expr, bool split)
 {
-	char *arg, *opername, *left, *right, oprkind;
-	Const *constant;
-	OpExpr *oper;
-	ScalarArrayOpExpr *arrayoper;
+	ScalarArrayOpExpr *arrayoper = (ScalarArrayOpExpr *)expr;
+	struct RDFfdwColumn *col = NULL;
+	Expr *left;
+	Expr *right;
 	Var *variable;
-	HeapTuple tuple;
-	StringInfoData result;
-	Oid leftargtype, rightargtype;
-	int index;
-	ArrayExpr *array;
-	ArrayCoerceExpr *arraycoerce;
-	Expr *rightexpr;
-	Expr *leftexpr;
-	bool first_arg, isNull;
+	Const *constant;
+	ArrayType *arr;
 	ArrayIterator iterator;
 	Datum datum;
-	ListCell *cell;
-	BooleanTest *btest;
-	BoolExpr *boolexpr;
-	FuncExpr *func;
-	struct RDFfdwColumn *col = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
+	bool isnull;
+	char *opername;
+	char **terms;
+	int nterms = 0;
+	int nelems;
+	List *result;
 
-	elog(DEBUG2, "%s called:  expr->type='%u'", __func__, expr->type);
+	if (!IsA(expr, ScalarArrayOpExpr) || !arrayoper->useOr || list_length(arrayoper->args) != 2)
+		return NIL;
 
-	if (expr == NULL)
-	{
-		elog(DEBUG2, "%s: returning NULL (expr is NULL)", __func__);
-		return NULL;
-	}
+	opername = get_opname(arrayoper->opno);
 
-	switch (nodeTag(expr))
-	{
-	case T_Const:
-		elog(DEBUG2, "%s [T_Const] called: expr->type=%u", __func__, expr->type);
-		constant = (Const *)expr;
-		if (constant->constisnull)
-		{
-			elog(DEBUG2, "%s [T_Const]: returning NULL (constant is NULL)", __func__);
-			return NULL;
-		}
-		else
-		{
-			/* get a string representation of the value */
-			char *c = DatumToString(constant->constvalue, constant->consttype);
-			if (c == NULL)
-			{
-				elog(DEBUG2, "%s [T_Const]: returning NULL (DatumToString returned NULL)", __func__);
-				return NULL;
-			}
-			else
-			{
-				char *l = lang(c);
-				char *dt = datatype(c);
-				char *lex_str = lex(c);
-				bool needs_escaping = false;
+	if (!opername || strcmp(opername, "=") != 0)
+		return NIL;
 
-				/* Check if the lexical value contains control characters that need escaping */
-				for (const char *p = lex_str; *p; p++)
-				{
-					if (*p == '\n' || *p == '\r' || *p == '\t')
-					{
-						needs_escaping = true;
-						break;
-					}
-				}
+#if PG_VERSION_NUM >= 120000
+	/* case insensitive collations would match other IRIs than the given ones */
+	if (OidIsValid(arrayoper->inputcollid) && !get_collation_isdeterministic(arrayoper->inputcollid))
+		return NIL;
+#endif
 
-				/* Escape control characters in the lexical value if needed */
-				if (needs_escaping)
-					lex_str = EscapeSPARQLLiteral(c);
+	left = (Expr *)linitial(arrayoper->args);
+	right = (Expr *)lsecond(arrayoper->args);
 
-				initStringInfo(&result);
+	if (IsA(left, RelabelType))
+		left = ((RelabelType *)left)->arg;
 
-				if (strlen(l) != 0)
-					appendStringInfo(&result, "%s", strlang(lex_str, l));
-				else if (strstr(c, "\"^^"))
-					appendStringInfo(&result, "%s", strdt(lex_str, dt));
-				else
-					appendStringInfo(&result, "%s", lex_str);
-			}
-		}
-		elog(DEBUG2, "%s [T_Const]: reached end of block with result='%s'", __func__, result.data);
-		break;
-	case T_Var:
+	if (!IsA(left, Var) || !IsA(right, Const))
+		return NIL;
 
-		elog(DEBUG2, "%s [T_Var]: start (expr->type='%u')", __func__, expr->type);
-		variable = (Var *)expr;
+	variable = (Var *)left;
+	constant = (Const *)right;
 
-		if (variable->vartype == BOOLOID)
+	if (variable->varno != baserel->relid || constant->constisnull)
+		return NIL;
+
+	for (int i = 0; i < state->numcols; i++)
+	{
+		if (state->rdfTable->cols[i]->pgattnum == variable->varattno)
 		{
-			elog(DEBUG2, "%s [T_Var]: returning NULL (variable type is a BOOLOID)", __func__);
-			return NULL;
+			col = state->rdfTable->cols[i];
+			break;
 		}
+	}
 
-		index = state->numcols - 1;
+	if (!col || !col->pushable || col->expression)
+		return NIL;
 
-		while (index >= 0 && state->rdfTable->cols[index]->pgattnum != variable->varattno)
-			--index;
+	arr = DatumGetArrayTypeP(constant->constvalue);
+	nelems = ArrayGetNItems(ARR_NDIM(arr), ARR_DIMS(arr));
 
-		/* if no foreign table column is found, return NULL */
-		if (index == -1)
+	if (nelems < state->values_threshold)
+		return NIL;
+
+	terms = (char **)palloc(sizeof(char *) * nelems);
+	iterator = array_create_iterator(arr, 0);
+
+	while (array_iterate(iterator, &datum, &isnull))
+	{
+		Const *element;
+		char *term;
+
+		/* NULL elements never match */
+		if (isnull)
+			continue;
+
+		element = makeConst(ARR_ELEMTYPE(arr), -1, constant->constcollid, -1, datum, false, false);
+		term = DeparseBindableTerm(state, baserel, col, element);
+
+		if (!term)
 		{
-			elog(DEBUG1, "%s [T_Var]: returning NULL (no table column found)", __func__);
-			return NULL;
+			array_free_iterator(iterator);
+			return NIL;
 		}
 
-		initStringInfo(&result);
-		appendStringInfo(&result, "%s", state->rdfTable->cols[index]->name);
+		terms[nterms++] = term;
+	}
 
-		elog(DEBUG2, "  %s [T_Var]: index='%d', result='%s'", __func__,
-			 index, state->rdfTable->cols[index]->name);
+	array_free_iterator(iterator);
 
-		break;
-	case T_BoolExpr:
-		boolexpr = (BoolExpr *) expr;
+	if (nterms == 0)
+		return NIL;
 
-		if (boolexpr->boolop == NOT_EXPR)
-		{
-			/* NOT always has exactly one argument */
-			char *inner = DeparseExpr(state, foreignrel,
-									(Expr *) linitial(boolexpr->args));
+	result = DeparseValuesBlocks(state, col->sparqlvar, terms, nterms, split);
 
-			/* if the inner expression is not pushable, neither is the NOT */
-			if (inner == NULL)
-				return NULL;
+	elog(DEBUG2, "%s: %d elements of %s bound in %d VALUES blocks", __func__, nterms, col->sparqlvar, list_length(result));
 
-			return psprintf("(!%s)", inner);
-		}
+	return result;
+}
 
-		/* Todo: OR_EXPR and AND_EXPR will be added here in the future */
-		return NULL;
-	case T_OpExpr:
-		elog(DEBUG2, "%s [T_OpExpr]: start (expr->type='%u')", __func__, expr->type);
-		oper = (OpExpr *)expr;
-		initStringInfo(&result);
+/*
+ * DeparseValuesBlocks
+ * -------------------
+ * Creates the VALUES blocks binding 'sparqlvar' to the given RDF terms, in
+ * the order of CompareTerms() and without duplicates. If 'split' is set, the
+ * terms are split into blocks of at most 'max_values_size' bytes.
+ *
+ * state    : SPARQL, SERVER and FOREIGN TABLE info
+ * sparqlvar: SPARQL variable bound by the blocks, e.g. "?s"
+ * terms    : RDF terms, sorted in place
+ * nterms   : number of elements of 'terms'
+ * split    : whether the terms may be split into several blocks
+ *
+ * returns a list of VALUES blocks
+ */
+static List *DeparseValuesBlocks(struct RDFfdwState *state, const char *sparqlvar, char **terms, int nterms, bool split)
+{
+	List *result = NIL;
+	StringInfoData values;
 
-		tuple = SearchSysCache1(OPEROID, ObjectIdGetDatum(oper->opno));
-		if (!HeapTupleIsValid(tuple))
-		{
-			elog(ERROR, "cache lookup failed for operator %u", oper->opno);
-		}
-		opername = pstrdup(((Form_pg_operator)GETSTRUCT(tuple))->oprname.data);
-		oprkind = ((Form_pg_operator)GETSTRUCT(tuple))->oprkind;
-		leftargtype = ((Form_pg_operator)GETSTRUCT(tuple))->oprleft;
-		rightargtype = ((Form_pg_operator)GETSTRUCT(tuple))->oprright;
-		ReleaseSysCache(tuple);
+	qsort(terms, nterms, sizeof(char *), CompareTerms);
 
-		/* don't push condition down if the right argument can't be translated into a SPARQL value*/
-		if (!canHandleType(rightargtype))
-		{
-			elog(DEBUG2, "%s [T_OpExpr]: returning NULL: cannot handle data type", __func__);
-			return NULL;
-		}
+	initStringInfo(&values);
 
-		/* the operators that we can translate */
-		if (strcmp(opername, "=") == 0 ||
-			(strcmp(opername, ">") == 0 && rightargtype != TEXTOID && rightargtype != BPCHAROID && rightargtype != NAMEOID && rightargtype != CHAROID) ||
-			(strcmp(opername, "<") == 0 && rightargtype != TEXTOID && rightargtype != BPCHAROID && rightargtype != NAMEOID && rightargtype != CHAROID) ||
-			(strcmp(opername, ">=") == 0 && rightargtype != TEXTOID && rightargtype != BPCHAROID && rightargtype != NAMEOID && rightargtype != CHAROID) ||
-			(strcmp(opername, "<=") == 0 && rightargtype != TEXTOID && rightargtype != BPCHAROID && rightargtype != NAMEOID && rightargtype != CHAROID) ||
-			strcmp(opername, "+") == 0 ||
-			strcmp(opername, "*") == 0 ||
-			strcmp(opername, "!=") == 0 ||
-			strcmp(opername, "<>") == 0 ||
-			strcmp(opername, "~~") == 0 ||
-			strcmp(opername, "!~~") == 0 ||
-			strcmp(opername, "~~*") == 0 ||
-			strcmp(opername, "!~~*") == 0)
-		{
-			/* SPARQL does not negate with <> */
-			if (strcmp(opername, "<>") == 0)
-				opername = "!=";
+	for (int i = 0; i < nterms; i++)
+	{
+		if (i > 0 && strcmp(terms[i], terms[i - 1]) == 0)
+			continue;
 
-			elog(DEBUG2, "%s [T_OpExpr]: deparsing operand of left expression", __func__);
-			left = DeparseExpr(state, foreignrel, linitial(oper->args));
-			elog(DEBUG2, "%s [T_OpExpr]: left operand returned => %s", __func__, left);
+		/* close the current block if the next term would exceed max_values_size */
+		if (split && values.len > 0 && state->max_values_size > 0 &&
+			(long)(values.len + strlen(terms[i]) + 2) > state->max_values_size)
+		{
+			appendStringInfoString(&values, "}");
+			result = lappend(result, values.data);
+			initStringInfo(&values);
+		}
 
-			if (left == NULL)
-			{
-				elog(DEBUG2, "%s [T_OpExpr]: returning NULL (left argument couldn't be deparsed)", __func__);
-				return NULL;
-			}
+		if (values.len == 0)
+			appendStringInfo(&values, "VALUES %s { ", sparqlvar);
 
-			if (oprkind == 'b')
-			{
-				StringInfoData left_filter_arg;
-				StringInfoData right_filter_arg;
-				struct RDFfdwColumn *right_column = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
-				struct RDFfdwColumn *left_column = (struct RDFfdwColumn *)palloc0(sizeof(struct RDFfdwColumn));
+		appendStringInfo(&values, "%s ", terms[i]);
+	}
 
-				elog(DEBUG2, "  %s [T_OpExpr]: deparsing left and right expressions", __func__);
-				leftexpr = linitial(oper->args);
-				rightexpr = lsecond(oper->args);
+	appendStringInfoString(&values, "}");
+	result = lappend(result, values.data);
 
-				elog(DEBUG2, "  %s [T_OpExpr]: deparsing operand of right expression, type %u", __func__, rightexpr->type);
-				right = DeparseExpr(state, foreignrel, rightexpr);
+	return result;
+}
 
-				elog(DEBUG2, "  %s [T_OpExpr]: [%s] left type %u, [%s] right type %u", __func__, left, leftexpr->type, right, rightexpr->type);
+/*
+ * DeparseSQLWhereConditions
+ * ----------------------
+ * Deparses the WHERE clause of SQL queries and tries to convert its conditions into
+ * SPARQL FILTER expressions.
+ *
+ * Equalities and IN lists can instead be bound in VALUES blocks at the top
+ * of the graph pattern, see DeparseTermBinding() and DeparseValuesList().
+ *
+ * state  : SPARQL, SERVER and FOREIGN TABLE info
+ * baserel: Conditions and columns used in the SQL query
+ * root   : planner info of the query, used to decide if an IN list can be
+ *          sent in several requests
+ *
+ * returns char* containing SPARQL FILTER expressions or an empty string if not applicable
+ */
+static char *DeparseSQLWhereConditions(struct RDFfdwState *state, RelOptInfo *baserel, PlannerInfo *root)
+{
+	List *conditions = baserel->baserestrictinfo;
+	ListCell *cell;
+	StringInfoData where_clause;
+	StringInfoData filter_expr;
+	StringInfoData values;
+	bool bind_terms;
+	bool flat_pattern;
+	bool splittable;
 
-				if (right == NULL)
-				{
-					elog(DEBUG2, "%s [T_OpExpr]: returning NULL (right argument couldn't be deparsed)", __func__);
-					return NULL;
-				}
+	elog(DEBUG1, "%s called", __func__);
 
-				initStringInfo(&left_filter_arg);
-				initStringInfo(&right_filter_arg);
+	initStringInfo(&where_clause);
+	initStringInfo(&filter_expr);
+	initStringInfo(&values);
 
-				left_column = GetRDFColumn(state, left);
+	/*
+	 * Terms are only bound in flat basic graph patterns. A variable that may
+	 * be unbound (OPTIONAL, UNION, ...) would take the value of the VALUES
+	 * block instead of discarding the solution, and BIND cannot assign a
+	 * variable that is already in scope.
+	 */
+	flat_pattern = !state->sparql_query->has_groups && !state->sparql_query->has_bind &&
+				   !SPARQLQueryNeedsSubquery(state->sparql_query);
+	bind_terms = state->enable_term_binding && flat_pattern;
 
-				if (leftexpr->type == T_Var && (!left_column || !left_column->pushable))
-				{
-					elog(DEBUG2, "%s [T_OpExpr]: returning NULL (column of left argument is invalid or not pushable)", __func__);
-					return NULL;
-				}
+	/*
+	 * The results of the requests of a split IN list are concatenated, which
+	 * is only correct if no LIMIT, ORDER BY, DISTINCT, aggregate or join is
+	 * pushed down. Otherwise the whole list is sent in a single request.
+	 */
+	splittable = root != NULL && root->parse->commandType == CMD_SELECT &&
+				 bms_membership(root->all_baserels) == BMS_SINGLETON &&
+				 root->parse->limitCount == NULL && root->parse->limitOffset == NULL &&
+				 root->parse->sortClause == NIL && root->parse->distinctClause == NIL &&
+				 root->parse->groupClause == NIL && !root->parse->hasAggs &&
+				 DeparseSPARQLModifier(state) == NULL;
 
-				elog(DEBUG2, "%s [T_OpExpr]: getting right column based on '%s' ... ", __func__, right);
-				right_column = GetRDFColumn(state, right);
+	/*
+	 * DO NOT initialize remote_conds here!
+	 * It should remain NULL for non-parsable queries.
+	 * Only initialize when we actually have pushable conditions.
+	 */
 
-				if (rightexpr->type == T_Var && (!right_column || !right_column->pushable))
-				{
-					elog(DEBUG2, "%s [T_OpExpr]: returning NULL (column of right argument is invalid or not pushable)", __func__);
-					return NULL;
-				}
+	foreach (cell, conditions)
+	{
+		RestrictInfo *ri = (RestrictInfo *)lfirst(cell);
+		char *where;
 
-				/* if the column contains an expression we use it in all FILTER expressions*/
-				if (left_column && left_column->expression)
-				{
-					elog(DEBUG2, "%s [T_OpExpr]: adding expression '%s' for left expression", __func__, left_column->expression);
-					appendStringInfo(&left_filter_arg, "%s", left_column->expression);
-				}
-				/* check if the argument is a string (T_Const) */
-				else if (IsStringDataType(leftargtype) && leftexpr->type == T_Const)
-				{
-					if (right_column)
-					{
-						/*
-						 * if the argument is a IRI/URI we must wrap it with IRI(), so that it
-						 * can be handled as such in the FILTER expressions.
-						 */
-						if (right_column->nodetype && strcmp(right_column->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0)
-							appendStringInfo(&left_filter_arg, "IRI(\"%s\")", left);
-						else if (right_column->language)
-						{
-							if (strcmp(right_column->language, "*") == 0)
-								appendStringInfo(&left_filter_arg, "%s", cstring_to_rdfliteral(left));
-							else
-								appendStringInfo(&left_filter_arg, "%s", strlang(left, right_column->language));
-						}
-						else if (right_column->literaltype)
-							appendStringInfo(&left_filter_arg, "%s", strdt(left, right_column->literaltype));
-						else if (isIRI(left) || isBlank(left))
-							appendStringInfo(&left_filter_arg, "%s", left);
-						else
-							appendStringInfo(&left_filter_arg, "%s", cstring_to_rdfliteral(left));
-					}
-					else if (isIRI(left))
-						appendStringInfo(&left_filter_arg, "%s", left);
-					else
-					{
-						char *xsd_type = MapSPARQLDatatype(leftargtype);
-						char *literal = cstring_to_rdfliteral(left);
+		List *chunks = NIL;
 
-						if (xsd_type && isPlainLiteral(literal) && rightargtype == RDFNODEOID)
-							appendStringInfo(&left_filter_arg, "%s^^<%s%s>",
-											 literal,
-											 RDF_XSD_BASE_URI,
-											 MapSPARQLDatatype(leftargtype));
-						else
-							appendStringInfo(&left_filter_arg, "%s", cstring_to_rdfliteral(left));
-					}
-				}
-				/* check if the argument is a column */
-				else if (left_column && leftexpr->type == T_Var)
-				{
-					/*
-					 * we wrap the column name (sparqlvar) with STR() if the column's language
-					 * is set to * (all languages)
-					 */
-					if (left_column->language && strcmp(left_column->language, "*") == 0)
-						appendStringInfo(&left_filter_arg, "STR(%s)", left_column->sparqlvar);
-					/* set the sparqlvar to the FILTER expression */
-					else
-						appendStringInfo(&left_filter_arg, "%s", left_column->sparqlvar);
-				}
-				else if (leftexpr->type == T_FuncExpr)
-				{
-					/* We try to resolve the column name <-> sparql variable one last time */
-					left_column = GetRDFColumn(state, left);
+		/* bind the term in the graph pattern instead of filtering it */
+		char *binding = bind_terms ? DeparseTermBinding(state, baserel, ri->clause) : NULL;
 
-					if (left_column)
-						appendStringInfo(&left_filter_arg, "%s", left_column->sparqlvar);
-					else
-						appendStringInfo(&left_filter_arg, "%s", left);
-				}
-				else
-				{
-					appendStringInfo(&left_filter_arg, "%s", left);
-				}
+		if (binding != NULL)
+		{
+			appendStringInfo(&values, "%s\n", binding);
+			state->remote_conds = lappend(state->remote_conds, ri);
+			continue;
+		}
 
-				/* if the column contains an expression we use it in all FILTER expressions*/
-				if (right_column && right_column->expression)
-				{
-					elog(DEBUG2, "%s [T_OpExpr]: adding expression '%s' for left expression", __func__, right_column->expression);
-					appendStringInfo(&right_filter_arg, "%s", right_column->expression);
-				}
-				/* check if the argument is a string (T_Const) */
-				else if (IsStringDataType(rightargtype) && rightexpr->type == T_Const)
-				{
-					if (left_column)
-					{
-						if (left_column->nodetype && strcmp(left_column->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0)
-							appendStringInfo(&right_filter_arg, "IRI(\"%s\")", right);
-						else if (left_column->language)
-						{
-							if (strcmp(left_column->language, "*") == 0)
-								appendStringInfo(&right_filter_arg, "%s", cstring_to_rdfliteral(right));
-							else
-								appendStringInfo(&right_filter_arg, "%s", strlang(right, left_column->language));
-						}
-						else if (left_column->literaltype)
-							appendStringInfo(&right_filter_arg, "%s", strdt(right, left_column->literaltype));
-						else if (isIRI(right) || isBlank(right))
-							appendStringInfo(&right_filter_arg, "%s", right);
-						else
-						{
+		/*
+		 * Large IN lists are bound in VALUES blocks as well. Only one of them
+		 * can be split, as the results of the requests are concatenated.
+		 */
+		if (state->values_threshold > 0 && flat_pattern)
+			chunks = DeparseValuesList(state, baserel, ri->clause, splittable && state->values_chunks == NIL);
 
-							appendStringInfo(&right_filter_arg, "%s", cstring_to_rdfliteral(right));
-						}
-					}
-					else if (isIRI(right))
-						appendStringInfo(&right_filter_arg, "%s", right);
-					else
-					{
-						char *xsd_type = MapSPARQLDatatype(rightargtype);
-						char *literal = cstring_to_rdfliteral(right);
+		if (chunks != NIL)
+		{
+			if (list_length(chunks) > 1)
+			{
+				state->values_chunks = chunks;
+				appendStringInfo(&values, "%s\n", RDF_SPARQL_VALUES_MARKER);
+			}
+			else
+				appendStringInfo(&values, "%s\n", (char *)linitial(chunks));
 
-						if (xsd_type && isPlainLiteral(literal) && leftargtype == RDFNODEOID)
-							appendStringInfo(&right_filter_arg, "%s^^<%s%s>",
-											 literal,
-											 RDF_XSD_BASE_URI,
-											 MapSPARQLDatatype(rightargtype));
-						else
-							appendStringInfo(&right_filter_arg, "%s", cstring_to_rdfliteral(right));
-					}
-				}
-				else if (rightexpr->type == T_Var)
-				{
-					if (right_column && right_column->language && strcmp(right_column->language, "*") == 0)
-						appendStringInfo(&right_filter_arg, "STR(%s)", right_column->sparqlvar);
-					else
-						appendStringInfo(&right_filter_arg, "%s", right_column->sparqlvar);
-				}
-				else if (rightexpr->type == T_FuncExpr)
-				{
-					/* We try to resolve the column name <-> sparql variable one last time */
-					right_column = GetRDFColumn(state, right);
+			state->remote_conds = lappend(state->remote_conds, ri);
+			continue;
+		}
 
-					if (right_column)
-						appendStringInfo(&right_filter_arg, "%s", right_column->sparqlvar);
-					else
-						appendStringInfo(&right_filter_arg, "%s", right);
-				}
-				else
-					appendStringInfo(&right_filter_arg, "%s", right);
+		/* deparse expression for pushdown */
+		where = DeparseExpr(state, baserel, ri->clause);
 
-				elog(DEBUG2, "  %s [T_OpExpr]: left argument converted: '%s' => '%s'", __func__, left, NameStr(left_filter_arg));
-				elog(DEBUG2, "  %s [T_OpExpr]: oper  => '%s'", __func__, opername);
-				elog(DEBUG2, "  %s [T_OpExpr]: right argument converted: '%s' => '%s'", __func__, right, NameStr(right_filter_arg));
+		if (where != NULL)
+		{
+			/* Initialize remote_conds list on first pushable condition */
+			if (state->remote_conds == NULL)
+				state->remote_conds = NIL;
 
-				if (strcmp(opername, "~~") == 0 || strcmp(opername, "~~*") == 0 || strcmp(opername, "!~~") == 0 || strcmp(opername, "!~~*") == 0)
-				{
-					/*
-					 * If the left and right side arguments are not respectively T_Var and
-					 * T_Const it is not safe to push down the REGEX FILTER. We then let
-					 * the client to deal with it.
-					 */
-					if (leftexpr->type != T_Var && rightexpr->type != T_Const)
-					{
-						elog(DEBUG2, "%s [T_OpExpr]: returning NULL (type of left expression is not a T_Var and the right expression is not a T_Const)", __func__);
-						return NULL;
-					}
+			/* append new FILTER clause to query string */
+			appendStringInfo(&where_clause, " FILTER(%s)\n", pstrdup(where));
 
-					appendStringInfo(&result, "%s(%s,\"%s\"%s)",
-									 opername[0] == '!' ? "!REGEX" : "REGEX",
-									 NameStr(left_filter_arg),
-									 CreateRegexString(right),
-									 strcmp(opername, "~~*") == 0 || strcmp(opername, "!~~*") == 0 ? ",\"i\"" : "");
-				}
-				else
-				{
-					appendStringInfo(&result, "%s %s %s",
-									 NameStr(left_filter_arg),
-									 opername,
-									 NameStr(right_filter_arg));
-				}
-			}
+			if (filter_expr.len > 0)
+				appendStringInfo(&filter_expr, " && (%s)", pstrdup(where));
 			else
-			{
-				elog(DEBUG2, "  %s [T_OpExpr]: unary operator not supported", __func__);
-			}
+				appendStringInfo(&filter_expr, "((%s)", pstrdup(where));
+
+			/* Track this RestrictInfo as successfully pushed down */
+			state->remote_conds = lappend(state->remote_conds, ri);
+
+			pfree(where);
 		}
 		else
 		{
-			elog(DEBUG2, "  %s exit [T_OpExpr]: returning NULL (operator cannot be translated '%s')", __func__, opername);
-			return NULL;
+			state->has_unparsable_conds = true;
+			elog(DEBUG1, "  %s: condition cannot be pushed down.", __func__);
 		}
+	}
 
-		break;
-	case T_BooleanTest:
-		elog(DEBUG2, "%s [T_BooleanTest]: start (expr->type='%u')", __func__, expr->type);
-		btest = (BooleanTest *)expr;
+	if (filter_expr.len > 0)
+		appendStringInfo(&filter_expr, ")");
 
-		if (btest->arg->type != T_Var)
-		{
-			elog(DEBUG2, "  %s exit [T_BooleanTest]: returning NULL (argument type is not a T_Var)", __func__);
-			return NULL;
-		}
+	state->sparql_filter_expr = filter_expr.data;
 
-		variable = (Var *)btest->arg;
+	/* VALUES blocks go at the top of the graph pattern */
+	if (values.len > 0)
+	{
+		state->sparql_values = values.data;
+		state->sparql_where = psprintf("%s%s", values.data, state->sparql_where);
+	}
 
-		index = state->numcols - 1;
-		while (index >= 0 && state->rdfTable->cols[index]->pgattnum != variable->varattno)
-			--index;
+	elog(DEBUG1, "%s exit: returning '%s'", __func__, where_clause.data);
+	return where_clause.data;
+}
 
-		arg = state->rdfTable->cols[index]->name;
+/*
+ * DeparseSPARQLWhereGraphPattern
+ * -------------------------------
+ * Extracts the graph pattern from the raw SPARQL WHERE clause supplied in the
+ * foreign table definition, stripping the surrounding curly braces so that
+ * rdf_fdw can inject additional FILTER expressions alongside it. If the
+ * query contains solution modifiers or aggregates, the whole query is
+ * returned as a sub-select, so that the FILTER expressions, ORDER BY and
+ * LIMIT are applied to its solutions.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns char* containing the bare WHERE graph pattern
+ */
+static char *DeparseSPARQLWhereGraphPattern(struct RDFfdwState *state)
+{
+	int where_position = -1;
+	int where_size = -1;
+	char *result;
 
-		if (arg == NULL)
+	elog(DEBUG1, "%s called", __func__);
+
+	if (state->sparql_query && (result = SPARQLDeparseGroupPattern(state->sparql_query)) != NULL)
+	{
+		elog(DEBUG1, "%s exit: returning '%s'", __func__, result);
+		return result;
+	}
+
+	/*
+	 * The query could not be parsed, so it is sent as is. We still take
+	 * whatever is between the outermost curly braces, as it is used in
+	 * the EXPLAIN output.
+	 */
+	for (int i = 0; state->raw_sparql[i] != '\0'; i++)
+	{
+		if (state->raw_sparql[i] == '{' && where_position == -1)
+			where_position = i + 1;
+
+		if (state->raw_sparql[i] == '}')
+			where_size = i - where_position;
+	}
+
+	result = pnstrdup(state->raw_sparql + where_position, where_size);
+
+	elog(DEBUG1, "%s exit: returning '%s'", __func__, result);
+	return result;
+}
+
+/*
+ * DeparseSQLOrderBy
+ * -----------------
+ * Deparses pathkeys, e.g. the SQL ORDER BY clause of the query, into a SPARQL
+ * ORDER BY clause. All pathkeys must be pushable, otherwise none is used.
+ *
+ * state   : SPARQL, SERVER and FOREIGN TABLE info
+ * baserel : Conditions and columns used in the SQL query
+ * pathkeys: sort order to be deparsed
+ *
+ * returns char* containg a SPARQL ORDER BY clause or an empty string if not applicable
+ */
+static char *DeparseSQLOrderBy(struct RDFfdwState *state, RelOptInfo *baserel, List *pathkeys)
+{
+	StringInfoData orderedquery;
+	List *usable_pathkeys = NIL;
+	ListCell *cell;
+	char *delim = " ";
+
+	elog(DEBUG1, "%s called", __func__);
+
+	initStringInfo(&orderedquery);
+
+	foreach (cell, pathkeys)
+	{
+		PathKey *pathkey = (PathKey *)lfirst(cell);
+		EquivalenceClass *pathkey_ec = pathkey->pk_eclass;
+		EquivalenceMember *em = NULL;
+		Expr *em_expr = NULL;
+		char *sort_clause;
+		Oid em_type;
+		bool can_pushdown;
+
+		/* ec_has_volatile saves some cycles */
+		if (pathkey_ec->ec_has_volatile)
 		{
-			elog(DEBUG1, "  %s exit [T_BooleanTest]: returning NULL (column name is not valid)", __func__);
+			elog(DEBUG1, "%s exit: returning NULL (pathkey_ec->ec_has_volatile)", __func__);
 			return NULL;
 		}
 
-		col = GetRDFColumn(state, arg);
+		/*
+		 * Find an EC member that can be used to sort the relation remotely
+		 * according to a pathkey using this EC.
+		 */
+		em = GetEquivalenceMember(pathkey_ec, baserel);
 
-		if (!col)
+		if (em == NULL)
 		{
-			elog(DEBUG2, "  %s exit [T_BooleanTest]: returning NULL (column not found)", __func__);
+			elog(DEBUG1, "%s exit: returning NULL (EquivalenceMember is NULL)", __func__);
 			return NULL;
 		}
 
-		if (!col->pushable)
+		em_expr = em->em_expr;
+		em_type = exprType((Node *)em_expr);
+
+		/*
+		 * SPARQL does not support sorting with functions, so it is not safe to
+		 * push down anything other than T_Var.
+		 */
+
+		can_pushdown = (em_expr->type == T_Var) && canHandleType(em_type);
+
+		elog(DEBUG1, "  %s: can push down > %d", __func__, can_pushdown);
+
+		if (can_pushdown && ((sort_clause = DeparseExpr(state, baserel, em_expr)) != NULL))
 		{
-			elog(DEBUG2, "  %s exit [T_BooleanTest]: returning NULL (column name is not pushable)", __func__);
-			return NULL;
-		}
+			/* keep usable_pathkeys for later use. */
+			usable_pathkeys = lappend(usable_pathkeys, pathkey);
 
-		initStringInfo(&result);
+			/* create orderedquery */
+			appendStringInfoString(&orderedquery, delim);
 
-		switch (btest->booltesttype)
+#if PG_VERSION_NUM >= 180000
+			if (pathkey->pk_cmptype == COMPARE_LT)
+#else
+			if (pathkey->pk_strategy == BTLessStrategyNumber)
+#endif /* PG_VERSION_NUM */
+				appendStringInfo(&orderedquery, " ASC (%s)", (GetRDFColumn(state, sort_clause))->sparqlvar);
+			else
+				appendStringInfo(&orderedquery, " DESC (%s)", (GetRDFColumn(state, sort_clause))->sparqlvar);
+		}
+		else
 		{
-		case IS_TRUE:
-			appendStringInfo(&result, "%s = %s",
-							 col->expression ? col->expression : col->sparqlvar,
-							 !col->literaltype ? "\"true\"" : strdt("true", col->literaltype));
-			break;
-		case IS_NOT_TRUE:
-			appendStringInfo(&result, "%s != %s",
-							 col->expression ? col->expression : col->sparqlvar,
-							 !col->literaltype ? "\"true\"" : strdt("true", col->literaltype));
-			break;
-		case IS_FALSE:
-			appendStringInfo(&result, "%s = %s",
-							 col->expression ? col->expression : col->sparqlvar,
-							 !col->literaltype ? "\"false\"" : strdt("false", col->literaltype));
-			break;
-		case IS_NOT_FALSE:
-			appendStringInfo(&result, "%s != %s",
-							 col->expression ? col->expression : col->sparqlvar,
-							 !col->literaltype ? "\"false\"" : strdt("false", col->literaltype));
+			/*
+			 * Before PostgreSQL v13, the planner and executor don't have
+			 * any clever strategy for taking data sorted by a prefix of the
+			 * query's pathkeys and getting it to be sorted by all of those
+			 * pathekeys.
+			 * So, unless we can push down all of the query pathkeys, forget it.
+			 * This could be improved from v13 on!
+			 */
+
+			elog(DEBUG1, "  %s: cannot push down ORDER BY", __func__);
+			list_free(usable_pathkeys);
+			usable_pathkeys = NIL;
 			break;
-		default:
-			elog(DEBUG2, "  %s exit [T_BooleanTest]: returning NULL (unknown booltesttype)", __func__);
-			return NULL;
 		}
+	}
 
-		break;
-	case T_ScalarArrayOpExpr:
-		elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: start (expr->type='%u')", __func__, expr->type);
-		arrayoper = (ScalarArrayOpExpr *)expr;
+	if (pathkeys != NIL && usable_pathkeys != NIL)
+	{
+		elog(DEBUG1, "%s exit: returning '%s'", __func__, orderedquery.data);
+		return orderedquery.data;
+	}
+	else
+	{
+		elog(DEBUG1, "%s exit: returning NULL (unable to deparse ORDER BY clause)", __func__);
+		return NULL;
+	}
+}
 
-		/* get operator name, left argument type and schema */
-		tuple = SearchSysCache1(OPEROID, ObjectIdGetDatum(arrayoper->opno));
-		if (!HeapTupleIsValid(tuple))
-		{
-			elog(ERROR, "cache lookup failed for operator %u", arrayoper->opno);
-		}
-		opername = pstrdup(((Form_pg_operator)GETSTRUCT(tuple))->oprname.data);
-		leftargtype = ((Form_pg_operator)GETSTRUCT(tuple))->oprleft;
-		ReleaseSysCache(tuple);
+/*
+ * GetEquivalenceMember
+ * --------------------
+ * Finds a member of an EquivalenceClass that only uses Vars of the given
+ * relation. If there is more than one suitable candidate, an arbitrary one
+ * of them is returned.
+ *
+ * ec     : EquivalenceClass of a pathkey
+ * baserel: relation of the FOREIGN TABLE
+ *
+ * returns the EquivalenceMember or NULL if the class has no member of 'baserel'
+ */
+static EquivalenceMember *GetEquivalenceMember(EquivalenceClass *ec, RelOptInfo *baserel)
+{
+	ListCell *cell;
 
-		/* don't try to push down anything but IN and NOT IN expressions */
-		if ((strcmp(opername, "=") != 0 || !arrayoper->useOr) && (strcmp(opername, "<>") != 0 || arrayoper->useOr))
-		{
-			elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (expression in not IN or NOT IN)", __func__);
-			return NULL;
-		}
+	foreach (cell, ec->ec_members)
+	{
+		EquivalenceMember *em = (EquivalenceMember *)lfirst(cell);
 
-		if (!canHandleType(leftargtype))
-		{
-			elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (cannot handle left argument's datatype)", __func__);
-			return NULL;
-		}
+		/*
+		 * Note we require !bms_is_empty, else we'd accept constant
+		 * expressions which are not suitable for the purpose.
+		 */
+		if (bms_is_subset(em->em_relids, baserel->relids) &&
+			!bms_is_empty(em->em_relids))
+			return em;
+	}
 
-		/* the first (=initial) argument can be T_Var or T_Func */
-		leftexpr = (Expr *)linitial(arrayoper->args);
-		left = DeparseExpr(state, foreignrel, leftexpr);
+	return NULL;
+}
 
-		if (left == NULL)
-		{
-			elog(DEBUG1, "%s exit [T_ScalarArrayOpExpr]: returning NULL (left argument couldn't be deparsed)", __func__);
-			return NULL;
-		}
+#if PG_VERSION_NUM >= 90600
+/*
+ * IsSPARQLOrderSafe
+ * -----------------
+ * Checks if the SPARQL ORDER BY created for the given pathkeys returns the
+ * rows in exactly the order PostgreSQL expects, so that the sorted result of
+ * the endpoint can be trusted. This is only the case if:
+ *
+ * - all pathkeys are plain columns, sorted with their default operators,
+ * - SPARQL and PostgreSQL compare the values the same way, i.e. numeric
+ *   columns with a numeric literaltype (e.g. xsd:int), or IRIs and xsd:string
+ *   literals in the "C" collation (code point order), and
+ * - NULL values are in the same place. SPARQL sorts unbound variables first
+ *   in ascending and last in descending order, so other orders are only safe
+ *   for NOT NULL columns.
+ *
+ * rdfnode columns are never safe, as they are sorted by their lexical form
+ * in PostgreSQL (see rdfnode_cmp).
+ *
+ * state   : SPARQL, SERVER and FOREIGN TABLE info
+ * baserel : relation of the FOREIGN TABLE
+ * pathkeys: sort order to be checked
+ *
+ * returns 'true' if the remote sort order can be trusted, or 'false' otherwise
+ */
+static bool IsSPARQLOrderSafe(struct RDFfdwState *state, RelOptInfo *baserel, List *pathkeys)
+{
+	ListCell *cell;
 
-		initStringInfo(&result);
+	if (pathkeys == NIL)
+		return false;
 
-		if (leftexpr->type == T_Var)
-		{
-			elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: left argument's dat type is T_Var (column)", __func__);
-			col = GetRDFColumn(state, left);
+	foreach (cell, pathkeys)
+	{
+		PathKey *pathkey = (PathKey *)lfirst(cell);
+		EquivalenceMember *em = GetEquivalenceMember(pathkey->pk_eclass, baserel);
+		Oid collation = pathkey->pk_eclass->ec_collation;
+		struct RDFfdwColumn *col = NULL;
+		Oid opclass;
+		bool ascending;
+		Var *var;
 
-			if (!col)
-			{
-				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (column of left argument is not valid)", __func__);
-				return NULL;
-			}
+		if (pathkey->pk_eclass->ec_has_volatile || em == NULL || !IsA(em->em_expr, Var))
+			return false;
 
-			if (!col->pushable)
-			{
-				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (column is not pushable)", __func__);
-				return NULL;
-			}
+		var = (Var *)em->em_expr;
 
-			if (strcmp(opername, "=") == 0)
-				appendStringInfo(&result, "%s IN (", !col->expression ? col->sparqlvar : col->expression);
-			else
-				appendStringInfo(&result, "%s NOT IN (", !col->expression ? col->sparqlvar : col->expression);
-		}
-		else if (leftexpr->type == T_FuncExpr)
-		{
-			elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: left argument's dat type is T_FuncExpr", __func__);
-			if (strcmp(opername, "=") == 0)
-				appendStringInfo(&result, "%s IN (", left);
-			else
-				appendStringInfo(&result, "%s NOT IN (", left);
-		}
-		else
+		for (int i = 0; i < state->numcols; i++)
 		{
-			elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL left argument type '%u' not supported", __func__, leftexpr->type);
-			return NULL;
+			if (state->rdfTable->cols[i]->pgattnum == var->varattno)
+				col = state->rdfTable->cols[i];
 		}
 
-		/* the second (=last) argument can be Const, ArrayExpr or ArrayCoerceExpr */
-		rightexpr = (Expr *)llast(arrayoper->args);
+		if (!col || !col->pushable)
+			return false;
 
-		switch (rightexpr->type)
-		{
-		case T_Const:
-			/* the second (=last) argument is a Const of ArrayType */
-			constant = (Const *)rightexpr;
+		/* only the default ordering of the data type, e.g. not text_pattern_ops */
+		opclass = GetDefaultOpClass(col->pgtype, BTREE_AM_OID);
 
-			/*
-			 * NULL isn't supported in Linked Data. A NULL "value" is rather represented
-			 * by the absence of a relation
-			 */
-			if (constant->constisnull)
-			{
-				elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: returning NULL (constant->constisnull)", __func__);
-				return NULL;
-			}
-			else
-			{
-				ArrayType *arr = DatumGetArrayTypeP(constant->constvalue);
-				StringInfoData type;
-				initStringInfo(&type);
+		if (!OidIsValid(opclass) || pathkey->pk_opfamily != get_opclass_family(opclass))
+			return false;
 
-				/* loop through the array elements */
-				iterator = array_create_iterator(arr, 0);
-				first_arg = true;
-				while (array_iterate(iterator, &datum, &isNull))
-				{
-					char *c;
+#if PG_VERSION_NUM >= 180000
+		ascending = pathkey->pk_cmptype == COMPARE_LT;
+#else
+		ascending = pathkey->pk_strategy == BTLessStrategyNumber;
+#endif /* PG_VERSION_NUM */
 
-					if (isNull)
-						c = "NULL";
-					else
-					{
+		if (pathkey->pk_nulls_first != ascending && !col->notnull)
+			return false;
 
-						c = DatumToString(datum, ARR_ELEMTYPE(arr));
-						if (c == NULL)
-						{
-							array_free_iterator(iterator);
-							return NULL;
-						}
-					}
+		/*
+		 * A numeric data type alone says nothing about the values the
+		 * endpoint sorts: without a numeric literaltype they may as well be
+		 * strings, which SPARQL compares by their lexical form ("10" < "9").
+		 */
+		if ((col->pgtype == INT2OID || col->pgtype == INT4OID || col->pgtype == INT8OID ||
+			 col->pgtype == FLOAT4OID || col->pgtype == FLOAT8OID || col->pgtype == NUMERICOID) &&
+			col->literaltype && isNumeric(strdt("0", col->literaltype)))
+			continue;
 
-					if (IsStringDataType(leftargtype))
-					{
-						if (col && col->pgtype == RDFNODEOID)
-							appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", c);
-						else if (col && col->language)
-							appendStringInfo(&result, "%s%s",
-											 first_arg ? "" : ", ", strlang(c, col->language));
-						else if (col && col->literaltype)
-							appendStringInfo(&result, "%s%s",
-											 first_arg ? "" : ", ", strdt(c, col->literaltype));
-						else
-							appendStringInfo(&result, "%s%s",
-											 first_arg ? "" : ", ", str(c));
-					}
-					else
-						appendStringInfo(&result, "%s%s",
-										 first_arg ? "" : ", ", c);
+		if (IsStringDataType(col->pgtype) &&
+			(collation == C_COLLATION_OID || collation == POSIX_COLLATION_OID) &&
+			((col->nodetype && strcmp(col->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0) ||
+			 (col->literaltype && (strcmp(col->literaltype, RDF_XSD_STRING) == 0 || strcmp(col->literaltype, "xsd:string") == 0))))
+			continue;
 
-					/* append the argument */
-					first_arg = false;
-				}
-				array_free_iterator(iterator);
+		return false;
+	}
 
-				/* don't push down empty arrays, since the semantics for NOT x = ANY(<empty array>) differ */
-				if (first_arg)
-				{
-					elog(DEBUG2, "%s [T_ScalarArrayOpExpr]: returning NULL (cannot push empty arrays)", __func__);
-					return NULL;
-				}
-			}
+	return true;
+}
 
-			break;
-		case T_ArrayCoerceExpr:
-			/* the second (=last) argument is an ArrayCoerceExpr */
-			arraycoerce = (ArrayCoerceExpr *)rightexpr;
+/*
+ * AddSortedPaths
+ * --------------
+ * Adds paths whose rows are sorted by the endpoint (SPARQL ORDER BY), so that
+ * PostgreSQL neither sorts the result of the scan again nor has to sort it
+ * for a merge join: one for the ORDER BY of the query, which was deparsed by
+ * InitSession(), and one for every join column useful for a merge join. The
+ * SPARQL ORDER BY of the latter is kept in the path's fdw_private and used
+ * by rdfGetForeignPlan(). Paths are only added if the remote sort order can
+ * be trusted (see IsSPARQLOrderSafe).
+ *
+ * The endpoint sorts the result while computing it, so only a comparison per
+ * row is added to the cost of the unsorted path, which keeps a sorted path
+ * cheaper than a local Sort on top of the unsorted one.
+ *
+ * root   : Planner info
+ * baserel: relation of the FOREIGN TABLE
+ */
+static void AddSortedPaths(PlannerInfo *root, RelOptInfo *baserel)
+{
+	struct RDFfdwState *state = (struct RDFfdwState *)baserel->fdw_private;
+	Cost total_cost = state->total_cost + baserel->rows * cpu_operator_cost;
+	ListCell *cell;
 
-			/* if the conversion requires more than binary coercion, don't push it down */
-#if PG_VERSION_NUM < 110000
-			if (arraycoerce->elemfuncid != InvalidOid)
-				return NULL;
-#else
-			if (arraycoerce->elemexpr && arraycoerce->elemexpr->type != T_RelabelType)
-			{
-				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (arraycoerce->elemexpr && arraycoerce->elemexpr->type != T_RelabelType)", __func__);
-				return NULL;
-			}
-#endif
-			if (arraycoerce->arg->type != T_ArrayExpr)
-			{
-				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (arraycoerce->arg->type != T_ArrayExpr)", __func__);
-				return NULL;
-			}
+	elog(DEBUG1, "%s called", __func__);
 
-			/* the actual array is here */
-			rightexpr = arraycoerce->arg;
-#if defined(__GNUC__) && __GNUC__ >= 7
-			__attribute__((fallthrough));
-#else
-			/* fall through */
-#endif
-			case T_ArrayExpr:
-			/* the second (=last) argument is an ArrayExpr */
-			array = (ArrayExpr *)rightexpr;
+	if (!state->enable_pushdown || !state->is_sparql_parsable)
+		return;
 
-			/* loop the array arguments */
-			first_arg = true;
-			foreach (cell, array->elements)
-			{
-				/* convert the argument to a string */
-				char *element = DeparseExpr(state, foreignrel, (Expr *)lfirst(cell));
+	if (state->sparql_orderby && IsSPARQLOrderSafe(state, baserel, root->query_pathkeys))
+	{
+		elog(DEBUG2, "%s: adding path sorted by '%s'", __func__, state->sparql_orderby);
+		add_path(baserel, CreateRDFScanPath(root, baserel, root->query_pathkeys, baserel->lateral_relids,
+											baserel->rows, state->startup_cost, total_cost, NIL));
+	}
 
-				/* if any element cannot be converted, give up */
-				if (element == NULL)
-				{
-					elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (unable to deparse element of T_ArrayExpr)", __func__);
-					return NULL;
-				}
+	/*
+	 * A LIMIT that was pushed down applies to the ORDER BY of the query, so
+	 * the rows cannot be sorted in any other order.
+	 */
+	if (!baserel->has_eclass_joins || state->sparql_limit)
+		return;
 
-				/* append the argument */
-				appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", element);
-				first_arg = false;
-			}
+	foreach (cell, root->eq_classes)
+	{
+		EquivalenceClass *ec = (EquivalenceClass *)lfirst(cell);
+		List *pathkeys;
+		char *orderby;
 
-			/* don't push down empty arrays, since the semantics for NOT x = ANY(<empty array>) differ */
-			if (first_arg)
-			{
-				elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (cannot push down empty arrays)", __func__);
-				return NULL;
-			}
+		if (ec->ec_has_volatile || !eclass_useful_for_merging(root, ec, baserel))
+			continue;
 
-			break;
-		default:
-			elog(DEBUG2, "%s exit [T_ScalarArrayOpExpr]: returning NULL (rightexpr->type not supported)", __func__);
-			return NULL;
-		}
+		/* ascending, with unbound variables (NULL) first, as sorted by SPARQL */
+		pathkeys = list_make1(make_canonical_pathkey(root, ec, linitial_oid(ec->ec_opfamilies),
+#if PG_VERSION_NUM >= 180000
+													 COMPARE_LT,
+#else
+													 BTLessStrategyNumber,
+#endif /* PG_VERSION_NUM */
+													 true));
 
-		/* parentheses close the FILTER expression */
-		appendStringInfo(&result, ")");
+		if (!IsSPARQLOrderSafe(state, baserel, pathkeys))
+			continue;
 
-		break;
-	case T_FuncExpr:
-		elog(DEBUG2, "%s [T_FuncExpr]: start (expr->type='%u')", __func__, expr->type);
-		func = (FuncExpr *)expr;
+		orderby = DeparseSQLOrderBy(state, baserel, pathkeys);
 
-		if (!canHandleType(func->funcresulttype))
-		{
-			return NULL;
-		}
+		if (orderby == NULL)
+			continue;
 
-		/* do nothing for implicit casts */
-		if (func->funcformat == COERCE_IMPLICIT_CAST)
-		{
-			char *impcast = DeparseExpr(state, foreignrel, linitial(func->args));
-			elog(DEBUG2, "%s exit [T_FuncExpr]: returning '%s' (implicit cast) ", __func__, impcast);
-			return impcast;
-		}
+		elog(DEBUG2, "%s: adding path sorted by '%s' for merge joins", __func__, orderby);
+		add_path(baserel, CreateRDFScanPath(root, baserel, pathkeys, baserel->lateral_relids,
+											baserel->rows, state->startup_cost, total_cost, list_make1(makeString(orderby))));
+	}
+}
+#endif /* PG_VERSION_NUM >= 90600 */
 
-		/* get function name and schema */
-		tuple = SearchSysCache1(PROCOID, ObjectIdGetDatum(func->funcid));
-		if (!HeapTupleIsValid(tuple))
-		{
-			elog(ERROR, "%s [T_FuncExpr]: cache lookup failed for function %u", __func__, func->funcid);
-		}
+/*
+ * CreateRDFScanPath
+ * -----------------
+ * Creates a ForeignPath that scans a FOREIGN TABLE.
+ *
+ * root          : Planner info
+ * baserel       : relation of the FOREIGN TABLE
+ * pathkeys      : sort order of the rows returned by the endpoint, or NIL
+ * required_outer: relations whose values are bound to the SPARQL query
+ * rows          : number of rows returned by the path
+ * startup_cost  : startup cost of the path
+ * total_cost    : total cost of the path
+ * fdw_private   : SPARQL ORDER BY of merge join paths, or NIL
+ *
+ * returns the ForeignPath as a Path
+ */
+static Path *CreateRDFScanPath(PlannerInfo *root, RelOptInfo *baserel, List *pathkeys, Relids required_outer, double rows, Cost startup_cost, Cost total_cost, List *fdw_private)
+{
+#if PG_VERSION_NUM >= 170000
+	return (Path *)create_foreignscan_path(root, baserel,
+										   NULL, /* pathtarget */
+										   rows,
+#if PG_VERSION_NUM >= 180000
+										   0, /* no parallel pathflags */
+#endif
+										   startup_cost,
+										   total_cost,
+										   pathkeys,
+										   required_outer,
+										   NULL, /* fdw_outerpath */
+										   NIL,	 /* fdw_restrictinfo */
+										   fdw_private);
+#elif PG_VERSION_NUM >= 90600
+	return (Path *)create_foreignscan_path(root, baserel,
+										   NULL, /* pathtarget */
+										   rows,
+										   startup_cost,
+										   total_cost,
+										   pathkeys,
+										   required_outer,
+										   NULL,
+										   fdw_private);
+#else /* PG_VERSION_NUM < 90600 (PostgreSQL 9.5) */
+	return (Path *)create_foreignscan_path(root, baserel,
+										   rows,
+										   startup_cost,
+										   total_cost,
+										   pathkeys,
+										   required_outer,
+										   NULL,
+										   fdw_private);
+#endif
+}
+
+#if PG_VERSION_NUM >= 120000
+/*
+ * IsParameterMember
+ * -----------------
+ * Callback of generate_implied_equalities_for_column() that matches the
+ * members of the FOREIGN TABLE one at a time, so that the join clauses of
+ * all its EquivalenceClasses are collected by AddParameterizedPaths().
+ *
+ * returns 'true' if the member is the one currently being collected
+ */
+static bool IsParameterMember(PlannerInfo *root, RelOptInfo *rel, EquivalenceClass *ec, EquivalenceMember *em, void *arg)
+{
+	RDFfdwParamMatch *match = (RDFfdwParamMatch *)arg;
 
-		opername = pstrdup(((Form_pg_proc)GETSTRUCT(tuple))->proname.data);
-		ReleaseSysCache(tuple);
+	if (match->current != NULL)
+		return equal(em->em_expr, match->current);
 
-		elog(DEBUG2, "  %s [T_FuncExpr]: opername = %s", __func__, opername);
+	if (list_member(match->already_used, em->em_expr))
+		return false;
 
-		if (!IsFunctionPushable(opername))
-		{
-			elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (function not in pg_catalog and not pushable) ", __func__);
-			return NULL;
-		}
+	match->current = em->em_expr;
+	return true;
+}
 
-		if (IsFunctionPushable(opername))
-		{
-			char *extract_type = "";
-			bool initarg = true;
-			StringInfoData args;
-			initStringInfo(&args);
-			initStringInfo(&result);
+/*
+ * IsParameterClause
+ * -----------------
+ * Checks if a clause compares a column of the FOREIGN TABLE with an
+ * expression of other relations or Params (column = expression), so that the
+ * value of the expression can be bound to the column's variable in the SPARQL
+ * query when it is known (see BindParameters). Only rdfnode columns and IRI columns (nodetype 'iri')
+ * without an expression are supported, as their values are RDF terms.
+ *
+ * state  : SPARQL, SERVER and FOREIGN TABLE info
+ * baserel: relation of the FOREIGN TABLE
+ * rinfo  : condition or join clause
+ * column : column of the FOREIGN TABLE (output)
+ * param  : expression computing the value of the column (output)
+ *
+ * returns 'true' if the clause can be bound to the SPARQL query
+ */
+static bool IsParameterClause(struct RDFfdwState *state, RelOptInfo *baserel, RestrictInfo *rinfo, struct RDFfdwColumn **column, Expr **param)
+{
+	OpExpr *oper = (OpExpr *)rinfo->clause;
+	struct RDFfdwColumn *col;
+	Expr *left;
+	Expr *right;
+	Var *var;
+	char *opername;
 
-			foreach (cell, func->args)
-			{
-				Expr *ex = lfirst(cell);
-				elog(DEBUG2, "%s [T_FuncExpr]: deparsing arguments for '%s'", __func__, opername);
-				arg = DeparseExpr(state, foreignrel, ex);
+	if (!IsA(oper, OpExpr) || list_length(oper->args) != 2)
+		return false;
 
-				if (!arg)
-				{
-					elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (arg is NULL and opername = %s)", __func__, opername);
-					pfree(opername);
-					return NULL;
-				}
+	opername = get_opname(oper->opno);
 
-				if (!initarg)
-				{
-					/*
-					 * We discard any further parameters of ROUND, as its equivalent
-					 * in SPARQL expects a single parameter.
-					 */
-					if (strcmp(opername, "round") == 0)
-						break;
-					else if (strcmp(opername, "extract") != 0)
-						appendStringInfo(&args, "%s", ", ");
-				}
+	if (opername == NULL || strcmp(opername, "=") != 0)
+		return false;
 
-				col = GetRDFColumn(state, arg);
+	/* case insensitive collations would match other IRIs than the given one */
+	if (OidIsValid(oper->inputcollid) && !get_collation_isdeterministic(oper->inputcollid))
+		return false;
 
-				if (col)
-				{
-					appendStringInfo(&args, "%s", !col->expression ? col->sparqlvar : col->expression);
-				}
-				else
-				{
-					if (ex->type == T_Const)
-					{
-						Const *ct = (Const *)ex;
+	left = (Expr *)linitial(oper->args);
+	right = (Expr *)lsecond(oper->args);
 
-						if (strcmp(opername, "extract") == 0 && initarg)
-						{
-							/*
-							 * in EXTRACT calls the first parameter becomes the function
-							 * call in SPARQL. So we leave this cycle after we parsed the
-							 * parameter.
-							 */
-							extract_type = FormatSQLExtractField(arg);
-							continue;
-						}
+	if (IsA(left, Var) && ((Var *)left)->varno == baserel->relid &&
+		!bms_is_member(baserel->relid, rinfo->right_relids))
+	{
+		var = (Var *)left;
+		*param = right;
+	}
+	else if (IsA(right, Var) && ((Var *)right)->varno == baserel->relid &&
+			 !bms_is_member(baserel->relid, rinfo->left_relids))
+	{
+		var = (Var *)right;
+		*param = left;
+	}
+	else
+		return false;
 
-						/* Return NULLL if the EXTRACT field cannot be converted to SPARQL */
-						if (strcmp(opername, "extract") == 0 && initarg && !arg)
-						{
-							elog(DEBUG1, "%s exit [T_FuncExpr]: returning NULL (EXTRACT field cannot be converted to SPARQL: '%s')", __func__, arg);
-							pfree(opername);
-							return NULL;
-						}
-						else if (IsStringDataType(ct->consttype) && strcmp(opername, "strdt") == 0)
-							appendStringInfo(&args, "%s", ExpandDatatypePrefix(arg));
-						else if (IsStringDataType(ct->consttype) && isIRI(arg))
-							appendStringInfo(&args, "%s", arg);
-						else if (IsStringDataType(ct->consttype))
-							appendStringInfo(&args, "%s", cstring_to_rdfliteral(arg));
-						else
-							appendStringInfo(&args, "%s", arg);
-					}
-					else
-						appendStringInfo(&args, "%s", arg);
-				}
+	if (contain_volatile_functions((Node *)*param))
+		return false;
 
-				initarg = false;
-			}
+	col = GetRDFColumnByAttnum(state, var->varattno);
 
-			if (strcmp(opername, "upper") == 0)
-				appendStringInfo(&result, "UCASE(%s)", NameStr(args));
-			else if (strcmp(opername, "lower") == 0)
-				appendStringInfo(&result, "LCASE(%s)", NameStr(args));
-			else if (strcmp(opername, "length") == 0)
-				appendStringInfo(&result, "STRLEN(%s)", NameStr(args));
-			else if (strcmp(opername, "abs") == 0)
-				appendStringInfo(&result, "ABS(%s)", NameStr(args));
-			else if (strcmp(opername, "round") == 0)
-				appendStringInfo(&result, "ROUND(%s)", NameStr(args));
-			else if (strcmp(opername, "floor") == 0)
-				appendStringInfo(&result, "FLOOR(%s)", NameStr(args));
-			else if (strcmp(opername, "ceil") == 0)
-				appendStringInfo(&result, "CEIL(%s)", NameStr(args));
-			else if (strcmp(opername, "strstarts") == 0 || strcmp(opername, "starts_with") == 0)
-				appendStringInfo(&result, "STRSTARTS(%s)", NameStr(args));
-			else if (strcmp(opername, "strends") == 0)
-				appendStringInfo(&result, "STRENDS(%s)", NameStr(args));
-			else if (strcmp(opername, "strbefore") == 0)
-				appendStringInfo(&result, "STRBEFORE(%s)", NameStr(args));
-			else if (strcmp(opername, "strafter") == 0)
-				appendStringInfo(&result, "STRAFTER(%s)", NameStr(args));
-			else if (strcmp(opername, "strlang") == 0)
-				appendStringInfo(&result, "STRLANG(%s)", NameStr(args));
-			else if (strcmp(opername, "strdt") == 0)
-				appendStringInfo(&result, "STRDT(%s)", NameStr(args));
-			else if (strcmp(opername, "str") == 0)
-				appendStringInfo(&result, "STR(%s)", NameStr(args));
-			else if (strcmp(opername, "iri") == 0)
-				appendStringInfo(&result, "IRI(%s)", NameStr(args));
-			else if (strcmp(opername, "isiri") == 0)
-				appendStringInfo(&result, "isIRI(%s)", NameStr(args));
-			else if (strcmp(opername, "lang") == 0)
-				appendStringInfo(&result, "LANG(%s)", NameStr(args));
-			else if (strcmp(opername, "langmatches") == 0)
-				appendStringInfo(&result, "LANGMATCHES(%s)", NameStr(args));
-			else if (strcmp(opername, "datatype") == 0)
-				appendStringInfo(&result, "DATATYPE(%s)", NameStr(args));
-			else if (strcmp(opername, "substring") == 0)
-				appendStringInfo(&result, "SUBSTR(%s)", NameStr(args));
-			else if (strcmp(opername, "contains") == 0)
-				appendStringInfo(&result, "CONTAINS(%s)", NameStr(args));
-			else if (strcmp(opername, "encode_for_uri") == 0)
-				appendStringInfo(&result, "ENCODE_FOR_URI(%s)", NameStr(args));
-			else if (strcmp(opername, "isblank") == 0)
-				appendStringInfo(&result, "isBLANK(%s)", NameStr(args));
-			else if (strcmp(opername, "isnumeric") == 0)
-				appendStringInfo(&result, "ISNUMERIC(%s)", NameStr(args));
-			else if (strcmp(opername, "isliteral") == 0)
-				appendStringInfo(&result, "isLITERAL(%s)", NameStr(args));
-			else if (strcmp(opername, "bnode") == 0)
-				appendStringInfo(&result, "BNODE(%s)", NameStr(args));
-			else if (strcmp(opername, "lcase") == 0)
-				appendStringInfo(&result, "LCASE(%s)", NameStr(args));
-			else if (strcmp(opername, "ucase") == 0)
-				appendStringInfo(&result, "UCASE(%s)", NameStr(args));
-			else if (strcmp(opername, "strlen") == 0)
-				appendStringInfo(&result, "STRLEN(%s)", NameStr(args));
-			else if (strcmp(opername, "substr") == 0)
-				appendStringInfo(&result, "SUBSTR(%s)", NameStr(args));
-			else if (strcmp(opername, "concat") == 0)
-				appendStringInfo(&result, "CONCAT(%s)", NameStr(args));
-			else if (strcmp(opername, "replace") == 0)
-				appendStringInfo(&result, "REPLACE(%s)", NameStr(args));
-			else if (strcmp(opername, "year") == 0)
-				appendStringInfo(&result, "YEAR(%s)", NameStr(args));
-			else if (strcmp(opername, "month") == 0)
-				appendStringInfo(&result, "MONTH(%s)", NameStr(args));
-			else if (strcmp(opername, "day") == 0)
-				appendStringInfo(&result, "DAY(%s)", NameStr(args));
-			else if (strcmp(opername, "hours") == 0)
-				appendStringInfo(&result, "HOURS(%s)", NameStr(args));
-			else if (strcmp(opername, "minutes") == 0)
-				appendStringInfo(&result, "MINUTES(%s)", NameStr(args));
-			else if (strcmp(opername, "seconds") == 0)
-				appendStringInfo(&result, "SECONDS(%s)", NameStr(args));
-			else if (strcmp(opername, "timezone") == 0)
-				appendStringInfo(&result, "TIMEZONE(%s)", NameStr(args));
-			else if (strcmp(opername, "tz") == 0)
-				appendStringInfo(&result, "TZ(%s)", NameStr(args));
-			else if (strcmp(opername, "md5") == 0)
-				appendStringInfo(&result, "MD5(%s)", NameStr(args));
-			else if (strcmp(opername, "bound") == 0)
-				appendStringInfo(&result, "BOUND(%s)", NameStr(args));
-			else if (strcmp(opername, "sameterm") == 0)
-				appendStringInfo(&result, "SAMETERM(%s)", NameStr(args));
-			else if (strcmp(opername, "coalesce") == 0)
-				appendStringInfo(&result, "COALESCE(%s)", NameStr(args));
-			else if (strcmp(opername, "extract") == 0)
-				appendStringInfo(&result, "%s(%s)", extract_type, NameStr(args));
-			else if (strcmp(opername, "rdfnode_to_timestamp") == 0)
-				appendStringInfo(&result, "%s", NameStr(args));
-			else if (strcmp(opername, "rdfnode_to_timestamptz") == 0)
-				appendStringInfo(&result, "%s", NameStr(args));
-			else if (strcmp(opername, "rdfnode_to_times") == 0)
-				appendStringInfo(&result, "%s", NameStr(args));
-			else if (strcmp(opername, "rdfnode_to_timetz") == 0)
-				appendStringInfo(&result, "%s", NameStr(args));
-			else if (strcmp(opername, "rdfnode_to_boolean") == 0)
-				appendStringInfo(&result, "%s", NameStr(args));
-			else if (strcmp(opername, "boolean_to_rdfnode") == 0)
-				appendStringInfo(&result, "%s", NameStr(args));
+	if (col == NULL || !col->pushable || col->expression || exprType((Node *)*param) != col->pgtype)
+		return false;
 
-			else
-			{
-				elog(DEBUG2, "%s [T_FuncExpr]: returning NULL (unknown opername '%s')", __func__, opername);
-				return NULL;
-			}
+	if (col->pgtype != RDFNODEOID &&
+		!(IsStringDataType(col->pgtype) && col->nodetype &&
+		  strcmp(col->nodetype, RDF_COLUMN_OPTION_NODETYPE_IRI) == 0))
+		return false;
 
-			pfree(args.data);
-		}
-		/* in PostgreSQL 11 EXTRACT is internally called as DATE_PART */
-		else if (strcmp(opername, "date_part") == 0)
-		{
-			Expr *field = linitial(func->args);
-			char *date_part_type = "";
+	*column = col;
+	return true;
+}
 
-			elog(DEBUG2, "%s [T_FuncExpr]: deparsing FIELD for '%s'", __func__, opername);
-			date_part_type = DeparseExpr(state, foreignrel, field);
+/*
+ * ContainsParam
+ * -------------
+ * Checks if an expression contains a Param, i.e. a value that is only known
+ * at execution time, such as a parameter of a prepared statement or the
+ * result of an InitPlan.
+ *
+ * returns 'true' if the expression contains a Param
+ */
+static bool ContainsParam(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
 
-			if (!date_part_type)
-			{
-				elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (date_part_type is NULL and opername = '%s')", __func__, opername);
-				pfree(opername);
-				return NULL;
-			}
+	if (IsA(node, Param))
+		return true;
 
-			elog(DEBUG2, "%s [T_FuncExpr]: date_part FIELD '%s'", __func__, date_part_type);
+	return expression_tree_walker(node, ContainsParam, context);
+}
 
-			date_part_type = FormatSQLExtractField(date_part_type);
+/*
+ * AddParameterizedPaths
+ * ---------------------
+ * Adds a path for every set of outer relations whose join clauses can be
+ * bound to the SPARQL query (see IsParameterClause), e.g. a small local
+ * table joined with a large FOREIGN TABLE. In a nested loop the request of
+ * such a path is sent for every outer row, with its join keys bound to the
+ * graph pattern, so that only the matching solutions are retrieved instead
+ * of the whole remote result set. The join clauses are also evaluated
+ * locally.
+ *
+ * Every request has the startup cost of the unparameterized path, so these
+ * paths are only chosen if there are few outer rows compared to the rows of
+ * the FOREIGN TABLE. If the join keys of all outer rows are sent in a single
+ * request (see DeparseParameterBatch), its startup cost is shared by them.
+ *
+ * root   : Planner info
+ * baserel: relation of the FOREIGN TABLE
+ */
+static void AddParameterizedPaths(PlannerInfo *root, RelOptInfo *baserel)
+{
+	struct RDFfdwState *state = (struct RDFfdwState *)baserel->fdw_private;
+	List *clauses = NIL;
+	List *ppi_list = NIL;
+	ListCell *cell;
 
-			if (date_part_type)
-			{
-				char *val;
+	elog(DEBUG1, "%s called", __func__);
 
-				elog(DEBUG2, "%s [T_FuncExpr]: deparsing VALUE for '%s'", __func__, opername);
+	/* a LIMIT pushed down would apply to the solutions of each outer row */
+	if (!state->enable_pushdown || !state->is_sparql_parsable || state->sparql_limit || state->values_chunks != NIL)
+		return;
 
-				val = DeparseExpr(state, foreignrel, lsecond(func->args));
-				col = GetRDFColumn(state, val);
+	foreach (cell, baserel->joininfo)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *)lfirst(cell);
 
-				initStringInfo(&result);
+		if (join_clause_is_movable_to(rinfo, baserel))
+			clauses = lappend(clauses, rinfo);
+	}
 
-				if (col)
-					appendStringInfo(&result, "%s(%s)", date_part_type, !col->expression ? col->sparqlvar : col->expression);
-				else
-					appendStringInfo(&result, "%s(\"%s\")", date_part_type, val);
-			}
-			else
-			{
-				elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (date_part_type is NULL)", __func__);
-				pfree(opername);
-				return NULL;
-			}
-		}
-		else if (strcmp(opername, "timestamp") == 0)
+	/* equality join clauses are kept in EquivalenceClasses, not in joininfo */
+	if (baserel->has_eclass_joins)
+	{
+		RDFfdwParamMatch match;
+
+		match.already_used = NIL;
+
+		for (;;)
 		{
-			char *value;
-			Expr *ex = linitial(func->args);
+			List *eclauses;
 
-			value = DeparseExpr(state, foreignrel, ex);
+			match.current = NULL;
+			eclauses = generate_implied_equalities_for_column(root, baserel,
+															  IsParameterMember,
+															  (void *)&match,
+															  baserel->lateral_referencers);
 
-			if (!value)
+			if (match.current == NULL)
+				break;
+
+			foreach (cell, eclauses)
 			{
-				elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (unable to deparse timestamp value)", __func__);
-				return NULL;
+				RestrictInfo *rinfo = (RestrictInfo *)lfirst(cell);
+
+				if (join_clause_is_movable_to(rinfo, baserel))
+					clauses = lappend(clauses, rinfo);
 			}
 
-			initStringInfo(&result);
-			appendStringInfo(&result, "%s", value);
-		}
-		else
-		{
-			elog(DEBUG2, "%s exit [T_FuncExpr]: returning NULL (unable to push function '%s')", __func__, opername);
-			return NULL;
+			match.already_used = lappend(match.already_used, match.current);
 		}
+	}
 
-		pfree(opername);
-		break;
-	case T_ArrayExpr:
-		elog(DEBUG2, "%s [T_ArrayExpr]: start (expr->type='%u')", __func__, expr->type);
+	foreach (cell, clauses)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *)lfirst(cell);
+		struct RDFfdwColumn *col;
+		Relids required_outer;
+		Expr *param;
 
-		/* this is exclusively for SPARQL COALESCE */
-		array = (ArrayExpr *)expr;
-		elog(DEBUG2, "%s [T_ArrayExpr]: function called", __func__);
-		initStringInfo(&result);
+		if (!IsParameterClause(state, baserel, rinfo, &col, &param))
+			continue;
 
-		/* loop the array arguments */
-		first_arg = true;
-		foreach (cell, array->elements)
+		required_outer = bms_union(rinfo->clause_relids, baserel->lateral_relids);
+		required_outer = bms_del_member(required_outer, baserel->relid);
+
+		if (bms_is_empty(required_outer))
+			continue;
+
+		/* get_baserel_parampathinfo() returns the same entry for the same relations */
+		ppi_list = list_append_unique_ptr(ppi_list, get_baserel_parampathinfo(root, baserel, required_outer));
+	}
+
+	foreach (cell, ppi_list)
+	{
+		ParamPathInfo *param_info = (ParamPathInfo *)lfirst(cell);
+		double rows = param_info->ppi_rows;
+		double outer_rows = 0;
+		Cost startup_cost = state->startup_cost;
+		Expr *batch_param = NULL;
+		int nparams = 0;
+		ListCell *lc;
+
+		foreach (lc, param_info->ppi_clauses)
 		{
-			Expr *element_expr = (Expr *)lfirst(cell);
-			char *element = DeparseExpr(state, foreignrel, element_expr);
+			struct RDFfdwColumn *col;
+			Expr *param;
 
-			/* if any element cannot be converted, give up */
-			if (element == NULL)
+			if (IsParameterClause(state, baserel, (RestrictInfo *)lfirst(lc), &col, &param))
 			{
-				elog(DEBUG2, "%s exit [T_ArrayExpr]: returning NULL (unable to deparse element of T_ArrayExpr)", __func__);
-				return NULL;
+				batch_param = param;
+				nparams++;
 			}
+		}
 
-			col = GetRDFColumn(state, element);
+		if (nparams == 1 && DeparseParameterBatch(root, batch_param, &outer_rows) != NULL && outer_rows > 1)
+			startup_cost /= outer_rows;
 
-			if (col)
-				appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", col->sparqlvar);
-			else if (nodeTag(element_expr) == T_Const && isLiteral(element))
-			{
-				/*
-				 * this seems unnecessary, but it is important to expand
-				 * possible prefixed XSD predicates into their full URI.
-				 */
-				char *dt = datatype(element);
+		elog(DEBUG2, "%s: adding parameterized path with %.0f rows", __func__, rows);
+		add_path(baserel, CreateRDFScanPath(root, baserel, NIL, param_info->ppi_req_outer,
+											rows, startup_cost, startup_cost + rows * 10.0, NIL));
+	}
+}
 
-				if (strlen(dt) != 0)
-					appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", strdt(element, dt));
-				else
-					appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", cstring_to_rdfliteral(element));
-			}
-			else if (nodeTag(element_expr) == T_Const)
-				appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", cstring_to_rdfliteral(element));
-			else
-				appendStringInfo(&result, "%s%s", first_arg ? "" : ", ", element);
+/*
+ * DeparseParameterBatch
+ * ---------------------
+ * Checks if the join keys of all outer rows of a parameterized scan can be
+ * sent in a single request, i.e. if its only parameter is a column of a
+ * table without conditions of its own, whose distinct values are then the
+ * join keys of all outer rows. LoadParameterBatch() reads them with the
+ * returned query once the first outer row is bound, and the rows of all
+ * following outer rows are served from the result of that request.
+ *
+ * root      : Planner info
+ * param     : expression computing the value of the parameter
+ * outer_rows: number of rows of the outer table (output)
+ *
+ * returns the SQL query reading the join keys, or NULL if the scan cannot
+ * be batched
+ */
+static char *DeparseParameterBatch(PlannerInfo *root, Expr *param, double *outer_rows)
+{
+	Var *var = (Var *)param;
+	RangeTblEntry *rte;
+	RelOptInfo *rel;
+	char relkind;
+	char *column;
 
-			first_arg = false;
-		}
+	if (root->parse->commandType != CMD_SELECT || !IsA(param, Var) ||
+		var->varlevelsup != 0 || var->varattno <= 0)
+		return NULL;
 
-		if (first_arg)
-		{
-			elog(DEBUG2, "%s exit [T_ArrayExpr]: returning NULL (cannot push empty arrays)", __func__);
-			return NULL;
-		}
+	rte = planner_rt_fetch(var->varno, root);
 
-		break;
-	default:
-		elog(DEBUG2, "%s exit: returning NULL (expression not supported '%u')", __func__, expr->type);
+	if (rte->rtekind != RTE_RELATION || rte->tablesample != NULL)
 		return NULL;
-	}
 
-	elog(DEBUG2, "%s exit: returning '%s'\n", __func__, result.data);
-	return result.data;
+	relkind = get_rel_relkind(rte->relid);
+
+	if (relkind != RELKIND_RELATION && relkind != RELKIND_MATVIEW && relkind != RELKIND_PARTITIONED_TABLE)
+		return NULL;
+
+	rel = find_base_rel(root, var->varno);
+
+	/* conditions could leave far fewer outer rows than distinct keys */
+	if (rel->baserestrictinfo != NIL || rel->rows > RDF_PARAM_BATCH_MAX_KEYS)
+		return NULL;
+
+	*outer_rows = rel->rows;
+	column = (char *)quote_identifier(get_attname(rte->relid, var->varattno, false));
+
+	return psprintf("SELECT DISTINCT %s FROM %s%s WHERE %s IS NOT NULL LIMIT %d",
+					column,
+					rte->inh ? "" : "ONLY ",
+					quote_qualified_identifier(get_namespace_name(get_rel_namespace(rte->relid)),
+											   get_rel_name(rte->relid)),
+					column,
+					RDF_PARAM_BATCH_MAX_KEYS + 1);
 }
 
 /*
- * DeparseSQLWhereConditions
- * ----------------------
- * Deparses the WHERE clause of SQL queries and tries to convert its conditions into
- * SPARQL FILTER expressions.
+ * BindParameters
+ * --------------
+ * Sends the request of a parameterized scan with the current values of its
+ * parameters, i.e. the join keys of the current outer row or the values of
+ * Params. The marker left in the graph pattern by rdfGetForeignPlan() is
+ * replaced by a VALUES block for IRIs, which the triplestore can look up in
+ * its indexes, and by a FILTER expression for literals, which SPARQL
+ * compares by value just like the rdfnode = operator (e.g. "1"^^xsd:int and
+ * "01"^^xsd:int). Blank nodes cannot be referred to in a query, so they are
+ * not bound. The result of the previous values is discarded.
  *
- * state  : SPARQL, SERVER and FOREIGN TABLE info
- * baserel: Conditions and columns used in the SQL query
+ * A NULL value can't be equal to any row, so in that case the scan returns
+ * no rows without sending a request.
  *
- * returns char* containing SPARQL FILTER expressions or an empty string if not applicable
+ * node : ForeignScanState of the parameterized scan
+ * state: SPARQL, SERVER and FOREIGN TABLE info
  */
-static char *DeparseSQLWhereConditions(struct RDFfdwState *state, RelOptInfo *baserel)
+static void BindParameters(ForeignScanState *node, RDFfdwState *state)
 {
-	List *conditions = baserel->baserestrictinfo;
-	ListCell *cell;
-	StringInfoData where_clause;
-	StringInfoData filter_expr;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	MemoryContext oldcontext;
+	StringInfoData values;
+	ListCell *cell_expr;
+	ListCell *cell_column;
 
 	elog(DEBUG1, "%s called", __func__);
 
-	initStringInfo(&where_clause);
-	initStringInfo(&filter_expr);
+	ReleaseRemoteResult(state);
+	state->params_bound = true;
+	state->param_batch_entry = NULL;
 
-	/*
-	 * DO NOT initialize remote_conds here!
-	 * It should remain NULL for non-parsable queries.
-	 * Only initialize when we actually have pushable conditions.
-	 */
+	/* IterateForeignScan runs in a short-lived context */
+	MemoryContextReset(state->param_cxt);
+	oldcontext = MemoryContextSwitchTo(state->param_cxt);
 
-	foreach (cell, conditions)
+	/* the rows of a batched scan were retrieved with the first outer row */
+	if (state->param_batch_sql != NULL && LookupParameterBatch(node, state))
 	{
-		RestrictInfo *ri = (RestrictInfo *)lfirst(cell);
-
-		/* deparse expression for pushdown */
-		char *where = DeparseExpr(state, baserel, ri->clause);
-
-		if (where != NULL)
-		{
-			/* Initialize remote_conds list on first pushable condition */
-			if (state->remote_conds == NULL)
-				state->remote_conds = NIL;
+		MemoryContextSwitchTo(oldcontext);
+		return;
+	}
 
-			/* append new FILTER clause to query string */
-			appendStringInfo(&where_clause, " FILTER(%s)\n", pstrdup(where));
+	initStringInfo(&values);
 
-			if (filter_expr.len > 0)
-				appendStringInfo(&filter_expr, " && (%s)", pstrdup(where));
-			else
-				appendStringInfo(&filter_expr, "((%s)", pstrdup(where));
+	forboth(cell_expr, state->param_exprs, cell_column, state->param_columns)
+	{
+		ExprState *expr = (ExprState *)lfirst(cell_expr);
+		struct RDFfdwColumn *col = GetRDFColumn(state, strVal(lfirst(cell_column)));
+		bool isnull;
+		Datum value;
+		char *term;
 
-			/* Track this RestrictInfo as successfully pushed down */
-			state->remote_conds = lappend(state->remote_conds, ri);
+		value = ExecEvalExpr(expr, econtext, &isnull);
 
-			pfree(where);
-		}
-		else
+		if (isnull)
 		{
-			state->has_unparsable_conds = true;
-			elog(DEBUG1, "  %s: condition cannot be pushed down.", __func__);
+			elog(DEBUG2, "%s: NULL value for '%s', no request is sent", __func__, col->sparqlvar);
+			MemoryContextSwitchTo(oldcontext);
+			return;
 		}
+
+		term = ParameterTerm(col, value);
+
+		if (values.len > 0)
+			appendStringInfoString(&values, "\n ");
+
+		/* characters that are not allowed in an IRIREF must be given to IRI() */
+		if (IsSPARQLIRIRef(term))
+			appendStringInfo(&values, "VALUES %s { %s }", col->sparqlvar, term);
+		else if (isIRI(term) || col->pgtype != RDFNODEOID)
+			appendStringInfo(&values, "FILTER(%s = IRI(%s))", col->sparqlvar,
+							 cstring_to_rdfliteral(pnstrdup(term + 1, strlen(term) - 2)));
+		else if (!isBlank(term))
+			appendStringInfo(&values, "FILTER(%s = %s)", col->sparqlvar, term);
 	}
 
-	if (filter_expr.len > 0)
-		appendStringInfo(&filter_expr, ")");
+	state->sparql = str_replace(state->sparql_params, RDF_SPARQL_PARAMETERS_MARKER, values.data);
 
-	state->sparql_filter_expr = filter_expr.data;
+	if (state->enable_streaming)
+		BeginStreamingSPARQL(state, state->param_cxt);
+	else
+		LoadRDFData(state);
 
-	elog(DEBUG1, "%s exit: returning '%s'", __func__, where_clause.data);
-	return where_clause.data;
+	MemoryContextSwitchTo(oldcontext);
 }
 
 /*
- * DeparseSPARQLWhereGraphPattern
- * -------------------------------
- * Extracts the graph pattern from the raw SPARQL WHERE clause supplied in the
- * foreign table definition, stripping the surrounding curly braces so that
- * rdf_fdw can inject additional FILTER expressions alongside it.
+ * ParameterTerm
+ * -------------
+ * Converts the value of a parameter, or of the column it is bound to, into
+ * an RDF term.
+ *
+ * col  : column bound to the parameter
+ * value: value of the parameter, not NULL
+ *
+ * returns the RDF term
+ */
+static char *ParameterTerm(struct RDFfdwColumn *col, Datum value)
+{
+	Oid typoutput;
+	bool typisvarlena;
+	char *term;
+
+	getTypeOutputInfo(col->pgtype, &typoutput, &typisvarlena);
+	term = OidOutputFunctionCall(typoutput, value);
+
+	/* IRI columns contain IRIs without angle brackets */
+	if (col->pgtype != RDFNODEOID && !isIRI(term))
+		term = psprintf("<%s>", term);
+
+	return term;
+}
+
+/*
+ * LookupParameterBatch
+ * --------------------
+ * Looks up the rows of the current outer row of a batched parameterized
+ * scan, loading the rows of all join keys with the first outer row. Literals
+ * and NULL values are left to BindParameters(), as are all values if the
+ * outer table turned out to have too many keys.
  *
+ * node : ForeignScanState of the parameterized scan
  * state: SPARQL, SERVER and FOREIGN TABLE info
  *
- * returns char* containing the bare WHERE graph pattern
+ * returns 'true' if the rows are served from 'state->param_batch_entry'
  */
-static char *DeparseSPARQLWhereGraphPattern(struct RDFfdwState *state)
+static bool LookupParameterBatch(ForeignScanState *node, RDFfdwState *state)
 {
-	int where_position = -1;
-	int where_size = -1;
-	char *result;
+	struct RDFfdwColumn *col = GetRDFColumn(state, strVal(linitial(state->param_columns)));
+	bool isnull;
+	Datum value;
+	char *term;
 
-	elog(DEBUG1, "%s called", __func__);
+	value = ExecEvalExpr((ExprState *)linitial(state->param_exprs), node->ss.ps.ps_ExprContext, &isnull);
 
-	/*
-	 * Deparsing SPARQL WHERE clause
-	 *   'where_position = i + 1' to remove the surrounging curly braces {} as we are
-	 *   interested only in WHERE clause's graph pattern
-	 */
-	for (int i = 0; state->raw_sparql[i] != '\0'; i++)
-	{
-		if (state->raw_sparql[i] == '{' && where_position == -1)
-			where_position = i + 1;
+	if (isnull)
+		return false;
 
-		if (state->raw_sparql[i] == '}')
-			where_size = i - where_position;
-	}
+	term = ParameterTerm(col, value);
 
-	result = pnstrdup(state->raw_sparql + where_position, where_size);
+	if (!IsSPARQLIRIRef(term))
+		return false;
 
-	elog(DEBUG1, "%s exit: returning '%s'", __func__, result);
-	return result;
+	if (state->param_batch == NULL)
+		LoadParameterBatch(node, state);
+
+	if (state->param_batch == NULL)
+		return false;
+
+	state->param_batch_entry = (RDFfdwParamBatchEntry *)hash_search(state->param_batch, &term, HASH_FIND, NULL);
+	state->param_batch_pos = 0;
+
+	return state->param_batch_entry != NULL;
 }
 
 /*
- * DeparseSQLOrderBy
- * -----------------
- *
- * state  : SPARQL, SERVER and FOREIGN TABLE info
- * baserel: Conditions and columns used in the SQL query
- * root   : Planner info
+ * LoadParameterBatch
+ * ------------------
+ * Reads the join keys of all outer rows of a batched parameterized scan with
+ * the query created by DeparseParameterBatch(), binds them in VALUES blocks
+ * of at most 'max_values_size' bytes, and sends one request for each block
+ * instead of one for each outer row. The rows are kept in 'state->param_batch'
+ * by join key until the end of the scan, so that rescans with other outer
+ * rows are served without a request. If the outer table has more than
+ * RDF_PARAM_BATCH_MAX_KEYS keys, the scan is not batched.
  *
- * returns char* containg a SPARQL ORDER BY clause or an empty string if not applicable
+ * node : ForeignScanState of the parameterized scan
+ * state: SPARQL, SERVER and FOREIGN TABLE info
  */
-static char *DeparseSQLOrderBy(struct RDFfdwState *state, PlannerInfo *root, RelOptInfo *baserel)
+static void LoadParameterBatch(ForeignScanState *node, RDFfdwState *state)
 {
-	StringInfoData orderedquery;
-	List *usable_pathkeys = NIL;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	struct RDFfdwColumn *col = GetRDFColumn(state, strVal(linitial(state->param_columns)));
+	MemoryContext oldcontext = CurrentMemoryContext;
+	MemoryContext load_cxt;
+	HASHCTL ctl;
 	ListCell *cell;
-	char *delim = " ";
+	char **terms;
+	int nterms = 0;
+	int attidx = -1;
+	uint64 nkeys;
 
 	elog(DEBUG1, "%s called", __func__);
 
-	initStringInfo(&orderedquery);
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "%s: SPI_connect failed", __func__);
+
+	if (SPI_execute(state->param_batch_sql, true, 0) != SPI_OK_SELECT)
+		elog(ERROR, "%s: unable to read the join keys with '%s'", __func__, state->param_batch_sql);
 
-	foreach (cell, root->query_pathkeys)
+	nkeys = SPI_processed;
+
+	if (nkeys > RDF_PARAM_BATCH_MAX_KEYS)
 	{
-		PathKey *pathkey = (PathKey *)lfirst(cell);
-		EquivalenceClass *pathkey_ec = pathkey->pk_eclass;
-		EquivalenceMember *em = NULL;
-		Expr *em_expr = NULL;
-		char *sort_clause;
-		Oid em_type;
-		ListCell *lc;
-		bool can_pushdown;
+		SPI_finish();
+		state->param_batch_sql = NULL;
+		elog(DEBUG1, "%s exit: more than %d join keys, sending a request for each outer row", __func__, RDF_PARAM_BATCH_MAX_KEYS);
+		return;
+	}
 
-		/* ec_has_volatile saves some cycles */
-		if (pathkey_ec->ec_has_volatile)
-		{
-			elog(DEBUG1, "%s exit: returning NULL (pathkey_ec->ec_has_volatile)", __func__);
-			return NULL;
-		}
+	/* the keys are kept until the end of the scan */
+	MemoryContextSwitchTo(state->param_batch_cxt);
 
-		/*
-		 * Given an EquivalenceClass and a foreign relation, find an EC member
-		 * that can be used to sort the relation remotely according to a pathkey
-		 * using this EC.
-		 *
-		 * If there is more than one suitable candidate, use an arbitrary
-		 * one of them.
-		 *
-		 * This checks that the EC member expression uses only Vars from the given
-		 * rel and is shippable.  Caller must separately verify that the pathkey's
-		 * ordering operator is shippable.
-		 */
-		foreach (lc, pathkey_ec->ec_members)
-		{
-			EquivalenceMember *some_em = (EquivalenceMember *)lfirst(lc);
+	terms = (char **)palloc(sizeof(char *) * Max(nkeys, 1));
+
+	for (uint64 i = 0; i < nkeys; i++)
+	{
+		char *value = SPI_getvalue(SPI_tuptable->vals[i], SPI_tuptable->tupdesc, 1);
+		char *term;
+
+		if (value == NULL)
+			continue;
+
+		/* IRI columns contain IRIs without angle brackets */
+		term = (col->pgtype != RDFNODEOID && !isIRI(value)) ? psprintf("<%s>", value) : value;
+
+		/* literals are bound to each outer row by BindParameters() */
+		if (IsSPARQLIRIRef(term))
+			terms[nterms++] = term;
+	}
+
+	SPI_finish();
+	MemoryContextSwitchTo(state->param_batch_cxt);
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(char *);
+	ctl.entrysize = sizeof(RDFfdwParamBatchEntry);
+	ctl.hash = StringKeyHash;
+	ctl.match = StringKeyMatch;
+	ctl.hcxt = state->param_batch_cxt;
+	state->param_batch = hash_create("rdf_fdw parameter batch", Max(nterms, 16), &ctl,
+									 HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+
+	/* keys without rows are looked up as well, and return no rows */
+	for (int i = 0; i < nterms; i++)
+	{
+		bool found;
+		RDFfdwParamBatchEntry *entry = (RDFfdwParamBatchEntry *)hash_search(state->param_batch, &terms[i], HASH_ENTER, &found);
+
+		if (!found)
+			entry->rows = NIL;
+	}
+
+	for (int i = 0; i < state->numcols; i++)
+	{
+		if (state->rdfTable->cols[i] == col)
+			attidx = i;
+	}
+
+	if (nterms == 0 || attidx < 0)
+	{
+		MemoryContextSwitchTo(oldcontext);
+		return;
+	}
+
+	load_cxt = AllocSetContextCreate(state->param_batch_cxt,
+									 "rdf_fdw parameter batch load context",
+									 ALLOCSET_DEFAULT_SIZES);
+
+	foreach (cell, DeparseValuesBlocks(state, col->sparqlvar, terms, nterms, true))
+	{
+		MemoryContextSwitchTo(load_cxt);
 
-			/*
-			 * Note we require !bms_is_empty, else we'd accept constant
-			 * expressions which are not suitable for the purpose.
-			 */
-			if (bms_is_subset(some_em->em_relids, baserel->relids) &&
-				!bms_is_empty(some_em->em_relids))
-			{
-				em = some_em;
-				break;
-			}
-		}
+		state->sparql = str_replace(state->sparql_params, RDF_SPARQL_PARAMETERS_MARKER, (char *)lfirst(cell));
+		LoadRDFData(state);
 
-		if (em == NULL)
+		while (state->rowcount < state->pagesize)
 		{
-			elog(DEBUG1, "%s exit: returning NULL (EquivalenceMember is NULL)", __func__);
-			return NULL;
-		}
+			RDFfdwParamBatchEntry *entry = NULL;
 
-		em_expr = em->em_expr;
-		em_type = exprType((Node *)em_expr);
-
-		/*
-		 * SPARQL does not support sorting with functions, so it is not safe to
-		 * push down anything other than T_Var.
-		 */
+			MemoryContextReset(state->temp_cxt);
+			MemoryContextSwitchTo(state->temp_cxt);
 
-		can_pushdown = (em_expr->type == T_Var) && canHandleType(em_type);
+			CreateTuple(slot, state);
+			state->rowcount++;
 
-		elog(DEBUG1, "  %s: can push down > %d", __func__, can_pushdown);
+			if (!slot->tts_isnull[attidx])
+			{
+				char *term = ParameterTerm(col, slot->tts_values[attidx]);
 
-		if (can_pushdown && ((sort_clause = DeparseExpr(state, baserel, em_expr)) != NULL))
-		{
-			/* keep usable_pathkeys for later use. */
-			usable_pathkeys = lappend(usable_pathkeys, pathkey);
+				entry = (RDFfdwParamBatchEntry *)hash_search(state->param_batch, &term, HASH_FIND, NULL);
+			}
 
-			/* create orderedquery */
-			appendStringInfoString(&orderedquery, delim);
+			if (entry == NULL)
+				continue;
 
-#if PG_VERSION_NUM >= 180000
-			if (pathkey->pk_cmptype == COMPARE_LT)
-#else
-			if (pathkey->pk_strategy == BTLessStrategyNumber)
-#endif /* PG_VERSION_NUM */
-				appendStringInfo(&orderedquery, " ASC (%s)", (GetRDFColumn(state, sort_clause))->sparqlvar);
-			else
-				appendStringInfo(&orderedquery, " DESC (%s)", (GetRDFColumn(state, sort_clause))->sparqlvar);
+			MemoryContextSwitchTo(state->param_batch_cxt);
+			entry->rows = lappend(entry->rows, ExecCopySlotHeapTuple(slot));
 		}
-		else
-		{
-			/*
-			 * Before PostgreSQL v13, the planner and executor don't have
-			 * any clever strategy for taking data sorted by a prefix of the
-			 * query's pathkeys and getting it to be sorted by all of those
-			 * pathekeys.
-			 * So, unless we can push down all of the query pathkeys, forget it.
-			 * This could be improved from v13 on!
-			 */
 
-			elog(DEBUG1, "  %s: cannot push down ORDER BY", __func__);
-			list_free(usable_pathkeys);
-			usable_pathkeys = NIL;
-			break;
-		}
+		ReleaseRemoteResult(state);
+		MemoryContextReset(load_cxt);
+	}
+
+	ExecClearTuple(slot);
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextDelete(load_cxt);
+
+	elog(DEBUG1, "%s exit: %d join keys", __func__, nterms);
+}
+#endif /* PG_VERSION_NUM >= 120000 */
+
+/*
+ * ReleaseRemoteResult
+ * -------------------
+ * Frees the result of the previous request of a scan that sends several
+ * requests, i.e. a parameterized scan or a scan of a split IN list, before
+ * the next one is sent.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ */
+static void ReleaseRemoteResult(RDFfdwState *state)
+{
+	if (state->stream)
+	{
+		EndStreamingSPARQL(state->stream);
+		state->stream = NULL;
 	}
 
-	if (root->query_pathkeys != NIL && usable_pathkeys != NIL)
+	if (state->xmldoc)
 	{
-		elog(DEBUG1, "%s exit: returning '%s'", __func__, orderedquery.data);
-		return orderedquery.data;
+		xmlFreeDoc(state->xmldoc);
+		state->xmldoc = NULL;
 	}
-	else
+
+	if (state->tsv)
 	{
-		elog(DEBUG1, "%s exit: returning NULL (unable to deparse ORDER BY clause)", __func__);
-		return NULL;
+		SPARQLTsvFreeParser(state->tsv);
+		state->tsv = NULL;
+	}
+
+	if (state->json)
+	{
+		SPARQLJsonFreeParser(state->json);
+		state->json = NULL;
 	}
+
+	state->records = NIL;
+	state->rowcount = 0;
+	state->pagesize = 0;
 }
 
 /*
- * DeparseSPARQLFrom
- * -----------------
- * Deparses the SPARQL FROM clause.
- *
- * raw_sparql: SPARQL query set in the CREATE TABLE statement
+ * SendValuesChunk
+ * ---------------
+ * Sends the request of the next VALUES block of an IN list that was split
+ * because of max_values_size, see DeparseValuesList(). The blocks bind
+ * different values of the same variable, so the results of the requests
+ * are simply concatenated by rdfIterateForeignScan().
  *
- * returns the SPARQL FROM clause
+ * state: SPARQL, SERVER and FOREIGN TABLE info
  */
-static char *DeparseSPARQLFrom(char *raw_sparql)
+static void SendValuesChunk(RDFfdwState *state)
 {
-	StringInfoData from;
-	char *open_chars = ">)\n\t ";
-	char *close_chars = " <\n\t";
-	int nfrom = 0;
+	MemoryContext oldcontext;
+	char *values = (char *)list_nth(state->values_chunks, state->values_chunk);
 
-	elog(DEBUG1, "%s called", __func__);
+	elog(DEBUG1, "%s called: VALUES block %d of %d", __func__,
+		 state->values_chunk + 1, list_length(state->values_chunks));
 
-	initStringInfo(&from);
+	ReleaseRemoteResult(state);
+	state->values_chunk++;
 
-	if (LocateKeyword(raw_sparql, open_chars, RDF_SPARQL_KEYWORD_FROM, close_chars, &nfrom, 0) != RDF_KEYWORD_NOT_FOUND)
-	{
-		int entry_position = 0;
+	/* IterateForeignScan runs in a short-lived context */
+	MemoryContextReset(state->param_cxt);
+	oldcontext = MemoryContextSwitchTo(state->param_cxt);
 
-		for (int i = 1; i <= nfrom; i++)
-		{
-			bool is_named = false;
-			StringInfoData from_entry;
-			initStringInfo(&from_entry);
+	state->sparql = str_replace(state->sparql_params, RDF_SPARQL_VALUES_MARKER, values);
 
-			entry_position = LocateKeyword(raw_sparql, open_chars, RDF_SPARQL_KEYWORD_FROM, close_chars, NULL, entry_position);
+	if (state->enable_streaming)
+		BeginStreamingSPARQL(state, state->param_cxt);
+	else
+		LoadRDFData(state);
 
-			if (entry_position == RDF_KEYWORD_NOT_FOUND)
-				break;
+	MemoryContextSwitchTo(oldcontext);
+}
 
-			entry_position = entry_position + (strlen(RDF_SPARQL_KEYWORD_FROM) + 1);
+/*
+ * DeparseSPARQLFrom
+ * -----------------
+ * Deparses the SPARQL FROM clause.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns the SPARQL FROM clause
+ */
+static char *DeparseSPARQLFrom(struct RDFfdwState *state)
+{
+	char *result = "";
 
-			while (raw_sparql[entry_position] == ' ')
-				entry_position++;
+	elog(DEBUG1, "%s called", __func__);
 
-			/* Is the SPARQL long enough for 'FROM NAMED' to be parsed? */
-			if (entry_position + strlen(RDF_SPARQL_KEYWORD_NAMED) <= strlen(raw_sparql))
-			{
-				/*
-				 * if the next keyword is NAMED, set is_named to 'true' and move the cursor
-				 * to the next keyword
-				 */
-				if (strncasecmp(raw_sparql + entry_position, RDF_SPARQL_KEYWORD_NAMED, strlen(RDF_SPARQL_KEYWORD_NAMED)) == 0)
-				{
-					is_named = true;
-					entry_position = entry_position + strlen(RDF_SPARQL_KEYWORD_NAMED);
+	if (state->sparql_query && state->sparql_query->dataset)
+		result = pstrdup(state->sparql_query->dataset);
 
-					while (raw_sparql[entry_position] == ' ')
-						entry_position++;
-				}
-			}
+	elog(DEBUG1, "%s exit: returning '%s'", __func__, result);
+	return result;
+}
 
-			while (raw_sparql[entry_position] != ' ' &&
-				   raw_sparql[entry_position] != '\n' &&
-				   raw_sparql[entry_position] != '\t' &&
-				   raw_sparql[entry_position] != '\0')
-			{
-				appendStringInfo(&from_entry, "%c", raw_sparql[entry_position]);
+/*
+ * DeparseSPARQLModifier
+ * ---------------------
+ * Returns the DISTINCT or REDUCED modifier of the SPARQL query that must be
+ * added to the SELECT clause of the query sent to the endpoint. A query that
+ * is used as a sub-select keeps its modifier, so none is returned.
+ *
+ * state: SPARQL, SERVER and FOREIGN TABLE info
+ *
+ * returns "DISTINCT", "REDUCED" or NULL
+ */
+static const char *DeparseSPARQLModifier(struct RDFfdwState *state)
+{
+	SPARQLQuery *query = state->sparql_query;
 
-				if (raw_sparql[entry_position] == '>')
-					break;
+	if (query == NULL || SPARQLQueryNeedsSubquery(query))
+		return NULL;
 
-				entry_position++;
-			}
+	if (query->distinct)
+		return "DISTINCT";
 
-			if (is_named)
-				appendStringInfo(&from, "%s %s %s\n", RDF_SPARQL_KEYWORD_FROM, RDF_SPARQL_KEYWORD_NAMED, from_entry.data);
-			else
-				appendStringInfo(&from, "%s %s\n", RDF_SPARQL_KEYWORD_FROM, from_entry.data);
-		}
-	}
+	if (query->reduced)
+		return "REDUCED";
 
-	elog(DEBUG1, "%s exit: returning '%s'", __func__, from.data);
-	return from.data;
+	return NULL;
 }
 
 /*
  * ExtractSPARQLPrefixes
  * -------------------
- * Parses the SPARQL PREFIX entries.
+ * Adds the PREFIX entries of the SPARQL query to the prefixes of the state.
  *
  * state  : SPARQL, SERVER and FOREIGN TABLE info
  *
@@ -7718,88 +13928,23 @@ static char *DeparseSPARQLFrom(char *raw_sparql)
  */
 static void ExtractSPARQLPrefixes(struct RDFfdwState *state)
 {
-	char *sparql = state->raw_sparql;
-	int p = 0;
-	int end_prefixes = 0;
-	StringInfoData prefix_str;
-	StringInfoData uri_str;
-
-	initStringInfo(&prefix_str);
-	initStringInfo(&uri_str);
+	ListCell *cell;
 
 	elog(DEBUG1, "%s called", __func__);
 
-	/* Locate where the PREFIX declarations end and the query begins */
-	end_prefixes = LocateKeyword(sparql, "\n\t> ", RDF_SPARQL_KEYWORD_SELECT, " *?\n\t", NULL, 0);
+	if (state->sparql_query == NULL)
+		return;
 
-	while (p < end_prefixes)
+	foreach (cell, state->sparql_query->prefixes)
 	{
-		/* Skip whitespace */
-		while (p < end_prefixes && isspace(sparql[p]))
-			p++;
-
-		/* Look for a PREFIX declaration */
-		if (strncasecmp(sparql + p, RDF_SPARQL_KEYWORD_PREFIX, strlen(RDF_SPARQL_KEYWORD_PREFIX)) == 0)
-		{
-			RDFPrefix *entry = palloc(sizeof(RDFPrefix));
-
-			p += strlen(RDF_SPARQL_KEYWORD_PREFIX);
-
-			/* Skip whitespace after "PREFIX" */
-			while (p < end_prefixes && isspace(sparql[p]))
-				p++;
-
-			/* Read prefix name (up to ':') */
-			resetStringInfo(&prefix_str);
-			while (p < end_prefixes && !isspace(sparql[p]) && sparql[p] != ':')
-			{
-				appendStringInfoChar(&prefix_str, sparql[p]);
-				p++;
-			}
-
-			/* Expect and skip ':' */
-			if (p >= end_prefixes || sparql[p] != ':')
-				ereport(ERROR, (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
-								errmsg("malformed PREFIX: expected ':' after prefix label")));
-			p++;
+		SPARQLPrefixDecl *decl = (SPARQLPrefixDecl *)lfirst(cell);
+		RDFPrefix *entry = palloc(sizeof(RDFPrefix));
 
-			/* Skip whitespace after ':' */
-			while (p < end_prefixes && isspace(sparql[p]))
-				p++;
-
-			/* Expect '<' */
-			if (p >= end_prefixes || sparql[p] != '<')
-				ereport(ERROR, (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
-								errmsg("malformed PREFIX: expected '<' before URI")));
-			p++;
-
-			/* Read URI up to '>' */
-			resetStringInfo(&uri_str);
-			while (p < end_prefixes && sparql[p] != '>')
-			{
-				appendStringInfoChar(&uri_str, sparql[p]);
-				p++;
-			}
-
-			if (p >= end_prefixes || sparql[p] != '>')
-				ereport(ERROR, (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
-								errmsg("malformed PREFIX: unterminated URI")));
-			p++; /* Skip '>' */
-
-			/* Store the prefix */
-			entry->prefix = pstrdup(prefix_str.data);
-			entry->url = pstrdup(uri_str.data);
-			state->prefixes = lappend(state->prefixes, entry);
+		entry->prefix = pstrdup(decl->label);
+		entry->url = pstrdup(decl->iri);
+		state->prefixes = lappend(state->prefixes, entry);
 
-			elog(DEBUG1, "Parsed PREFIX: %s -> %s", entry->prefix, entry->url);
-		}
-		else
-		{
-			/* Skip to next line or fail fast? */
-			while (p < end_prefixes && sparql[p] != '\n')
-				p++;
-			p++;
-		}
+		elog(DEBUG1, "Parsed PREFIX: %s -> %s", entry->prefix, entry->url);
 	}
 }
 
@@ -10916,9 +17061,6 @@ Datum interval_ge_rdfnode(PG_FUNCTION_ARGS)
 
 static void LoadPrefixes(RDFfdwState *state)
 {
-	int ret;
-	bool isnull;
-	char query[1024];
 	ListCell *cell;
 	StringInfoData prefixes;
 
@@ -10928,69 +17070,211 @@ static void LoadPrefixes(RDFfdwState *state)
 
 	if (state->prefix_context)
 	{
-		MemoryContext oldcontext = CurrentMemoryContext;
+		List *context_prefixes = GetContextPrefixes(state->prefix_context);
+
+		if (context_prefixes == NIL)
+			elog(WARNING, "no prefixes found for context '%s'", state->prefix_context);
 
-		if (SPI_connect() != SPI_OK_CONNECT)
-			elog(ERROR, "rdf_fdw: SPI_connect failed");
+		/* copy the cached entries, as the cache might be reset any time */
+		foreach (cell, context_prefixes)
+		{
+			RDFPrefix *cached = (RDFPrefix *)lfirst(cell);
+			RDFPrefix *entry = palloc(sizeof(RDFPrefix));
 
-		snprintf(query, sizeof(query),
-				 "SELECT prefix, uri FROM sparql.prefixes WHERE context = %s",
-				 quote_literal_cstr(state->prefix_context));
+			entry->prefix = pstrdup(cached->prefix);
+			entry->url = pstrdup(cached->url);
+			state->prefixes = lappend(state->prefixes, entry);
+		}
+	}
 
-		ret = SPI_execute(query, true, 0);
+	ExtractSPARQLPrefixes(state);
 
-		if (ret != SPI_OK_SELECT)
-			elog(ERROR, "rdf_fdw: SPI_execute failed: %s", query);
+	foreach (cell, state->prefixes)
+	{
+		RDFPrefix *p = (RDFPrefix *)lfirst(cell);
+		appendStringInfo(&prefixes, "PREFIX %s: <%s>\n", p->prefix, p->url);
+	}
 
-		if (SPI_processed == 0)
-			elog(WARNING, "no prefixes found for context '%s'", state->prefix_context);
+	state->sparql_prefixes = prefixes.data;
+}
+
+/*
+ * GetContextPrefixes
+ * ------------------
+ * Returns the prefixes stored in sparql.prefixes for a prefix context. They
+ * are read with SPI the first time the context is used, and then kept in the
+ * PrefixCache until sparql.prefixes is modified. The list and its entries
+ * belong to the cache and must not be modified by the caller.
+ *
+ * context: prefix context
+ *
+ * returns a List of RDFPrefix, or NIL if the context has no prefixes
+ */
+static List *GetContextPrefixes(const char *context)
+{
+	int ret;
+	bool isnull;
+	char query[1024];
+	ListCell *cell;
+	List *result = NIL;
+	RDFfdwPrefixCacheEntry *entry;
+	MemoryContext oldcontext = CurrentMemoryContext;
+
+	if (PrefixCacheContext == NULL)
+	{
+		PrefixCacheContext = AllocSetContextCreate(CacheMemoryContext,
+												   "rdf_fdw prefixes",
+												   ALLOCSET_SMALL_SIZES);
+		CacheRegisterRelcacheCallback(PrefixCacheCallback, (Datum)0);
+	}
+
+	if (!PrefixCacheValid)
+	{
+		MemoryContextReset(PrefixCacheContext);
+		PrefixCache = NIL;
+		PrefixCacheValid = true;
+	}
+
+	foreach (cell, PrefixCache)
+	{
+		entry = (RDFfdwPrefixCacheEntry *)lfirst(cell);
 
-		for (int i = 0; i < SPI_processed; i++)
+		if (strcmp(entry->context, context) == 0)
 		{
-			HeapTuple tuple = SPI_tuptable->vals[i];
-			TupleDesc tupdesc = SPI_tuptable->tupdesc;
-			char *uri;
-			char *prefix = TextDatumGetCString(SPI_getbinval(tuple, tupdesc, 1, &isnull));
-			RDFPrefix *entry;
-			MemoryContext spicontext;
+			elog(DEBUG2, "%s: using cached prefixes of context '%s'", __func__, context);
+			return entry->prefixes;
+		}
+	}
 
-			if (isnull)
-			{
-				elog(WARNING, "%s: NULL prefix skipped", __func__);
-				continue;
-			}
+	/*
+	 * The relation is looked up before it is read, as catalog access is not
+	 * allowed in PrefixCacheCallback.
+	 */
+	if (!OidIsValid(PrefixesRelid))
+	{
+		Oid nspid = get_namespace_oid("sparql", true);
 
-			uri = TextDatumGetCString(SPI_getbinval(tuple, tupdesc, 2, &isnull));
+		if (OidIsValid(nspid))
+			PrefixesRelid = get_relname_relid("prefixes", nspid);
+	}
 
-			if (isnull)
-			{
-				elog(WARNING, "%s: NULL URI skipped", __func__);
-				continue;
-			}
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "rdf_fdw: SPI_connect failed");
 
-			/* allocate the entry and list cell in the CALLER's context */
-			spicontext = MemoryContextSwitchTo(oldcontext);
+	snprintf(query, sizeof(query),
+			 "SELECT prefix, uri FROM sparql.prefixes WHERE context = %s",
+			 quote_literal_cstr(context));
 
-			entry = palloc(sizeof(RDFPrefix));
-			entry->prefix = pstrdup(prefix);
-			entry->url = pstrdup(uri);
-			state->prefixes = lappend(state->prefixes, entry);
+	ret = SPI_execute(query, true, 0);
+
+	if (ret != SPI_OK_SELECT)
+		elog(ERROR, "rdf_fdw: SPI_execute failed: %s", query);
+
+	for (int i = 0; i < SPI_processed; i++)
+	{
+		HeapTuple tuple = SPI_tuptable->vals[i];
+		TupleDesc tupdesc = SPI_tuptable->tupdesc;
+		char *uri;
+		char *prefix = TextDatumGetCString(SPI_getbinval(tuple, tupdesc, 1, &isnull));
+		RDFPrefix *prefix_entry;
+		MemoryContext spicontext;
 
-			MemoryContextSwitchTo(spicontext);
+		if (isnull)
+		{
+			elog(WARNING, "%s: NULL prefix skipped", __func__);
+			continue;
 		}
 
-		SPI_finish();
+		uri = TextDatumGetCString(SPI_getbinval(tuple, tupdesc, 2, &isnull));
+
+		if (isnull)
+		{
+			elog(WARNING, "%s: NULL URI skipped", __func__);
+			continue;
+		}
+
+		/* allocate the entry and list cell in the CALLER's context */
+		spicontext = MemoryContextSwitchTo(oldcontext);
+
+		prefix_entry = palloc(sizeof(RDFPrefix));
+		prefix_entry->prefix = pstrdup(prefix);
+		prefix_entry->url = pstrdup(uri);
+		result = lappend(result, prefix_entry);
+
+		MemoryContextSwitchTo(spicontext);
 	}
 
-	ExtractSPARQLPrefixes(state);
+	SPI_finish();
 
-	foreach (cell, state->prefixes)
+	/*
+	 * Only store the prefixes if the cache wasn't invalidated meanwhile, e.g.
+	 * by a concurrent change committed while SPI was reading them, and if
+	 * they were not read with a transaction snapshot that might not see
+	 * changes already committed.
+	 */
+	if (!PrefixCacheValid || !OidIsValid(PrefixesRelid) || IsolationUsesXactSnapshot())
+		return result;
+
+	oldcontext = MemoryContextSwitchTo(PrefixCacheContext);
+
+	entry = (RDFfdwPrefixCacheEntry *)palloc(sizeof(RDFfdwPrefixCacheEntry));
+	entry->context = pstrdup(context);
+	entry->prefixes = NIL;
+
+	foreach (cell, result)
 	{
 		RDFPrefix *p = (RDFPrefix *)lfirst(cell);
-		appendStringInfo(&prefixes, "PREFIX %s: <%s>\n", p->prefix, p->url);
+		RDFPrefix *cached = palloc(sizeof(RDFPrefix));
+
+		cached->prefix = pstrdup(p->prefix);
+		cached->url = pstrdup(p->url);
+		entry->prefixes = lappend(entry->prefixes, cached);
 	}
 
-	state->sparql_prefixes = prefixes.data;
+	PrefixCache = lappend(PrefixCache, entry);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return entry->prefixes;
+}
+
+/*
+ * PrefixCacheCallback
+ * -------------------
+ * Relcache invalidation callback. Invalidations of sparql.prefixes are sent
+ * by rdf_fdw_invalidate_prefixes for every statement that modifies it, so
+ * the PrefixCache is marked as invalid and emptied when it is used next. An
+ * InvalidOid (e.g. after a cache reset) invalidates it as well.
+ */
+static void PrefixCacheCallback(Datum arg, Oid relid)
+{
+	if (!OidIsValid(relid) || relid == PrefixesRelid)
+	{
+		PrefixCacheValid = false;
+		/* looked up again, in case the extension was dropped */
+		PrefixesRelid = InvalidOid;
+	}
+}
+
+/*
+ * rdf_fdw_invalidate_prefixes
+ * ---------------------------
+ * Statement-level trigger function of sparql.prefixes. Modifying rows does
+ * not invalidate the relcache entry of a table, so this is done here to let
+ * every backend (including this one) know that its PrefixCache is stale.
+ */
+Datum rdf_fdw_invalidate_prefixes(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *)fcinfo->context;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_E_R_I_E_TRIGGER_PROTOCOL_VIOLATED),
+				 errmsg("%s: not called by trigger manager", __func__)));
+
+	CacheInvalidateRelcache(trigdata->tg_relation);
+
+	PG_RETURN_POINTER(NULL);
 }
 
 /*
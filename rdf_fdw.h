@@ -20,6 +20,7 @@
 #include <curl/curl.h>       /* CURL */
 #include <libxml/tree.h>     /* xmlDocPtr, xmlNodePtr */
 #include "lib/stringinfo.h"  /* StringInfoData */
+#include "sparql_parser.h"   /* SPARQLQuery */
 /* Version */
 #define FDW_VERSION "2.7"
 
@@ -41,6 +42,11 @@
 #define RDF_TABLE_OPTION_ENABLE_PUSHDOWN "enable_pushdown"
 #define RDF_TABLE_OPTION_FETCH_SIZE "fetch_size"
 #define RDF_TABLE_OPTION_READONLY "readonly"
+#define RDF_TABLE_OPTION_ENABLE_STREAMING "enable_streaming"
+#define RDF_TABLE_OPTION_USE_REMOTE_ESTIMATE "use_remote_estimate"
+#define RDF_TABLE_OPTION_ENABLE_TERM_BINDING "enable_term_binding"
+#define RDF_TABLE_OPTION_VALUES_THRESHOLD "values_threshold"
+#define RDF_TABLE_OPTION_ENABLE_DIRECT_MODIFY "enable_direct_modify"
 
 /* Column options */
 #define RDF_COLUMN_OPTION_VARIABLE "variable"
@@ -64,6 +70,7 @@
 #define RDF_SPARQL_KEYWORD_ORDERBY "ORDER BY"
 #define RDF_SPARQL_KEYWORD_HAVING "HAVING"
 #define RDF_SPARQL_KEYWORD_LIMIT "LIMIT"
+#define RDF_SPARQL_KEYWORD_OFFSET "OFFSET"
 #define RDF_SPARQL_KEYWORD_UNION "UNION"
 #define RDF_SPARQL_KEYWORD_MINUS "MINUS"
 
@@ -76,6 +83,11 @@
 #define RDF_SPARQL_AGGREGATE_FUNCTION_SAMPLE "SAMPLE"
 #define RDF_SPARQL_AGGREGATE_FUNCTION_GROUPCONCAT "GROUP_CONCAT"
 
+/* comment replaced by the values of a parameterized scan, see BindParameters() */
+#define RDF_SPARQL_PARAMETERS_MARKER "## rdf_fdw parameters ##"
+/* comment replaced by the VALUES block of each request of a split IN list, see SendValuesChunk() */
+#define RDF_SPARQL_VALUES_MARKER "## rdf_fdw values ##"
+
 /* XML and SPARQL result tags */
 #define RDF_XML_NAME_TAG "name"
 #define RDF_SPARQL_RESULT_LITERAL "literal"
@@ -96,9 +108,16 @@
 #define RDF_KEYWORD_NOT_FOUND -1
 #define RDF_DEFAULT_FORMAT "application/sparql-results+xml"
 #define RDF_RDFXML_FORMAT "application/rdf+xml"
+#define RDF_SPARQL_JSON_FORMAT "application/sparql-results+json"
+#define RDF_SPARQL_TSV_FORMAT "text/tab-separated-values"
 #define RDF_DEFAULT_QUERY_PARAM "query"
 #define RDF_DEFAULT_FETCH_SIZE 100
 #define RDF_DEFAULT_BATCH_SIZE 50
+#define RDF_DEFAULT_COPY_BATCH_SIZE 1000
+#define RDF_DEFAULT_REMOTE_ESTIMATE_TTL 300
+#define RDF_ESTIMATE_CACHE_SIZE 256
+#define RDF_PARAM_BATCH_MAX_KEYS 10000
+#define RDF_ANALYZE_SAMPLE_WINDOWS 10
 
 /* RDF base URIs */
 #define RDF_DEFAULT_BASE_URI "http://rdf_fdw.postgresql.org/"
@@ -149,6 +168,7 @@
 /* Server options */
 #define RDF_SERVER_OPTION_SELECT_URL "endpoint"
 #define RDF_SERVER_OPTION_UPDATE_URL "update_url"
+#define RDF_SERVER_OPTION_GRAPH_STORE_URL "graph_store_url"
 #define RDF_SERVER_OPTION_FORMAT "format"
 #define RDF_SERVER_OPTION_CUSTOMPARAM "custom"
 #define RDF_SERVER_OPTION_CONNECTTIMEOUT "connect_timeout"
@@ -167,6 +187,13 @@
 #define RDF_SERVER_OPTION_BATCH_SIZE "batch_size" 
 #define RDF_SERVER_OPTION_READONLY "readonly"
 #define RDF_SERVER_OPTION_MAX_RESPONSE_SIZE "max_response_size"
+#define RDF_SERVER_OPTION_ENABLE_STREAMING "enable_streaming"
+#define RDF_SERVER_OPTION_USE_REMOTE_ESTIMATE "use_remote_estimate"
+#define RDF_SERVER_OPTION_REMOTE_ESTIMATE_TTL "remote_estimate_ttl"
+#define RDF_SERVER_OPTION_ENABLE_TERM_BINDING "enable_term_binding"
+#define RDF_SERVER_OPTION_VALUES_THRESHOLD "values_threshold"
+#define RDF_SERVER_OPTION_MAX_VALUES_SIZE "max_values_size"
+#define RDF_SERVER_OPTION_ENABLE_DIRECT_MODIFY "enable_direct_modify"
 
 extern Oid RDFNODEOID;
 
@@ -179,12 +206,48 @@ typedef enum RDFfdwQueryType
 	SPARQL_UPDATE
 } RDFfdwQueryType;
 
+/*
+ * Counters of a scan reported by EXPLAIN (ANALYZE), collected only if the
+ * scan is instrumented. Times are in milliseconds and are only measured if
+ * 'timing' is set, i.e. unless EXPLAIN was called with TIMING OFF.
+ */
+typedef struct RDFfdwScanStats
+{
+	bool timing;			/* measure the times below */
+	long requests;			/* HTTP requests sent to the endpoint */
+	long retries;			/* requests repeated after network errors */
+	long rows;				/* records parsed from the responses */
+	double bytes;			/* response bytes received, as transferred */
+	double bytes_decoded;	/* response bytes after content decoding */
+	double connect_time;	/* establishing the connections (incl. DNS) */
+	double first_byte_time; /* until the first response byte arrived */
+	double transfer_time;	/* whole requests */
+	double parse_time;		/* parsing the responses into records */
+	double conversion_time; /* converting records into tuples */
+} RDFfdwScanStats;
+
+/*
+ * RDFfdwRequestBody
+ * -----------------
+ * Body of a batched update request, sent by libcurl directly from its
+ * parts, i.e. the prefixes, the batch buffer and the closing brackets of
+ * the last data block, instead of being copied into a single string first.
+ */
+typedef struct RDFfdwRequestBody
+{
+	const char *parts[3]; /* prologue, statements and epilogue */
+	size_t lengths[3];	  /* lengths of 'parts' */
+	int part;			  /* part being sent */
+	size_t offset;		  /* bytes of 'part' already sent */
+} RDFfdwRequestBody;
+
 typedef struct RDFfdwState
 {
 	int numcols;					   /* Total number of columns in the foreign table. */
 	int rowcount;					   /* Number of rows currently returned to the client */
 	int pagesize;					   /* Total number of records retrieved from the SPARQL endpoint*/
 	char *sparql;					   /* Final SPARQL query sent to the endpoint (after pushdown) */
+	RDFfdwRequestBody *request_body;   /* Body of update requests, sent instead of 'sparql' if set */
 	char *user;						   /* User name for HTTP basic authentication */
 	char *password;					   /* Password for HTTP basic authentication */
 	char *token;					   /* Bearer token for HTTP token-based authentication */
@@ -194,12 +257,19 @@ typedef struct RDFfdwState
 	char *sparql_where;				   /* SPARQL WHERE clause */
 	char *sparql_filter;			   /* SPARQL FILTER clauses based on SQL WHERE conditions */
 	char *sparql_filter_expr;          /* SPARQL FILTER clauses as single expression (for EXPLAIN output) */
+	char *sparql_values;			   /* VALUES blocks of the equalities bound in the graph pattern (enable_term_binding) */
 	char *sparql_orderby;			   /* SPARQL ORDER BY clause based on the SQL ORDER BY clause */
 	char *sparql_limit;				   /* SPARQL LIMIT clause based on SQL LIMIT and FETCH clause */
+	char *sparql_groupby;			   /* SPARQL GROUP BY clause based on the SQL GROUP BY clause */
+	char *sparql_having;			   /* SPARQL HAVING clause based on the SQL HAVING clause */
 	char *sparql_resultset;			   /* Raw string containing the result of a SPARQL query */
 	char *sparql_update_pattern;       /* SPARQL triple pattern for INSERT/DELETE/UPDATE queries */
+	char *sparql_count;				   /* SPARQL query counting the rows of a direct UPDATE/DELETE */
 	char *raw_sparql;				   /* Raw SPARQL query set in the CREATE TABLE statement */
+	SPARQLQuery *sparql_query;		   /* Clauses of raw_sparql, parsed once per FOREIGN TABLE */
 	char *endpoint;					   /* SPARQL endpoint set in the CREATE SERVER statement*/
+	char *graph_store_url;			   /* Graph Store Protocol endpoint used to load inserted triples */
+	const char *graph_store_format;	   /* Content-Type of inserts sent to graph_store_url, or NULL */
 	char *query_param;				   /* SPARQL query POST parameter used by the endpoint */
 	char *format;					   /* Format in which the RDF triplestore has to reply */
 	char *prefix_context;              /* Prefix context for SPARQL queries */
@@ -212,19 +282,48 @@ typedef struct RDFfdwState
 	bool request_redirect;			   /* Enables or disables URL redirecting. */
 	bool enable_pushdown;			   /* Enables or disables pushdown of SQL commands */
 	bool enable_xml_huge;			   /* Enables or disables XML parser to handle huge XML documents */
+	bool enable_streaming;			   /* Parses SELECT results while they are being downloaded */
+	bool enable_term_binding;		   /* Binds equalities as terms of the graph pattern instead of FILTER */
+	int values_threshold;			   /* Minimum number of elements of IN lists pushed down as VALUES (0 = never) */
+	long max_values_size;			   /* Maximum size in bytes of the VALUES block of a request (0 = unlimited) */
+	bool use_remote_estimate;		   /* Asks the endpoint for the number of rows when planning */
+	bool enable_direct_modify;		   /* Sends UPDATE and DELETE as a single SPARQL UPDATE if possible */
+	bool set_processed;				   /* A direct UPDATE/DELETE sets the row count of the command */
 	bool is_sparql_parsable;		   /* Marks whether the SPARQL query is parsable for pushdown */
 	bool log_sparql;				   /* Enables or disables logging SPARQL queries as NOTICE */
 	bool has_unparsable_conds;		   /* Marks a query that contains expressions that cannot be parsed for pushdown. */
 	bool readonly;				   	   /* Enables or disables INSERT, UPDATE, and DELETE operations */
+	bool is_join;					   /* Scans a join of FOREIGN TABLEs pushed down as a single SPARQL query */
 	List *remote_conds;				   /* List of RestrictInfo nodes that were successfully pushed down to the remote SPARQL endpoint */
+	List *scan_tlist;				   /* Expressions of the scan tuple of pushed down joins and aggregations */
+	List *param_columns;			   /* Names of the columns bound to the values of a parameterized scan */
+	List *param_exprs;				   /* ExprStates computing the values of 'param_columns' */
+	bool params_bound;				   /* The request with the current parameter values was sent */
+	char *sparql_params;			   /* SPARQL query of a parameterized or split scan, before the values are bound */
+	MemoryContext param_cxt;		   /* Memory Context for the result of the current parameter values, VALUES block or streamed request */
+	List *values_chunks;			   /* VALUES blocks of an IN list sent in separate requests (max_values_size) */
+	int values_chunk;				   /* Index of the next VALUES block to be sent */
+	char *param_batch_sql;			   /* SQL query returning the join keys of the outer table of a parameterized scan, see LoadParameterBatch() */
+	struct HTAB *param_batch;		   /* Rows of a batched parameterized scan for each join key, or NULL if not loaded yet */
+	struct RDFfdwParamBatchEntry *param_batch_entry; /* Rows of the current join key, or NULL if they are requested from the endpoint */
+	int param_batch_pos;			   /* Index of the next row of 'param_batch_entry' */
+	MemoryContext param_batch_cxt;	   /* Memory Context of 'param_batch' */
 	long request_max_redirect;		   /* Limit of how many times the URL redirection (jump) may occur. */
 	long connect_timeout;				   /* Timeout for establishing a connection to the SPARQL endpoint */
 	long request_timeout;				   /* Timeout for the entire HTTP request (connect + transfer) */
 	long max_retries;				   /* Number of retry attempts for failed SPARQL queries */
 	long max_response_size;			   /* Maximum allowed HTTP response body size in bytes (0 = unlimited) */
+	long remote_estimate_ttl;		   /* Seconds a remote row count estimate is cached (0 = not cached) */
 	xmlDocPtr xmldoc;				   /* XML document where the result of SPARQL queries will be stored */
 	Oid foreigntableid;				   /* FOREIGN TABLE oid */
 	List *records;					   /* List of records retrieved from a SPARQL request (after parsing 'xmldoc')*/
+	struct RDFfdwStream *stream;	   /* Streamed SELECT result (enable_streaming), or NULL */
+	RDFfdwScanStats *stats;			   /* Counters for EXPLAIN (ANALYZE), or NULL if not instrumented */
+	struct SPARQLTsvParser *tsv;	   /* SPARQL TSV result set, read instead of 'xmldoc' and 'records' */
+	int *tsv_fields;				   /* field of each column in the rows of 'tsv' (-1 if not in the result) */
+	struct SPARQLJsonParser *json;	   /* SPARQL JSON result set, read instead of 'xmldoc' and 'records' */
+	int *json_fields;				   /* term of each column in the rows of 'json' (-1 if it has no variable) */
+	struct HTAB *binding_map;		   /* columns of each SPARQL variable, see CreateBindingMap() */
 	List *prefixes; 		   		   /* List of RDF prefixes used in the SPARQL query and context */
 	struct RDFfdwTable *rdfTable;	   /* All necessary information of the FOREIGN TABLE used in a SQL statement */
 	Cost startup_cost;				   /* startup cost estimate */
@@ -235,7 +334,7 @@ typedef struct RDFfdwState
 	MemoryContext rdfctxt;			   /* Memory Context for data manipulation */
 	CURL *curl;						   /* CURL request handler */
 	RDFfdwQueryType sparql_query_type; /* SPARQL Query type: SELECT, DESCRIBE */
-	MemoryContext temp_cxt;			   /* Temporary memory context for per-row allocations during INSERT */
+	MemoryContext temp_cxt;			   /* Temporary memory context for per-row allocations, reset for every row */
 	/* exclusively for rdf_fdw_clone_table usage */
 	Relation target_table;
 	bool verbose;
@@ -249,6 +348,7 @@ typedef struct RDFfdwState
 	int batch_size; 				   /* Number of rows to batch for INSERT/UPDATE/DELETE */
 	int batch_count;				   /* Current number of rows in the batch buffer */
 	StringInfoData batch_statements;   /* Buffer for batched SPARQL statements */
+	RDFfdwQueryType batch_block;	   /* Operation of the last data block in 'batch_statements' */
 } RDFfdwState;
 
 typedef struct RDFfdwTable
@@ -257,6 +357,22 @@ typedef struct RDFfdwTable
 	struct RDFfdwColumn **cols; /* List of columns of a FOREIGN TABLE */
 } RDFfdwTable;
 
+/*
+ * Direct conversions of lexical forms into Datums, chosen for each column
+ * from its data type and literaltype by GetColumnDecoder(). Values they
+ * don't accept go through the input function of the column's type.
+ */
+typedef enum RDFfdwDecoder
+{
+	RDF_DECODER_INPUT,	/* input function of the type only */
+	RDF_DECODER_INT2,	/* xsd:integer (and derived types) -> smallint */
+	RDF_DECODER_INT4,	/* xsd:integer (and derived types) -> integer */
+	RDF_DECODER_INT8,	/* xsd:integer (and derived types) -> bigint */
+	RDF_DECODER_FLOAT8, /* xsd:double, xsd:float, xsd:decimal -> double precision */
+	RDF_DECODER_BOOL,	/* xsd:boolean -> boolean */
+	RDF_DECODER_TIMESTAMPTZ /* xsd:dateTime with a time zone -> timestamp with time zone */
+} RDFfdwDecoder;
+
 typedef struct RDFfdwColumn
 {
 	char *name;			 /* Column name */
@@ -265,12 +381,18 @@ typedef struct RDFfdwColumn
 	char *literaltype;	 /* Column OPTION 'type' - literal data type */
 	char *literal_fomat; /* Column OPTION 'literal_format' - literal value format ('raw' or 'content') */
 	char *nodetype;		 /* Column OPTION 'nodetype' - node data type */
+	bool has_nodetype;	 /* Column OPTION 'nodetype' was set, see LoadRDFTableInfo() */
 	char *language;		 /* Column OPTION 'language' - RDF language tag for literals */
 	Oid pgtype;			 /* PostgreSQL data type */
 	int pgtypmod;		 /* PostgreSQL type modifier */
 	int pgattnum;		 /* PostgreSQL attribute number */
 	bool used;			 /* Is the column used in the current SQL query? */
 	bool pushable;		 /* Marks a column as safe or not to pushdown */
+	bool notnull;		 /* Column has a NOT NULL constraint, i.e. its variable is always bound */
+	FmgrInfo *typinput;	 /* input function of pgtype, see InitColumnInput() */
+	Oid typioparam;		 /* type OID passed to the input function */
+	int typinputmod;	 /* type modifier passed to the input function */
+	RDFfdwDecoder decoder; /* direct conversion of values, see CreateDatum() */
 
 } RDFfdwColumn;
 
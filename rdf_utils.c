@@ -1021,7 +1021,8 @@ bool IsSPARQLVariableValid(const char *str)
  * Checks if a SPARQL query can be parsed and modified to accommodate possible
  * pushdown instructions. If it returns false it does not mean that the query
  * is invalid. It just means that it contains unsupported clauses and it cannot
- * be modifed.
+ * be modifed. Queries with solution modifiers or aggregates are modified as
+ * a sub-select, see SPARQLDeparseGroupPattern().
  *
  * state: SPARQL, SERVER and FOREIGN TABLE info
  *
@@ -1029,28 +1030,18 @@ bool IsSPARQLVariableValid(const char *str)
  */
 bool IsSPARQLParsable(struct RDFfdwState *state)
 {
-	int keyword_count = 0;
 	bool result;
 
 	Assert(state != NULL);
-	Assert(state->raw_sparql != NULL);
+	Assert(state->sparql_query != NULL);
 
 	elog(DEBUG3, "%s called", __func__);
-	/*
-	 * SPARQL Queries containing SUB SELECTS are not supported. So, if any number
-	 * other than 1 is returned from LocateKeyword, this query cannot be parsed.
-	 */
-	LocateKeyword(state->raw_sparql, "{\n\t> ", RDF_SPARQL_KEYWORD_SELECT, " *?\n\t", &keyword_count, 0);
 
-	elog(DEBUG2, "%s: SPARQL contains '%d' SELECT clauses.", __func__, keyword_count);
+	result = state->sparql_query->form == SPARQL_FORM_SELECT &&
+			 state->sparql_query->error == NULL;
 
-	result = LocateKeyword(state->raw_sparql, " \n\t}", RDF_SPARQL_KEYWORD_GROUPBY, " \n\t?", NULL, 0) == RDF_KEYWORD_NOT_FOUND &&
-			 LocateKeyword(state->raw_sparql, " \n\t}", RDF_SPARQL_KEYWORD_ORDERBY, " \n\t?DA", NULL, 0) == RDF_KEYWORD_NOT_FOUND &&
-			 LocateKeyword(state->raw_sparql, " \n\t}", RDF_SPARQL_KEYWORD_LIMIT, " \n\t", NULL, 0) == RDF_KEYWORD_NOT_FOUND &&
-			 LocateKeyword(state->raw_sparql, " \n\t}", RDF_SPARQL_KEYWORD_MINUS, " \n\t{", NULL, 0) == RDF_KEYWORD_NOT_FOUND &&
-			 LocateKeyword(state->raw_sparql, " \n\t}", RDF_SPARQL_KEYWORD_UNION, " \n\t{", NULL, 0) == RDF_KEYWORD_NOT_FOUND &&
-			 LocateKeyword(state->raw_sparql, " \n\t", RDF_SPARQL_KEYWORD_HAVING, " \n\t(", NULL, 0) == RDF_KEYWORD_NOT_FOUND &&
-			 keyword_count == 1;
+	if (result && SPARQLQueryNeedsSubquery(state->sparql_query))
+		elog(DEBUG2, "%s: SPARQL contains solution modifiers or aggregates and will be used as a sub-select", __func__);
 
 	elog(DEBUG3, "%s exit: returning '%s'", __func__, !result ? "false" : "true");
 	return result;
@@ -1613,3 +1604,144 @@ char *EscapeSPARQLLiteral(const char *input)
 
 	return result.data;
 }
+
+/*
+ * IsSPARQLNameChar
+ * ----------------
+ * Checks if 'c' may be part of a SPARQL variable name or blank node label.
+ * Non-ASCII (UTF-8) bytes are accepted, as they stand for the PN_CHARS_U
+ * code points of the SPARQL 1.1 grammar.
+ */
+static bool IsSPARQLNameChar(char c)
+{
+	return isalnum((unsigned char)c) || c == '_' || (unsigned char)c >= 0x80;
+}
+
+/*
+ * RenameSPARQLVariables
+ * ---------------------
+ * Renames the variables and blank node labels of a SPARQL fragment, e.g. a
+ * graph pattern, FILTER or expression, so that the fragments of different
+ * foreign tables can be combined into a single query without clashing.
+ * Every variable ?name (or $name) becomes ?<prefix>name, unless 'name' is
+ * listed in 'names', in which case it is replaced by the variable at the same
+ * position in 'targets'. Blank node labels _:b become _:<prefix>b. IRIs,
+ * literals and comments are copied verbatim.
+ *
+ * fragment: SPARQL fragment to be renamed
+ * prefix  : prefix added to variable names and blank node labels
+ * names   : variable names (without '?') that are explicitly renamed, or NIL
+ * targets : variables (with '?') replacing the ones in 'names'
+ *
+ * returns a new string with the renamed fragment
+ */
+char *RenameSPARQLVariables(const char *fragment, const char *prefix, List *names, List *targets)
+{
+	StringInfoData result;
+	const char *p = fragment;
+
+	if (!fragment)
+		return NULL;
+
+	initStringInfo(&result);
+
+	while (*p)
+	{
+		if (*p == '"' || *p == '\'')
+		{
+			/* string literal, short ("...") or long ("""...""") */
+			const char *start = p;
+			char quote = *p;
+			bool is_long = p[1] == quote && p[2] == quote;
+
+			p += is_long ? 3 : 1;
+
+			while (*p)
+			{
+				if (*p == '\\' && p[1] != '\0')
+					p += 2;
+				else if (*p == quote && (!is_long || (p[1] == quote && p[2] == quote)))
+				{
+					p += is_long ? 3 : 1;
+					break;
+				}
+				else
+					p++;
+			}
+
+			appendBinaryStringInfo(&result, start, p - start);
+		}
+		else if (*p == '<')
+		{
+			/* IRI reference, otherwise the "less than" operator */
+			const char *end = p + 1;
+
+			while (*end && (unsigned char)*end > 0x20 && !strchr("<>\"{}|^`\\", *end))
+				end++;
+
+			if (*end == '>')
+			{
+				appendBinaryStringInfo(&result, p, end - p + 1);
+				p = end + 1;
+			}
+			else
+				appendStringInfoChar(&result, *p++);
+		}
+		else if (*p == '#')
+		{
+			/* comment until the end of the line */
+			const char *end = strchr(p, '\n');
+
+			if (!end)
+				end = p + strlen(p);
+
+			appendBinaryStringInfo(&result, p, end - p);
+			p = end;
+		}
+		else if (*p == '\\' && p[1] != '\0')
+		{
+			/* escaped character of a prefixed name, e.g. ex:a\#b */
+			appendBinaryStringInfo(&result, p, 2);
+			p += 2;
+		}
+		else if ((*p == '?' || *p == '$') && IsSPARQLNameChar(p[1]))
+		{
+			const char *start = ++p;
+			char *name;
+			bool found = false;
+			ListCell *name_cell;
+			ListCell *target_cell;
+
+			while (IsSPARQLNameChar(*p))
+				p++;
+
+			name = pnstrdup(start, p - start);
+
+			forboth(name_cell, names, target_cell, targets)
+			{
+				if (strcmp(name, (char *)lfirst(name_cell)) == 0)
+				{
+					appendStringInfoString(&result, (char *)lfirst(target_cell));
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+				appendStringInfo(&result, "?%s%s", prefix, name);
+
+			pfree(name);
+		}
+		else if (*p == '_' && p[1] == ':' &&
+				 (p == fragment || !(IsSPARQLNameChar(p[-1]) || p[-1] == '-' || p[-1] == '.')))
+		{
+			/* blank node label (and not the end of a prefix like my_:) */
+			appendStringInfo(&result, "_:%s", prefix);
+			p += 2;
+		}
+		else
+			appendStringInfoChar(&result, *p++);
+	}
+
+	return result.data;
+}
@@ -57,6 +57,7 @@ extern Const *CStringToConst(const char *str);
 /* SPARQL Query Generation */
 extern char *CreateRegexString(char *str);
 extern char *FormatSQLExtractField(char *field);
+extern char *RenameSPARQLVariables(const char *fragment, const char *prefix, List *names, List *targets);
 
 #if PG_VERSION_NUM < 130000
 void pg_unicode_to_server(pg_wchar c, unsigned char *utf8);
@@ -0,0 +1,61 @@
+/*
+ * Ingest benchmark (not part of the regression tests)
+ *
+ * Loads the same triples into the Fuseki test container, first with SPARQL
+ * UPDATE and then through the Graph Store Protocol (graph_store_url), and
+ * prints the triples/sec of both paths. Deploy the container with
+ * scripts/postgres-env/fuseki/deploy-fuseki.sh and run:
+ *
+ *   psql -d postgres -v triples=1000000 -f scripts/benchmarks/fuseki-ingest.sql
+ *
+ * 'triples' defaults to one million.
+ */
+\if :{?triples}
+\else
+  \set triples 1000000
+\endif
+
+CREATE SERVER fuseki_ingest
+FOREIGN DATA WRAPPER rdf_fdw
+OPTIONS (
+  endpoint   'http://fuseki:3030/dt/sparql',
+  update_url 'http://fuseki:3030/dt/update',
+  batch_size '10000');
+
+CREATE FOREIGN TABLE ft_ingest (
+  subject   rdfnode OPTIONS (variable '?s'),
+  predicate rdfnode OPTIONS (variable '?p'),
+  object    rdfnode OPTIONS (variable '?o')
+)
+SERVER fuseki_ingest OPTIONS (
+  sparql 'SELECT * {?s ?p ?o}',
+  sparql_update_pattern '?s ?p ?o .'
+);
+
+CREATE USER MAPPING FOR CURRENT_USER
+SERVER fuseki_ingest OPTIONS (user 'admin', password 'secret');
+
+CREATE TEMPORARY TABLE ingest_rate (path text, triples bigint, seconds float8);
+CREATE FUNCTION pg_temp.ingest(path text, triples int) RETURNS void AS $$
+DECLARE
+  started timestamptz := clock_timestamp();
+BEGIN
+  INSERT INTO ft_ingest (subject, predicate, object)
+  SELECT '<https://www.uni-muenster.de>', '<http://www.w3.org/2000/01/rdf-schema#label>', i::rdfnode
+  FROM generate_series(1, triples) AS g(i);
+  INSERT INTO ingest_rate VALUES (path, triples, extract(epoch FROM clock_timestamp() - started));
+END; $$ LANGUAGE plpgsql;
+
+SELECT pg_temp.ingest('sparql_update', :triples);
+DELETE FROM ft_ingest;
+
+ALTER SERVER fuseki_ingest OPTIONS (ADD graph_store_url 'http://fuseki:3030/dt/data');
+SELECT pg_temp.ingest('graph_store', :triples);
+DELETE FROM ft_ingest;
+
+SELECT path, triples, round(seconds::numeric, 2) AS seconds,
+       round(triples / seconds) AS triples_per_sec
+FROM ingest_rate
+ORDER BY path;
+
+DROP SERVER fuseki_ingest CASCADE;
@@ -0,0 +1,906 @@
+/*---------------------------------------------------------------------
+ *
+ * sparql_json.c
+ *   Decoder for SPARQL 1.1 Query Results JSON Format
+ *   (application/sparql-results+json).
+ *
+ * The decoder is a push parser: the response body is fed to it in chunks
+ * of arbitrary size, as they are received from the endpoint. The caller
+ * registers the variables it needs beforehand, and every complete entry
+ * of "results.bindings" becomes a row with one RDF term per registered
+ * variable:
+ *
+ *   {"s": {"type": "literal", "value": "foo", "xml:lang": "en"}}
+ *
+ * becomes a row whose term of "?s" is the literal "foo" with the language
+ * tag "en". Bindings of other variables are skipped without being copied.
+ *
+ * Copyright (C) 2022-2026 Jim Jones <jim.jones@uni-muenster.de>
+ *
+ *---------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "rdf_fdw.h"
+#include "sparql_json.h"
+
+#include "lib/stringinfo.h"
+#include "mb/pg_wchar.h"
+#include "utils/memutils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* maximum nesting level of JSON containers */
+#define SPARQL_JSON_MAX_DEPTH 64
+
+/* replacement character for lone UTF-16 surrogates */
+#define SPARQL_JSON_REPLACEMENT_CHAR 0xFFFD
+
+typedef enum
+{
+	JSON_EXPECT_VALUE,		  /* any value, e.g. after ':' */
+	JSON_EXPECT_VALUE_OR_END, /* first element of an array or ']' */
+	JSON_EXPECT_KEY,		  /* member name, after ',' in an object */
+	JSON_EXPECT_KEY_OR_END,	  /* first member name of an object or '}' */
+	JSON_EXPECT_COLON,		  /* ':' after a member name */
+	JSON_EXPECT_COMMA_OR_END, /* ',', '}' or ']' after a value */
+	JSON_IN_STRING,			  /* inside a string */
+	JSON_IN_ESCAPE,			  /* after a '\' inside a string */
+	JSON_IN_UNICODE,		  /* inside a \uXXXX escape */
+	JSON_IN_LITERAL,		  /* inside a number, true, false or null */
+	JSON_EXPECT_EOF			  /* after the top-level value */
+} SPARQLJsonLexState;
+
+typedef struct SPARQLJsonLevel
+{
+	bool is_object;	  /* object or array */
+	bool is_bindings; /* the "results.bindings" array */
+	char *key;		  /* name of the member being parsed (objects only) */
+} SPARQLJsonLevel;
+
+struct SPARQLJsonParser
+{
+	/* tokenizer */
+	SPARQLJsonLexState state;
+	SPARQLJsonLevel levels[SPARQL_JSON_MAX_DEPTH];
+	int depth;				 /* number of open containers */
+	bool string_is_key;		 /* the string being read is a member name */
+	StringInfoData token;	 /* string or literal being read */
+	pg_wchar codepoint;		 /* \uXXXX escape being read */
+	int hexdigits;			 /* number of hex digits read in codepoint */
+	pg_wchar high_surrogate; /* pending high surrogate of a \uXXXX pair */
+	size_t offset;			 /* bytes consumed so far */
+	char *error;			 /* error message, once parsing failed */
+	MemoryContext cxt;		 /* memory context the parser was created in */
+
+	/* registered variables, without '?' */
+	char **variables;
+	int numvars;
+	int maxvars;
+
+	/* decoded result set */
+	SPARQLJsonTerm **rows;	 /* complete rows, not yet consumed unless 'keep' */
+	int numrows;
+	int maxrows;
+	int next;				 /* index of the next row to be read */
+	bool keep;				 /* keep consumed rows, so they can be read again */
+	SPARQLJsonTerm *row;	 /* row being decoded, not yet in 'rows' */
+	int row_level;			 /* level of the binding object of 'row' */
+	bool in_term;			 /* inside the RDF term of a variable */
+	int term_index;			 /* variable of the term, or -1 if not registered */
+	char *term_var;
+	char *term_type;
+	char *term_value;
+	char *term_datatype;
+	char *term_lang;
+};
+
+static bool JsonParseChunk(SPARQLJsonParser *parser, const char *chunk, size_t size, bool terminate);
+static bool JsonError(SPARQLJsonParser *parser, const char *message);
+static bool JsonBeginContainer(SPARQLJsonParser *parser, bool is_object);
+static bool JsonEndContainer(SPARQLJsonParser *parser, bool is_object);
+static bool JsonScalar(SPARQLJsonParser *parser, bool is_string);
+static bool JsonEndLiteral(SPARQLJsonParser *parser);
+static bool JsonAddTerm(SPARQLJsonParser *parser);
+static void JsonAddRow(SPARQLJsonParser *parser);
+static void JsonFreeRow(SPARQLJsonParser *parser, SPARQLJsonTerm *row);
+static void JsonAppendCodepoint(SPARQLJsonParser *parser, pg_wchar c);
+static void JsonFlushSurrogate(SPARQLJsonParser *parser);
+static void JsonResetTerm(SPARQLJsonParser *parser);
+
+/*
+ * SPARQLJsonCreateParser
+ * ----------------------
+ * Creates a SPARQL JSON push parser in the current memory context. Its
+ * variables must be registered with SPARQLJsonAddVariable before any data
+ * is fed to it.
+ *
+ * keep: keep the rows once they are consumed, so that the result set can
+ *       be read again after SPARQLJsonRewind. Otherwise every row is freed
+ *       by the next call of SPARQLJsonNextRow, and the memory used by the
+ *       parser does not grow with the size of the result set.
+ *
+ * returns a new parser
+ */
+SPARQLJsonParser *SPARQLJsonCreateParser(bool keep)
+{
+	SPARQLJsonParser *parser = (SPARQLJsonParser *)palloc0(sizeof(SPARQLJsonParser));
+
+	elog(DEBUG2, "%s called", __func__);
+
+	initStringInfo(&parser->token);
+	parser->state = JSON_EXPECT_VALUE;
+	parser->cxt = CurrentMemoryContext;
+	parser->keep = keep;
+
+	return parser;
+}
+
+/*
+ * SPARQLJsonFreeParser
+ * --------------------
+ * Releases a parser and the rows it holds.
+ *
+ * parser: parser created by SPARQLJsonCreateParser
+ */
+void SPARQLJsonFreeParser(SPARQLJsonParser *parser)
+{
+	if (parser == NULL)
+		return;
+
+	for (int i = 0; i < parser->numrows; i++)
+		if (parser->rows[i])
+			JsonFreeRow(parser, parser->rows[i]);
+
+	if (parser->rows)
+		pfree(parser->rows);
+
+	if (parser->row)
+		JsonFreeRow(parser, parser->row);
+
+	for (int i = 0; i < parser->numvars; i++)
+		pfree(parser->variables[i]);
+
+	if (parser->variables)
+		pfree(parser->variables);
+
+	for (int i = 0; i < parser->depth; i++)
+		if (parser->levels[i].key)
+			pfree(parser->levels[i].key);
+
+	JsonResetTerm(parser);
+
+	if (parser->token.data)
+		pfree(parser->token.data);
+
+	pfree(parser);
+}
+
+/*
+ * SPARQLJsonAddVariable
+ * ---------------------
+ * Registers a variable whose bindings are to be decoded. A variable that
+ * is registered more than once gets the same position.
+ *
+ * parser  : parser created by SPARQLJsonCreateParser
+ * variable: variable name, e.g. "?s"
+ *
+ * returns the position of the variable's term in the rows, or -1 if
+ * 'variable' is not a variable name.
+ */
+int SPARQLJsonAddVariable(SPARQLJsonParser *parser, const char *variable)
+{
+	MemoryContext oldcxt;
+
+	Assert(parser->offset == 0);
+
+	if (variable == NULL || strlen(variable) < 2)
+		return -1;
+
+	for (int i = 0; i < parser->numvars; i++)
+	{
+		/* "?s" and "$s" denote the same variable */
+		if (strcmp(parser->variables[i], variable + 1) == 0)
+			return i;
+	}
+
+	oldcxt = MemoryContextSwitchTo(parser->cxt);
+
+	if (parser->numvars == parser->maxvars)
+	{
+		parser->maxvars = parser->maxvars == 0 ? 8 : parser->maxvars * 2;
+
+		if (parser->variables == NULL)
+			parser->variables = (char **)palloc(parser->maxvars * sizeof(char *));
+		else
+			parser->variables = (char **)repalloc(parser->variables, parser->maxvars * sizeof(char *));
+	}
+
+	parser->variables[parser->numvars] = pstrdup(variable + 1);
+
+	MemoryContextSwitchTo(oldcxt);
+
+	return parser->numvars++;
+}
+
+/*
+ * SPARQLJsonGetError
+ * ------------------
+ * returns the message of the error that stopped the parser, or NULL
+ */
+const char *SPARQLJsonGetError(SPARQLJsonParser *parser)
+{
+	return parser->error;
+}
+
+/*
+ * SPARQLJsonCountRows
+ * -------------------
+ * returns the number of complete rows decoded and not yet consumed
+ */
+int SPARQLJsonCountRows(SPARQLJsonParser *parser)
+{
+	return parser->numrows - parser->next;
+}
+
+/*
+ * SPARQLJsonNextRow
+ * -----------------
+ * Reads the next complete row of the result set.
+ *
+ * parser: parser created by SPARQLJsonCreateParser
+ *
+ * returns an array with one term per registered variable, or NULL if no
+ * complete row is available (yet). Variables without a binding in the row
+ * have terms of type SPARQL_JSON_UNBOUND. Unless the parser keeps its
+ * rows, the row is valid until the next call.
+ */
+SPARQLJsonTerm *SPARQLJsonNextRow(SPARQLJsonParser *parser)
+{
+	if (!parser->keep && parser->next > 0 && parser->rows[parser->next - 1])
+	{
+		JsonFreeRow(parser, parser->rows[parser->next - 1]);
+		parser->rows[parser->next - 1] = NULL;
+	}
+
+	if (parser->next >= parser->numrows)
+	{
+		/* all rows were consumed, so the array can be reused */
+		if (!parser->keep)
+		{
+			parser->numrows = 0;
+			parser->next = 0;
+		}
+
+		return NULL;
+	}
+
+	return parser->rows[parser->next++];
+}
+
+/*
+ * SPARQLJsonRewind
+ * ----------------
+ * Positions a parser that keeps its rows at its first row again.
+ */
+void SPARQLJsonRewind(SPARQLJsonParser *parser)
+{
+	Assert(parser->keep);
+
+	parser->next = 0;
+}
+
+/*
+ * SPARQLJsonParseChunk
+ * --------------------
+ * Feeds a chunk of a SPARQL JSON result set to the parser. Tokens may be
+ * split across chunks at any byte.
+ *
+ * parser   : parser created by SPARQLJsonCreateParser
+ * chunk    : data received from the endpoint
+ * size     : size of 'chunk' in bytes
+ * terminate: true if this is the last chunk of the document
+ *
+ * returns false if the data is not a valid SPARQL JSON result set; the
+ * reason is available through SPARQLJsonGetError.
+ */
+bool SPARQLJsonParseChunk(SPARQLJsonParser *parser, const char *chunk, size_t size, bool terminate)
+{
+	MemoryContext oldcxt;
+	bool result;
+
+	/*
+	 * Streamed chunks arrive in short-lived memory contexts, but member
+	 * names and RDF terms may span several chunks, and rows have to
+	 * outlive them.
+	 */
+	oldcxt = MemoryContextSwitchTo(parser->cxt);
+	result = JsonParseChunk(parser, chunk, size, terminate);
+	MemoryContextSwitchTo(oldcxt);
+
+	return result;
+}
+
+/*
+ * JsonParseChunk
+ * --------------
+ * Tokenizer of SPARQLJsonParseChunk, running in the parser's memory context.
+ */
+static bool JsonParseChunk(SPARQLJsonParser *parser, const char *chunk, size_t size, bool terminate)
+{
+	size_t i = 0;
+
+	if (parser->error)
+		return false;
+
+	while (i < size)
+	{
+		char c = chunk[i];
+
+		switch (parser->state)
+		{
+		case JSON_IN_STRING:
+			if (c == '"')
+			{
+				JsonFlushSurrogate(parser);
+
+				if (parser->string_is_key)
+				{
+					SPARQLJsonLevel *level = &parser->levels[parser->depth - 1];
+
+					if (level->key)
+						pfree(level->key);
+
+					level->key = pstrdup(parser->token.data);
+					parser->state = JSON_EXPECT_COLON;
+				}
+				else if (!JsonScalar(parser, true))
+					return false;
+			}
+			else if (c == '\\')
+				parser->state = JSON_IN_ESCAPE;
+			else if ((unsigned char)c < 0x20)
+				return JsonError(parser, "unescaped control character in string");
+			else
+			{
+				/* copy the whole run of unescaped characters at once */
+				size_t end = i + 1;
+
+				while (end < size && chunk[end] != '"' && chunk[end] != '\\' &&
+					   (unsigned char)chunk[end] >= 0x20)
+					end++;
+
+				JsonFlushSurrogate(parser);
+				appendBinaryStringInfo(&parser->token, chunk + i, (int)(end - i));
+				parser->offset += end - i;
+				i = end;
+				continue;
+			}
+			break;
+
+		case JSON_IN_ESCAPE:
+			parser->state = JSON_IN_STRING;
+
+			if (c == 'u')
+			{
+				parser->state = JSON_IN_UNICODE;
+				parser->codepoint = 0;
+				parser->hexdigits = 0;
+				break;
+			}
+
+			JsonFlushSurrogate(parser);
+
+			switch (c)
+			{
+			case '"':
+			case '\\':
+			case '/':
+				appendStringInfoChar(&parser->token, c);
+				break;
+			case 'b':
+				appendStringInfoChar(&parser->token, '\b');
+				break;
+			case 'f':
+				appendStringInfoChar(&parser->token, '\f');
+				break;
+			case 'n':
+				appendStringInfoChar(&parser->token, '\n');
+				break;
+			case 'r':
+				appendStringInfoChar(&parser->token, '\r');
+				break;
+			case 't':
+				appendStringInfoChar(&parser->token, '\t');
+				break;
+			default:
+				return JsonError(parser, "invalid escape sequence in string");
+			}
+			break;
+
+		case JSON_IN_UNICODE:
+			if (c >= '0' && c <= '9')
+				parser->codepoint = (parser->codepoint << 4) | (c - '0');
+			else if (c >= 'a' && c <= 'f')
+				parser->codepoint = (parser->codepoint << 4) | (c - 'a' + 10);
+			else if (c >= 'A' && c <= 'F')
+				parser->codepoint = (parser->codepoint << 4) | (c - 'A' + 10);
+			else
+				return JsonError(parser, "invalid \\u escape sequence in string");
+
+			if (++parser->hexdigits == 4)
+			{
+				if (parser->codepoint == 0)
+					return JsonError(parser, "unsupported Unicode escape sequence \\u0000");
+
+				JsonAppendCodepoint(parser, parser->codepoint);
+				parser->state = JSON_IN_STRING;
+			}
+			break;
+
+		case JSON_IN_LITERAL:
+			if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+				c == '-' || c == '+' || c == '.')
+			{
+				appendStringInfoChar(&parser->token, c);
+				break;
+			}
+
+			/* the literal ends here, 'c' belongs to the next token */
+			if (!JsonEndLiteral(parser))
+				return false;
+
+			continue;
+
+		default:
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+				break;
+
+			switch (parser->state)
+			{
+			case JSON_EXPECT_VALUE:
+			case JSON_EXPECT_VALUE_OR_END:
+				if (c == ']' && parser->state == JSON_EXPECT_VALUE_OR_END)
+				{
+					if (!JsonEndContainer(parser, false))
+						return false;
+				}
+				else if (c == '{' || c == '[')
+				{
+					if (!JsonBeginContainer(parser, c == '{'))
+						return false;
+				}
+				else if (c == '"')
+				{
+					resetStringInfo(&parser->token);
+					parser->string_is_key = false;
+					parser->state = JSON_IN_STRING;
+				}
+				else if (c == '-' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z'))
+				{
+					resetStringInfo(&parser->token);
+					appendStringInfoChar(&parser->token, c);
+					parser->state = JSON_IN_LITERAL;
+				}
+				else
+					return JsonError(parser, "unexpected character, expected a value");
+				break;
+
+			case JSON_EXPECT_KEY:
+			case JSON_EXPECT_KEY_OR_END:
+				if (c == '}' && parser->state == JSON_EXPECT_KEY_OR_END)
+				{
+					if (!JsonEndContainer(parser, true))
+						return false;
+				}
+				else if (c == '"')
+				{
+					resetStringInfo(&parser->token);
+					parser->string_is_key = true;
+					parser->state = JSON_IN_STRING;
+				}
+				else
+					return JsonError(parser, "unexpected character, expected a member name");
+				break;
+
+			case JSON_EXPECT_COLON:
+				if (c != ':')
+					return JsonError(parser, "unexpected character, expected ':'");
+
+				parser->state = JSON_EXPECT_VALUE;
+				break;
+
+			case JSON_EXPECT_COMMA_OR_END:
+				if (c == ',')
+					parser->state = parser->levels[parser->depth - 1].is_object ? JSON_EXPECT_KEY : JSON_EXPECT_VALUE;
+				else if (c == '}' || c == ']')
+				{
+					if (!JsonEndContainer(parser, c == '}'))
+						return false;
+				}
+				else
+					return JsonError(parser, "unexpected character, expected ',' or the end of a container");
+				break;
+
+			case JSON_EXPECT_EOF:
+				return JsonError(parser, "unexpected data after the end of the document");
+
+			default:
+				break;
+			}
+			break;
+		}
+
+		parser->offset++;
+		i++;
+	}
+
+	if (terminate)
+	{
+		if (parser->state == JSON_IN_LITERAL && !JsonEndLiteral(parser))
+			return false;
+
+		if (parser->state != JSON_EXPECT_EOF)
+			return JsonError(parser, "unexpected end of document");
+
+		elog(DEBUG2, "%s: parsed %zu bytes", __func__, parser->offset);
+	}
+
+	return true;
+}
+
+/*
+ * IsSPARQLJsonFormat
+ * ------------------
+ * Checks if a 'format' (MIME type) requests SPARQL JSON result sets.
+ */
+bool IsSPARQLJsonFormat(const char *format)
+{
+	return format != NULL &&
+		   pg_strncasecmp(format, RDF_SPARQL_JSON_FORMAT, strlen(RDF_SPARQL_JSON_FORMAT)) == 0;
+}
+
+/*
+ * JsonError
+ * ---------
+ * Stops the parser with an error message. Always returns false.
+ */
+static bool JsonError(SPARQLJsonParser *parser, const char *message)
+{
+	parser->error = psprintf("%s at byte %zu", message, parser->offset);
+	return false;
+}
+
+/*
+ * JsonBeginContainer
+ * ------------------
+ * Handles '{' and '['. Keeps track of the path to "results.bindings" and
+ * starts a new row for each of its entries.
+ */
+static bool JsonBeginContainer(SPARQLJsonParser *parser, bool is_object)
+{
+	SPARQLJsonLevel *level;
+	SPARQLJsonLevel *parent = parser->depth > 0 ? &parser->levels[parser->depth - 1] : NULL;
+
+	if (parser->depth == SPARQL_JSON_MAX_DEPTH)
+		return JsonError(parser, "maximum nesting level exceeded");
+
+	level = &parser->levels[parser->depth];
+	level->is_object = is_object;
+	level->is_bindings = false;
+	level->key = NULL;
+
+	if (!is_object && parser->depth == 2 &&
+		parser->levels[0].is_object && parser->levels[1].is_object &&
+		parser->levels[0].key && strcmp(parser->levels[0].key, "results") == 0 &&
+		parser->levels[1].key && strcmp(parser->levels[1].key, "bindings") == 0)
+		level->is_bindings = true;
+	else if (is_object && parent && parent->is_bindings)
+	{
+		/* palloc0 makes all terms SPARQL_JSON_UNBOUND */
+		parser->row = (SPARQLJsonTerm *)palloc0(Max(parser->numvars, 1) * sizeof(SPARQLJsonTerm));
+		parser->row_level = parser->depth;
+	}
+	else if (is_object && parser->row && parser->depth == parser->row_level + 1)
+	{
+		JsonResetTerm(parser);
+		parser->term_var = pstrdup(parent->key);
+		parser->term_index = -1;
+		parser->in_term = true;
+
+		for (int i = 0; i < parser->numvars; i++)
+		{
+			if (strcmp(parser->variables[i], parent->key) == 0)
+			{
+				parser->term_index = i;
+				break;
+			}
+		}
+	}
+
+	parser->depth++;
+	parser->state = is_object ? JSON_EXPECT_KEY_OR_END : JSON_EXPECT_VALUE_OR_END;
+
+	return true;
+}
+
+/*
+ * JsonEndContainer
+ * ----------------
+ * Handles '}' and ']'. Completes the RDF term of a variable or a whole
+ * row, which is only now added to the rows that can be read.
+ */
+static bool JsonEndContainer(SPARQLJsonParser *parser, bool is_object)
+{
+	SPARQLJsonLevel *level;
+
+	if (parser->depth == 0 || parser->levels[parser->depth - 1].is_object != is_object)
+		return JsonError(parser, is_object ? "unexpected '}'" : "unexpected ']'");
+
+	parser->depth--;
+	level = &parser->levels[parser->depth];
+
+	if (level->key)
+	{
+		pfree(level->key);
+		level->key = NULL;
+	}
+
+	if (parser->in_term && parser->depth == parser->row_level + 1)
+	{
+		if (!JsonAddTerm(parser))
+			return false;
+	}
+	else if (parser->row && parser->depth == parser->row_level)
+		JsonAddRow(parser);
+
+	parser->state = parser->depth == 0 ? JSON_EXPECT_EOF : JSON_EXPECT_COMMA_OR_END;
+
+	return true;
+}
+
+/*
+ * JsonScalar
+ * ----------
+ * Handles a complete string, number, true, false or null value held in
+ * 'token'. Only string members of RDF terms of registered variables are
+ * of interest.
+ */
+static bool JsonScalar(SPARQLJsonParser *parser, bool is_string)
+{
+	if (is_string && parser->in_term && parser->term_index >= 0 &&
+		parser->depth == parser->row_level + 2)
+	{
+		char *key = parser->levels[parser->depth - 1].key;
+		char **field = NULL;
+
+		if (strcmp(key, "type") == 0)
+			field = &parser->term_type;
+		else if (strcmp(key, "value") == 0)
+			field = &parser->term_value;
+		else if (strcmp(key, "datatype") == 0)
+			field = &parser->term_datatype;
+		else if (strcmp(key, "xml:lang") == 0)
+			field = &parser->term_lang;
+
+		if (field)
+		{
+			if (*field)
+				pfree(*field);
+
+			*field = pstrdup(parser->token.data);
+		}
+	}
+
+	parser->state = parser->depth == 0 ? JSON_EXPECT_EOF : JSON_EXPECT_COMMA_OR_END;
+
+	return true;
+}
+
+/*
+ * JsonEndLiteral
+ * --------------
+ * Validates a complete number, true, false or null.
+ */
+static bool JsonEndLiteral(SPARQLJsonParser *parser)
+{
+	char *literal = parser->token.data;
+
+	if (strcmp(literal, "true") != 0 && strcmp(literal, "false") != 0 && strcmp(literal, "null") != 0)
+	{
+		char *end;
+
+		if (!(literal[0] == '-' || (literal[0] >= '0' && literal[0] <= '9')))
+			return JsonError(parser, psprintf("invalid token \"%s\"", literal));
+
+		(void)strtod(literal, &end);
+
+		if (*end != '\0')
+			return JsonError(parser, psprintf("invalid number \"%s\"", literal));
+	}
+
+	return JsonScalar(parser, false);
+}
+
+/*
+ * JsonAddTerm
+ * -----------
+ * Stores the RDF term of a variable, read from an object such as
+ * {"type": "uri", "value": "..."}, in the row being decoded. The strings
+ * read from the object are handed over to the row without copying them.
+ */
+static bool JsonAddTerm(SPARQLJsonParser *parser)
+{
+	SPARQLJsonTerm *term;
+	SPARQLJsonTermType type;
+
+	parser->in_term = false;
+
+	/* the variable is not needed by the caller */
+	if (parser->term_index < 0)
+	{
+		JsonResetTerm(parser);
+		return true;
+	}
+
+	if (parser->term_type == NULL)
+		return JsonError(parser, psprintf("RDF term of variable \"%s\" has no type", parser->term_var));
+
+	if (strcmp(parser->term_type, "uri") == 0)
+		type = SPARQL_JSON_IRI;
+	else if (strcmp(parser->term_type, "bnode") == 0)
+		type = SPARQL_JSON_BNODE;
+	/* "typed-literal" is still produced by older endpoints, e.g. Virtuoso */
+	else if (strcmp(parser->term_type, "literal") == 0 || strcmp(parser->term_type, "typed-literal") == 0)
+		type = SPARQL_JSON_LITERAL;
+	else
+		return JsonError(parser, psprintf("unsupported RDF term type \"%s\" for variable \"%s\"",
+										  parser->term_type, parser->term_var));
+
+	if (parser->term_value == NULL)
+		return JsonError(parser, psprintf("RDF term of variable \"%s\" has no value", parser->term_var));
+
+	term = &parser->row[parser->term_index];
+
+	/* a variable bound twice in the same entry keeps its last term */
+	if (term->value)
+		pfree(term->value);
+	if (term->datatype)
+		pfree(term->datatype);
+	if (term->lang)
+		pfree(term->lang);
+
+	term->type = type;
+	term->value = parser->term_value;
+	term->datatype = NULL;
+	term->lang = NULL;
+	parser->term_value = NULL;
+
+	if (type == SPARQL_JSON_LITERAL)
+	{
+		term->datatype = parser->term_datatype;
+		term->lang = parser->term_lang;
+		parser->term_datatype = NULL;
+		parser->term_lang = NULL;
+	}
+
+	JsonResetTerm(parser);
+
+	return true;
+}
+
+/*
+ * JsonAddRow
+ * ----------
+ * Appends the row decoded last to the rows that can be read.
+ */
+static void JsonAddRow(SPARQLJsonParser *parser)
+{
+	if (parser->numrows == parser->maxrows)
+	{
+		parser->maxrows = parser->maxrows == 0 ? 64 : parser->maxrows * 2;
+
+		if (parser->rows == NULL)
+			parser->rows = (SPARQLJsonTerm **)palloc(parser->maxrows * sizeof(SPARQLJsonTerm *));
+		else
+			parser->rows = (SPARQLJsonTerm **)repalloc(parser->rows, parser->maxrows * sizeof(SPARQLJsonTerm *));
+	}
+
+	parser->rows[parser->numrows++] = parser->row;
+	parser->row = NULL;
+}
+
+/*
+ * JsonFreeRow
+ * -----------
+ * Frees a row and the strings of its terms.
+ */
+static void JsonFreeRow(SPARQLJsonParser *parser, SPARQLJsonTerm *row)
+{
+	for (int i = 0; i < parser->numvars; i++)
+	{
+		if (row[i].value)
+			pfree(row[i].value);
+		if (row[i].datatype)
+			pfree(row[i].datatype);
+		if (row[i].lang)
+			pfree(row[i].lang);
+	}
+
+	pfree(row);
+}
+
+/*
+ * JsonAppendCodepoint
+ * -------------------
+ * Appends the character of a \uXXXX escape to 'token' as UTF-8, combining
+ * UTF-16 surrogate pairs. Lone surrogates are replaced with U+FFFD.
+ */
+static void JsonAppendCodepoint(SPARQLJsonParser *parser, pg_wchar c)
+{
+	unsigned char utf8[8];
+
+	if (parser->high_surrogate)
+	{
+		if (c >= 0xDC00 && c <= 0xDFFF)
+		{
+			c = 0x10000 + ((parser->high_surrogate - 0xD800) << 10) + (c - 0xDC00);
+			parser->high_surrogate = 0;
+		}
+		else
+			JsonFlushSurrogate(parser);
+	}
+
+	if (c >= 0xD800 && c <= 0xDBFF)
+	{
+		parser->high_surrogate = c;
+		return;
+	}
+
+	if (c >= 0xDC00 && c <= 0xDFFF)
+		c = SPARQL_JSON_REPLACEMENT_CHAR;
+
+	unicode_to_utf8(c, utf8);
+	appendBinaryStringInfo(&parser->token, (char *)utf8, pg_utf_mblen(utf8));
+}
+
+/*
+ * JsonFlushSurrogate
+ * ------------------
+ * Replaces a high surrogate that is not followed by a low surrogate with
+ * U+FFFD.
+ */
+static void JsonFlushSurrogate(SPARQLJsonParser *parser)
+{
+	if (parser->high_surrogate)
+	{
+		parser->high_surrogate = 0;
+		JsonAppendCodepoint(parser, SPARQL_JSON_REPLACEMENT_CHAR);
+	}
+}
+
+/*
+ * JsonResetTerm
+ * -------------
+ * Frees the fields of the RDF term read last.
+ */
+static void JsonResetTerm(SPARQLJsonParser *parser)
+{
+	if (parser->term_var)
+		pfree(parser->term_var);
+	if (parser->term_type)
+		pfree(parser->term_type);
+	if (parser->term_value)
+		pfree(parser->term_value);
+	if (parser->term_datatype)
+		pfree(parser->term_datatype);
+	if (parser->term_lang)
+		pfree(parser->term_lang);
+
+	parser->term_var = NULL;
+	parser->term_type = NULL;
+	parser->term_value = NULL;
+	parser->term_datatype = NULL;
+	parser->term_lang = NULL;
+}
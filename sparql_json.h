@@ -0,0 +1,58 @@
+/*---------------------------------------------------------------------
+ *
+ * sparql_json.h
+ *   Decoder for SPARQL 1.1 Query Results JSON Format
+ *   (application/sparql-results+json).
+ *
+ * Copyright (C) 2022-2026 Jim Jones <jim.jones@uni-muenster.de>
+ *
+ *---------------------------------------------------------------------
+ */
+
+#ifndef SPARQL_JSON_H
+#define SPARQL_JSON_H
+
+#include "postgres.h"
+
+/*
+ * SPARQLJsonParser
+ * ----------------
+ * Incremental (push) decoder for SPARQL JSON result sets. Each entry of
+ * "results.bindings" is decoded into a row with one RDF term per variable
+ * registered by the caller, in the order of registration. Just like the
+ * TSV reader, no document is built.
+ */
+typedef struct SPARQLJsonParser SPARQLJsonParser;
+
+typedef enum SPARQLJsonTermType
+{
+	SPARQL_JSON_UNBOUND, /* no binding in the entry */
+	SPARQL_JSON_IRI,	 /* "type": "uri" */
+	SPARQL_JSON_BNODE,	 /* "type": "bnode" */
+	SPARQL_JSON_LITERAL	 /* "type": "literal" or "typed-literal" */
+} SPARQLJsonTermType;
+
+/*
+ * SPARQLJsonTerm
+ * --------------
+ * RDF term of a variable in a row returned by SPARQLJsonNextRow.
+ */
+typedef struct SPARQLJsonTerm
+{
+	SPARQLJsonTermType type;
+	char *value;	/* IRI, blank node label or lexical form, unescaped */
+	char *datatype; /* datatype IRI of typed literals, or NULL */
+	char *lang;		/* language tag of literals, or NULL */
+} SPARQLJsonTerm;
+
+extern SPARQLJsonParser *SPARQLJsonCreateParser(bool keep);
+extern int SPARQLJsonAddVariable(SPARQLJsonParser *parser, const char *variable);
+extern bool SPARQLJsonParseChunk(SPARQLJsonParser *parser, const char *chunk, size_t size, bool terminate);
+extern const char *SPARQLJsonGetError(SPARQLJsonParser *parser);
+extern int SPARQLJsonCountRows(SPARQLJsonParser *parser);
+extern SPARQLJsonTerm *SPARQLJsonNextRow(SPARQLJsonParser *parser);
+extern void SPARQLJsonRewind(SPARQLJsonParser *parser);
+extern void SPARQLJsonFreeParser(SPARQLJsonParser *parser);
+extern bool IsSPARQLJsonFormat(const char *format);
+
+#endif /* SPARQL_JSON_H */
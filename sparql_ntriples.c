@@ -0,0 +1,599 @@
+/*---------------------------------------------------------------------
+ *
+ * sparql_ntriples.c
+ *   Serializer of SPARQL triple templates into N-Triples and N-Quads,
+ *   the request bodies of the SPARQL 1.1 Graph Store Protocol.
+ *
+ * The 'sparql_update_pattern' of a foreign table is written with the
+ * syntax of a SPARQL quad template: triples separated by '.', predicate
+ * and object lists separated by ';' and ',', prefixed names, the keyword
+ * 'a', abbreviated numbers and booleans, and optional GRAPH blocks. Once
+ * its variables are substituted with the values of a row, the template is
+ * rewritten here as one line per triple with every term in its full form:
+ *
+ *   <subject> <predicate> "object"^^<datatype> [<graph>] .
+ *
+ * so that the store can load it without going through its SPARQL parser.
+ * Blank nodes and collections are not supported, as SPARQL 1.1 Update
+ * does not allow them in INSERT DATA either.
+ *
+ * Copyright (C) 2022-2026 Jim Jones <jim.jones@uni-muenster.de>
+ *
+ *---------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "rdf_fdw.h"
+#include "sparql_ntriples.h"
+
+#include <ctype.h>
+#include <string.h>
+
+typedef enum NTriplesTermType
+{
+	NTRIPLES_TERM_IRI,
+	NTRIPLES_TERM_LITERAL,
+	NTRIPLES_TERM_VARIABLE
+} NTriplesTermType;
+
+typedef struct NTriplesReader
+{
+	const char *pos;	  /* start of the text not read yet */
+	List *prefixes;		  /* RDFPrefix entries used to expand prefixed names */
+	bool allow_variables; /* variables are accepted as terms */
+	char *error;		  /* reason why the template was rejected, or NULL */
+} NTriplesReader;
+
+static void SkipSpace(NTriplesReader *reader);
+static bool ReaderError(NTriplesReader *reader, const char *message);
+static bool IsKeyword(NTriplesReader *reader, const char *keyword);
+static bool IsNameChar(char c);
+static bool ReadTerm(NTriplesReader *reader, StringInfo term, NTriplesTermType *type);
+static bool ReadIRI(NTriplesReader *reader, StringInfo term);
+static bool ReadPrefixedName(NTriplesReader *reader, StringInfo term);
+static bool ReadString(NTriplesReader *reader, StringInfo term);
+static bool ReadNumber(NTriplesReader *reader, StringInfo term);
+static bool ReadTriples(NTriplesReader *reader, StringInfo buf, const char *graph);
+
+/*
+ * SPARQLTriplesToNTriples
+ * -----------------------
+ * Appends to 'buf' the triples of the SPARQL quad template 'triples', one
+ * per line in N-Triples syntax. Triples written inside a GRAPH block get
+ * the graph name as fourth term, which makes the output N-Quads; in that
+ * case 'has_graph' is set to true.
+ *
+ * Variables are only accepted if 'allow_variables' is true, which is used
+ * to validate templates before their variables are substituted. Returns
+ * false and sets 'errmsg' if the template cannot be serialized, in which
+ * case the contents of 'buf' are undefined.
+ *
+ * buf            : output buffer
+ * triples        : quad template, without INSERT DATA and curly braces
+ * prefixes       : RDFPrefix entries used to expand prefixed names
+ * allow_variables: whether variables are valid terms
+ * has_graph      : set to true if a GRAPH block was found
+ * errmsg         : error message, if the function returns false
+ */
+bool SPARQLTriplesToNTriples(StringInfo buf, const char *triples, List *prefixes,
+							 bool allow_variables, bool *has_graph, char **errmsg)
+{
+	NTriplesReader reader;
+
+	reader.pos = triples;
+	reader.prefixes = prefixes;
+	reader.allow_variables = allow_variables;
+	reader.error = NULL;
+
+	*errmsg = NULL;
+
+	for (;;)
+	{
+		SkipSpace(&reader);
+
+		if (*reader.pos == '\0')
+			break;
+
+		if (*reader.pos == '.')
+		{
+			/* stray separator, e.g. between a GRAPH block and a triple */
+			reader.pos++;
+			continue;
+		}
+
+		if (IsKeyword(&reader, "GRAPH"))
+		{
+			StringInfoData graph;
+			NTriplesTermType type;
+
+			reader.pos += strlen("GRAPH");
+			SkipSpace(&reader);
+
+			initStringInfo(&graph);
+			if (!ReadTerm(&reader, &graph, &type))
+				break;
+
+			if (type == NTRIPLES_TERM_LITERAL)
+			{
+				ReaderError(&reader, "graph name must be an IRI");
+				break;
+			}
+
+			SkipSpace(&reader);
+			if (*reader.pos != '{')
+			{
+				ReaderError(&reader, "expected '{' after the graph name");
+				break;
+			}
+			reader.pos++;
+
+			if (!ReadTriples(&reader, buf, graph.data))
+				break;
+
+			SkipSpace(&reader);
+			if (*reader.pos != '}')
+			{
+				ReaderError(&reader, "expected '}' to close the GRAPH block");
+				break;
+			}
+			reader.pos++;
+
+			*has_graph = true;
+			pfree(graph.data);
+			continue;
+		}
+
+		if (!ReadTriples(&reader, buf, NULL))
+			break;
+
+		SkipSpace(&reader);
+		if (*reader.pos != '\0' && !IsKeyword(&reader, "GRAPH"))
+		{
+			ReaderError(&reader, "unexpected character after triple");
+			break;
+		}
+	}
+
+	if (reader.error)
+	{
+		*errmsg = reader.error;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * ReadTriples
+ * -----------
+ * Reads triples until the end of the template, a closing '}' or a GRAPH
+ * keyword, and appends them to 'buf'. If 'graph' is not NULL it is added
+ * to every triple as graph name.
+ */
+static bool ReadTriples(NTriplesReader *reader, StringInfo buf, const char *graph)
+{
+	StringInfoData subject;
+	StringInfoData predicate;
+	StringInfoData object;
+	NTriplesTermType type;
+	const char *start;
+
+	initStringInfo(&subject);
+	initStringInfo(&predicate);
+	initStringInfo(&object);
+
+	for (;;)
+	{
+		SkipSpace(reader);
+
+		if (*reader->pos == '\0' || *reader->pos == '}' || IsKeyword(reader, "GRAPH"))
+			return true;
+
+		if (*reader->pos == '.')
+		{
+			reader->pos++;
+			continue;
+		}
+
+		start = reader->pos;
+		resetStringInfo(&subject);
+		if (!ReadTerm(reader, &subject, &type))
+			return false;
+
+		if (type == NTRIPLES_TERM_LITERAL)
+		{
+			reader->pos = start;
+			return ReaderError(reader, "literals are not allowed as subject");
+		}
+
+		/* predicate-object list: p o (, o)* (; p o (, o)*)* */
+		for (;;)
+		{
+			SkipSpace(reader);
+
+			start = reader->pos;
+			resetStringInfo(&predicate);
+			if (!ReadTerm(reader, &predicate, &type))
+				return false;
+
+			if (type == NTRIPLES_TERM_LITERAL)
+			{
+				reader->pos = start;
+				return ReaderError(reader, "predicate must be an IRI");
+			}
+
+			for (;;)
+			{
+				SkipSpace(reader);
+
+				resetStringInfo(&object);
+				if (!ReadTerm(reader, &object, &type))
+					return false;
+
+				appendStringInfo(buf, "%s %s %s", subject.data, predicate.data, object.data);
+				if (graph)
+					appendStringInfo(buf, " %s", graph);
+				appendStringInfoString(buf, " .\n");
+
+				SkipSpace(reader);
+				if (*reader->pos != ',')
+					break;
+				reader->pos++;
+			}
+
+			if (*reader->pos != ';')
+				break;
+
+			/* a trailing ';' may end the predicate-object list */
+			while (*reader->pos == ';')
+			{
+				reader->pos++;
+				SkipSpace(reader);
+			}
+
+			if (*reader->pos == '.' || *reader->pos == '}' || *reader->pos == '\0')
+				break;
+		}
+
+		SkipSpace(reader);
+		if (*reader->pos == '.')
+			reader->pos++;
+		else if (*reader->pos != '}' && *reader->pos != '\0' && !IsKeyword(reader, "GRAPH"))
+			return ReaderError(reader, "expected '.' after triple");
+	}
+}
+
+/*
+ * ReadTerm
+ * --------
+ * Reads the RDF term at the current position and appends it to 'term' in
+ * N-Triples syntax, setting 'type' to its kind.
+ */
+static bool ReadTerm(NTriplesReader *reader, StringInfo term, NTriplesTermType *type)
+{
+	char c = *reader->pos;
+
+	*type = NTRIPLES_TERM_IRI;
+
+	if (c == '\0')
+		return ReaderError(reader, "unexpected end of triple pattern");
+
+	if (c == '<')
+		return ReadIRI(reader, term);
+
+	if (c == '"' || c == '\'')
+	{
+		*type = NTRIPLES_TERM_LITERAL;
+		return ReadString(reader, term);
+	}
+
+	if (c == '?' || c == '$')
+	{
+		const char *start = reader->pos;
+
+		if (!reader->allow_variables)
+			return ReaderError(reader, "unbound variable in triple pattern");
+
+		reader->pos++;
+		while (IsNameChar(*reader->pos))
+			reader->pos++;
+
+		appendBinaryStringInfo(term, start, reader->pos - start);
+		*type = NTRIPLES_TERM_VARIABLE;
+		return true;
+	}
+
+	if (c == '_' && reader->pos[1] == ':')
+		return ReaderError(reader, "blank nodes are not allowed in triple pattern");
+
+	if (c == '[' || c == '(')
+		return ReaderError(reader, "blank nodes and collections are not allowed in triple pattern");
+
+	if (isdigit((unsigned char)c) || c == '+' || c == '-' ||
+		(c == '.' && isdigit((unsigned char)reader->pos[1])))
+	{
+		*type = NTRIPLES_TERM_LITERAL;
+		return ReadNumber(reader, term);
+	}
+
+	if (IsKeyword(reader, "true") || IsKeyword(reader, "false"))
+	{
+		bool value = IsKeyword(reader, "true");
+
+		reader->pos += value ? strlen("true") : strlen("false");
+		appendStringInfo(term, "\"%s\"^^%s", value ? "true" : "false", RDF_XSD_BOOLEAN);
+		*type = NTRIPLES_TERM_LITERAL;
+		return true;
+	}
+
+	if (c == 'a' && !IsNameChar(reader->pos[1]) && reader->pos[1] != ':')
+	{
+		reader->pos++;
+		appendStringInfo(term, "<%stype>", RDF_RDF_BASE_URI);
+		return true;
+	}
+
+	return ReadPrefixedName(reader, term);
+}
+
+/*
+ * ReadIRI
+ * -------
+ * Copies an IRI reference, including its angle brackets.
+ */
+static bool ReadIRI(NTriplesReader *reader, StringInfo term)
+{
+	const char *end = reader->pos + 1;
+
+	while (*end && *end != '>')
+	{
+		if (isspace((unsigned char)*end) || *end == '<' || *end == '"')
+			return ReaderError(reader, "invalid character in IRI");
+		end++;
+	}
+
+	if (*end != '>')
+		return ReaderError(reader, "unterminated IRI");
+
+	appendBinaryStringInfo(term, reader->pos, end - reader->pos + 1);
+	reader->pos = end + 1;
+
+	return true;
+}
+
+/*
+ * ReadPrefixedName
+ * ----------------
+ * Expands a prefixed name, e.g. foaf:name, into a full IRI using the
+ * prefixes of the table's context.
+ */
+static bool ReadPrefixedName(NTriplesReader *reader, StringInfo term)
+{
+	const char *start = reader->pos;
+	const char *colon;
+	const char *end;
+	ListCell *cell;
+
+	colon = start;
+	while (IsNameChar(*colon) || *colon == '.')
+		colon++;
+
+	if (*colon != ':')
+		return ReaderError(reader, "invalid term in triple pattern");
+
+	/* the local part may contain dots, but cannot end with one */
+	end = colon + 1;
+	while (IsNameChar(*end) || *end == '.' || *end == ':' || *end == '%')
+		end++;
+	while (end > colon + 1 && end[-1] == '.')
+		end--;
+
+	foreach (cell, reader->prefixes)
+	{
+		RDFPrefix *prefix = (RDFPrefix *)lfirst(cell);
+
+		if (strlen(prefix->prefix) == (size_t)(colon - start) &&
+			strncmp(prefix->prefix, start, colon - start) == 0)
+		{
+			appendStringInfo(term, "<%s", prefix->url);
+			appendBinaryStringInfo(term, colon + 1, end - colon - 1);
+			appendStringInfoChar(term, '>');
+			reader->pos = end;
+			return true;
+		}
+	}
+
+	reader->error = psprintf("unknown prefix \"%.*s\" in triple pattern",
+							 (int)(colon - start), start);
+	return false;
+}
+
+/*
+ * ReadString
+ * ----------
+ * Reads a literal written with single or double quotes, short or long,
+ * and appends it as a double quoted N-Triples literal, followed by its
+ * language tag or datatype IRI. Escape sequences are kept as they are,
+ * since SPARQL and N-Triples share them; quotes and line breaks written
+ * verbatim in the literal are escaped.
+ */
+static bool ReadString(NTriplesReader *reader, StringInfo term)
+{
+	char quote = *reader->pos;
+	bool longstring = reader->pos[1] == quote && reader->pos[2] == quote;
+	const char *p = reader->pos + (longstring ? 3 : 1);
+
+	appendStringInfoChar(term, '"');
+
+	for (;;)
+	{
+		if (*p == '\0')
+			return ReaderError(reader, "unterminated literal");
+
+		if (*p == quote)
+		{
+			if (!longstring)
+				break;
+			if (p[1] == quote && p[2] == quote)
+				break;
+		}
+
+		if (*p == '\\')
+		{
+			if (p[1] == '\0')
+				return ReaderError(reader, "unterminated literal");
+
+			/* \' is not needed in a double quoted literal */
+			if (p[1] == '\'')
+				appendStringInfoChar(term, '\'');
+			else
+				appendBinaryStringInfo(term, p, 2);
+			p += 2;
+			continue;
+		}
+
+		if (*p == '\n' || *p == '\r')
+		{
+			if (!longstring)
+				return ReaderError(reader, "line break in literal");
+			appendStringInfoString(term, *p == '\n' ? "\\n" : "\\r");
+		}
+		else if (*p == '"')
+			appendStringInfoString(term, "\\\"");
+		else
+			appendStringInfoChar(term, *p);
+
+		p++;
+	}
+
+	appendStringInfoChar(term, '"');
+	reader->pos = p + (longstring ? 3 : 1);
+
+	if (*reader->pos == '@')
+	{
+		const char *start = reader->pos;
+
+		reader->pos++;
+		while (isalnum((unsigned char)*reader->pos) || *reader->pos == '-')
+			reader->pos++;
+
+		if (reader->pos == start + 1)
+			return ReaderError(reader, "empty language tag");
+
+		appendBinaryStringInfo(term, start, reader->pos - start);
+	}
+	else if (reader->pos[0] == '^' && reader->pos[1] == '^')
+	{
+		reader->pos += 2;
+		appendStringInfoString(term, "^^");
+
+		if (*reader->pos == '<')
+			return ReadIRI(reader, term);
+
+		return ReadPrefixedName(reader, term);
+	}
+
+	return true;
+}
+
+/*
+ * ReadNumber
+ * ----------
+ * Reads an abbreviated xsd:integer, xsd:decimal or xsd:double literal and
+ * appends it with its explicit datatype.
+ */
+static bool ReadNumber(NTriplesReader *reader, StringInfo term)
+{
+	const char *start = reader->pos;
+	const char *p = start;
+	const char *datatype = RDF_XSD_INTEGER;
+
+	if (*p == '+' || *p == '-')
+		p++;
+
+	while (isdigit((unsigned char)*p))
+		p++;
+
+	/* a dot not followed by a digit terminates the triple */
+	if (*p == '.' && isdigit((unsigned char)p[1]))
+	{
+		datatype = RDF_XSD_DECIMAL;
+		p++;
+		while (isdigit((unsigned char)*p))
+			p++;
+	}
+
+	if (*p == 'e' || *p == 'E')
+	{
+		datatype = RDF_XSD_DOUBLE;
+		p++;
+		if (*p == '+' || *p == '-')
+			p++;
+		if (!isdigit((unsigned char)*p))
+			return ReaderError(reader, "invalid exponent in numeric literal");
+		while (isdigit((unsigned char)*p))
+			p++;
+	}
+
+	if (p == start || !isdigit((unsigned char)p[-1]))
+		return ReaderError(reader, "invalid numeric literal");
+
+	appendStringInfoChar(term, '"');
+	appendBinaryStringInfo(term, start, p - start);
+	appendStringInfo(term, "\"^^%s", datatype);
+	reader->pos = p;
+
+	return true;
+}
+
+/*
+ * SkipSpace
+ * ---------
+ * Skips whitespace and comments.
+ */
+static void SkipSpace(NTriplesReader *reader)
+{
+	for (;;)
+	{
+		while (isspace((unsigned char)*reader->pos))
+			reader->pos++;
+
+		if (*reader->pos != '#')
+			return;
+
+		while (*reader->pos && *reader->pos != '\n')
+			reader->pos++;
+	}
+}
+
+/*
+ * IsKeyword
+ * ---------
+ * Checks, case-insensitively, whether the text at the current position is
+ * the given keyword, and not the beginning of a longer name.
+ */
+static bool IsKeyword(NTriplesReader *reader, const char *keyword)
+{
+	size_t len = strlen(keyword);
+
+	return pg_strncasecmp(reader->pos, keyword, len) == 0 &&
+		   !IsNameChar(reader->pos[len]) && reader->pos[len] != ':';
+}
+
+static bool IsNameChar(char c)
+{
+	return isalnum((unsigned char)c) || c == '_' || c == '-' || (unsigned char)c >= 0x80;
+}
+
+static bool ReaderError(NTriplesReader *reader, const char *message)
+{
+	int len = strnlen(reader->pos, 20);
+
+	if (len == 0)
+		reader->error = pstrdup(message);
+	else
+		reader->error = psprintf("%s near \"%.*s\"", message, len, reader->pos);
+
+	return false;
+}
@@ -0,0 +1,25 @@
+/*---------------------------------------------------------------------
+ *
+ * sparql_ntriples.h
+ *   Serializer of SPARQL triple templates into N-Triples and N-Quads,
+ *   the request bodies of the SPARQL 1.1 Graph Store Protocol.
+ *
+ * Copyright (C) 2022-2026 Jim Jones <jim.jones@uni-muenster.de>
+ *
+ *---------------------------------------------------------------------
+ */
+
+#ifndef SPARQL_NTRIPLES_H
+#define SPARQL_NTRIPLES_H
+
+#include "postgres.h"
+#include "lib/stringinfo.h"
+#include "nodes/pg_list.h"
+
+#define SPARQL_NTRIPLES_CONTENT_TYPE "application/n-triples"
+#define SPARQL_NQUADS_CONTENT_TYPE "application/n-quads"
+
+extern bool SPARQLTriplesToNTriples(StringInfo buf, const char *triples, List *prefixes,
+									bool allow_variables, bool *has_graph, char **errmsg);
+
+#endif /* SPARQL_NTRIPLES_H */
@@ -0,0 +1,645 @@
+/*---------------------------------------------------------------------
+ *
+ * sparql_parser.c
+ *   Parser for the clause structure of SPARQL 1.1 queries set in the
+ *   'sparql' option of foreign tables.
+ *
+ * The query is split into tokens (IRIs, literals, variables, words and
+ * punctuation, skipping comments), so that keywords inside IRIs, literals
+ * and comments are never mistaken for clauses. The tokens are then walked
+ * along the top-level grammar of a query:
+ *
+ *   Prologue  SELECT [DISTINCT|REDUCED] projection
+ *   DatasetClause*  [WHERE] { group graph pattern }
+ *   [GROUP BY ...] [HAVING ...] [ORDER BY ...] [LIMIT n] [OFFSET n]
+ *   [VALUES ...]
+ *
+ * Each clause is kept as the text it was written with, which is all the
+ * deparser needs to rebuild the query around the conditions, sort keys and
+ * limits it pushes down.
+ *
+ * Copyright (C) 2022-2026 Jim Jones <jim.jones@uni-muenster.de>
+ *
+ *---------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "rdf_fdw.h"
+#include "sparql_parser.h"
+
+#include "lib/stringinfo.h"
+#include <ctype.h>
+#include <string.h>
+
+typedef enum SPARQLTokenType
+{
+	SPARQL_TOKEN_END,	 /* end of the query, or lexer error */
+	SPARQL_TOKEN_IRI,	 /* <http://...> */
+	SPARQL_TOKEN_STRING, /* "...", '...', """...""" or '''...''' */
+	SPARQL_TOKEN_VAR,	 /* ?name or $name */
+	SPARQL_TOKEN_WORD,	 /* keywords, prefixed names, blank nodes, numbers */
+	SPARQL_TOKEN_PUNCT	 /* any other single character */
+} SPARQLTokenType;
+
+typedef struct SPARQLLexer
+{
+	const char *pos;	  /* start of the text not tokenized yet */
+	SPARQLTokenType type; /* type of the current token */
+	const char *start;	  /* first character of the current token */
+	int len;			  /* length of the current token */
+	char *error;		  /* lexer or parser error, or NULL */
+} SPARQLLexer;
+
+static void NextToken(SPARQLLexer *lex);
+static bool IsNameChar(char c);
+static bool TokenIs(SPARQLLexer *lex, const char *keyword);
+static bool TokenIsPunct(SPARQLLexer *lex, char c);
+static bool IsAggregateFunction(SPARQLLexer *lex);
+static bool ParseError(SPARQLLexer *lex, const char *message);
+static void ParsePrologue(SPARQLLexer *lex, SPARQLQuery *query);
+static bool ParseProjection(SPARQLLexer *lex, SPARQLQuery *query);
+static bool ParseDataset(SPARQLLexer *lex, SPARQLQuery *query);
+static bool ParseWhere(SPARQLLexer *lex, SPARQLQuery *query);
+static bool ParseModifiers(SPARQLLexer *lex, SPARQLQuery *query);
+static char *CopyString(const char *str);
+
+/*
+ * SPARQLParseQuery
+ * ----------------
+ * Parses the clauses of a SPARQL query. Malformed PREFIX declarations are
+ * reported as an ERROR, as they would break any query sent to the
+ * endpoint. Anything else that cannot be parsed is recorded in the
+ * 'error' field of the result, so that the caller can fall back to
+ * sending the query as is.
+ *
+ * query: SPARQL query
+ *
+ * returns the clauses of the query, allocated in the current memory context
+ */
+SPARQLQuery *SPARQLParseQuery(const char *query)
+{
+	SPARQLQuery *result = (SPARQLQuery *)palloc0(sizeof(SPARQLQuery));
+	SPARQLLexer lex;
+
+	elog(DEBUG2, "%s called", __func__);
+
+	Assert(query != NULL);
+
+	MemSet(&lex, 0, sizeof(lex));
+	lex.pos = query;
+	NextToken(&lex);
+
+	ParsePrologue(&lex, result);
+
+	if (TokenIs(&lex, RDF_SPARQL_KEYWORD_SELECT))
+	{
+		result->form = SPARQL_FORM_SELECT;
+		NextToken(&lex);
+
+		if (ParseProjection(&lex, result) &&
+			ParseDataset(&lex, result) &&
+			ParseWhere(&lex, result))
+			ParseModifiers(&lex, result);
+	}
+	else if (TokenIs(&lex, "CONSTRUCT"))
+		result->form = SPARQL_FORM_CONSTRUCT;
+	else if (TokenIs(&lex, RDF_SPARQL_KEYWORD_DESCRIBE))
+		result->form = SPARQL_FORM_DESCRIBE;
+	else if (TokenIs(&lex, "ASK"))
+		result->form = SPARQL_FORM_ASK;
+	else
+		ParseError(&lex, "expected SELECT, CONSTRUCT, DESCRIBE or ASK");
+
+	result->error = lex.error;
+
+	elog(DEBUG2, "%s exit: %s", __func__, result->error ? result->error : "query parsed");
+	return result;
+}
+
+/*
+ * SPARQLCopyQuery
+ * ---------------
+ * returns a copy of 'query' in the current memory context
+ */
+SPARQLQuery *SPARQLCopyQuery(SPARQLQuery *query)
+{
+	SPARQLQuery *result = (SPARQLQuery *)palloc(sizeof(SPARQLQuery));
+	ListCell *cell;
+
+	memcpy(result, query, sizeof(SPARQLQuery));
+
+	result->base = CopyString(query->base);
+	result->projection = CopyString(query->projection);
+	result->dataset = CopyString(query->dataset);
+	result->where = CopyString(query->where);
+	result->modifiers = CopyString(query->modifiers);
+	result->error = CopyString(query->error);
+	result->prefixes = NIL;
+
+	foreach (cell, query->prefixes)
+	{
+		SPARQLPrefixDecl *decl = (SPARQLPrefixDecl *)lfirst(cell);
+		SPARQLPrefixDecl *copy = (SPARQLPrefixDecl *)palloc(sizeof(SPARQLPrefixDecl));
+
+		copy->label = pstrdup(decl->label);
+		copy->iri = pstrdup(decl->iri);
+		result->prefixes = lappend(result->prefixes, copy);
+	}
+
+	return result;
+}
+
+/*
+ * SPARQLQueryNeedsSubquery
+ * ------------------------
+ * Checks if the solutions of the WHERE clause are changed by the rest of
+ * the query, i.e. grouped, aggregated, sorted, sliced, joined with a
+ * trailing VALUES clause or extended with (expression AS ?var) projections,
+ * whose variables are unbound inside the WHERE clause. Conditions and
+ * limits can then only be added around the query, used as a sub-select.
+ *
+ * returns 'true' if the query must be wrapped in a sub-select
+ */
+bool SPARQLQueryNeedsSubquery(SPARQLQuery *query)
+{
+	return query->modifiers != NULL || query->has_aggregates || query->has_expressions;
+}
+
+/*
+ * SPARQLQueryIsComposite
+ * ----------------------
+ * Checks if the solutions of the query are combined from several group
+ * graph patterns, i.e. UNION, MINUS or a sub-select, or are grouped,
+ * sorted or sliced by its solution modifiers.
+ *
+ * returns 'true' if the query is composite
+ */
+bool SPARQLQueryIsComposite(SPARQLQuery *query)
+{
+	return query->has_union || query->has_minus || query->has_subselect ||
+		   query->has_groupby || query->has_having || query->has_orderby ||
+		   query->has_limit || query->has_offset;
+}
+
+/*
+ * SPARQLDeparseGroupPattern
+ * -------------------------
+ * Deparses the group graph pattern whose solutions are the rows of the
+ * foreign table, without its surrounding curly braces, so that FILTER
+ * expressions can be appended to it. This is the WHERE clause of the
+ * query, or the whole query as a sub-select if SPARQLQueryNeedsSubquery.
+ *
+ * returns the group graph pattern, or NULL if the query was not parsed
+ */
+char *SPARQLDeparseGroupPattern(SPARQLQuery *query)
+{
+	const char *modifier = "";
+
+	if (query->error || query->form != SPARQL_FORM_SELECT || query->where == NULL)
+		return NULL;
+
+	if (!SPARQLQueryNeedsSubquery(query))
+		return pstrdup(query->where);
+
+	if (query->distinct)
+		modifier = "DISTINCT ";
+	else if (query->reduced)
+		modifier = "REDUCED ";
+
+	return psprintf("{SELECT %s%s WHERE {%s}%s%s}",
+					modifier,
+					query->projection,
+					query->where,
+					query->modifiers ? " " : "",
+					query->modifiers ? query->modifiers : "");
+}
+
+/*
+ * NextToken
+ * ---------
+ * Moves the lexer to the next token, skipping whitespaces and comments.
+ * Prefixed names and keywords are read as words; a '<' that does not
+ * start an IRI is the comparison operator.
+ */
+static void NextToken(SPARQLLexer *lex)
+{
+	const char *p = lex->pos;
+
+	for (;;)
+	{
+		while (isspace((unsigned char)*p))
+			p++;
+
+		if (*p != '#')
+			break;
+
+		while (*p && *p != '\n')
+			p++;
+	}
+
+	lex->start = p;
+	lex->type = SPARQL_TOKEN_PUNCT;
+
+	if (*p == '\0')
+		lex->type = SPARQL_TOKEN_END;
+	else if (*p == '<')
+	{
+		const char *end = p + 1;
+
+		while (*end && *end != '>' && !isspace((unsigned char)*end) &&
+			   strchr("<\"{}|^`", *end) == NULL)
+			end++;
+
+		if (*end == '>')
+		{
+			lex->type = SPARQL_TOKEN_IRI;
+			p = end;
+		}
+	}
+	else if (*p == '"' || *p == '\'')
+	{
+		char quote = *p;
+		bool longstring = p[1] == quote && p[2] == quote;
+
+		p += longstring ? 3 : 1;
+
+		for (;;)
+		{
+			if (*p == '\0' || (!longstring && *p == '\n'))
+			{
+				lex->start = p;
+				lex->len = 0;
+				lex->pos = p;
+				lex->type = SPARQL_TOKEN_END;
+				ParseError(lex, "unterminated string literal");
+				return;
+			}
+
+			if (*p == '\\' && p[1] != '\0')
+				p++;
+			else if (*p == quote && (!longstring || (p[1] == quote && p[2] == quote)))
+				break;
+
+			p++;
+		}
+
+		if (longstring)
+			p += 2;
+
+		lex->type = SPARQL_TOKEN_STRING;
+	}
+	else if ((*p == '?' || *p == '$') && IsNameChar(p[1]))
+	{
+		while (IsNameChar(p[1]))
+			p++;
+
+		lex->type = SPARQL_TOKEN_VAR;
+	}
+	else if (IsNameChar(*p) || *p == ':')
+	{
+		const char *end = p;
+
+		/* local names may contain dots, but not end with one */
+		while (*end != '\0' && (IsNameChar(*end) || strchr(":.-%\\", *end) != NULL))
+		{
+			if (*end == '\\' && end[1] != '\0')
+				end++;
+			end++;
+		}
+
+		while (end[-1] == '.')
+			end--;
+
+		lex->type = SPARQL_TOKEN_WORD;
+		p = end - 1;
+	}
+
+	if (lex->type == SPARQL_TOKEN_END)
+		lex->len = 0;
+	else
+	{
+		p++;
+		lex->len = p - lex->start;
+	}
+
+	lex->pos = p;
+}
+
+static bool IsNameChar(char c)
+{
+	return isalnum((unsigned char)c) || c == '_' || IS_HIGHBIT_SET(c);
+}
+
+/*
+ * TokenIs
+ * -------
+ * returns 'true' if the current token is the word 'keyword', in any case
+ */
+static bool TokenIs(SPARQLLexer *lex, const char *keyword)
+{
+	return lex->type == SPARQL_TOKEN_WORD &&
+		   lex->len == strlen(keyword) &&
+		   strncasecmp(lex->start, keyword, lex->len) == 0;
+}
+
+static bool TokenIsPunct(SPARQLLexer *lex, char c)
+{
+	return lex->type == SPARQL_TOKEN_PUNCT && *lex->start == c;
+}
+
+static bool IsAggregateFunction(SPARQLLexer *lex)
+{
+	return TokenIs(lex, RDF_SPARQL_AGGREGATE_FUNCTION_COUNT) ||
+		   TokenIs(lex, RDF_SPARQL_AGGREGATE_FUNCTION_SUM) ||
+		   TokenIs(lex, RDF_SPARQL_AGGREGATE_FUNCTION_AVG) ||
+		   TokenIs(lex, RDF_SPARQL_AGGREGATE_FUNCTION_MIN) ||
+		   TokenIs(lex, RDF_SPARQL_AGGREGATE_FUNCTION_MAX) ||
+		   TokenIs(lex, RDF_SPARQL_AGGREGATE_FUNCTION_SAMPLE) ||
+		   TokenIs(lex, RDF_SPARQL_AGGREGATE_FUNCTION_GROUPCONCAT);
+}
+
+/*
+ * ParseError
+ * ----------
+ * Records the first error found in the query and stops the parser.
+ *
+ * returns 'false', so that it can be returned by the calling parse function
+ */
+static bool ParseError(SPARQLLexer *lex, const char *message)
+{
+	if (lex->error == NULL)
+	{
+		if (lex->type == SPARQL_TOKEN_END)
+			lex->error = psprintf("%s at end of query", message);
+		else
+			lex->error = psprintf("%s at or near \"%.*s\"", message, lex->len, lex->start);
+	}
+
+	return false;
+}
+
+/*
+ * ParsePrologue
+ * -------------
+ * Parses the BASE and PREFIX declarations that precede the query form.
+ */
+static void ParsePrologue(SPARQLLexer *lex, SPARQLQuery *query)
+{
+	for (;;)
+	{
+		if (TokenIs(lex, "BASE"))
+		{
+			NextToken(lex);
+
+			if (lex->type != SPARQL_TOKEN_IRI)
+			{
+				ParseError(lex, "expected IRI after BASE");
+				return;
+			}
+
+			query->base = pnstrdup(lex->start + 1, lex->len - 2);
+			NextToken(lex);
+		}
+		else if (TokenIs(lex, RDF_SPARQL_KEYWORD_PREFIX))
+		{
+			SPARQLPrefixDecl *decl;
+
+			NextToken(lex);
+
+			if (lex->type != SPARQL_TOKEN_WORD ||
+				memchr(lex->start, ':', lex->len) != lex->start + lex->len - 1)
+				ereport(ERROR, (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								errmsg("malformed PREFIX: expected ':' after prefix label")));
+
+			decl = (SPARQLPrefixDecl *)palloc(sizeof(SPARQLPrefixDecl));
+			decl->label = pnstrdup(lex->start, lex->len - 1);
+
+			NextToken(lex);
+
+			if (TokenIsPunct(lex, '<'))
+				ereport(ERROR, (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								errmsg("malformed PREFIX: unterminated URI")));
+
+			if (lex->type != SPARQL_TOKEN_IRI)
+				ereport(ERROR, (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+								errmsg("malformed PREFIX: expected '<' before URI")));
+
+			decl->iri = pnstrdup(lex->start + 1, lex->len - 2);
+			query->prefixes = lappend(query->prefixes, decl);
+
+			elog(DEBUG2, "%s: PREFIX %s: <%s>", __func__, decl->label, decl->iri);
+
+			NextToken(lex);
+		}
+		else
+			return;
+	}
+}
+
+/*
+ * ParseProjection
+ * ---------------
+ * Parses the solution modifier and the projection of a SELECT query, up to
+ * the dataset or WHERE clause.
+ */
+static bool ParseProjection(SPARQLLexer *lex, SPARQLQuery *query)
+{
+	const char *first = NULL;
+	const char *last = NULL;
+	bool aggregate = false;
+	int depth = 0;
+
+	if (TokenIs(lex, "DISTINCT"))
+	{
+		query->distinct = true;
+		NextToken(lex);
+	}
+	else if (TokenIs(lex, "REDUCED"))
+	{
+		query->reduced = true;
+		NextToken(lex);
+	}
+
+	while (lex->type != SPARQL_TOKEN_END)
+	{
+		if (depth == 0 &&
+			(TokenIs(lex, "WHERE") || TokenIs(lex, RDF_SPARQL_KEYWORD_FROM) || TokenIsPunct(lex, '{')))
+			break;
+
+		if (TokenIsPunct(lex, '('))
+		{
+			depth++;
+
+			if (aggregate)
+				query->has_aggregates = true;
+		}
+		else if (TokenIsPunct(lex, ')'))
+			depth--;
+		else if (TokenIs(lex, "AS"))
+			query->has_expressions = true;
+
+		aggregate = IsAggregateFunction(lex);
+
+		if (first == NULL)
+			first = lex->start;
+
+		last = lex->start + lex->len;
+		NextToken(lex);
+	}
+
+	if (first == NULL)
+		return ParseError(lex, "expected variables or '*' after SELECT");
+
+	query->projection = pnstrdup(first, last - first);
+
+	return true;
+}
+
+/*
+ * ParseDataset
+ * ------------
+ * Parses the FROM and FROM NAMED clauses, one line per graph.
+ */
+static bool ParseDataset(SPARQLLexer *lex, SPARQLQuery *query)
+{
+	StringInfoData dataset;
+
+	initStringInfo(&dataset);
+
+	while (TokenIs(lex, RDF_SPARQL_KEYWORD_FROM))
+	{
+		bool named = false;
+
+		NextToken(lex);
+
+		if (TokenIs(lex, RDF_SPARQL_KEYWORD_NAMED))
+		{
+			named = true;
+			NextToken(lex);
+		}
+
+		if (lex->type != SPARQL_TOKEN_IRI && lex->type != SPARQL_TOKEN_WORD)
+			return ParseError(lex, "expected IRI after FROM");
+
+		if (named)
+			appendStringInfo(&dataset, "%s %s %.*s\n", RDF_SPARQL_KEYWORD_FROM, RDF_SPARQL_KEYWORD_NAMED, lex->len, lex->start);
+		else
+			appendStringInfo(&dataset, "%s %.*s\n", RDF_SPARQL_KEYWORD_FROM, lex->len, lex->start);
+
+		NextToken(lex);
+	}
+
+	query->dataset = dataset.data;
+
+	return true;
+}
+
+/*
+ * ParseWhere
+ * ----------
+ * Parses the group graph pattern of the WHERE clause, recording the
+ * constructs it contains.
+ */
+static bool ParseWhere(SPARQLLexer *lex, SPARQLQuery *query)
+{
+	const char *open;
+	int depth = 1;
+
+	if (TokenIs(lex, "WHERE"))
+		NextToken(lex);
+
+	if (!TokenIsPunct(lex, '{'))
+		return ParseError(lex, "expected '{'");
+
+	open = lex->start;
+	NextToken(lex);
+
+	while (lex->type != SPARQL_TOKEN_END)
+	{
+		if (TokenIsPunct(lex, '{'))
+		{
+			query->has_groups = true;
+			depth++;
+		}
+		else if (TokenIsPunct(lex, '}') && --depth == 0)
+			break;
+		else if (TokenIs(lex, "OPTIONAL"))
+			query->has_optional = true;
+		else if (TokenIs(lex, RDF_SPARQL_KEYWORD_UNION))
+			query->has_union = true;
+		else if (TokenIs(lex, RDF_SPARQL_KEYWORD_MINUS))
+			query->has_minus = true;
+		else if (TokenIs(lex, "BIND"))
+			query->has_bind = true;
+		else if (TokenIs(lex, RDF_SPARQL_KEYWORD_SELECT))
+			query->has_subselect = true;
+
+		NextToken(lex);
+	}
+
+	if (lex->type == SPARQL_TOKEN_END)
+		return ParseError(lex, "unterminated group graph pattern");
+
+	query->where = pnstrdup(open + 1, lex->start - open - 1);
+	NextToken(lex);
+
+	return true;
+}
+
+/*
+ * ParseModifiers
+ * --------------
+ * Parses the solution modifiers and the trailing VALUES clause that follow
+ * the WHERE clause. They are kept as written, from their first to their
+ * last token, so that a trailing comment is left out.
+ */
+static bool ParseModifiers(SPARQLLexer *lex, SPARQLQuery *query)
+{
+	const char *first = NULL;
+	const char *last = NULL;
+	int depth = 0;
+
+	while (lex->type != SPARQL_TOKEN_END)
+	{
+		if (TokenIsPunct(lex, '{'))
+			depth++;
+		else if (TokenIsPunct(lex, '}') && --depth < 0)
+			return ParseError(lex, "unbalanced '}'");
+		else if (depth == 0)
+		{
+			if (TokenIs(lex, "GROUP"))
+				query->has_groupby = true;
+			else if (TokenIs(lex, RDF_SPARQL_KEYWORD_HAVING))
+				query->has_having = true;
+			else if (TokenIs(lex, "ORDER"))
+				query->has_orderby = true;
+			else if (TokenIs(lex, RDF_SPARQL_KEYWORD_LIMIT))
+				query->has_limit = true;
+			else if (TokenIs(lex, RDF_SPARQL_KEYWORD_OFFSET))
+				query->has_offset = true;
+		}
+
+		if (first == NULL)
+			first = lex->start;
+
+		last = lex->start + lex->len;
+		NextToken(lex);
+	}
+
+	if (lex->error)
+		return false;
+
+	if (depth > 0)
+		return ParseError(lex, "unterminated VALUES clause");
+
+	if (first != NULL)
+		query->modifiers = pnstrdup(first, last - first);
+
+	return true;
+}
+
+static char *CopyString(const char *str)
+{
+	return str ? pstrdup(str) : NULL;
+}
@@ -0,0 +1,92 @@
+/*---------------------------------------------------------------------
+ *
+ * sparql_parser.h
+ *   Parser for the clause structure of SPARQL 1.1 queries set in the
+ *   'sparql' option of foreign tables.
+ *
+ * Copyright (C) 2022-2026 Jim Jones <jim.jones@uni-muenster.de>
+ *
+ *---------------------------------------------------------------------
+ */
+
+#ifndef SPARQL_PARSER_H
+#define SPARQL_PARSER_H
+
+#include "postgres.h"
+#include "nodes/pg_list.h"
+
+typedef enum SPARQLQueryForm
+{
+	SPARQL_FORM_UNKNOWN,
+	SPARQL_FORM_SELECT,
+	SPARQL_FORM_CONSTRUCT,
+	SPARQL_FORM_DESCRIBE,
+	SPARQL_FORM_ASK
+} SPARQLQueryForm;
+
+/*
+ * SPARQLPrefixDecl
+ * ----------------
+ * PREFIX declaration of the query prologue.
+ */
+typedef struct SPARQLPrefixDecl
+{
+	char *label; /* prefix label without the ':', may be empty */
+	char *iri;	 /* namespace IRI without the angle brackets */
+} SPARQLPrefixDecl;
+
+/*
+ * SPARQLQuery
+ * -----------
+ * Clauses of a SPARQL query, as written in the query text. Only the
+ * structure the deparser relies on is parsed: the prologue, the query
+ * form, the projection, the dataset, the group graph pattern of the WHERE
+ * clause and the solution modifiers. Expressions and triple patterns are
+ * kept verbatim, and the constructs found in them are recorded as flags.
+ *
+ * If the query cannot be parsed, 'error' describes why and the clauses
+ * that follow the failing token are left empty.
+ */
+typedef struct SPARQLQuery
+{
+	SPARQLQueryForm form;
+	char *base;			/* BASE IRI without the angle brackets, or NULL */
+	List *prefixes;		/* SPARQLPrefixDecl, in order of declaration */
+
+	/* SELECT clause */
+	bool distinct;		  /* SELECT DISTINCT */
+	bool reduced;		  /* SELECT REDUCED */
+	char *projection;	  /* variables and expressions after the modifier */
+	bool has_aggregates;  /* projection calls an aggregate function */
+	bool has_expressions; /* projection contains (expression AS ?var) */
+
+	/* dataset clause, as "FROM <iri>\n" and "FROM NAMED <iri>\n" lines */
+	char *dataset;
+
+	/* group graph pattern of the WHERE clause, without its curly braces */
+	char *where;
+	bool has_groups;	/* nested group graph patterns */
+	bool has_optional;	/* OPTIONAL */
+	bool has_union;		/* UNION */
+	bool has_minus;		/* MINUS */
+	bool has_bind;		/* BIND */
+	bool has_subselect; /* sub-select */
+
+	/* solution modifiers and trailing VALUES clause, or NULL */
+	char *modifiers;
+	bool has_groupby;
+	bool has_having;
+	bool has_orderby;
+	bool has_limit;
+	bool has_offset;
+
+	char *error; /* parse error, or NULL */
+} SPARQLQuery;
+
+extern SPARQLQuery *SPARQLParseQuery(const char *query);
+extern SPARQLQuery *SPARQLCopyQuery(SPARQLQuery *query);
+extern bool SPARQLQueryNeedsSubquery(SPARQLQuery *query);
+extern bool SPARQLQueryIsComposite(SPARQLQuery *query);
+extern char *SPARQLDeparseGroupPattern(SPARQLQuery *query);
+
+#endif /* SPARQL_PARSER_H */
@@ -0,0 +1,675 @@
+/*---------------------------------------------------------------------
+ *
+ * sparql_tsv.c
+ *   Reader for SPARQL 1.1 Query Results TSV Format
+ *   (text/tab-separated-values).
+ *
+ * A TSV result set is a header line with the variable names, followed by
+ * one line per solution. Fields are separated by tabs and hold RDF terms
+ * in Turtle/N-Triples syntax, or nothing if the variable is unbound:
+ *
+ *   ?s<TAB>?o
+ *   <http://example.org/a><TAB>"foo"@en
+ *   _:b0<TAB>42
+ *
+ * Rows are handed out as soon as their line is complete, and their fields
+ * are only decoded when (and if) a column needs them.
+ *
+ * Copyright (C) 2022-2026 Jim Jones <jim.jones@uni-muenster.de>
+ *
+ *---------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "rdf_fdw.h"
+#include "sparql_tsv.h"
+
+#include "lib/stringinfo.h"
+#include "mb/pg_wchar.h"
+#include "utils/memutils.h"
+#include <string.h>
+
+struct SPARQLTsvParser
+{
+	StringInfoData buffer;	/* received data not consumed yet */
+	size_t pos;				/* start of the next line in 'buffer' */
+	size_t data_start;		/* start of the first row in 'buffer' */
+	bool keep;				/* keep consumed rows, so they can be read again */
+	bool terminated;		/* the whole document was received */
+	bool has_header;		/* the header line was parsed */
+	char **variables;		/* variable names of the header, e.g. "?s" */
+	int numvars;			/* number of variables in the header */
+	StringInfoData row;		/* copy of the current row, split at tabs */
+	char **fields;			/* fields of the current row (numvars entries) */
+	size_t offset;			/* bytes consumed so far */
+	char *error;			/* error message, once parsing failed */
+	MemoryContext cxt;		/* memory context the parser was created in */
+};
+
+static bool TsvError(SPARQLTsvParser *parser, const char *message);
+static bool TsvParseHeader(SPARQLTsvParser *parser);
+static char *TsvUnescape(const char *start, const char *end);
+static int TsvHexValue(char c);
+static const char *TsvNumericDatatype(const char *literal);
+
+/*
+ * SPARQLTsvCreateParser
+ * ---------------------
+ * Creates a SPARQL TSV reader in the current memory context, to be fed
+ * with SPARQLTsvParseChunk. Consumed rows are discarded, so the memory
+ * used by the reader does not grow with the size of the result set.
+ *
+ * returns a new parser
+ */
+SPARQLTsvParser *SPARQLTsvCreateParser(void)
+{
+	SPARQLTsvParser *parser = (SPARQLTsvParser *)palloc0(sizeof(SPARQLTsvParser));
+
+	elog(DEBUG2, "%s called", __func__);
+
+	initStringInfo(&parser->buffer);
+	initStringInfo(&parser->row);
+	parser->cxt = CurrentMemoryContext;
+
+	return parser;
+}
+
+/*
+ * SPARQLTsvFreeParser
+ * -------------------
+ * Releases a parser and the data it holds.
+ *
+ * parser: parser created by SPARQLTsvCreateParser or SPARQLTsvReadMemory
+ */
+void SPARQLTsvFreeParser(SPARQLTsvParser *parser)
+{
+	if (parser == NULL)
+		return;
+
+	if (parser->buffer.data)
+		pfree(parser->buffer.data);
+
+	if (parser->row.data)
+		pfree(parser->row.data);
+
+	for (int i = 0; i < parser->numvars; i++)
+		pfree(parser->variables[i]);
+
+	if (parser->variables)
+		pfree(parser->variables);
+
+	if (parser->fields)
+		pfree(parser->fields);
+
+	pfree(parser);
+}
+
+/*
+ * SPARQLTsvGetError
+ * -----------------
+ * returns the message of the error that stopped the parser, or NULL
+ */
+const char *SPARQLTsvGetError(SPARQLTsvParser *parser)
+{
+	return parser->error;
+}
+
+/*
+ * SPARQLTsvParseChunk
+ * -------------------
+ * Feeds a chunk of a SPARQL TSV result set to the parser. Lines may be
+ * split across chunks at any byte.
+ *
+ * parser   : parser created by SPARQLTsvCreateParser
+ * chunk    : data received from the endpoint
+ * size     : size of 'chunk' in bytes
+ * terminate: true if this is the last chunk of the document
+ *
+ * returns false if the header of the result set is invalid; the reason is
+ * available through SPARQLTsvGetError.
+ */
+bool SPARQLTsvParseChunk(SPARQLTsvParser *parser, const char *chunk, size_t size, bool terminate)
+{
+	MemoryContext oldcxt;
+	bool result = true;
+
+	if (parser->error)
+		return false;
+
+	/* drop the rows that were already consumed */
+	if (!parser->keep && parser->pos > 0)
+	{
+		size_t remaining = parser->buffer.len - parser->pos;
+
+		memmove(parser->buffer.data, parser->buffer.data + parser->pos, remaining);
+		parser->buffer.len = (int)remaining;
+		parser->buffer.data[remaining] = '\0';
+		parser->pos = 0;
+		parser->data_start = 0;
+	}
+
+	if (size > 0)
+		appendBinaryStringInfo(&parser->buffer, chunk, (int)size);
+
+	parser->terminated = terminate;
+
+	/*
+	 * Streamed chunks arrive in short-lived memory contexts, but the header
+	 * has to outlive them.
+	 */
+	if (!parser->has_header)
+	{
+		oldcxt = MemoryContextSwitchTo(parser->cxt);
+		result = TsvParseHeader(parser);
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	return result;
+}
+
+/*
+ * SPARQLTsvReadMemory
+ * -------------------
+ * Creates a parser for a complete SPARQL TSV result set held in memory.
+ * The parser takes over 'buffer', which must be palloc'd in the current
+ * memory context and null-terminated, instead of copying it. Rows are not
+ * discarded once consumed, so the result set can be read again after
+ * SPARQLTsvRewind.
+ *
+ * buffer: SPARQL TSV result set
+ * size  : size of 'buffer' in bytes
+ * errmsg: set to the reason of the failure if NULL is returned
+ *
+ * returns a parser positioned at the first row, or NULL if the result set
+ * cannot be read.
+ */
+SPARQLTsvParser *SPARQLTsvReadMemory(char *buffer, size_t size, char **errmsg)
+{
+	SPARQLTsvParser *parser = SPARQLTsvCreateParser();
+
+	pfree(parser->buffer.data);
+	parser->buffer.data = buffer;
+	parser->buffer.len = (int)size;
+	parser->buffer.maxlen = (int)size + 1;
+	parser->keep = true;
+	parser->terminated = true;
+
+	if (!TsvParseHeader(parser))
+	{
+		if (errmsg)
+			*errmsg = pstrdup(parser->error);
+
+		SPARQLTsvFreeParser(parser);
+		return NULL;
+	}
+
+	return parser;
+}
+
+/*
+ * SPARQLTsvGetVariableIndex
+ * -------------------------
+ * Looks up a variable in the header of the result set.
+ *
+ * parser  : parser whose header was already received
+ * variable: variable name, e.g. "?s"
+ *
+ * returns the position of the variable's field in the rows, or -1 if the
+ * result set does not contain the variable.
+ */
+int SPARQLTsvGetVariableIndex(SPARQLTsvParser *parser, const char *variable)
+{
+	if (variable == NULL)
+		return -1;
+
+	for (int i = 0; i < parser->numvars; i++)
+	{
+		/* "?s" and "$s" denote the same variable */
+		if (strcmp(parser->variables[i] + 1, variable + 1) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * SPARQLTsvCountRows
+ * ------------------
+ * returns the number of complete rows received and not yet consumed
+ */
+int SPARQLTsvCountRows(SPARQLTsvParser *parser)
+{
+	const char *p = parser->buffer.data + parser->pos;
+	const char *end = parser->buffer.data + parser->buffer.len;
+	int rows = 0;
+
+	if (!parser->has_header)
+		return 0;
+
+	while (p < end)
+	{
+		const char *eol = memchr(p, '\n', end - p);
+
+		if (eol == NULL)
+		{
+			/* the last line of a document does not need a line break */
+			if (parser->terminated)
+				rows++;
+			break;
+		}
+
+		rows++;
+		p = eol + 1;
+	}
+
+	return rows;
+}
+
+/*
+ * SPARQLTsvNextRow
+ * ----------------
+ * Reads the next complete row of the result set.
+ *
+ * parser: parser whose header was already received
+ *
+ * returns an array with one field per header variable, or NULL if no
+ * complete row is available (yet). The fields are valid until the next
+ * call, and each of them can be decoded with SPARQLTsvDecodeTerm.
+ */
+char **SPARQLTsvNextRow(SPARQLTsvParser *parser)
+{
+	char *line = parser->buffer.data + parser->pos;
+	char *end = parser->buffer.data + parser->buffer.len;
+	char *eol;
+	size_t len;
+	int nfields = 0;
+	char *field;
+
+	if (!parser->has_header || line >= end)
+		return NULL;
+
+	eol = memchr(line, '\n', end - line);
+
+	if (eol == NULL)
+	{
+		/* the rest of the line has not arrived yet */
+		if (!parser->terminated)
+			return NULL;
+
+		eol = end;
+	}
+
+	len = eol - line;
+	parser->pos += len + (eol < end ? 1 : 0);
+	parser->offset += len + 1;
+
+	if (len > 0 && line[len - 1] == '\r')
+		len--;
+
+	resetStringInfo(&parser->row);
+	appendBinaryStringInfo(&parser->row, line, (int)len);
+
+	field = parser->row.data;
+
+	for (char *p = parser->row.data;; p++)
+	{
+		if (*p == '\t' || *p == '\0')
+		{
+			bool last = (*p == '\0');
+
+			*p = '\0';
+
+			if (nfields < parser->numvars)
+				parser->fields[nfields] = field;
+
+			nfields++;
+			field = p + 1;
+
+			if (last)
+				break;
+		}
+	}
+
+	/* a line without fields is a row of unbound variables */
+	if (nfields != parser->numvars && !(len == 0 && parser->numvars == 0))
+		elog(ERROR, "failed to parse SPARQL TSV result: row has %d fields, but the header has %d variables (byte %zu)",
+			 nfields, parser->numvars, parser->offset);
+
+	return parser->fields;
+}
+
+/*
+ * SPARQLTsvRewind
+ * ---------------
+ * Positions a parser created by SPARQLTsvReadMemory at its first row again.
+ */
+void SPARQLTsvRewind(SPARQLTsvParser *parser)
+{
+	Assert(parser->keep);
+
+	parser->pos = parser->data_start;
+	parser->offset = parser->data_start;
+}
+
+/*
+ * SPARQLTsvDecodeTerm
+ * -------------------
+ * Decodes the RDF term of a TSV field into the parts a term has in SPARQL
+ * XML results. Escape sequences are resolved, so the lexical form can be
+ * given to any type input function. Abbreviated numbers and booleans (42,
+ * 1.5, 1e3, true) are expanded to their typed literals.
+ *
+ * field: field of a row returned by SPARQLTsvNextRow
+ * term : decoded RDF term
+ */
+void SPARQLTsvDecodeTerm(char *field, SPARQLTsvTerm *term)
+{
+	size_t len = strlen(field);
+	bool escaped = (strchr(field, '\\') != NULL);
+
+	memset(term, 0, sizeof(SPARQLTsvTerm));
+
+	if (len == 0)
+	{
+		term->type = SPARQL_TSV_UNBOUND;
+		return;
+	}
+
+	if (field[0] == '<')
+	{
+		if (len < 2 || field[len - 1] != '>')
+			elog(ERROR, "failed to parse SPARQL TSV result: invalid IRI %s", field);
+
+		term->type = SPARQL_TSV_IRI;
+		term->value = escaped ? TsvUnescape(field + 1, field + len - 1) : pnstrdup(field + 1, len - 2);
+	}
+	else if (field[0] == '_' && field[1] == ':')
+	{
+		term->type = SPARQL_TSV_BNODE;
+		term->value = field + 2;
+	}
+	else if (field[0] == '"')
+	{
+		char *p = field + 1;
+		char *suffix;
+
+		/* find the closing quote, skipping escaped characters */
+		while (*p && *p != '"')
+			p += (*p == '\\' && *(p + 1)) ? 2 : 1;
+
+		if (*p != '"')
+			elog(ERROR, "failed to parse SPARQL TSV result: unterminated literal %s", field);
+
+		term->type = SPARQL_TSV_LITERAL;
+		term->value = escaped ? TsvUnescape(field + 1, p) : pnstrdup(field + 1, p - field - 1);
+		suffix = p + 1;
+
+		if (*suffix == '@' && *(suffix + 1))
+			term->lang = suffix + 1;
+		else if (suffix[0] == '^' && suffix[1] == '^' && suffix[2] == '<' &&
+				 suffix[strlen(suffix) - 1] == '>')
+			term->datatype = pnstrdup(suffix + 3, strlen(suffix) - 4);
+		else if (*suffix != '\0')
+			elog(ERROR, "failed to parse SPARQL TSV result: invalid literal %s", field);
+	}
+	else
+	{
+		/* abbreviated literal, e.g. 42, -1.5, 1.0e3, true */
+		const char *datatype = TsvNumericDatatype(field);
+
+		if (datatype == NULL && (strcmp(field, "true") == 0 || strcmp(field, "false") == 0))
+			datatype = RDF_XSD_BOOLEAN;
+
+		if (datatype == NULL)
+			elog(ERROR, "failed to parse SPARQL TSV result: unsupported RDF term %s", field);
+
+		term->type = SPARQL_TSV_LITERAL;
+		term->value = field;
+		term->datatype = pnstrdup(datatype + 1, strlen(datatype) - 2);
+	}
+}
+
+/*
+ * IsSPARQLTsvFormat
+ * -----------------
+ * Checks if a 'format' (MIME type) requests SPARQL TSV result sets.
+ */
+bool IsSPARQLTsvFormat(const char *format)
+{
+	return format != NULL &&
+		   pg_strncasecmp(format, RDF_SPARQL_TSV_FORMAT, strlen(RDF_SPARQL_TSV_FORMAT)) == 0;
+}
+
+/*
+ * TsvError
+ * --------
+ * Stops the parser with an error message. Always returns false.
+ */
+static bool TsvError(SPARQLTsvParser *parser, const char *message)
+{
+	parser->error = psprintf("%s at byte %zu", message, parser->offset);
+	return false;
+}
+
+/*
+ * TsvParseHeader
+ * --------------
+ * Reads the variable names from the first line of the result set, once it
+ * is complete. An empty document is a result set without variables.
+ */
+static bool TsvParseHeader(SPARQLTsvParser *parser)
+{
+	char *data = parser->buffer.data;
+	char *end = data + parser->buffer.len;
+	char *eol;
+	char *line;
+	char *var;
+	size_t len;
+
+	eol = memchr(data, '\n', parser->buffer.len);
+
+	if (eol == NULL && !parser->terminated)
+		return true;
+
+	if (eol == NULL)
+		eol = end;
+
+	line = data;
+	len = eol - line;
+
+	/* skip the UTF-8 byte order mark */
+	if (len >= 3 && memcmp(line, "\xEF\xBB\xBF", 3) == 0)
+	{
+		line += 3;
+		len -= 3;
+	}
+
+	if (len > 0 && line[len - 1] == '\r')
+		len--;
+
+	line = pnstrdup(line, len);
+
+	if (len > 0)
+	{
+		int max = 1;
+
+		for (char *p = line; *p; p++)
+			if (*p == '\t')
+				max++;
+
+		parser->variables = (char **)palloc0(max * sizeof(char *));
+
+		for (var = strtok(line, "\t"); var != NULL; var = strtok(NULL, "\t"))
+		{
+			if (var[0] != '?' && var[0] != '$')
+			{
+				TsvError(parser, psprintf("invalid variable name \"%s\" in header", var));
+				pfree(line);
+				return false;
+			}
+
+			parser->variables[parser->numvars++] = pstrdup(var);
+		}
+	}
+
+	pfree(line);
+
+	parser->fields = (char **)palloc0((parser->numvars + 1) * sizeof(char *));
+	parser->has_header = true;
+	parser->pos = eol < end ? eol - data + 1 : eol - data;
+	parser->data_start = parser->pos;
+	parser->offset = parser->pos;
+
+	elog(DEBUG2, "%s: result set has %d variables", __func__, parser->numvars);
+
+	return true;
+}
+
+/*
+ * TsvUnescape
+ * -----------
+ * Resolves the escape sequences (\t, \n, \", \uXXXX, \UXXXXXXXX, ...) of
+ * an IRI or of the lexical form of a literal. Invalid escape sequences are
+ * kept as they are.
+ */
+static char *TsvUnescape(const char *start, const char *end)
+{
+	StringInfoData buf;
+
+	initStringInfo(&buf);
+
+	for (const char *p = start; p < end; p++)
+	{
+		if (*p != '\\' || p + 1 >= end)
+		{
+			appendStringInfoChar(&buf, *p);
+			continue;
+		}
+
+		switch (*(p + 1))
+		{
+		case 't':
+			appendStringInfoChar(&buf, '\t');
+			break;
+		case 'b':
+			appendStringInfoChar(&buf, '\b');
+			break;
+		case 'n':
+			appendStringInfoChar(&buf, '\n');
+			break;
+		case 'r':
+			appendStringInfoChar(&buf, '\r');
+			break;
+		case 'f':
+			appendStringInfoChar(&buf, '\f');
+			break;
+		case '"':
+		case '\'':
+		case '\\':
+			appendStringInfoChar(&buf, *(p + 1));
+			break;
+		case 'u':
+		case 'U':
+		{
+			int ndigits = *(p + 1) == 'u' ? 4 : 8;
+			pg_wchar c = 0;
+			int i;
+
+			for (i = 0; i < ndigits && p + 2 + i < end && TsvHexValue(p[2 + i]) >= 0; i++)
+				c = (c << 4) | TsvHexValue(p[2 + i]);
+
+			if (i < ndigits || c == 0 || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+			{
+				appendStringInfoChar(&buf, '\\');
+				continue;
+			}
+			else
+			{
+				unsigned char utf8[8];
+
+				unicode_to_utf8(c, utf8);
+				appendBinaryStringInfo(&buf, (char *)utf8, pg_utf_mblen(utf8));
+				p += ndigits;
+			}
+			break;
+		}
+		default:
+			appendStringInfoChar(&buf, '\\');
+			continue;
+		}
+
+		/* skip the escaped character */
+		p++;
+	}
+
+	return buf.data;
+}
+
+/*
+ * TsvHexValue
+ * -----------
+ * returns the value of a hexadecimal digit, or -1
+ */
+static int TsvHexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+
+	return -1;
+}
+
+/*
+ * TsvNumericDatatype
+ * ------------------
+ * Determines the datatype of an abbreviated numeric literal, following
+ * the INTEGER, DECIMAL and DOUBLE productions of Turtle.
+ *
+ * returns RDF_XSD_INTEGER, RDF_XSD_DECIMAL, RDF_XSD_DOUBLE or NULL if
+ * 'literal' is not a number.
+ */
+static const char *TsvNumericDatatype(const char *literal)
+{
+	const char *p = literal;
+	bool digits = false;
+	bool dot = false;
+
+	if (*p == '+' || *p == '-')
+		p++;
+
+	for (; *p; p++)
+	{
+		if (*p >= '0' && *p <= '9')
+			digits = true;
+		else if (*p == '.' && !dot)
+			dot = true;
+		else
+			break;
+	}
+
+	if (!digits)
+		return NULL;
+
+	if (*p == '\0')
+		return dot ? (*(p - 1) == '.' ? NULL : RDF_XSD_DECIMAL) : RDF_XSD_INTEGER;
+
+	if (*p != 'e' && *p != 'E')
+		return NULL;
+
+	p++;
+
+	if (*p == '+' || *p == '-')
+		p++;
+
+	if (*p < '0' || *p > '9')
+		return NULL;
+
+	while (*p >= '0' && *p <= '9')
+		p++;
+
+	return *p == '\0' ? RDF_XSD_DOUBLE : NULL;
+}
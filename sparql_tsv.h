@@ -0,0 +1,60 @@
+/*---------------------------------------------------------------------
+ *
+ * sparql_tsv.h
+ *   Reader for SPARQL 1.1 Query Results TSV Format
+ *   (text/tab-separated-values).
+ *
+ * Copyright (C) 2022-2026 Jim Jones <jim.jones@uni-muenster.de>
+ *
+ *---------------------------------------------------------------------
+ */
+
+#ifndef SPARQL_TSV_H
+#define SPARQL_TSV_H
+
+#include "postgres.h"
+
+/*
+ * SPARQLTsvParser
+ * ---------------
+ * Line-oriented reader for SPARQL TSV result sets. Data is fed to it in
+ * chunks of arbitrary size and handed out one row at a time, as an array
+ * of fields in the order of the header variables. Unlike the XML parser,
+ * no document is built: each row is read straight from the received data.
+ */
+typedef struct SPARQLTsvParser SPARQLTsvParser;
+
+typedef enum SPARQLTsvTermType
+{
+	SPARQL_TSV_UNBOUND, /* empty field */
+	SPARQL_TSV_IRI,		/* <http://...> */
+	SPARQL_TSV_BNODE,	/* _:label */
+	SPARQL_TSV_LITERAL	/* "...", "..."@lang, "..."^^<iri>, 42, true, ... */
+} SPARQLTsvTermType;
+
+/*
+ * SPARQLTsvTerm
+ * -------------
+ * RDF term of a TSV field, as decoded by SPARQLTsvDecodeTerm.
+ */
+typedef struct SPARQLTsvTerm
+{
+	SPARQLTsvTermType type;
+	char *value;	/* IRI, blank node label or lexical form, unescaped */
+	char *datatype; /* datatype IRI of typed literals, or NULL */
+	char *lang;		/* language tag of literals, or NULL */
+} SPARQLTsvTerm;
+
+extern SPARQLTsvParser *SPARQLTsvCreateParser(void);
+extern bool SPARQLTsvParseChunk(SPARQLTsvParser *parser, const char *chunk, size_t size, bool terminate);
+extern SPARQLTsvParser *SPARQLTsvReadMemory(char *buffer, size_t size, char **errmsg);
+extern const char *SPARQLTsvGetError(SPARQLTsvParser *parser);
+extern int SPARQLTsvGetVariableIndex(SPARQLTsvParser *parser, const char *variable);
+extern int SPARQLTsvCountRows(SPARQLTsvParser *parser);
+extern char **SPARQLTsvNextRow(SPARQLTsvParser *parser);
+extern void SPARQLTsvRewind(SPARQLTsvParser *parser);
+extern void SPARQLTsvFreeParser(SPARQLTsvParser *parser);
+extern void SPARQLTsvDecodeTerm(char *field, SPARQLTsvTerm *term);
+extern bool IsSPARQLTsvFormat(const char *format);
+
+#endif /* SPARQL_TSV_H */
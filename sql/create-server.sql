@@ -146,4 +146,36 @@ FOREIGN DATA WRAPPER rdf_fdw
 OPTIONS (    
   endpoint 'https://dbpedia.org/sparql',
   max_response_size '1.5'
-);
\ No newline at end of file
+);
+
+/* invalid enable_streaming value */
+CREATE SERVER rdfserver_error20
+FOREIGN DATA WRAPPER rdf_fdw 
+OPTIONS (    
+  endpoint 'https://dbpedia.org/sparql',
+  enable_streaming 'foo'
+);
+
+/* invalid use_remote_estimate value */
+CREATE SERVER rdfserver_error21
+FOREIGN DATA WRAPPER rdf_fdw 
+OPTIONS (    
+  endpoint 'https://dbpedia.org/sparql',
+  use_remote_estimate 'foo'
+);
+
+/* invalid remote_estimate_ttl - negative value */
+CREATE SERVER rdfserver_error22
+FOREIGN DATA WRAPPER rdf_fdw 
+OPTIONS (    
+  endpoint 'https://dbpedia.org/sparql',
+  remote_estimate_ttl '-1'
+);
+
+/* invalid remote_estimate_ttl - non-numeric value */
+CREATE SERVER rdfserver_error23
+FOREIGN DATA WRAPPER rdf_fdw 
+OPTIONS (    
+  endpoint 'https://dbpedia.org/sparql',
+  remote_estimate_ttl 'foo'
+);
@@ -146,6 +146,15 @@ ALTER FOREIGN TABLE ft ALTER COLUMN predicate TYPE text;
 DELETE FROM ft WHERE predicate = '<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>'; -- should fail, predicate column is now text, not rdfnode
 ALTER FOREIGN TABLE ft ALTER COLUMN predicate TYPE rdfnode;
 
+/* direct modify: the DELETE is sent as a single SPARQL UPDATE */
+ALTER FOREIGN TABLE ft OPTIONS (ADD enable_direct_modify 'true');
+INSERT INTO ft (subject, predicate, object) VALUES
+  ('<https://www.uni-muenster.de/rdf_fdw/direct-modify>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"a"@en'),
+  ('<https://www.uni-muenster.de/rdf_fdw/direct-modify>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"b"@en');
+DELETE FROM ft WHERE subject = '<https://www.uni-muenster.de/rdf_fdw/direct-modify>';
+SELECT * FROM ft WHERE subject = '<https://www.uni-muenster.de/rdf_fdw/direct-modify>';
+ALTER FOREIGN TABLE ft OPTIONS (DROP enable_direct_modify);
+
 /* cleanup */
 DELETE FROM ft WHERE object IN (SELECT object FROM ft WHERE sparql.lang(object) = 'non-existent-lang');
 DELETE FROM ft WHERE object IN (SELECT object FROM ft WHERE sparql.lang(object) <> 'en');
@@ -78,6 +78,12 @@ INSERT INTO ft (subject, predicate, object) VALUES
 ('<https://www.uni-muenster.de>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"Universidade de Münster"@pt')
 RETURNING *;
 
+/* RETURNING disables batch inserts, so that every row is returned */
+INSERT INTO ft (subject, predicate, object) VALUES
+('<https://www.uni-muenster.de>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"Universität Münster"@de-AT'),
+('<https://www.uni-muenster.de>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"Université de Münster"@fr')
+RETURNING object;
+
 /*
  * Here we transfer data from a local static graph into a destination named
  * graph in Fuseki. This exercises the cross-FDW INSERT-SELECT code path
@@ -173,14 +179,18 @@ COPY (
   ORDER BY o::text COLLATE "C"
 ) TO STDOUT DELIMITER E' ';
 
-/*** Exception tests ***/
-
-/* COPY .. FROM must fail - not supported */
+/* COPY .. FROM is sent in the same batched requests as INSERT */
 COPY ft (subject, predicate, object) FROM STDIN WITH (DELIMITER ' ');
 <https://www.uni-muenster.de> <http://www.w3.org/1999/02/22-rdf-syntax-ns#value> "42"^^<http://www.w3.org/2001/XMLSchema#int>
 <https://www.uni-muenster.de> <http://www.w3.org/1999/02/22-rdf-syntax-ns#value> "37"^^<http://www.w3.org/2001/XMLSchema#int>
 \.
 
+SELECT subject, predicate, object FROM ft
+WHERE predicate = '<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>'
+ORDER BY object::text COLLATE "C";
+
+/*** Exception tests ***/
+
 /* INSERT must fail - all columns must be of type rdfnode */
 ALTER FOREIGN TABLE ft ALTER COLUMN predicate TYPE text;
 INSERT INTO ft (subject, predicate, object) VALUES
@@ -286,6 +296,115 @@ ALTER FOREIGN TABLE ft ALTER COLUMN predicate TYPE text;
 INSERT INTO ft (subject, predicate, object) VALUES ('<https://www.uni-muenster.de>', '<http://www.w3.org/1999/02/22-rdf-syntax-ns#type>', 'http://dbpedia.org/resource/University');
 ALTER FOREIGN TABLE ft ALTER COLUMN predicate TYPE rdfnode;
 
+/* Graph Store Protocol: inserts are sent as N-Quads to graph_store_url */
+ALTER SERVER fuseki OPTIONS (ADD graph_store_url 'http://fuseki:3030/dt/data');
+CREATE FOREIGN TABLE ft_gsp (
+  subject   rdfnode OPTIONS (variable '?s'),
+  predicate rdfnode OPTIONS (variable '?p'),
+  object    rdfnode OPTIONS (variable '?o')
+)
+SERVER fuseki OPTIONS (
+  log_sparql 'true',
+  sparql 'SELECT * {GRAPH <http://rdf-fdw.test/gsp> {?s ?p ?o}}',
+  sparql_update_pattern
+    'GRAPH <http://rdf-fdw.test/gsp> {
+       ?s ?p ?o .
+       ?s rdf:comment "loaded via rdf_fdw"@en .
+     }'
+);
+INSERT INTO ft_gsp (subject, predicate, object) VALUES
+('<https://www.uni-muenster.de>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"University of Münster"@en'),
+('<https://www.uni-muenster.de>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"Universität Münster"@de'),
+('<https://www.uni-muenster.de>', '<http://www.w3.org/2000/01/rdf-schema#seeAlso>', '<https://www.wwu.de>');
+ALTER FOREIGN TABLE ft_gsp OPTIONS (SET log_sparql 'false');
+SELECT * FROM ft_gsp
+ORDER BY predicate, object::text COLLATE "C";
+/* DELETE still goes through SPARQL UPDATE */
+DELETE FROM ft_gsp;
+SELECT * FROM ft_gsp;
+/* COPY .. FROM is sent in batches of 1000 rows, unless the SERVER sets batch_size */
+ALTER SERVER fuseki OPTIONS (DROP batch_size);
+ALTER FOREIGN TABLE ft_gsp OPTIONS (SET sparql_update_pattern 'GRAPH <http://rdf-fdw.test/gsp> {?s ?p ?o}', SET log_sparql 'true');
+COPY ft_gsp (subject, predicate, object) FROM STDIN;
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"1"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"2"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"3"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"4"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"5"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"6"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"7"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"8"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"9"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"10"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"11"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"12"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"13"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"14"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"15"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"16"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"17"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"18"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"19"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"20"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"21"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"22"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"23"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"24"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"25"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"26"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"27"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"28"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"29"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"30"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"31"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"32"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"33"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"34"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"35"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"36"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"37"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"38"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"39"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"40"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"41"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"42"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"43"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"44"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"45"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"46"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"47"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"48"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"49"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"50"
+<https://www.uni-muenster.de>	<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>	"51"
+\.
+ALTER FOREIGN TABLE ft_gsp OPTIONS (SET log_sparql 'false');
+SELECT count(*) FROM ft_gsp;
+DELETE FROM ft_gsp;
+ALTER SERVER fuseki OPTIONS (ADD batch_size '5');
+/* without GRAPH blocks the inserts are sent as N-Triples to the default graph */
+ALTER FOREIGN TABLE ft_gsp OPTIONS (
+  SET sparql 'SELECT * {?s ?p ?o FILTER(?s = <http://rdf-fdw.test/ntriples>)}',
+  SET sparql_update_pattern
+    '?s ?p ?o ;
+        a <http://schema.org/CollegeOrUniversity> ;
+        rdf:label "WWU"@de, "Uni Münster"@de ;
+        <http://schema.org/numberOfStudents> 45000 .',
+  SET log_sparql 'true');
+INSERT INTO ft_gsp (subject, predicate, object) VALUES
+('<http://rdf-fdw.test/ntriples>', '<http://www.w3.org/2000/01/rdf-schema#seeAlso>', '<https://www.wwu.de>');
+ALTER FOREIGN TABLE ft_gsp OPTIONS (SET log_sparql 'false');
+SELECT * FROM ft_gsp
+ORDER BY predicate::text COLLATE "C", object::text COLLATE "C";
+DELETE FROM ft_gsp;
+SELECT * FROM ft_gsp;
+/* blank nodes cannot be sent as N-Triples */
+ALTER FOREIGN TABLE ft_gsp OPTIONS (SET sparql_update_pattern '?s ?p ?o . ?s rdf:seeAlso _:b');
+INSERT INTO ft_gsp (subject, predicate, object) VALUES
+('<https://www.uni-muenster.de>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"University of Münster"@en');
+DROP FOREIGN TABLE ft_gsp;
+ALTER SERVER fuseki OPTIONS (DROP graph_store_url);
+
 /* cleanup */
 DELETE FROM ft;
 DELETE FROM rdbms_fuseki;    -- clear <http://www.uni-muenster.de/graph>
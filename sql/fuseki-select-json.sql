@@ -0,0 +1,4 @@
+/* runs sql/include/fuseki-select.sql with SPARQL JSON result sets */
+\set format 'application/sparql-results+json'
+\set streaming 'false'
+\i sql/include/fuseki-select.sql
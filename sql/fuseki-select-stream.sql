@@ -0,0 +1,4 @@
+/* runs sql/include/fuseki-select.sql with streamed SPARQL XML result sets */
+\set format 'application/sparql-results+xml'
+\set streaming 'true'
+\i sql/include/fuseki-select.sql
@@ -88,4 +88,10 @@ DELETE FROM ft;
 
 SELECT * FROM ft;
 
+/* COPY FROM one million triples */
+COPY ft (subject, predicate, object) FROM PROGRAM
+  'seq 1000000 | awk ''{print "<https://www.uni-muenster.de>\t<http://www.w3.org/2000/01/rdf-schema#label>\t\"" $1 "\"^^<http://www.w3.org/2001/XMLSchema#int>"}''';
+SELECT count(*) FROM ft;
+DELETE FROM ft;
+
 DROP SERVER fuseki CASCADE;
@@ -0,0 +1,3 @@
+/* runs sql/include/fuseki-table-clone.sql with SPARQL TSV result sets */
+\set format 'text/tab-separated-values'
+\i sql/include/fuseki-table-clone.sql
@@ -171,6 +171,20 @@ ALTER FOREIGN TABLE ft ALTER COLUMN predicate TYPE text;
 UPDATE ft SET object = '"foo"@en';
 ALTER FOREIGN TABLE ft ALTER COLUMN predicate TYPE rdfnode;
 
+/* direct modify: the UPDATE is sent as a single SPARQL UPDATE */
+ALTER FOREIGN TABLE ft OPTIONS (ADD enable_direct_modify 'true');
+INSERT INTO ft (subject, predicate, object) VALUES
+  ('<https://www.uni-muenster.de/rdf_fdw/direct-modify>', '<http://www.w3.org/2000/01/rdf-schema#label>', '"a"@en');
+UPDATE ft SET object = '"b"@en'
+WHERE subject = '<https://www.uni-muenster.de/rdf_fdw/direct-modify>';
+/* a plain EXPLAIN sends no request */
+EXPLAIN (COSTS OFF)
+UPDATE ft SET object = '"c"@en'
+WHERE subject = '<https://www.uni-muenster.de/rdf_fdw/direct-modify>';
+SELECT * FROM ft WHERE subject = '<https://www.uni-muenster.de/rdf_fdw/direct-modify>';
+DELETE FROM ft WHERE subject = '<https://www.uni-muenster.de/rdf_fdw/direct-modify>';
+ALTER FOREIGN TABLE ft OPTIONS (DROP enable_direct_modify);
+
 /* cleanup */
 UPDATE ft SET object = '"updated"'::rdfnode WHERE subject IN (SELECT subject FROM ft WHERE predicate = '<http://foo.bar>');
 UPDATE ft SET object = '"updated"'::rdfnode WHERE subject IN (SELECT subject FROM ft WHERE predicate <> '<http://foo.bar>');
@@ -172,14 +172,18 @@ COPY (
   ORDER BY o::text COLLATE "C"
 ) TO STDOUT DELIMITER E' ';
 
-/*** Exception tests ***/
-
-/* COPY .. FROM must fail - not supported */
+/* COPY .. FROM is sent in the same batched requests as INSERT */
 COPY ft (subject, predicate, object) FROM STDIN WITH (DELIMITER ' ');
 <https://www.uni-muenster.de> <http://www.w3.org/1999/02/22-rdf-syntax-ns#value> "42"^^<http://www.w3.org/2001/XMLSchema#int>
 <https://www.uni-muenster.de> <http://www.w3.org/1999/02/22-rdf-syntax-ns#value> "37"^^<http://www.w3.org/2001/XMLSchema#int>
 \.
 
+SELECT subject, predicate, object FROM ft
+WHERE predicate = '<http://www.w3.org/1999/02/22-rdf-syntax-ns#value>'
+ORDER BY object::text COLLATE "C";
+
+/*** Exception tests ***/
+
 /* INSERT must fail - all columns must be of type rdfnode */
 ALTER FOREIGN TABLE ft ALTER COLUMN predicate TYPE text;
 INSERT INTO ft (subject, predicate, object) VALUES
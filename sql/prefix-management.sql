@@ -51,6 +51,15 @@ SELECT sparql.add_prefix('testctx', 'foo', 'http://example.org/foo#');
 SELECT sparql.add_context('testctx', 'test context - updated', true);
 SELECT sparql.add_prefix('testctx', 'foo', 'http://example.org/foo-updated#', true);
 
+-- Prefixes of a context are cached, and reloaded once they are modified
+ALTER SERVER wikidata OPTIONS (ADD prefix_context 'testctx');
+SELECT p, o FROM rdbms ORDER BY p::text COLLATE "C" LIMIT 0;
+SELECT sparql.add_prefix('testctx', 'baz', 'http://example.org/baz#');
+SELECT p, o FROM rdbms ORDER BY p::text COLLATE "C" LIMIT 0;
+SELECT sparql.drop_prefix('testctx', 'baz');
+SELECT p, o FROM rdbms ORDER BY p::text COLLATE "C" LIMIT 0;
+ALTER SERVER wikidata OPTIONS (DROP prefix_context);
+
 -- Check the prefix context and prefixes
 SELECT context, description FROM sparql.prefix_contexts ORDER BY context COLLATE "C";
 SELECT context, prefix, uri FROM sparql.prefixes ORDER BY context, prefix COLLATE "C";
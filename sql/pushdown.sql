@@ -1104,8 +1104,10 @@ WHERE
   sparql.md5(o) = sparql.md5('"hello"@en');
 
 /* ================================================================
- * Non-pushable tables
- * (SPARQL query contains MINUS, UNION, LIMIT, ORDER BY, GROUP BY)
+ * SPARQL queries containing MINUS, UNION, LIMIT, ORDER BY and
+ * GROUP BY - conditions are pushed down, around a sub-select if the
+ * query has solution modifiers or aggregates, except for those on
+ * text columns without 'nodetype'
  * ================================================================ */
 
 CREATE FOREIGN TABLE np_minus (
@@ -1163,4 +1165,134 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT p, c FROM np_groupby
 WHERE c > 1;
 
+/* text columns without 'nodetype' keep their conditions local */
+CREATE FOREIGN TABLE np_union_text (
+  p text OPTIONS (variable '?p'),
+  o text OPTIONS (variable '?o', nodetype 'iri')
+)
+SERVER test_server OPTIONS (
+  sparql 'SELECT * WHERE {{<http://example.org/s> ?p ?o} UNION {<http://example.org/s2> ?p ?o}}');
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT p, o FROM np_union_text
+WHERE p = 'http://example.org/p' AND o = 'http://example.org/o';
+
+/* ----------------------------------------------------------------
+ * JOIN pushdown - the endpoint joins FOREIGN TABLEs of the same
+ * SERVER with a single request.
+ * ---------------------------------------------------------------- */
+CREATE FOREIGN TABLE join_film (
+  film rdfnode OPTIONS (variable '?film'),
+  director rdfnode OPTIONS (variable '?director')
+)
+SERVER test_server OPTIONS (
+  sparql 'SELECT * WHERE {?film <http://dbpedia.org/ontology/director> ?director}');
+
+CREATE FOREIGN TABLE join_person (
+  person rdfnode OPTIONS (variable '?person'),
+  name rdfnode OPTIONS (variable '?name')
+)
+SERVER test_server OPTIONS (
+  sparql 'SELECT * WHERE {?person <http://xmlns.com/foaf/0.1/name> ?name}');
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT f.film, p.name FROM join_film f
+JOIN join_person p ON f.director = p.person;
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT f.film, p.name FROM join_film f
+JOIN join_person p ON f.director = p.person
+WHERE p.name = '"Stanley Kubrick"@en';
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT f.film, p.name FROM join_film f
+LEFT JOIN join_person p ON f.director = p.person;
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT count(*) FROM join_film;
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT director, count(film) FROM join_film
+GROUP BY director;
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT director, sparql.sample(film) FROM join_film
+GROUP BY director
+HAVING count(*) > 2;
+
+/* remote sort order of numeric columns is used if NULL values are sorted as in SPARQL */
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT version FROM pgtypes_ft
+ORDER BY version NULLS FIRST;
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT version FROM pgtypes_ft
+ORDER BY version;
+
+ALTER FOREIGN TABLE pgtypes_ft ALTER COLUMN version SET NOT NULL;
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT version FROM pgtypes_ft
+ORDER BY version DESC;
+
+ALTER FOREIGN TABLE pgtypes_ft ALTER COLUMN version DROP NOT NULL;
+
+/* numeric columns without a numeric literaltype may hold strings, and keep the local Sort */
+ALTER FOREIGN TABLE pgtypes_ft ALTER COLUMN version OPTIONS (DROP literaltype);
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT version FROM pgtypes_ft
+ORDER BY version NULLS FIRST;
+
+ALTER FOREIGN TABLE pgtypes_ft ALTER COLUMN version OPTIONS (ADD literaltype 'xsd:integer');
+
+/* join keys of another relation are bound to the graph pattern of a parameterized scan */
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT f.film, f.director
+FROM (VALUES ('<http://dbpedia.org/resource/The_Shining_(film)>'::rdfnode)) AS l (film)
+JOIN join_film f ON f.film = l.film;
+
+/* values of parameters are bound to the graph pattern at execution time */
+PREPARE film_by_iri (rdfnode) AS
+SELECT film, director FROM join_film WHERE film = $1;
+
+SET plan_cache_mode = force_generic_plan;
+
+EXPLAIN (VERBOSE, COSTS OFF)
+EXECUTE film_by_iri('<http://dbpedia.org/resource/The_Shining_(film)>');
+
+RESET plan_cache_mode;
+
+DEALLOCATE film_by_iri;
+
+/* equalities are bound as terms of the graph pattern (enable_term_binding) */
+ALTER FOREIGN TABLE join_film OPTIONS (ADD enable_term_binding 'true');
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT film, director FROM join_film
+WHERE film = '<http://dbpedia.org/resource/The_Shining_(film)>';
+
+ALTER FOREIGN TABLE join_film OPTIONS (DROP enable_term_binding);
+
+/* IN lists with at least values_threshold elements are bound in a VALUES block */
+ALTER FOREIGN TABLE join_film OPTIONS (ADD values_threshold '3');
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT film, director FROM join_film
+WHERE film IN ('<http://dbpedia.org/resource/The_Shining_(film)>',
+               '<http://dbpedia.org/resource/Alien_(film)>',
+               '<http://dbpedia.org/resource/Blade_Runner>');
+
+/* VALUES blocks larger than max_values_size are split into several requests */
+ALTER SERVER test_server OPTIONS (ADD max_values_size '120');
+
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT film, director FROM join_film
+WHERE film IN ('<http://dbpedia.org/resource/The_Shining_(film)>',
+               '<http://dbpedia.org/resource/Alien_(film)>',
+               '<http://dbpedia.org/resource/Blade_Runner>');
+
+ALTER SERVER test_server OPTIONS (DROP max_values_size);
+ALTER FOREIGN TABLE join_film OPTIONS (DROP values_threshold);
+
 DROP SERVER test_server CASCADE;
@@ -487,8 +487,9 @@ SERVER dbpedia OPTIONS (
 
 
 /*
- * All filters (WHERE, FETCH and ILIKE) will be applied locally,
- * as the raw SPARQL cannot be parsed - it contains aggregators.
+ * The WHERE (ILIKE) condition and FETCH will be applied locally, as the
+ * raw SPARQL contains aggregators and 'country' has no 'nodetype'. The
+ * ORDER BY is pushed down around a sub-select.
  */
 SELECT party, nmembers 
 FROM party_members
@@ -526,8 +527,8 @@ SERVER dbpedia OPTIONS (
 /* ################### Expression Check ################### */
 
 /*
- * All filters (WHERE and ORDER BY) will be applied locally,
- * as the raw SPARQL cannot be parsed - it contains UNION.
+ * The WHERE condition will be applied locally, as the raw SPARQL contains
+ * UNION and 'party' has no 'nodetype'. The ORDER BY is pushed down.
  */
 SELECT name, party, birthdate
 FROM chanceler_candidates
@@ -593,7 +594,8 @@ WHERE
   
 
 /*
- * SPARQL contains a LIMIT. Nothing will be pushed down.
+ * SPARQL contains a LIMIT. Conditions on text columns without 'nodetype'
+ * are applied locally.
  */
  CREATE FOREIGN TABLE person1 (
   person text OPTIONS (variable '?person'),
@@ -615,7 +617,8 @@ WHERE
 SELECT birthdate FROM person1 WHERE person = 'foo'; 
 
 /*
- * SPARQL contains ORDER BY. Nothing will be pushed down.
+ * SPARQL contains ORDER BY. Conditions on text columns without 'nodetype'
+ * are applied locally.
  */
  CREATE FOREIGN TABLE person2 (
   person text OPTIONS (variable '?person'),